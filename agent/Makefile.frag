@@ -85,6 +85,7 @@ TEST_BINARIES = \
 	tests/test_curl_md \
 	tests/test_datastore \
 	tests/test_environment \
+	tests/test_explain \
 	tests/test_fw_codeigniter \
 	tests/test_fw_drupal \
 	tests/test_fw_support \
@@ -107,6 +108,7 @@ TEST_BINARIES = \
         tests/test_php_error \
 	tests/test_php_execute \
 	tests/test_php_minit \
+	tests/test_php_samplers \
 	tests/test_php_stack \
 	tests/test_php_stacked_segment \
 	tests/test_php_txn \
@@ -144,6 +146,19 @@ run-unit-tests: $(TEST_BINARIES:%=%.phony) | $(TEST_BINARIES)
 %.phony: %
 	@$< $(TESTARGS)
 
+#
+# Benchmarks are built and run like the unit tests, but separately from them,
+# since they take longer and only report timings.
+#
+BENCH_BINARIES = \
+	tests/bench_php_stack
+
+.PHONY: benches
+benches: $(BENCH_BINARIES)
+
+.PHONY: run-benches
+run-benches: $(BENCH_BINARIES:%=%.phony) | $(BENCH_BINARIES)
+
 #
 # Valgrind support, starting with defining where to find valgrind and the
 # scripts and suppressions we also use for the axiom test suite's valgrind
@@ -296,11 +311,14 @@ tests/%.o: tests/%.c
 tests/test_%: tests/test_%.o $(TLIB_OBJS) $(PHP_MODULES)
 	$(CC) -o $@ $(LDFLAGS) $(TEST_LDFLAGS) $< $(PHP_EMBED_LIBRARY) $(TLIB_OBJS) $(wildcard .libs/*.o) $(LIBS) $(EXTRA_LIBS) $(TEST_LIBS) $(TEST_NEWRELIC_SHARED_LIBADD)
 
+tests/bench_%: tests/bench_%.o $(TLIB_OBJS) $(PHP_MODULES)
+	$(CC) -o $@ $(LDFLAGS) $(TEST_LDFLAGS) $< $(PHP_EMBED_LIBRARY) $(TLIB_OBJS) $(wildcard .libs/*.o) $(LIBS) $(EXTRA_LIBS) $(TEST_LIBS) $(TEST_NEWRELIC_SHARED_LIBADD)
+
 #
 # Secondary declaration to prevent the intermediate .o files from being
 # deleted, causing double compilation.
 #
-.SECONDARY: $(TLIB_OBJS) $(TEST_BINARIES:%=%.o)
+.SECONDARY: $(TLIB_OBJS) $(TEST_BINARIES:%=%.o) $(BENCH_BINARIES:%=%.o)
 
 #
 # Include dependency files. See axiom/Makefile for a discussion of how this
@@ -308,6 +326,7 @@ tests/test_%: tests/test_%.o $(TLIB_OBJS) $(PHP_MODULES)
 #
 -include $(TLIB_OBJS:.o=.d)
 -include $(TEST_BINARIES:%=%.d)
+-include $(BENCH_BINARIES:%=%.d)
 
 #
 # Getting "make clean" to remove the unit test build products is difficult, as
@@ -320,6 +339,6 @@ tests/test_%: tests/test_%.o $(TLIB_OBJS) $(PHP_MODULES)
 # directory structure. We've never supported (or done) that anyway, but now it
 # really won't work.
 #
-OVERALL_TARGET := $(TEST_BINARIES) tests/*.o tests/*.d
+OVERALL_TARGET := $(TEST_BINARIES) $(BENCH_BINARIES) tests/*.o tests/*.d
 
 # vim: set noet ts=2 sw=2:
@@ -12,11 +12,14 @@
 #include "php_wrapper.h"
 #include "fw_hooks.h"
 #include "fw_support.h"
+#include "util_buffer.h"
 #include "util_logging.h"
 #include "util_matcher.h"
 #include "util_memory.h"
+#include "util_metrics.h"
 #include "util_regex.h"
 #include "util_strings.h"
+#include "util_threads.h"
 #include "fw_wordpress.h"
 
 #define NR_WORDPRESS_HOOK_PREFIX "Framework/WordPress/Hook/"
@@ -25,6 +28,28 @@
 
 static nr_regex_t* wordpress_hook_regex;
 
+/*
+ * The process-wide plugin/theme attribution cache. Attribution only depends on
+ * the file path, the directory constants WordPress defines and its theme
+ * roots, so results are shared across requests: the outer map is keyed by the
+ * site key built from those (see nr_wordpress_site_key()), and each inner map
+ * is keyed by filename with the plugin or theme name (or NULL for core and
+ * unmatched files) as the value. Since the file path alone determines the
+ * result, a changed file (new mtime, opcache reset) keeps its attribution,
+ * while a change to WP_PLUGIN_DIR, WP_CONTENT_DIR or the theme roots produces
+ * a new site key and thus a fresh inner map.
+ *
+ * Both maps are bounded: once a limit is reached the affected map is flushed
+ * rather than tracking recency, as the set of files behind hooks is stable
+ * and refilling is cheap compared to the bookkeeping an LRU would need.
+ */
+#define NR_WORDPRESS_PLUGIN_CACHE_MAX_SITES 16
+#define NR_WORDPRESS_PLUGIN_CACHE_MAX_FILES 8192
+
+static nr_hashmap_t* wordpress_plugin_cache;
+static nrthread_mutex_t wordpress_plugin_cache_mutex
+    = NRTHREAD_MUTEX_INITIALIZER;
+
 static nr_matcher_t* create_matcher_for_constant(const char* constant,
                                                  const char* suffix) {
   zval* value = nr_php_get_constant(constant);
@@ -216,6 +241,194 @@ static void free_wordpress_metadata(void* metadata) {
   nr_free(metadata);
 }
 
+static void free_wordpress_plugin_cache_site(void* site) {
+  nr_hashmap_t* files = (nr_hashmap_t*)site;
+
+  nr_hashmap_destroy(&files);
+}
+
+int nr_php_wordpress_plugin_cache_get(const char* site_key,
+                                      const char* filename,
+                                      size_t filename_len,
+                                      char** plugin_ptr) {
+  nr_hashmap_t* files = NULL;
+  char* plugin = NULL;
+  int found = 0;
+
+  if ((NULL == site_key) || (NULL == filename) || (NULL == plugin_ptr)) {
+    return 0;
+  }
+
+  nrt_mutex_lock(&wordpress_plugin_cache_mutex);
+  if (nr_hashmap_get_into(wordpress_plugin_cache, site_key,
+                          nr_strlen(site_key), (void**)&files)
+      && nr_hashmap_get_into(files, filename, filename_len, (void**)&plugin)) {
+    /*
+     * The cached value is copied so that the caller owns it: another thread
+     * may flush the cache while the current request still uses the name.
+     */
+    *plugin_ptr = nr_strdup(plugin);
+    found = 1;
+  }
+  nrt_mutex_unlock(&wordpress_plugin_cache_mutex);
+
+  return found;
+}
+
+void nr_php_wordpress_plugin_cache_set(const char* site_key,
+                                       const char* filename,
+                                       size_t filename_len,
+                                       const char* plugin) {
+  nr_hashmap_t* files = NULL;
+  size_t site_key_len;
+
+  if ((NULL == site_key) || (NULL == filename)) {
+    return;
+  }
+  site_key_len = nr_strlen(site_key);
+
+  nrt_mutex_lock(&wordpress_plugin_cache_mutex);
+  if (NULL == wordpress_plugin_cache) {
+    wordpress_plugin_cache
+        = nr_hashmap_create(free_wordpress_plugin_cache_site);
+  }
+
+  if (!nr_hashmap_get_into(wordpress_plugin_cache, site_key, site_key_len,
+                           (void**)&files)) {
+    if (nr_hashmap_count(wordpress_plugin_cache)
+        >= NR_WORDPRESS_PLUGIN_CACHE_MAX_SITES) {
+      nrl_verbosedebug(NRL_FRAMEWORK,
+                       "Wordpress: plugin cache site limit reached; flushing");
+      nr_hashmap_destroy(&wordpress_plugin_cache);
+      wordpress_plugin_cache
+          = nr_hashmap_create(free_wordpress_plugin_cache_site);
+    }
+    files = nr_hashmap_create(free_wordpress_metadata);
+    nr_hashmap_set(wordpress_plugin_cache, site_key, site_key_len, files);
+  } else if (nr_hashmap_count(files) >= NR_WORDPRESS_PLUGIN_CACHE_MAX_FILES) {
+    nrl_verbosedebug(NRL_FRAMEWORK,
+                     "Wordpress: plugin cache file limit reached; flushing");
+    files = nr_hashmap_create(free_wordpress_metadata);
+    nr_hashmap_update(wordpress_plugin_cache, site_key, site_key_len, files);
+  }
+
+  nr_hashmap_update(files, filename, filename_len, nr_strdup(plugin));
+  nrt_mutex_unlock(&wordpress_plugin_cache_mutex);
+}
+
+void nr_php_wordpress_plugin_cache_destroy(void) {
+  nrt_mutex_lock(&wordpress_plugin_cache_mutex);
+  nr_hashmap_destroy(&wordpress_plugin_cache);
+  nrt_mutex_unlock(&wordpress_plugin_cache_mutex);
+}
+
+/*
+ * Purpose : Append the theme roots reported by get_theme_roots() to a buffer.
+ *
+ * Returns : true if the theme roots were available, false otherwise.
+ */
+static bool nr_wordpress_site_key_add_theme_roots(nrbuf_t* buf TSRMLS_DC) {
+  zval* roots = nr_php_call(NULL, "get_theme_roots");
+  bool found = false;
+
+  if (nr_php_is_zval_valid_string(roots)) {
+    nr_buffer_add(buf, Z_STRVAL_P(roots), Z_STRLEN_P(roots));
+    found = true;
+  } else if (nr_php_is_zval_valid_array(roots)
+             && (nr_php_zend_hash_num_elements(Z_ARRVAL_P(roots)) > 0)) {
+    zval* path = NULL;
+
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(roots), path) {
+      if (nr_php_is_zval_valid_string(path)) {
+        nr_buffer_add(buf, Z_STRVAL_P(path), Z_STRLEN_P(path));
+        nr_buffer_add(buf, NR_PSTR(","));
+      }
+    }
+    ZEND_HASH_FOREACH_END();
+    found = true;
+  }
+
+  nr_php_zval_free(&roots);
+  return found;
+}
+
+/*
+ * Purpose : Return the key identifying the current site's directory layout in
+ *           the process-wide plugin cache.
+ *
+ * Returns : The site key, owned by the request globals, or NULL if WordPress
+ *           hasn't yet defined the plugin and content directories or loaded
+ *           the theme API, or if the theme roots couldn't be found.
+ *
+ * Note    : The key is only built once every input of the plugin, theme and
+ *           core matchers is available, and is then kept for the rest of the
+ *           request. Matchers built before that may have used fallback
+ *           prefixes, so they are destroyed and rebuilt from the same inputs
+ *           as the key. Until then, the process-wide cache is bypassed.
+ *
+ *           Checking for the constants and for get_theme_roots() is cheap,
+ *           but calling it isn't, so it is called at most once per request.
+ *           If it doesn't return the theme roots, the key is unavailable for
+ *           the rest of the request.
+ */
+static const char* nr_wordpress_site_key(TSRMLS_D) {
+  static const struct {
+    const char* name;
+    bool required;
+  } constants[] = {
+      {"WP_PLUGIN_DIR", true},
+      {"WP_CONTENT_DIR", true},
+      {"WPINC", false},
+  };
+  nrbuf_t* buf = NULL;
+  size_t i;
+
+  if (NRPRG(wordpress_site_key)) {
+    return NRPRG(wordpress_site_key);
+  }
+  if (NRPRG(wordpress_site_key_unavailable)) {
+    return NULL;
+  }
+
+  buf = nr_buffer_create(256, 0);
+  for (i = 0; i < sizeof(constants) / sizeof(constants[0]); i++) {
+    zval* value = nr_php_get_constant(constants[i].name TSRMLS_CC);
+    bool valid = nr_php_is_zval_valid_string(value);
+
+    if (valid) {
+      nr_buffer_add(buf, Z_STRVAL_P(value), Z_STRLEN_P(value));
+    }
+    nr_buffer_add(buf, NR_PSTR("|"));
+    nr_php_zval_free(&value);
+
+    if (!valid && constants[i].required) {
+      nr_buffer_destroy(&buf);
+      return NULL;
+    }
+  }
+
+  if (NULL == nr_php_find_function("get_theme_roots" TSRMLS_CC)) {
+    nr_buffer_destroy(&buf);
+    return NULL;
+  }
+
+  if (!nr_wordpress_site_key_add_theme_roots(buf TSRMLS_CC)) {
+    NRPRG(wordpress_site_key_unavailable) = true;
+    nr_buffer_destroy(&buf);
+    return NULL;
+  }
+  nr_buffer_add(buf, NR_PSTR("\0"));
+
+  NRPRG(wordpress_site_key) = nr_strdup(nr_buffer_cptr(buf));
+  nr_buffer_destroy(&buf);
+
+  nr_matcher_destroy(&NRPRG(wordpress_plugin_matcher));
+  nr_matcher_destroy(&NRPRG(wordpress_theme_matcher));
+  nr_matcher_destroy(&NRPRG(wordpress_core_matcher));
+
+  return NRPRG(wordpress_site_key);
+}
+
 static inline void nr_wordpress_hooks_create_metric(nr_segment_t* segment,
                                        const char* hook_name) {
   if (NULL == segment) {
@@ -231,8 +444,205 @@ static inline void nr_wordpress_hooks_create_metric(nr_segment_t* segment,
   }
 }
 
+/*
+ * The size of the stack buffer used for the key of an aggregate, which is
+ * enough for all but unusually long plugin and hook names.
+ */
+#define NR_WORDPRESS_HOOK_AGGREGATE_KEY_SIZE 256
+
+/*
+ * Accumulated timings for one (plugin, hook) pair when hook callbacks are
+ * aggregated rather than recorded as individual segments.
+ */
+typedef struct _nr_wordpress_hook_aggregate_t {
+  char* plugin;
+  char* hook;
+  nrtime_t count;
+  nrtime_t total;
+  nrtime_t exclusive;
+  nrtime_t min;
+  nrtime_t max;
+  nrtime_t sum_of_squares;
+} nr_wordpress_hook_aggregate_t;
+
+static void free_wordpress_hook_aggregate(void* value) {
+  nr_wordpress_hook_aggregate_t* aggregate
+      = (nr_wordpress_hook_aggregate_t*)value;
+
+  if (NULL == aggregate) {
+    return;
+  }
+
+  nr_free(aggregate->plugin);
+  nr_free(aggregate->hook);
+  nr_free(aggregate);
+}
+
+void nr_php_wordpress_hook_aggregate_add(const char* plugin,
+                                         const char* hook,
+                                         nrtime_t duration,
+                                         nrtime_t exclusive TSRMLS_DC) {
+  nr_wordpress_hook_aggregate_t* aggregate = NULL;
+  size_t plugin_len = nr_strlen(plugin);
+  size_t hook_len = nr_strlen(hook);
+  size_t key_len;
+  char key_buf[NR_WORDPRESS_HOOK_AGGREGATE_KEY_SIZE];
+  char* key = key_buf;
+
+  if ((NULL == plugin) && (NULL == hook)) {
+    return;
+  }
+
+  /*
+   * The key is the plugin and hook separated by a NUL byte, which cannot occur
+   * in either. It's built in a fixed buffer on the stack so that hits don't
+   * allocate, unless the hook name is unusually long.
+   */
+  key_len = plugin_len + 1 + hook_len;
+  if (key_len > sizeof(key_buf)) {
+    key = (char*)nr_malloc(key_len);
+  }
+  nr_memcpy(key, plugin, plugin_len);
+  key[plugin_len] = '\0';
+  nr_memcpy(key + plugin_len + 1, hook, hook_len);
+
+  if (NULL == NRPRG(wordpress_hook_aggregates)) {
+    NRPRG(wordpress_hook_aggregates)
+        = nr_hashmap_create(free_wordpress_hook_aggregate);
+  } else {
+    aggregate = (nr_wordpress_hook_aggregate_t*)nr_hashmap_get(
+        NRPRG(wordpress_hook_aggregates), key, key_len);
+  }
+
+  if (NULL == aggregate) {
+    aggregate = (nr_wordpress_hook_aggregate_t*)nr_zalloc(
+        sizeof(nr_wordpress_hook_aggregate_t));
+    aggregate->plugin = nr_strdup(plugin);
+    aggregate->hook = nr_strdup(hook);
+    aggregate->min = duration;
+    nr_hashmap_set(NRPRG(wordpress_hook_aggregates), key, key_len, aggregate);
+  }
+
+  aggregate->count += 1;
+  aggregate->total += duration;
+  aggregate->exclusive += exclusive;
+  aggregate->sum_of_squares += duration * duration;
+  if (duration < aggregate->min) {
+    aggregate->min = duration;
+  }
+  if (duration > aggregate->max) {
+    aggregate->max = duration;
+  }
+
+  if (key != key_buf) {
+    nr_free(key);
+  }
+}
+
+static void nr_wordpress_hook_aggregate_metric(
+    nrmtable_t* table,
+    const char* prefix,
+    const char* name,
+    const nr_wordpress_hook_aggregate_t* aggregate) {
+  char* metric_name = NULL;
+
+  if (NULL == name) {
+    return;
+  }
+
+  metric_name = nr_formatf("%s%s", prefix, name);
+  nrm_add_internal(0, table, metric_name, aggregate->count, aggregate->total,
+                   aggregate->exclusive, aggregate->min, aggregate->max,
+                   aggregate->sum_of_squares);
+  nr_free(metric_name);
+}
+
+static void nr_wordpress_hook_aggregate_apply(void* value,
+                                              const char* key NRUNUSED,
+                                              size_t key_len NRUNUSED,
+                                              void* user_data) {
+  nr_wordpress_hook_aggregate_t* aggregate
+      = (nr_wordpress_hook_aggregate_t*)value;
+  nrmtable_t* table = (nrmtable_t*)user_data;
+
+  nr_wordpress_hook_aggregate_metric(table, NR_WORDPRESS_HOOK_PREFIX,
+                                     aggregate->hook, aggregate);
+  nr_wordpress_hook_aggregate_metric(table, NR_WORDPRESS_PLUGIN_PREFIX,
+                                     aggregate->plugin, aggregate);
+}
+
+void nr_php_wordpress_hook_aggregate_metrics(nrmtable_t* table TSRMLS_DC) {
+  if (NULL == NRPRG(wordpress_hook_aggregates)) {
+    return;
+  }
+
+  if (NULL != table) {
+    nr_hashmap_apply(NRPRG(wordpress_hook_aggregates),
+                     nr_wordpress_hook_aggregate_apply, table);
+  }
+  nr_hashmap_destroy(&NRPRG(wordpress_hook_aggregates));
+}
+
+/*
+ * Purpose : Record a hook callback that has finished executing.
+ *
+ * Params  : 1. The segment of the callback.
+ *           2. The plugin or theme the callback belongs to, or NULL for core.
+ *           3. The hook being executed.
+ */
+static void nr_wordpress_hook_callback_record(nr_segment_t* segment,
+                                              const char* plugin,
+                                              const char* hook) {
+  if (NULL == segment) {
+    return;
+  }
+
+  nr_wordpress_create_metric(segment, NR_WORDPRESS_HOOK_PREFIX, hook);
+  nr_wordpress_create_metric(segment, NR_WORDPRESS_PLUGIN_PREFIX, plugin);
+}
+
+/*
+ * Purpose : Record a hook callback that has finished executing when hooks are
+ *           aggregated.
+ *
+ * Params  : 1. The segment of the callback.
+ *           2. The plugin or theme the callback belongs to, or NULL for core.
+ *           3. The hook being executed.
+ *           4. The duration of the callback.
+ *           5. The value of NRPRG(wordpress_hook_exclusive_time) when the
+ *              callback began.
+ *
+ * Note    : Callbacks that ran for less than the hook threshold only update
+ *           the per-request aggregate table. No metrics are added to their
+ *           segments, which are therefore discarded on end unless otherwise
+ *           interesting. Slower callbacks are recorded individually.
+ */
+static void nr_wordpress_hook_callback_aggregate(nr_segment_t* segment,
+                                                 const char* plugin,
+                                                 const char* hook,
+                                                 nrtime_t duration,
+                                                 nrtime_t mark TSRMLS_DC) {
+  /*
+   * The callbacks that finished since this one began were nested within it,
+   * so the exclusive time they accumulated is this callback's child time.
+   */
+  nrtime_t children = NRPRG(wordpress_hook_exclusive_time) - mark;
+  nrtime_t exclusive = (duration > children) ? duration - children : 0;
+
+  NRPRG(wordpress_hook_exclusive_time) += exclusive;
+
+  if (duration < NRINI(wordpress_hooks_threshold)) {
+    nr_php_wordpress_hook_aggregate_add(plugin, hook, duration,
+                                        exclusive TSRMLS_CC);
+    return;
+  }
+
+  nr_wordpress_hook_callback_record(segment, plugin, hook);
+}
+
 static char* nr_wordpress_plugin_from_function(zend_function* func TSRMLS_DC) {
   const char* filename = NULL;
+  const char* site_key = NULL;
   size_t filename_len;
   char* plugin = NULL;
   int plugin_len;
@@ -269,6 +679,21 @@ static char* nr_wordpress_plugin_from_function(zend_function* func TSRMLS_DC) {
   } else {
     NRPRG(wordpress_file_metadata) = nr_hashmap_create(free_wordpress_metadata);
   }
+
+  /*
+   * Not seen yet in this request: consult the process-wide cache before
+   * falling back to the matchers.
+   */
+  site_key = nr_wordpress_site_key(TSRMLS_C);
+  if (nr_php_wordpress_plugin_cache_get(site_key, filename, filename_len,
+                                        &plugin)) {
+    NRPRG(wordpress_plugin_cache_hits) += 1;
+    nr_hashmap_set(NRPRG(wordpress_file_metadata), filename, filename_len,
+                   plugin);
+    return plugin;
+  }
+  NRPRG(wordpress_plugin_cache_misses) += 1;
+
   nrl_verbosedebug(NRL_FRAMEWORK,
                    "Wordpress: NOT found in cache: "
                    "filename=" NRP_FMT,
@@ -326,18 +751,52 @@ cache_and_return:
    */
   nr_hashmap_set(NRPRG(wordpress_file_metadata), filename, filename_len,
                  plugin);
+  nr_php_wordpress_plugin_cache_set(site_key, filename, filename_len, plugin);
   return plugin;
 }
 
+#if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
+    && !defined OVERWRITE_ZEND_EXECUTE_DATA
+/*
+ * With OAPI nr_wordpress_wrap_hook() is only called once the callback has
+ * finished, so when hooks are aggregated, the aggregated hook time and the
+ * time when the callback began are kept on a stack rather than on the call
+ * stack. They are pushed for every callback so that they're always balanced
+ * by the pops in nr_wordpress_wrap_hook().
+ */
+NR_PHP_WRAPPER(nr_wordpress_wrap_hook_before) {
+  NR_UNUSED_SPECIALFN;
+  (void)wraprec;
+
+  nr_stack_push(&NRPRG(wordpress_hook_marks),
+                (void*)(uintptr_t)NRPRG(wordpress_hook_exclusive_time));
+  nr_stack_push(&NRPRG(wordpress_hook_marks), (void*)(uintptr_t)nr_get_time());
+}
+NR_PHP_WRAPPER_END
+#endif /* OAPI */
+
 NR_PHP_WRAPPER(nr_wordpress_wrap_hook) {
 #if ZEND_MODULE_API_NO < ZEND_7_4_X_API_NO
   zend_function* func = NULL;
 #endif
   char* plugin = NULL;
+  const char* tag = NULL;
+  nrtime_t mark = 0;
+  nrtime_t start = 0;
 
   NR_UNUSED_SPECIALFN;
   (void)wraprec;
 
+#if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
+    && !defined OVERWRITE_ZEND_EXECUTE_DATA
+  if (wraprec
+      && (nr_wordpress_wrap_hook_before
+          == wraprec->special_instrumentation_before)) {
+    start = (nrtime_t)(uintptr_t)nr_stack_pop(&NRPRG(wordpress_hook_marks));
+    mark = (nrtime_t)(uintptr_t)nr_stack_pop(&NRPRG(wordpress_hook_marks));
+  }
+#endif
+
   /*
    * We only want to hook the function being called if this is a WordPress
    * function, we're instrumenting hooks, and WordPress is currently executing
@@ -347,11 +806,11 @@ NR_PHP_WRAPPER(nr_wordpress_wrap_hook) {
 
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
-  char* tag = nr_stack_get_top(&NRPRG(wordpress_tags));
-  if ((0 == NRINI(wordpress_hooks)) || (NULL == tag)) {
+  tag = (const char*)nr_stack_get_top(&NRPRG(wordpress_tags));
 #else
-  if ((0 == NRINI(wordpress_hooks)) || (NULL == NRPRG(wordpress_tag))) {
+  tag = NRPRG(wordpress_tag);
 #endif /* OAPI */
+  if ((0 == NRINI(wordpress_hooks)) || (NULL == tag)) {
     NR_PHP_WRAPPER_LEAVE;
   }
 #if ZEND_MODULE_API_NO < ZEND_7_4_X_API_NO
@@ -361,18 +820,39 @@ NR_PHP_WRAPPER(nr_wordpress_wrap_hook) {
   plugin = wraprec->wordpress_plugin_theme;
 #endif
 
-  NR_PHP_WRAPPER_CALL;
-  if (NULL != plugin || NRPRG(wordpress_core)) {
+  if ((NULL == plugin) && !NRPRG(wordpress_core)) {
+    NR_PHP_WRAPPER_LEAVE;
+  }
+
+  if (!NRPRG(wordpress_hooks_aggregate)) {
+    NR_PHP_WRAPPER_CALL;
+    nr_wordpress_hook_callback_record(auto_segment, plugin, tag);
+    NR_PHP_WRAPPER_LEAVE;
+  }
+
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
-    nr_wordpress_create_metric(auto_segment, NR_WORDPRESS_HOOK_PREFIX, tag);
-#else
-    nr_wordpress_create_metric(auto_segment, NR_WORDPRESS_HOOK_PREFIX,
-                               NRPRG(wordpress_tag));
-#endif
-    nr_wordpress_create_metric(auto_segment, NR_WORDPRESS_PLUGIN_PREFIX,
-                               plugin);
+  /*
+   * The callback has already been executed, and its start was recorded by
+   * nr_wordpress_wrap_hook_before().
+   */
+  if (0 != start) {
+    nr_wordpress_hook_callback_aggregate(auto_segment, plugin, tag,
+                                         nr_time_duration(start, nr_get_time()),
+                                         mark TSRMLS_CC);
   }
+#else
+  /*
+   * The callback is timed here rather than from its segment, so that fast
+   * callbacks don't depend on the segment at all.
+   */
+  mark = NRPRG(wordpress_hook_exclusive_time);
+  start = nr_get_time();
+  NR_PHP_WRAPPER_CALL;
+  nr_wordpress_hook_callback_aggregate(auto_segment, plugin, tag,
+                                       nr_time_duration(start, nr_get_time()),
+                                       mark TSRMLS_CC);
+#endif /* OAPI */
 }
 NR_PHP_WRAPPER_END
 
@@ -764,7 +1244,10 @@ NR_PHP_WRAPPER(nr_wordpress_add_filter) {
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
         callback_wraprec = nr_php_wrap_callable_before_after_clean(
-            zf, NULL, nr_wordpress_wrap_hook, nr_wordpress_wrap_hook);
+            zf,
+            NRPRG(wordpress_hooks_aggregate) ? nr_wordpress_wrap_hook_before
+                                             : NULL,
+            nr_wordpress_wrap_hook, nr_wordpress_wrap_hook);
 #else
         callback_wraprec = nr_php_wrap_callable(zf, nr_wordpress_wrap_hook);
 #endif
@@ -883,4 +1366,29 @@ void nr_wordpress_minit(void) {
 
 void nr_wordpress_mshutdown(void) {
   nr_regex_destroy(&wordpress_hook_regex);
+  nr_php_wordpress_plugin_cache_destroy();
+}
+
+void nr_wordpress_txn_end_metrics(nrtxn_t* txn TSRMLS_DC) {
+  nr_php_wordpress_hook_aggregate_metrics(txn ? txn->unscoped_metrics : NULL
+                                              TSRMLS_CC);
+  nr_wordpress_plugin_cache_metrics(txn TSRMLS_CC);
+}
+
+void nr_wordpress_plugin_cache_metrics(nrtxn_t* txn TSRMLS_DC) {
+  if ((NULL == txn)
+      || ((0 == NRPRG(wordpress_plugin_cache_hits))
+          && (0 == NRPRG(wordpress_plugin_cache_misses)))) {
+    return;
+  }
+
+  nrm_force_add(txn->unscoped_metrics,
+                "Supportability/PHP/WordPress/PluginCache/Hit",
+                NRPRG(wordpress_plugin_cache_hits));
+  nrm_force_add(txn->unscoped_metrics,
+                "Supportability/PHP/WordPress/PluginCache/Miss",
+                NRPRG(wordpress_plugin_cache_misses));
+
+  NRPRG(wordpress_plugin_cache_hits) = 0;
+  NRPRG(wordpress_plugin_cache_misses) = 0;
 }
@@ -38,6 +38,85 @@ char* nr_php_wordpress_plugin_match_matcher(const char* filename);
  */
 char* nr_php_wordpress_theme_match_matcher(const char* filename);
 
+/*
+ * Purpose : Look up a filename in the process-wide plugin/theme attribution
+ *           cache.
+ *
+ * Params  : 1. The site key identifying the WordPress directory layout.
+ *           2. The filename.
+ *           3. The length of the filename.
+ *           4. A pointer that receives a newly allocated copy of the cached
+ *              plugin or theme name. This may be set to NULL if the file was
+ *              cached as not belonging to a plugin or theme.
+ *
+ * Returns : Non-zero if the filename was found in the cache; zero otherwise.
+ */
+extern int nr_php_wordpress_plugin_cache_get(const char* site_key,
+                                             const char* filename,
+                                             size_t filename_len,
+                                             char** plugin_ptr);
+
+/*
+ * Purpose : Store a filename's attribution in the process-wide cache. The
+ *           cache is bounded; reaching a limit flushes the affected entries.
+ *
+ * Params  : 1. The site key identifying the WordPress directory layout.
+ *           2. The filename.
+ *           3. The length of the filename.
+ *           4. The plugin or theme name, which is copied, or NULL.
+ */
+extern void nr_php_wordpress_plugin_cache_set(const char* site_key,
+                                              const char* filename,
+                                              size_t filename_len,
+                                              const char* plugin);
+
+/*
+ * Purpose : Destroy the process-wide plugin/theme attribution cache.
+ */
+extern void nr_php_wordpress_plugin_cache_destroy(void);
+
+/*
+ * Purpose : Accumulate the duration of a hook callback into the per-request
+ *           aggregate table used when newrelic.framework.wordpress.hooks.options
+ *           is "aggregate".
+ *
+ * Params  : 1. The plugin or theme the callback belongs to, or NULL for core.
+ *           2. The hook name.
+ *           3. The duration of the callback.
+ *           4. The exclusive time of the callback: its duration less the time
+ *              spent in the hook callbacks nested within it.
+ */
+extern void nr_php_wordpress_hook_aggregate_add(const char* plugin,
+                                                const char* hook,
+                                                nrtime_t duration,
+                                                nrtime_t exclusive TSRMLS_DC);
+
+/*
+ * Purpose : Add the Framework/WordPress/Hook and Framework/WordPress/Plugin
+ *           metrics for the aggregated hook callbacks to a metric table and
+ *           clear the aggregate table.
+ *
+ * Params  : 1. The metric table. If NULL, the aggregates are discarded.
+ */
+extern void nr_php_wordpress_hook_aggregate_metrics(nrmtable_t* table
+                                                        TSRMLS_DC);
+
+/*
+ * Purpose : Add the plugin cache hit and miss supportability metrics for the
+ *           current request to the transaction and reset the counters.
+ *
+ * Params  : 1. The transaction.
+ */
+extern void nr_wordpress_plugin_cache_metrics(nrtxn_t* txn TSRMLS_DC);
+
+/*
+ * Purpose : Add the WordPress metrics that are accumulated over the request
+ *           rather than on segments to the transaction.
+ *
+ * Params  : 1. The transaction.
+ */
+extern void nr_wordpress_txn_end_metrics(nrtxn_t* txn TSRMLS_DC);
+
 extern void nr_wordpress_minit(void);
 extern void nr_wordpress_mshutdown(void);
 
@@ -365,17 +365,20 @@ NR_PHP_WRAPPER(nr_monolog_logger_addrecord) {
   if (nr_txn_log_forwarding_enabled(NRPRG(txn))) {
     argc = nr_php_get_user_func_arg_count(NR_EXECUTE_ORIG_ARGS TSRMLS_CC);
     message = nr_monolog_get_message(NR_EXECUTE_ORIG_ARGS TSRMLS_CC);
+    api = nr_monolog_version(this_var TSRMLS_CC);
+    timestamp
+        = nr_monolog_get_timestamp(api, argc, NR_EXECUTE_ORIG_ARGS TSRMLS_CC);
 
-    if (nr_txn_log_forwarding_context_data_enabled(NRPRG(txn))) {
+    /* Context data is only converted for events that the transaction would
+     * keep: once its log events are being sampled, most are dropped */
+    if (nr_txn_log_forwarding_context_data_enabled(NRPRG(txn))
+        && nr_txn_log_event_is_admitted(NRPRG(txn), level_name, timestamp)) {
       zval* context_data = nr_monolog_extract_context_data(
           argc, NR_EXECUTE_ORIG_ARGS TSRMLS_CC);
       context_attributes
           = nr_monolog_convert_context_data_to_attributes(context_data);
       nr_php_arg_release(&context_data);
     }
-    api = nr_monolog_version(this_var TSRMLS_CC);
-    timestamp
-        = nr_monolog_get_timestamp(api, argc, NR_EXECUTE_ORIG_ARGS TSRMLS_CC);
     char version[MAJOR_VERSION_LENGTH];
     snprintf(version, sizeof(version), "%d", api);
     nr_txn_suggest_package_supportability_metric(NRPRG(txn), PHP_PACKAGE_NAME,
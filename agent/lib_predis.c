@@ -9,6 +9,7 @@
 #include "php_datastore.h"
 #include "php_execute.h"
 #include "php_hash.h"
+#include "php_redis.h"
 #include "php_wrapper.h"
 #include "fw_hooks.h"
 #include "fw_support.h"
@@ -55,7 +56,10 @@
  *
  * Predis also supports pipelines, where a number of commands are executed in
  * parallel. The agent's limited async support is used to correctly break out
- * each command.
+ * each command. When newrelic.datastore_tracer.redis_batching.enabled is set,
+ * the commands within a pipeline are instead aggregated into a Redis batch
+ * (see php_redis.h), which is reported as a single datastore segment when the
+ * pipeline ends.
  *
  * As a final quirk, WebdisConnection implements an entirely different
  * connection type to interact with Webdis servers. These objects don't use the
@@ -94,6 +98,21 @@ static inline nr_hashmap_t* nr_predis_get_commands(TSRMLS_D) {
   return NRPRG(predis_commands);
 }
 
+/*
+ * Purpose : Return the batch of the Predis pipeline currently being executed.
+ *
+ * Returns : The batch, or NULL if no pipeline is being executed or batching is
+ *           disabled.
+ */
+static inline nr_php_redis_batch_t* nr_predis_get_batch(TSRMLS_D) {
+#if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
+    && !defined OVERWRITE_ZEND_EXECUTE_DATA
+  return (nr_php_redis_batch_t*)nr_stack_get_top(&NRPRG(predis_batches));
+#else
+  return NRPRG(predis_batch);
+#endif /* OAPI */
+}
+
 static void nr_predis_instrument_connection(zval* conn TSRMLS_DC) {
   nr_php_wrap_callable(
       nr_php_find_class_method(Z_OBJCE_P(conn), "readresponse"),
@@ -494,6 +513,7 @@ NR_PHP_WRAPPER(nr_predis_connection_readResponse) {
   zval* command = NULL;
   zval* conn = NULL;
   uint64_t index;
+  nr_php_redis_batch_t* batch = NULL;
   nr_segment_t* segment = NULL;
   nr_segment_datastore_params_t params = {
     .datastore = {
@@ -536,6 +556,18 @@ NR_PHP_WRAPPER(nr_predis_connection_readResponse) {
   params.instance = nr_predis_retrieve_datastore_instance(conn TSRMLS_CC);
   params.operation = operation;
 
+  /*
+   * When batching is enabled, commands within a pipeline are added to the
+   * pipeline's batch rather than being reported individually.
+   */
+  batch = nr_predis_get_batch(TSRMLS_C);
+  if (batch) {
+    nr_php_redis_batch_set_instance(batch, params.instance);
+    nr_php_redis_batch_add_command(batch, operation, duration);
+    nr_php_redis_batch_add_round_trip(batch, *start, *start + duration);
+    goto end;
+  }
+
   /*
    * In normal, non-pipeline use, predis_ctx will be NULL, and everything is
    * reported synchronously.
@@ -710,7 +742,8 @@ NR_PHP_WRAPPER(nr_predis_pipeline_executePipeline) {
    * well, since it looks for the underlying writeRequest() and readResponse()
    * method calls that the pipeline functionality uses. The only thing we need
    * to do is set up the predis_ctx global for this pipeline so that async
-   * contexts are correctly set up.
+   * contexts are correctly set up, and, if batching is enabled, the batch
+   * that the pipeline's commands are added to.
    *
    * We'll save any existing context just in case this is a nested pipeline.
    */
@@ -719,10 +752,19 @@ NR_PHP_WRAPPER(nr_predis_pipeline_executePipeline) {
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
   nr_stack_push(&NRPRG(predis_ctxs),
                 nr_formatf("Predis #" NR_TIME_FMT, nr_get_time()));
+  if (NRINI(redis_batching_enabled)) {
+    nr_stack_push(&NRPRG(predis_batches),
+                  nr_php_redis_batch_create("pipeline"));
+  }
 #else
   char* prev_predis_ctx;
+  nr_php_redis_batch_t* prev_predis_batch;
   prev_predis_ctx = NRPRG(predis_ctx);
+  prev_predis_batch = NRPRG(predis_batch);
   NRPRG(predis_ctx) = nr_formatf("Predis #" NR_TIME_FMT, nr_get_time());
+  if (NRINI(redis_batching_enabled)) {
+    NRPRG(predis_batch) = nr_php_redis_batch_create("pipeline");
+  }
 #endif /* OAPI */
 
   NR_PHP_WRAPPER_CALL;
@@ -738,6 +780,10 @@ NR_PHP_WRAPPER(nr_predis_pipeline_executePipeline) {
     || defined OVERWRITE_ZEND_EXECUTE_DATA
   nr_free(NRPRG(predis_ctx));
   NRPRG(predis_ctx) = prev_predis_ctx;
+  if (NRINI(redis_batching_enabled)) {
+    nr_php_redis_batch_end(&NRPRG(predis_batch), NRPRG(txn));
+    NRPRG(predis_batch) = prev_predis_batch;
+  }
 #endif /* not OAPI */
 }
 NR_PHP_WRAPPER_END
@@ -747,6 +793,12 @@ NR_PHP_WRAPPER_END
 static void predis_executePipeline_handle_stack() {
   char* predis_ctx = (char*)nr_stack_pop(&NRPRG(predis_ctxs));
   nr_free(predis_ctx);
+
+  if (NRINI(redis_batching_enabled)) {
+    nr_php_redis_batch_t* batch
+        = (nr_php_redis_batch_t*)nr_stack_pop(&NRPRG(predis_batches));
+    nr_php_redis_batch_end(&batch, NRPRG(txn));
+  }
 }
 
 NR_PHP_WRAPPER(nr_predis_pipeline_executePipeline_after) {
@@ -75,8 +75,10 @@
  *           entries. The array size is limited to NR_PHP_STACKTRACE_LIMIT.
  *
  * Params  : 1. An optional zval of the point from which to do the trace.
- *              If this is NULL, nr_php_backtrace is used to capture the
- *              current VM position.
+ *              If this is NULL, the current VM position is used: on PHP 7
+ *              and above, the execute data is walked directly, with the same
+ *              frames as nr_php_backtrace, and the JSON of each distinct
+ *              backtrace is cached for the rest of the request.
  *
  * Returns : A newly allocated JSON stack trace string or NULL on error.
  */
@@ -97,6 +99,11 @@ extern char* nr_php_backtrace_to_json(zval* itrace TSRMLS_DC);
 #define NR_PHP_BACKTRACE_LIMIT 20
 extern zval* nr_php_backtrace(TSRMLS_D);
 
+/*
+ * The maximum number of distinct backtraces whose JSON is cached per request.
+ */
+#define NR_PHP_BACKTRACE_CACHE_LIMIT 256
+
 /*
  * Purpose : Write a dump of the current VM position to a file descriptor.
  *
@@ -243,6 +250,24 @@ extern void nr_php_txn_shutdown(TSRMLS_D);
 extern nr_status_t nr_php_txn_end(int ignoretxn,
                                   int in_post_deactivate TSRMLS_DC);
 
+/*
+ * Purpose : Finalise and send the transaction that nr_php_txn_end deferred
+ *           until after the response, if there is one.
+ *
+ *           When newrelic.deferred_txn_finalization is enabled, transactions
+ *           ended by the post-deactivate handler are not sent immediately. In
+ *           ZTS builds they are handed to a finaliser thread; otherwise they
+ *           are kept in NRPRG(deferred_txn) until this function is called from
+ *           the SAPI deactivate callback.
+ */
+extern void nr_php_txn_finalise_deferred(TSRMLS_D);
+
+/*
+ * Purpose : Stop this process's transaction finaliser thread, if it has one,
+ *           once every transaction it holds has been sent.
+ */
+extern void nr_php_txn_finaliser_shutdown(void);
+
 /*
  * Purpose : Check if the given extension is loaded.
  *
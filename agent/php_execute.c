@@ -1075,11 +1075,12 @@ static void nr_php_execute_metadata_init(nr_php_execute_metadata_t* metadata,
 
 #if ZEND_MODULE_API_NO >= ZEND_7_0_X_API_NO /* PHP7+ */
 /*
- * Purpose : If code level metrics are enabled, use the metadata to create agent
- * attributes in the segment with code level metrics.
+ * Purpose : Create agent attributes in the segment with code level metrics.
  *
  * Params  : 1. segment to create and add agent attributes to
- *           2. metadata that will populate the CLM attributes
+ *           2. the namespace, function and filepath, each of which may be
+ *              NULL, and their lengths
+ *           3. the line number of the function
  *
  * Returns : void
  *
@@ -1089,21 +1090,15 @@ static void nr_php_execute_metadata_init(nr_php_execute_metadata_t* metadata,
  *       as the "function" name.
  *       Current CLM functionality only works with PHP 7+
  */
-static inline void nr_php_execute_segment_add_code_level_metrics(
+static void nr_php_execute_segment_add_code_level_metrics_attributes(
     nr_segment_t* segment,
-    const nr_php_execute_metadata_t* metadata) {
-  /*
-   * Check if code level metrics are enabled in the ini.
-   * If they aren't, exit and don't add any attributes.
-   */
-  if (!NRINI(code_level_metrics_enabled)) {
-    return;
-  }
-
-  if (NULL == metadata) {
-    return;
-  }
-
+    const char* namespace,
+    size_t namespace_len,
+    const char* function,
+    size_t function_len,
+    const char* filepath,
+    size_t filepath_len,
+    uint32_t function_lineno) {
   if (NULL == segment) {
     return;
   }
@@ -1128,28 +1123,13 @@ static inline void nr_php_execute_segment_add_code_level_metrics(
     s = NULL;                       \
   }
 
-  const char* namespace = NULL;
-  const char* function = NULL;
-  const char* filepath = NULL;
-
-  if (NULL != metadata->scope) {
-    namespace = ZSTR_VAL(metadata->scope);
-    CHK_CLM_STRLEN(namespace, ZSTR_LEN(metadata->scope));
-  }
-
-  if (NULL != metadata->function) {
-    function = ZSTR_VAL(metadata->function);
-    CHK_CLM_STRLEN(function, ZSTR_LEN(metadata->function));
-  }
-
-  if (NULL != metadata->filepath) {
-    filepath = ZSTR_VAL(metadata->filepath);
-    CHK_CLM_STRLEN(filepath, ZSTR_LEN(metadata->filepath));
-  }
+  CHK_CLM_STRLEN(namespace, namespace_len);
+  CHK_CLM_STRLEN(function, function_len);
+  CHK_CLM_STRLEN(filepath, filepath_len);
 
 #undef CHK_CLM_STRLEN
 
-  if (1 == metadata->function_lineno) {
+  if (1 == function_lineno) {
     /*
      * It's a file.  For CLM purposes, the "function" name is the filepath.
      */
@@ -1209,7 +1189,72 @@ static inline void nr_php_execute_segment_add_code_level_metrics(
   }
 
   nr_attributes_agent_add_long(segment->attributes, CLM_ATTRIBUTE_DESTINATION,
-                               "code.lineno", metadata->function_lineno);
+                               "code.lineno", function_lineno);
+}
+
+
+/*
+ * Purpose : Add the code level metrics attributes from the metadata. This is
+ *           the add callback of the segment's deferred attributes: see
+ *           nr_php_execute_segment_add_code_level_metrics().
+ */
+static void nr_php_execute_code_level_metrics_add(nr_segment_t* segment,
+                                                  void* data) {
+  const nr_php_execute_metadata_t* metadata
+      = (const nr_php_execute_metadata_t*)data;
+
+  if (NULL == metadata) {
+    return;
+  }
+
+  nr_php_execute_segment_add_code_level_metrics_attributes(
+      segment, metadata->scope ? ZSTR_VAL(metadata->scope) : NULL,
+      metadata->scope ? ZSTR_LEN(metadata->scope) : 0,
+      metadata->function ? ZSTR_VAL(metadata->function) : NULL,
+      metadata->function ? ZSTR_LEN(metadata->function) : 0,
+      metadata->filepath ? ZSTR_VAL(metadata->filepath) : NULL,
+      metadata->filepath ? ZSTR_LEN(metadata->filepath) : 0,
+      metadata->function_lineno);
+}
+
+/*
+ * Code level metrics whose strings have been copied into the transaction's
+ * trace string pool, so that they no longer depend on the request. Each
+ * string is a pool index, or 0 if it isn't set.
+ */
+typedef struct _nr_php_execute_pooled_clm_t {
+  int scope;
+  int function;
+  int filepath;
+  uint32_t function_lineno;
+} nr_php_execute_pooled_clm_t;
+
+static void nr_php_execute_pooled_code_level_metrics_add(nr_segment_t* segment,
+                                                         void* data) {
+  const nr_php_execute_pooled_clm_t* clm
+      = (const nr_php_execute_pooled_clm_t*)data;
+  const nrpool_t* pool;
+
+  if (NULL == clm || NULL == segment || NULL == segment->txn) {
+    return;
+  }
+
+#define POOLED_STR(idx) nr_string_get(pool, (idx))
+#define POOLED_LEN(idx) ((idx) ? (size_t)nr_string_len(pool, (idx)) : 0)
+
+  pool = segment->txn->trace_strings;
+  nr_php_execute_segment_add_code_level_metrics_attributes(
+      segment, POOLED_STR(clm->scope), POOLED_LEN(clm->scope),
+      POOLED_STR(clm->function), POOLED_LEN(clm->function),
+      POOLED_STR(clm->filepath), POOLED_LEN(clm->filepath),
+      clm->function_lineno);
+
+#undef POOLED_STR
+#undef POOLED_LEN
+}
+
+static void nr_php_execute_pooled_code_level_metrics_dtor(void* data) {
+  nr_free(data);
 }
 
 #endif
@@ -1272,6 +1317,111 @@ static inline void nr_php_execute_metadata_release(
 #endif /* PHP7 */
 }
 
+#if ZEND_MODULE_API_NO >= ZEND_7_0_X_API_NO /* PHP7+ */
+static void nr_php_execute_code_level_metrics_dtor(void* data) {
+  nr_php_execute_metadata_t* metadata = (nr_php_execute_metadata_t*)data;
+
+  nr_php_execute_metadata_release(metadata);
+  nr_free(metadata);
+}
+
+static const nr_segment_deferred_attributes_t
+    nr_php_execute_pooled_clm_callbacks = {
+        .add = nr_php_execute_pooled_code_level_metrics_add,
+        .dtor = nr_php_execute_pooled_code_level_metrics_dtor,
+};
+
+/*
+ * Copy the metadata strings into the transaction's trace string pool, so that
+ * the attributes can still be added once the request has ended. This is the
+ * detach callback of the segment's deferred attributes.
+ */
+static void* nr_php_execute_code_level_metrics_detach(nr_segment_t* segment,
+                                                      void* data) {
+  const nr_php_execute_metadata_t* metadata
+      = (const nr_php_execute_metadata_t*)data;
+  nr_php_execute_pooled_clm_t* clm;
+  nrpool_t* pool;
+
+  if (NULL == metadata || NULL == segment || NULL == segment->txn) {
+    return NULL;
+  }
+
+  pool = segment->txn->trace_strings;
+  clm = nr_zalloc(sizeof(nr_php_execute_pooled_clm_t));
+  if (metadata->scope) {
+    clm->scope = nr_string_add(pool, ZSTR_VAL(metadata->scope));
+  }
+  if (metadata->function) {
+    clm->function = nr_string_add(pool, ZSTR_VAL(metadata->function));
+  }
+  if (metadata->filepath) {
+    clm->filepath = nr_string_add(pool, ZSTR_VAL(metadata->filepath));
+  }
+  clm->function_lineno = metadata->function_lineno;
+
+  return clm;
+}
+
+static const nr_segment_deferred_attributes_t nr_php_execute_clm_callbacks = {
+    .add = nr_php_execute_code_level_metrics_add,
+    .dtor = nr_php_execute_code_level_metrics_dtor,
+    .detach = nr_php_execute_code_level_metrics_detach,
+    .detached = &nr_php_execute_pooled_clm_callbacks,
+};
+
+/*
+ * Purpose : If code level metrics are enabled, arrange for the segment to get
+ *           code level metrics attributes.
+ *
+ * Params  : 1. segment to add the code level metrics to
+ *           2. metadata that will populate the CLM attributes
+ *
+ * Note    : Most segments are never kept in the trace or turned into span
+ *           events, so the attributes are deferred until they're needed. The
+ *           segment only keeps its own reference to each of the metadata
+ *           strings until then, which keeps them alive for the rest of the
+ *           request. If the transaction is finalised after the request, the
+ *           strings are first copied into the transaction.
+ */
+static inline void nr_php_execute_segment_add_code_level_metrics(
+    nr_segment_t* segment,
+    const nr_php_execute_metadata_t* metadata) {
+  nr_php_execute_metadata_t* deferred;
+
+  /*
+   * Check if code level metrics are enabled in the ini.
+   * If they aren't, exit and don't add any attributes.
+   */
+  if (!NRINI(code_level_metrics_enabled)) {
+    return;
+  }
+
+  if (NULL == metadata || NULL == segment) {
+    return;
+  }
+
+  if (NULL == metadata->function && NULL == metadata->filepath) {
+    return;
+  }
+
+  deferred = nr_malloc(sizeof(nr_php_execute_metadata_t));
+  *deferred = *metadata;
+  if (deferred->scope) {
+    zend_string_addref(deferred->scope);
+  }
+  if (deferred->function) {
+    zend_string_addref(deferred->function);
+  }
+  if (deferred->filepath) {
+    zend_string_addref(deferred->filepath);
+  }
+
+  nr_segment_set_deferred_attributes(segment, &nr_php_execute_clm_callbacks,
+                                     deferred);
+}
+#endif /* PHP7 */
+
 static inline void nr_php_execute_segment_add_metric(
     nr_segment_t* segment,
     const nr_php_execute_metadata_t* metadata,
@@ -9,10 +9,44 @@
 #include "php_explain_pdo_mysql.h"
 #include "php_pdo.h"
 #include "nr_segment_datastore.h"
+#include "util_hashmap.h"
 #include "util_logging.h"
 #include "util_memory.h"
 #include "util_object.h"
+#include "util_sql.h"
 #include "util_strings.h"
+#include "util_threads.h"
+
+/*
+ * The process-wide explain plan cache. EXPLAIN queries are run against the
+ * application's own database, so explaining every execution of a hot slow
+ * query adds load exactly where it is already a problem. Plans are instead
+ * cached as JSON by datastore instance and normalized SQL id, and reused until
+ * newrelic.transaction_tracer.explain_cache_ttl has elapsed.
+ *
+ * The cache is bounded by newrelic.transaction_tracer.explain_cache_size. As
+ * with the WordPress plugin cache, it is flushed once full rather than
+ * tracking recency: the set of slow queries is small and stable.
+ */
+typedef struct _nr_php_explain_plan_cache_entry_t {
+  char* plan_json;
+  nrtime_t expires; /* When the entry must no longer be used */
+} nr_php_explain_plan_cache_entry_t;
+
+static nr_hashmap_t* explain_plan_cache;
+static nrthread_mutex_t explain_plan_cache_mutex = NRTHREAD_MUTEX_INITIALIZER;
+
+static void nr_php_explain_plan_cache_entry_destroy(void* value) {
+  nr_php_explain_plan_cache_entry_t* entry
+      = (nr_php_explain_plan_cache_entry_t*)value;
+
+  if (NULL == entry) {
+    return;
+  }
+
+  nr_free(entry->plan_json);
+  nr_free(entry);
+}
 
 nr_status_t nr_php_explain_add_value_to_row(const zval* zv, nrobj_t* row) {
   if ((NULL == zv) || (NULL == row)) {
@@ -177,7 +211,8 @@ nr_explain_plan_t* nr_php_explain_pdo_statement(nrtxn_t* txn,
     NRTXNGLOBAL(generating_explain_plan) = 1;
     explain_start = nr_get_time();
 
-    plan = nr_php_explain_pdo_mysql_statement(stmt, parameters TSRMLS_CC);
+    plan = nr_php_explain_pdo_mysql_statement(txn, stmt,
+                                              parameters TSRMLS_CC);
 
     explain_stop = nr_get_time();
     NRTXNGLOBAL(generating_explain_plan) = 0;
@@ -198,3 +233,105 @@ int nr_php_explain_wanted(const nrtxn_t* txn, nrtime_t duration TSRMLS_DC) {
   return ((0 == NRTXNGLOBAL(generating_explain_plan))
           && nr_segment_potential_explain_plan(txn, duration));
 }
+
+char* nr_php_explain_plan_cache_key(const nr_datastore_instance_t* instance,
+                                    const char* sql TSRMLS_DC) {
+  char* obfuscated;
+  uint32_t id;
+
+  if ((NULL == instance) || (NULL == sql)) {
+    return NULL;
+  }
+
+  if ((0 == NRINI(explain_cache_ttl)) || (0 == NRINI(explain_cache_size))) {
+    return NULL;
+  }
+
+  obfuscated = nr_sql_obfuscate(sql);
+  id = nr_sql_normalized_id(obfuscated);
+  nr_free(obfuscated);
+
+  if (0 == id) {
+    return NULL;
+  }
+
+  return nr_formatf("%s|%s|%s|%u", NRSAFESTR(instance->host),
+                    NRSAFESTR(instance->port_path_or_id),
+                    NRSAFESTR(instance->database_name), (unsigned int)id);
+}
+
+nr_explain_plan_t* nr_php_explain_plan_cache_get(const nrtxn_t* txn,
+                                                 const char* key) {
+  nr_php_explain_plan_cache_entry_t* entry = NULL;
+  nr_explain_plan_t* plan = NULL;
+  char* plan_json = NULL;
+
+  if (NULL == key) {
+    return NULL;
+  }
+
+  nrt_mutex_lock(&explain_plan_cache_mutex);
+  if (nr_hashmap_get_into(explain_plan_cache, key, nr_strlen(key),
+                          (void**)&entry)) {
+    if (nr_get_time() < entry->expires) {
+      plan_json = nr_strdup(entry->plan_json);
+    } else {
+      nr_hashmap_delete(explain_plan_cache, key, nr_strlen(key));
+    }
+  }
+  nrt_mutex_unlock(&explain_plan_cache_mutex);
+
+  /*
+   * The plan is rebuilt outside of the lock: the JSON copy is owned by this
+   * request.
+   */
+  plan = nr_explain_plan_create_from_json(plan_json);
+  nr_free(plan_json);
+
+  if (txn) {
+    nrm_force_add(txn->unscoped_metrics,
+                  plan ? "Supportability/DatabaseUtils/ExplainPlanCache/Hit"
+                       : "Supportability/DatabaseUtils/ExplainPlanCache/Miss",
+                  0);
+  }
+
+  return plan;
+}
+
+void nr_php_explain_plan_cache_add(const char* key,
+                                   const nr_explain_plan_t* plan TSRMLS_DC) {
+  nr_php_explain_plan_cache_entry_t* entry = NULL;
+  size_t key_len;
+
+  if ((NULL == key) || (NULL == plan)) {
+    return;
+  }
+
+  entry = (nr_php_explain_plan_cache_entry_t*)nr_malloc(
+      sizeof(nr_php_explain_plan_cache_entry_t));
+  entry->plan_json = nr_explain_plan_to_json(plan);
+  entry->expires = nr_get_time() + NRINI(explain_cache_ttl);
+  key_len = nr_strlen(key);
+
+  nrt_mutex_lock(&explain_plan_cache_mutex);
+  if (NULL == explain_plan_cache) {
+    explain_plan_cache
+        = nr_hashmap_create(nr_php_explain_plan_cache_entry_destroy);
+  } else if (nr_hashmap_count(explain_plan_cache)
+             >= (size_t)NRINI(explain_cache_size)) {
+    nrl_verbosedebug(NRL_SQL, "%s: explain plan cache is full; flushing",
+                     __func__);
+    nr_hashmap_destroy(&explain_plan_cache);
+    explain_plan_cache
+        = nr_hashmap_create(nr_php_explain_plan_cache_entry_destroy);
+  }
+
+  nr_hashmap_update(explain_plan_cache, key, key_len, entry);
+  nrt_mutex_unlock(&explain_plan_cache_mutex);
+}
+
+void nr_php_explain_plan_cache_destroy(void) {
+  nrt_mutex_lock(&explain_plan_cache_mutex);
+  nr_hashmap_destroy(&explain_plan_cache);
+  nrt_mutex_unlock(&explain_plan_cache_mutex);
+}
@@ -9,6 +9,7 @@
 #ifndef PHP_EXPLAIN_HDR
 #define PHP_EXPLAIN_HDR
 
+#include "nr_datastore_instance.h"
 #include "nr_explain.h"
 
 /*
@@ -65,4 +66,48 @@ extern nr_explain_plan_t* nr_php_explain_pdo_statement(nrtxn_t* txn,
 extern int nr_php_explain_wanted(const nrtxn_t* txn,
                                  nrtime_t duration TSRMLS_DC);
 
+/*
+ * Purpose : Build the key of a query in the process-wide explain plan cache.
+ *
+ * Params  : 1. The datastore instance the query was sent to.
+ *           2. The SQL of the query.
+ *
+ * Returns : A newly allocated key, or NULL if the query can't be cached or the
+ *           cache is disabled.
+ *
+ * Note    : Queries that only differ in their literal values share a key, as
+ *           the key is built from the normalized SQL id.
+ */
+extern char* nr_php_explain_plan_cache_key(
+    const nr_datastore_instance_t* instance,
+    const char* sql TSRMLS_DC);
+
+/*
+ * Purpose : Look up an explain plan in the process-wide explain plan cache.
+ *
+ * Params  : 1. The transaction, which receives a supportability metric for
+ *              the hit or miss.
+ *           2. The key returned by nr_php_explain_plan_cache_key().
+ *
+ * Returns : A newly allocated copy of the cached explain plan, or NULL if
+ *           there is no unexpired plan for the key.
+ */
+extern nr_explain_plan_t* nr_php_explain_plan_cache_get(const nrtxn_t* txn,
+                                                        const char* key);
+
+/*
+ * Purpose : Add an explain plan to the process-wide explain plan cache.
+ *
+ * Params  : 1. The key returned by nr_php_explain_plan_cache_key().
+ *           2. The explain plan, which is copied.
+ */
+extern void nr_php_explain_plan_cache_add(const char* key,
+                                          const nr_explain_plan_t* plan
+                                              TSRMLS_DC);
+
+/*
+ * Purpose : Destroy the process-wide explain plan cache.
+ */
+extern void nr_php_explain_plan_cache_destroy(void);
+
 #endif /* PHP_EXPLAIN_HDR */
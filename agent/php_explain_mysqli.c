@@ -81,6 +81,24 @@ static nr_explain_plan_t* nr_php_explain_mysqli_issue(
     nr_php_object_handle_t handle,
     const char* sql TSRMLS_DC);
 
+/*
+ * Purpose : Return the cached explain plan for the given SQL if there is one,
+ *           otherwise issue an EXPLAIN query and cache the result.
+ *
+ * Params  : 1. The transaction.
+ *           2. The link the SQL was sent to.
+ *           3. The handle of the MySQLi statement, or 0 if there was no
+ *              statement.
+ *           4. The SQL to explain.
+ *
+ * Returns : A newly allocated explain plan, or NULL on error.
+ */
+static nr_explain_plan_t* nr_php_explain_mysqli_issue_cached(
+    const nrtxn_t* txn,
+    zval* link,
+    nr_php_object_handle_t handle,
+    const char* sql TSRMLS_DC);
+
 /*
  * Purpose : Prepare an EXPLAIN query.
  *
@@ -120,7 +138,7 @@ nr_explain_plan_t* nr_php_explain_mysqli_query(const nrtxn_t* txn,
   }
 
   query = nr_strndup(sql, sql_len);
-  plan = nr_php_explain_mysqli_issue(link, 0, query TSRMLS_CC);
+  plan = nr_php_explain_mysqli_issue_cached(txn, link, 0, query TSRMLS_CC);
   nr_free(query);
 
   return plan;
@@ -155,7 +173,7 @@ nr_explain_plan_t* nr_php_explain_mysqli_stmt(const nrtxn_t* txn,
     return NULL;
   }
 
-  plan = nr_php_explain_mysqli_issue(link, handle, query TSRMLS_CC);
+  plan = nr_php_explain_mysqli_issue_cached(txn, link, handle, query TSRMLS_CC);
   nr_free(query);
 
   return plan;
@@ -307,6 +325,29 @@ end:
   return plan;
 }
 
+static nr_explain_plan_t* nr_php_explain_mysqli_issue_cached(
+    const nrtxn_t* txn,
+    zval* link,
+    nr_php_object_handle_t handle,
+    const char* sql TSRMLS_DC) {
+  nr_datastore_instance_t* instance;
+  nr_explain_plan_t* plan;
+  char* key;
+
+  instance = nr_php_mysqli_retrieve_datastore_instance(link TSRMLS_CC);
+  key = nr_php_explain_plan_cache_key(instance, sql TSRMLS_CC);
+
+  plan = nr_php_explain_plan_cache_get(txn, key);
+  if (NULL == plan) {
+    plan = nr_php_explain_mysqli_issue(link, handle, sql TSRMLS_CC);
+    nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
+  }
+
+  nr_free(key);
+
+  return plan;
+}
+
 static nr_explain_plan_t* nr_php_explain_mysqli_issue(
     zval* link,
     nr_php_object_handle_t handle,
@@ -96,7 +96,8 @@ static enum pdo_error_mode set_pdo_silent(zval* dbh TSRMLS_DC);
 
 /* }}} */
 
-nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(zval* stmt,
+nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(const nrtxn_t* txn,
+                                                      zval* stmt,
                                                       zval* parameters
                                                           TSRMLS_DC) {
   zval* dbh = NULL;
@@ -104,6 +105,8 @@ nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(zval* stmt,
   zval* explain_stmt = NULL;
   pdo_stmt_t* pdo_stmt = NULL;
   nr_explain_plan_t* plan = NULL;
+  char* query = NULL;
+  char* key = NULL;
 
   pdo_stmt = nr_php_pdo_get_statement_object(stmt TSRMLS_CC);
   if (NULL == pdo_stmt) {
@@ -130,6 +133,20 @@ nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(zval* stmt,
     goto end;
   }
 
+  /*
+   * Duplicating the connection and explaining the query are both round trips
+   * to the database, so a cached plan is used where there is one.
+   */
+  query = nr_strndup(pdo_query_string, pdo_query_string_len);
+  key = nr_php_explain_plan_cache_key(
+      nr_php_pdo_get_datastore_instance(stmt TSRMLS_CC), query TSRMLS_CC);
+  nr_free(query);
+
+  plan = nr_php_explain_plan_cache_get(txn, key);
+  if (plan) {
+    goto end;
+  }
+
   dbh = &pdo_stmt->database_object_handle;
   dup = nr_php_pdo_duplicate(dbh TSRMLS_CC);
   if (NULL == dup) {
@@ -144,8 +161,10 @@ nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(zval* stmt,
 
   plan = fetch_explain_plan_from_stmt(explain_stmt TSRMLS_CC);
   nr_php_zval_free(&explain_stmt);
+  nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
 
 end:
+  nr_free(key);
   nr_php_zval_free(&dup);
   nr_php_zval_free(&explain_stmt);
 
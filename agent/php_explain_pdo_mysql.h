@@ -12,14 +12,19 @@
 /*
  * Purpose : Returns an explain plan for the given prepared statement.
  *
- * Params  : 1. A PDOStatement object that has been executed.
- *           2. An array of parameters to bind, or NULL to use those previously
+ * Params  : 1. The transaction.
+ *           2. A PDOStatement object that has been executed.
+ *           3. An array of parameters to bind, or NULL to use those previously
  *              bound to the PDOStatement object.
  *
  * Returns : An explain plan, or NULL if no explain plan can be generated.
+ *
+ * Note    : A plan from the process-wide explain plan cache is returned if
+ *           there is one for the statement's query.
  */
-extern nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(zval* stmt,
-                                                             zval* parameters
-                                                                 TSRMLS_DC);
+extern nr_explain_plan_t* nr_php_explain_pdo_mysql_statement(
+    const nrtxn_t* txn,
+    zval* stmt,
+    zval* parameters TSRMLS_DC);
 
 #endif /* PHP_EXPLAIN_PDO_MYSQL_HDR */
@@ -32,6 +32,7 @@ static void nr_php_per_process_globals_dispose(void) {
   nr_free(nr_php_per_process_globals.daemon_auditlog);
   nr_free(nr_php_per_process_globals.daemon_app_timeout);
   nr_free(nr_php_per_process_globals.daemon_start_timeout);
+  nr_free(nr_php_per_process_globals.daemon_connect_cache_file);
   nr_free(nr_php_per_process_globals.udspath);
   nr_free(nr_php_per_process_globals.address_path);
   nr_conn_params_free(nr_php_per_process_globals.daemon_conn_params);
@@ -32,6 +32,7 @@ typedef struct _nrphpglobals_t {
   nrtime_t
       daemon_app_connect_timeout; /* Daemon application connection timeout */
   char* daemon_start_timeout;     /* Daemon startup timeout */
+  char* daemon_connect_cache_file; /* Daemon connect reply cache file */
   char* udspath;      /* Legacy path for daemon, set by newrelic.daemon.port */
   char* address_path; /* Path for daemon, set by newrelic.daemon.address */
   nr_conn_params_t* daemon_conn_params; /* Daemon connection information */
@@ -82,6 +83,10 @@ typedef struct _nrphpglobals_t {
                                     detection has run. Used in conjunction with
                                     composer_api_per_process_detection. */
   char* docker_id; /* 64 byte hex docker ID parsed from /proc/self/mountinfo */
+  int deferred_txn_finalization; /* newrelic.deferred_txn_finalization */
+  nr_txn_finaliser_t* txn_finaliser; /* Finalises transactions off the request
+                                        thread in ZTS builds; created lazily by
+                                        each process that needs it */
 
   /* Original PHP callback pointer contents */
   nrphperrfn_t orig_error_cb;
@@ -91,6 +96,9 @@ typedef struct _nrphpglobals_t {
   /* Original PHP SAPI header callback */
   nrphphdrfn_t orig_header_handler;
 
+  /* Original PHP SAPI deactivate callback */
+  nrphpsapideactivatefn_t orig_sapi_deactivate;
+
   struct {
     uint8_t no_sql_parsing;
     uint8_t show_sql_parsing;
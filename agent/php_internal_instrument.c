@@ -1608,6 +1608,12 @@ NR_INNER_WRAPPER(redis_connect) {
                                                     host, port TSRMLS_CC);
   }
 
+  /*
+   * Batches are keyed by object handle, so a batch left behind by a destroyed
+   * object must not absorb the commands of a new connection reusing it.
+   */
+  nr_php_redis_discard_batch(NR_PHP_INTERNAL_FN_THIS() TSRMLS_CC);
+
   nr_php_instrument_datastore_operation_call(nr_wrapper, NR_DATASTORE_REDIS,
                                              nr_wrapper->extra, instance,
                                              INTERNAL_FUNCTION_PARAM_PASSTHRU);
@@ -1620,6 +1626,7 @@ NR_INNER_WRAPPER(redis_connect) {
 NR_INNER_WRAPPER(redis_close) {
   zval* this_obj = NR_PHP_INTERNAL_FN_THIS();
   nr_php_redis_remove_datastore_instance(this_obj TSRMLS_CC);
+  nr_php_redis_discard_batch(this_obj TSRMLS_CC);
 
   if (nr_zend_call_old_handler(nr_wrapper->oldhandler,
                                INTERNAL_FUNCTION_PARAM_PASSTHRU)) {
@@ -1661,10 +1668,33 @@ NR_INNER_WRAPPER(redis_select) {
  */
 NR_INNER_WRAPPER(redis_function) {
   nr_datastore_instance_t* instance;
+  nr_php_redis_batch_t* batch;
   zval* this_obj = NULL;
+  nrtime_t start;
+  int zcaught = 0;
 
   this_obj = NR_PHP_INTERNAL_FN_THIS();
 
+  /*
+   * In pipeline mode the command is only queued, so it's added to the
+   * connection's batch rather than getting its own segment.
+   */
+  batch = nr_php_redis_get_batch(this_obj TSRMLS_CC);
+  if (batch) {
+    start = nr_txn_now_rel(NRPRG(txn));
+    zcaught = nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                                       INTERNAL_FUNCTION_PARAM_PASSTHRU);
+    nr_php_redis_batch_add_command(
+        batch, nr_wrapper->extra,
+        nr_time_duration(start, nr_txn_now_rel(NRPRG(txn))));
+
+    if (zcaught) {
+      zend_bailout();
+      /* NOTREACHED */
+    }
+    return;
+  }
+
   instance = nr_php_redis_retrieve_datastore_instance(this_obj TSRMLS_CC);
 
   nr_php_instrument_datastore_operation_call(nr_wrapper, NR_DATASTORE_REDIS,
@@ -1672,6 +1702,112 @@ NR_INNER_WRAPPER(redis_function) {
                                              INTERNAL_FUNCTION_PARAM_PASSTHRU);
 }
 
+/*
+ * Handle
+ *   Redis redis::pipeline ()
+ *
+ * In pipeline mode, phpredis queues commands locally and sends them to the
+ * server in a single round trip when redis::exec() is called.
+ */
+NR_INNER_WRAPPER(redis_pipeline) {
+  zval* this_obj = NR_PHP_INTERNAL_FN_THIS();
+
+  if (nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                               INTERNAL_FUNCTION_PARAM_PASSTHRU)) {
+    zend_bailout();
+    /* NOTREACHED */
+  }
+
+  if (nr_php_is_zval_valid_object(return_value)) {
+    nr_php_redis_start_batch(this_obj TSRMLS_CC);
+  }
+}
+
+/*
+ * Handle
+ *   Redis redis::multi ( [ int $mode = Redis::MULTI ] )
+ */
+NR_INNER_WRAPPER(redis_multi) {
+  zend_long mode = 0;
+  zval* this_obj = NR_PHP_INTERNAL_FN_THIS();
+
+  if (FAILURE
+      == zend_parse_parameters_ex(ZEND_PARSE_PARAMS_QUIET,
+                                  ZEND_NUM_ARGS() TSRMLS_CC, "|l", &mode)) {
+    mode = 0;
+  }
+
+  if (nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                               INTERNAL_FUNCTION_PARAM_PASSTHRU)) {
+    zend_bailout();
+    /* NOTREACHED */
+  }
+
+  /*
+   * Only pipeline mode is batched: in the default MULTI mode each command is
+   * still sent to the server as it is called.
+   */
+  if (NR_PHP_REDIS_PIPELINE == mode
+      && nr_php_is_zval_valid_object(return_value)) {
+    nr_php_redis_start_batch(this_obj TSRMLS_CC);
+  }
+}
+
+/*
+ * Handle
+ *   array redis::exec ()
+ */
+NR_INNER_WRAPPER(redis_exec) {
+  nr_datastore_instance_t* instance;
+  nr_php_redis_batch_t* batch;
+  zval* this_obj = NR_PHP_INTERNAL_FN_THIS();
+  nrtime_t start;
+  int zcaught = 0;
+
+  instance = nr_php_redis_retrieve_datastore_instance(this_obj TSRMLS_CC);
+
+  batch = nr_php_redis_get_batch(this_obj TSRMLS_CC);
+  if (NULL == batch) {
+    nr_php_instrument_datastore_operation_call(
+        nr_wrapper, NR_DATASTORE_REDIS, nr_wrapper->extra, instance,
+        INTERNAL_FUNCTION_PARAM_PASSTHRU);
+    return;
+  }
+
+  /*
+   * Sending the queued commands is the pipeline's round trip, so the batch is
+   * reported with the timing of this call.
+   */
+  nr_php_redis_batch_set_instance(batch, instance);
+  start = nr_txn_now_rel(NRPRG(txn));
+  zcaught = nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                                     INTERNAL_FUNCTION_PARAM_PASSTHRU);
+  nr_php_redis_end_batch(this_obj, start,
+                         nr_txn_now_rel(NRPRG(txn)) TSRMLS_CC);
+
+  if (zcaught) {
+    zend_bailout();
+    /* NOTREACHED */
+  }
+}
+
+/*
+ * Handle
+ *   bool redis::discard ()
+ *   redis::__destruct ()
+ */
+NR_INNER_WRAPPER(redis_discard) {
+  zval* this_obj = NR_PHP_INTERNAL_FN_THIS();
+
+  nr_php_redis_discard_batch(this_obj TSRMLS_CC);
+
+  if (nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                               INTERNAL_FUNCTION_PARAM_PASSTHRU)) {
+    zend_bailout();
+    /* NOTREACHED */
+  }
+}
+
 static char* nr_php_prepared_statement_make_pgsql_key(
     const zval* conn,
     const char* stmtname,
@@ -2222,6 +2358,12 @@ NR_INNER_WRAPPER(pdo_construct) {
 
   this_obj = NR_PHP_INTERNAL_FN_THIS();
 
+  /*
+   * The object handle may have belonged to a PDO object that has since been
+   * destroyed, along with its connection.
+   */
+  nr_php_pdo_connection_forget(this_obj TSRMLS_CC);
+
   /*
    * nr_php_pdo_options_save checks both the PDO object and the options array
    * for validity.
@@ -2234,6 +2376,44 @@ NR_INNER_WRAPPER(pdo_construct) {
   }
 }
 
+/*
+ * Handle
+ *   PDO::connect ( string $dsn [, string $username [, string $password [,
+ * array $options ]]] )
+ *
+ * PDO::connect() (added in PHP 8.4) creates the PDO object without calling
+ * PDO::__construct, so the same bookkeeping is done on the returned object.
+ */
+NR_INNER_WRAPPER(pdo_connect) {
+  char* dsn = NULL;
+  nr_string_len_t dsn_len = 0;
+  char* password = NULL;
+  nr_string_len_t password_len = 0;
+  zval* options = NULL;
+  char* username = NULL;
+  nr_string_len_t username_len = 0;
+  int zcaught = 0;
+
+  if (FAILURE
+      == zend_parse_parameters_ex(ZEND_PARSE_PARAMS_QUIET,
+                                  ZEND_NUM_ARGS() TSRMLS_CC, "s|s!s!a!", &dsn,
+                                  &dsn_len, &username, &username_len, &password,
+                                  &password_len, &options)) {
+    options = NULL;
+  }
+
+  zcaught = nr_zend_call_old_handler(nr_wrapper->oldhandler,
+                                     INTERNAL_FUNCTION_PARAM_PASSTHRU);
+
+  nr_php_pdo_connection_forget(return_value TSRMLS_CC);
+  nr_php_pdo_options_save(return_value, options TSRMLS_CC);
+
+  if (zcaught) {
+    zend_bailout();
+    /* NOTREACHED */
+  }
+}
+
 /*
  * Handle
  *   PDO::exec (string)
@@ -3164,7 +3344,9 @@ NR_OUTER_WRAPPER(redis_dbsize)
 NR_OUTER_WRAPPER(redis_decr)
 NR_OUTER_WRAPPER(redis_decrby)
 NR_OUTER_WRAPPER(redis_del)
+NR_OUTER_WRAPPER(redis_discard)
 NR_OUTER_WRAPPER(redis_delete)
+NR_OUTER_WRAPPER(redis_destruct)
 NR_OUTER_WRAPPER(redis_eval)
 NR_OUTER_WRAPPER(redis_evalsha)
 NR_OUTER_WRAPPER(redis_exec)
@@ -3220,6 +3402,7 @@ NR_OUTER_WRAPPER(redis_migrate)
 NR_OUTER_WRAPPER(redis_move)
 NR_OUTER_WRAPPER(redis_mset)
 NR_OUTER_WRAPPER(redis_msetnx)
+NR_OUTER_WRAPPER(redis_multi)
 NR_OUTER_WRAPPER(redis_open)
 NR_OUTER_WRAPPER(redis_pconnect)
 NR_OUTER_WRAPPER(redis_persist)
@@ -3229,6 +3412,7 @@ NR_OUTER_WRAPPER(redis_pfadd)
 NR_OUTER_WRAPPER(redis_pfcount)
 NR_OUTER_WRAPPER(redis_pfmerge)
 NR_OUTER_WRAPPER(redis_ping)
+NR_OUTER_WRAPPER(redis_pipeline)
 NR_OUTER_WRAPPER(redis_popen)
 NR_OUTER_WRAPPER(redis_psetex)
 NR_OUTER_WRAPPER(redis_pttl)
@@ -3325,6 +3509,7 @@ NR_OUTER_WRAPPER(sqlite3_querysingle)
 NR_OUTER_WRAPPER(sqlite3_exec)
 
 NR_OUTER_WRAPPER(pdo_construct)
+NR_OUTER_WRAPPER(pdo_connect)
 NR_OUTER_WRAPPER(pdo_query)
 NR_OUTER_WRAPPER(pdo_exec)
 NR_OUTER_WRAPPER(pdo_prepare)
@@ -3598,7 +3783,11 @@ void nr_php_generate_internal_wrap_records(void) {
   NR_INTERNAL_WRAPREC("redis::eval", redis_eval, redis_function, 0, "eval")
   NR_INTERNAL_WRAPREC("redis::evalsha", redis_evalsha, redis_function, 0,
                       "evalsha")
-  NR_INTERNAL_WRAPREC("redis::exec", redis_exec, redis_function, 0, "exec")
+  NR_INTERNAL_WRAPREC("redis::discard", redis_discard, redis_discard, 0,
+                      "discard")
+  NR_INTERNAL_WRAPREC("redis::__destruct", redis_destruct, redis_discard, 0,
+                      "__destruct")
+  NR_INTERNAL_WRAPREC("redis::exec", redis_exec, redis_exec, 0, "exec")
   NR_INTERNAL_WRAPREC("redis::exists", redis_exists, redis_function, 0,
                       "exists")
   NR_INTERNAL_WRAPREC("redis::expire", redis_expire, redis_function, 0,
@@ -3682,6 +3871,7 @@ void nr_php_generate_internal_wrap_records(void) {
   NR_INTERNAL_WRAPREC("redis::mset", redis_mset, redis_function, 0, "mset")
   NR_INTERNAL_WRAPREC("redis::msetnx", redis_msetnx, redis_function, 0,
                       "msetnx")
+  NR_INTERNAL_WRAPREC("redis::multi", redis_multi, redis_multi, 0, "multi")
   NR_INTERNAL_WRAPREC("redis::persist", redis_persist, redis_function, 0,
                       "persist")
   NR_INTERNAL_WRAPREC("redis::pexpire", redis_pexpire, redis_function, 0,
@@ -3694,6 +3884,8 @@ void nr_php_generate_internal_wrap_records(void) {
   NR_INTERNAL_WRAPREC("redis::pfmerge", redis_pfmerge, redis_function, 0,
                       "pfmerge")
   NR_INTERNAL_WRAPREC("redis::ping", redis_ping, redis_function, 0, "ping")
+  NR_INTERNAL_WRAPREC("redis::pipeline", redis_pipeline, redis_pipeline, 0,
+                      "pipeline")
   NR_INTERNAL_WRAPREC("redis::psetex", redis_psetex, redis_function, 0,
                       "psetex")
   NR_INTERNAL_WRAPREC("redis::pttl", redis_pttl, redis_function, 0, "pttl")
@@ -3846,6 +4038,9 @@ void nr_php_generate_internal_wrap_records(void) {
   NR_INTERNAL_WRAPREC("pdo\\odbc::__construct", pdo_construct, pdo_construct, 0, 0)
   NR_INTERNAL_WRAPREC("pdo\\pgsql::__construct", pdo_construct, pdo_construct, 0, 0)
   NR_INTERNAL_WRAPREC("pdo\\sqlite::__construct", pdo_construct, pdo_construct, 0, 0)
+#endif
+#if ZEND_MODULE_API_NO >= ZEND_8_4_X_API_NO
+  NR_INTERNAL_WRAPREC("pdo::connect", pdo_connect, pdo_connect, 0, 0)
 #endif
   NR_INTERNAL_WRAPREC("pdo::query", pdo_query, pdo_query, 0, 0)
 #if ZEND_MODULE_API_NO >= ZEND_8_4_X_API_NO
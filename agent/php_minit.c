@@ -608,6 +608,8 @@ PHP_MINIT_FUNCTION(newrelic) {
       daemon_args.loglevel = NR_PHP_PROCESS_GLOBALS(daemon_loglevel);
       daemon_args.auditlog = NR_PHP_PROCESS_GLOBALS(daemon_auditlog);
       daemon_args.app_timeout = NR_PHP_PROCESS_GLOBALS(daemon_app_timeout);
+      daemon_args.connect_cache_file
+          = NR_PHP_PROCESS_GLOBALS(daemon_connect_cache_file);
       daemon_args.integration_mode
           = NR_PHP_PROCESS_GLOBALS(daemon_special_integration);
       daemon_args.debug_http
@@ -705,6 +707,15 @@ PHP_MINIT_FUNCTION(newrelic) {
   NR_PHP_PROCESS_GLOBALS(orig_header_handler) = sapi_module.header_handler;
   sapi_module.header_handler = nr_php_header_handler;
 
+  /*
+   * Save the SAPI module deactivate callback so that deferred transactions can
+   * be finalised once it has finished the request.
+   */
+  if (NR_PHP_PROCESS_GLOBALS(deferred_txn_finalization)) {
+    NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate) = sapi_module.deactivate;
+    sapi_module.deactivate = nr_php_sapi_deactivate;
+  }
+
 #define NR_INFO_SPECIAL_FLAGS(field)                  \
   if (NR_PHP_PROCESS_GLOBALS(special_flags).field) {  \
     nrl_info(NRL_INIT, "special_flags." #field "=1"); \
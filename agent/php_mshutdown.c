@@ -9,12 +9,18 @@
 #include <signal.h>
 #include <sys/wait.h>
 
+#include "php_explain.h"
 #include "php_globals.h"
 #include "php_internal_instrument.h"
+#include "php_samplers.h"
 #include "php_user_instrument.h"
 #include "php_vm.h"
 #include "nr_agent.h"
+#include "nr_attributes.h"
+#include "nr_commands.h"
+#include "nr_span_queue.h"
 #include "util_logging.h"
+#include "util_slab.h"
 #include "fw_wordpress.h"
 #include "lib_aws_sdk_php.h"
 
@@ -42,6 +48,8 @@ PHP_MSHUTDOWN_FUNCTION(newrelic) {
   nrl_debug(NRL_INIT, "MSHUTDOWN processing started");
 
   nr_wordpress_mshutdown();
+  nr_php_explain_plan_cache_destroy();
+  nr_php_shutdown_samplers();
 
 #if ZEND_MODULE_API_NO >= ZEND_8_1_X_API_NO /* PHP 8.1+ */
   nr_aws_sdk_mshutdown();
@@ -51,6 +59,32 @@ PHP_MSHUTDOWN_FUNCTION(newrelic) {
   sapi_module.header_handler = NR_PHP_PROCESS_GLOBALS(orig_header_handler);
   NR_PHP_PROCESS_GLOBALS(orig_header_handler) = NULL;
 
+  /* restore deactivate callback */
+  if (nr_php_sapi_deactivate == sapi_module.deactivate) {
+    sapi_module.deactivate = NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate);
+  }
+  NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate) = NULL;
+
+  /*
+   * Send any transactions that are still waiting to be finalised before the
+   * daemon connection and applications go away.
+   */
+  nr_php_txn_finalise_deferred(TSRMLS_C);
+  nr_php_txn_finaliser_shutdown();
+
+  /*
+   * Send the span batches still waiting for the encoder thread, and stop it.
+   */
+  nr_span_queue_encoder_shutdown();
+
+  /*
+   * Release the segment pages, the encoding buffer and the attribute filters
+   * kept for later transactions.
+   */
+  nr_slab_page_cache_clear();
+  nr_cmd_txndata_shutdown();
+  nr_attribute_filter_cache_clear();
+
   nr_agent_close_daemon_connection();
 
   nrl_close_log_file();
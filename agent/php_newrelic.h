@@ -13,6 +13,7 @@
 #include "nr_mysqli_metadata.h"
 #include "nr_segment.h"
 #include "nr_txn.h"
+#include "nr_txn_finaliser.h"
 #include "php_extension.h"
 #include "util_hashmap.h"
 #include "util_matcher.h"
@@ -26,6 +27,7 @@ extern PHP_RINIT_FUNCTION(newrelic);
 extern PHP_RSHUTDOWN_FUNCTION(newrelic);
 extern PHP_MINFO_FUNCTION(newrelic);
 extern int nr_php_post_deactivate(void);
+extern int nr_php_sapi_deactivate(TSRMLS_D);
 
 extern void nr_php_late_initialization(void);
 extern nrobj_t* nr_php_app_settings(void);
@@ -264,6 +266,7 @@ typedef void (*nrphpcufafn_t)(zend_function* func,
 typedef int (*nrphphdrfn_t)(sapi_header_struct* sapi_header,
                             sapi_header_op_enum op,
                             sapi_headers_struct* sapi_headers TSRMLS_DC);
+typedef int (*nrphpsapideactivatefn_t)(TSRMLS_D);
 
 #if ZEND_MODULE_API_NO >= ZEND_7_0_X_API_NO /* PHP 7.0+ */
 typedef void (*nr_php_execute_internal_function_t)(
@@ -325,6 +328,8 @@ bool wordpress_plugins;                /* set based on
                                                  newrelic.framework.wordpress.hooks.options */
 bool wordpress_core;                   /* set based on
                                                  newrelic.framework.wordpress.hooks.options */
+bool wordpress_hooks_aggregate;        /* set based on
+                                                 newrelic.framework.wordpress.hooks.options */
 nrinistr_t
     wordpress_hooks_skip_filename; /* newrelic.framework.wordpress.hooks_skip_filename
                                     */
@@ -382,12 +387,21 @@ nrinibool_t
 nrinibool_t
     database_name_reporting_enabled; /* newrelic.datastore_tracer.database_name_reporting.enabled
                                       */
+nrinibool_t
+    redis_batching_enabled; /* newrelic.datastore_tracer.redis_batching.enabled
+                             */
 /*
  * Cloud relationship settings
  */
 nrinistr_t
     aws_account_id; /* newrelic.cloud.aws.account_id */
 
+/*
+ * Memory sampler settings
+ */
+nriniuint_t memory_sampler_policy;   /* newrelic.memory_sampler.policy */
+nrinitime_t memory_sampler_interval; /* newrelic.memory_sampler.interval */
+
 /*
  * Deprecated settings that control request parameter capture.
  */
@@ -406,6 +420,10 @@ nrinibool_t tt_slowsql;  /* newrelic.transaction_tracer.slow_sql */
 zend_bool tt_threshold_is_apdex_f; /* True if threshold is apdex_f */
 nrinitime_t tt_threshold;          /* newrelic.transaction_tracer.threshold */
 nrinitime_t ep_threshold; /* newrelic.transaction_tracer.explain_threshold */
+nrinitime_t
+    explain_cache_ttl; /* newrelic.transaction_tracer.explain_cache_ttl */
+nriniuint_t
+    explain_cache_size; /* newrelic.transaction_tracer.explain_cache_size */
 nrinitime_t
     ss_threshold; /* newrelic.transaction_tracer.stack_trace_threshold */
 nrinibool_t
@@ -464,6 +482,9 @@ nr_stack_t wordpress_tags;
 nr_stack_t wordpress_tag_states; /* stack of bools indicating
                                     whether the current tag
                                     needs to be released */
+nr_stack_t wordpress_hook_marks; /* stack of the aggregated hook
+                                    exclusive time when each executing
+                                    hook callback began */
 #else
 bool check_cufa; /* Whether we need to check cufa because we are
                     instrumenting hooks, or whether we can skip cufa */
@@ -476,6 +497,17 @@ nr_matcher_t* wordpress_theme_matcher;  /* Matcher for theme filenames */
 nr_matcher_t* wordpress_core_matcher;   /* Matcher for plugin filenames */
 nr_hashmap_t* wordpress_file_metadata;  /* Metadata for plugin and theme names
                                            given a filename */
+char* wordpress_site_key; /* Key of the current site in the process-wide
+                             plugin cache */
+bool wordpress_site_key_unavailable; /* Whether the site key can't be built
+                                        for the rest of the request */
+uint64_t wordpress_plugin_cache_hits;   /* Process-wide plugin cache hits */
+uint64_t wordpress_plugin_cache_misses; /* Process-wide plugin cache misses */
+nr_hashmap_t* wordpress_hook_aggregates; /* Aggregated hook callback timings
+                                            keyed by plugin and hook */
+nrtime_t wordpress_hook_exclusive_time; /* Exclusive time of the hook
+                                          callbacks that have finished when
+                                          aggregating hooks */
 nr_hashmap_t* wordpress_clean_tag_cache; /* Cached clean tags */                                           
 
 char* doctrine_dql; /* The current Doctrine DQL. Only non-NULL while a Doctrine
@@ -484,6 +516,9 @@ char* doctrine_dql; /* The current Doctrine DQL. Only non-NULL while a Doctrine
 int php_cur_stack_depth; /* Total current depth of PHP stack, measured in PHP
                             call frames */
 
+nr_hashmap_t* backtrace_json_cache; /* Backtrace JSON keyed by the frames it
+                                       was built from */
+
 nrphpcufafn_t
     cufa_callback; /* The current call_user_func_array callback, if any */
 
@@ -501,6 +536,8 @@ nr_regex_t* aws_arn_regex; /* The compiled regex to search for ARNs */
 char* mysql_last_conn;
 char* pgsql_last_conn;
 nr_hashmap_t* datastore_connections;
+nr_hashmap_t* pdo_connections; /* Metadata for each PDO connection, indexed by
+                                  the PDO object handle */
 
 nrinibool_t guzzle_enabled; /* newrelic.guzzle.enabled */
 
@@ -630,15 +667,25 @@ nrapp_t* app; /* The application used in the last attempt to initialize a
 
 nrtxn_t* txn; /* The all-important transaction pointer */
 
+nrtxn_t* deferred_txn; /* A completed transaction waiting to be finalised once
+                          the response has been sent; see
+                          nr_php_txn_finalise_deferred() */
+
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
 nr_stack_t predis_ctxs; /* Without OAPI, we are able to utilize the call
                            stack to keep track of the current predis_ctx.
                            WIth OAPI, we must track this manually */
+nr_stack_t predis_batches; /* The batches of the Predis pipelines being
+                              executed when Redis batching is enabled */
 #else
 char* predis_ctx; /* The current Predis pipeline context name, if any */
+struct _nr_php_redis_batch_t* predis_batch; /* The batch of the current Predis
+                                               pipeline, if any */
 #endif
 nr_hashmap_t* predis_commands;
+nr_hashmap_t* redis_batches; /* The batches of phpredis connections in pipeline
+                                mode, indexed by object handle */
 
 nrcallbackfn_t error_group_user_callback; /* The user defined callback for
                                               error group naming */
@@ -7,6 +7,7 @@
 #include "php_globals.h"
 #include "php_hash.h"
 #include "php_internal_instrument.h"
+#include "php_samplers.h"
 #include "php_user_instrument.h"
 
 #include "nr_commands.h"
@@ -18,6 +19,7 @@
 #include "util_json.h"
 #include "util_logging.h"
 #include "util_memory.h"
+#include "util_slab.h"
 #include "util_strings.h"
 #include "util_url.h"
 
@@ -537,6 +539,28 @@ static PHP_INI_MH(nr_preload_framework_library_detection_mh) {
   return SUCCESS;
 }
 
+static PHP_INI_MH(nr_deferred_txn_finalization_mh) {
+  int val;
+
+  (void)entry;
+  (void)NEW_VALUE_LEN;
+  (void)mh_arg1;
+  (void)mh_arg2;
+  (void)mh_arg3;
+  (void)stage;
+  NR_UNUSED_TSRMLS;
+
+  val = nr_bool_from_str(NEW_VALUE);
+
+  if (-1 == val) {
+    return FAILURE;
+  }
+
+  NR_PHP_PROCESS_GLOBALS(deferred_txn_finalization) = val ? 1 : 0;
+
+  return SUCCESS;
+}
+
 static PHP_INI_MH(nr_composer_per_process_detection_mh) {
   int val;
 
@@ -595,6 +619,77 @@ static PHP_INI_MH(nr_loglevel_mh) {
   }
 }
 
+/*
+ * The largest log buffer that may be configured: anything beyond this only
+ * delays messages without saving any further writes.
+ */
+#define NR_PHP_INI_MAX_LOGFILE_BUFFER_SIZE (16 * 1024 * 1024)
+
+static PHP_INI_MH(nr_logfile_buffer_size_mh) {
+  int val = 0;
+
+  (void)entry;
+  (void)mh_arg1;
+  (void)mh_arg2;
+  (void)mh_arg3;
+  (void)stage;
+  NR_UNUSED_TSRMLS;
+
+  if (0 != NEW_VALUE_LEN) {
+    if (NR_FAILURE == nr_strtoi(&val, NEW_VALUE, 0)) {
+      nrl_warning(NRL_INIT,
+                  "invalid newrelic.logfile_buffer_size \"%.16s\"; log "
+                  "buffering disabled",
+                  NEW_VALUE);
+      val = 0;
+    }
+    if (val < 0) {
+      val = 0;
+    } else if (val > NR_PHP_INI_MAX_LOGFILE_BUFFER_SIZE) {
+      val = NR_PHP_INI_MAX_LOGFILE_BUFFER_SIZE;
+    }
+  }
+
+  nrl_set_log_buffer_size((size_t)val);
+
+  return SUCCESS;
+}
+
+/*
+ * The largest value accepted for newrelic.slab_page_cache_size.
+ */
+#define NR_PHP_INI_MAX_SLAB_PAGE_CACHE_SIZE (256 * 1024 * 1024)
+
+static PHP_INI_MH(nr_slab_page_cache_size_mh) {
+  int val = NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT;
+
+  (void)entry;
+  (void)mh_arg1;
+  (void)mh_arg2;
+  (void)mh_arg3;
+  (void)stage;
+  NR_UNUSED_TSRMLS;
+
+  if (0 != NEW_VALUE_LEN) {
+    if (NR_FAILURE == nr_strtoi(&val, NEW_VALUE, 0)) {
+      nrl_warning(NRL_INIT,
+                  "invalid newrelic.slab_page_cache_size \"%.16s\"; using "
+                  "the default",
+                  NEW_VALUE);
+      val = NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT;
+    }
+    if (val < 0) {
+      val = 0;
+    } else if (val > NR_PHP_INI_MAX_SLAB_PAGE_CACHE_SIZE) {
+      val = NR_PHP_INI_MAX_SLAB_PAGE_CACHE_SIZE;
+    }
+  }
+
+  nr_slab_page_cache_set_limit((size_t)val);
+
+  return SUCCESS;
+}
+
 static PHP_INI_MH(nr_daemon_logfile_mh) {
   (void)entry;
   (void)mh_arg1;
@@ -786,6 +881,22 @@ static PHP_INI_MH(nr_daemon_app_timeout_mh) {
   return SUCCESS;
 }
 
+static PHP_INI_MH(nr_daemon_connect_cache_file_mh) {
+  (void)entry;
+  (void)mh_arg1;
+  (void)mh_arg2;
+  (void)mh_arg3;
+  (void)stage;
+  NR_UNUSED_TSRMLS;
+
+  nr_free(NR_PHP_PROCESS_GLOBALS(daemon_connect_cache_file));
+
+  if (NEW_VALUE_LEN > 0) {
+    NR_PHP_PROCESS_GLOBALS(daemon_connect_cache_file) = nr_strdup(NEW_VALUE);
+  }
+  return SUCCESS;
+}
+
 static PHP_INI_MH(nr_daemon_app_connect_timeout_mh) {
   (void)entry;
   (void)mh_arg1;
@@ -1626,6 +1737,43 @@ static PHP_INI_MH(nr_recordsql_mh) {
   return SUCCESS;
 }
 
+static PHP_INI_MH(nr_memory_sampler_policy_mh) {
+  nriniuint_t* p;
+  int val;
+
+#ifndef ZTS
+  char* base = (char*)mh_arg2;
+#else
+  char* base = (char*)ts_resource(*((int*)mh_arg2));
+#endif
+
+  p = (nriniuint_t*)(base + (size_t)mh_arg1);
+
+  (void)entry;
+  (void)mh_arg3;
+  NR_UNUSED_TSRMLS;
+
+  if (0 == NEW_VALUE_LEN) {
+    val = NR_PHP_MEMORY_SAMPLER_ALWAYS;
+  } else {
+    if (0 == nr_stricmp(NEW_VALUE, "always")) {
+      val = NR_PHP_MEMORY_SAMPLER_ALWAYS;
+    } else if (0 == nr_stricmp(NEW_VALUE, "interval")) {
+      val = NR_PHP_MEMORY_SAMPLER_INTERVAL;
+    } else if (0 == nr_stricmp(NEW_VALUE, "rusage")) {
+      val = NR_PHP_MEMORY_SAMPLER_RUSAGE;
+    } else {
+      p->where = 0;
+      return FAILURE;
+    }
+  }
+
+  p->value = (zend_uint)val;
+  p->where = stage;
+
+  return SUCCESS;
+}
+
 static PHP_INI_MH(nr_tt_internal_mh) {
   int val;
 
@@ -1964,12 +2112,19 @@ static PHP_INI_MH(nr_wordpress_hooks_options_mh) {
   if (0 == nr_strcmp(NEW_VALUE, "all_callbacks")) {
     NRPRG(wordpress_plugins) = true;
     NRPRG(wordpress_core) = true;
+    NRPRG(wordpress_hooks_aggregate) = false;
   } else if (0 == nr_strcmp(NEW_VALUE, "plugin_callbacks")) {
     NRPRG(wordpress_plugins) = true;
     NRPRG(wordpress_core) = false;
+    NRPRG(wordpress_hooks_aggregate) = false;
   } else if (0 == nr_strcmp(NEW_VALUE, "threshold")) {
     NRPRG(wordpress_plugins) = false;
     NRPRG(wordpress_core) = false;
+    NRPRG(wordpress_hooks_aggregate) = false;
+  } else if (0 == nr_strcmp(NEW_VALUE, "aggregate")) {
+    NRPRG(wordpress_plugins) = true;
+    NRPRG(wordpress_core) = false;
+    NRPRG(wordpress_hooks_aggregate) = true;
   } else {
     nrl_warning(NRL_INIT, "Invalid %s value \"%s\"; using \"%s\" instead.",
                 ZEND_STRING_VALUE(entry->name), NEW_VALUE,
@@ -2053,6 +2208,11 @@ PHP_INI_ENTRY_EX("newrelic.loglevel",
                  NR_PHP_SYSTEM,
                  nr_loglevel_mh,
                  0)
+PHP_INI_ENTRY_EX("newrelic.logfile_buffer_size",
+                 "0",
+                 NR_PHP_SYSTEM,
+                 nr_logfile_buffer_size_mh,
+                 0)
 
 /*
  * High security mode is a system setting since it affects daemon spawn.
@@ -2082,6 +2242,26 @@ PHP_INI_ENTRY_EX("newrelic.preload_framework_library_detection",
                  nr_preload_framework_library_detection_mh,
                  0)
 
+/*
+ * Finalises and sends transactions after the response has been sent, rather
+ * than before.
+ */
+PHP_INI_ENTRY_EX("newrelic.deferred_txn_finalization",
+                 "0",
+                 NR_PHP_SYSTEM,
+                 nr_deferred_txn_finalization_mh,
+                 0)
+
+/*
+ * The size of the per-process cache of memory pages used to store the
+ * segments of finished transactions for reuse by later ones.
+ */
+PHP_INI_ENTRY_EX("newrelic.slab_page_cache_size",
+                 "4194304",
+                 NR_PHP_SYSTEM,
+                 nr_slab_page_cache_size_mh,
+                 0)
+
 /*
  * Enables per-process Composer API package detection and reporting. Depends on
  * newrelic.vulnerability_management.composer_api.enabled.
@@ -2163,6 +2343,11 @@ PHP_INI_ENTRY_EX("newrelic.daemon.app_timeout",
                  NR_PHP_SYSTEM,
                  nr_daemon_app_timeout_mh,
                  0)
+PHP_INI_ENTRY_EX("newrelic.daemon.connect_cache_file",
+                 "",
+                 NR_PHP_SYSTEM,
+                 nr_daemon_connect_cache_file_mh,
+                 0)
 PHP_INI_ENTRY_EX("newrelic.daemon.app_connect_timeout",
                  "",
                  NR_PHP_SYSTEM,
@@ -2541,6 +2726,22 @@ STD_PHP_INI_ENTRY_EX(
     zend_newrelic_globals,
     newrelic_globals,
     0)
+STD_PHP_INI_ENTRY_EX("newrelic.transaction_tracer.explain_cache_ttl",
+                     "60s",
+                     NR_PHP_SYSTEM,
+                     nr_time_mh,
+                     explain_cache_ttl,
+                     zend_newrelic_globals,
+                     newrelic_globals,
+                     0)
+STD_PHP_INI_ENTRY_EX("newrelic.transaction_tracer.explain_cache_size",
+                     "1000",
+                     NR_PHP_SYSTEM,
+                     nr_unsigned_int_mh,
+                     explain_cache_size,
+                     zend_newrelic_globals,
+                     newrelic_globals,
+                     0)
 STD_PHP_INI_ENTRY_EX(
     "newrelic.transaction_tracer."
     "stack_trace_threshold",
@@ -2781,6 +2982,14 @@ STD_PHP_INI_ENTRY_EX(
     zend_newrelic_globals,
     newrelic_globals,
     nr_enabled_disabled_dh)
+STD_PHP_INI_ENTRY_EX("newrelic.datastore_tracer.redis_batching.enabled",
+                     "0",
+                     NR_PHP_REQUEST,
+                     nr_boolean_mh,
+                     redis_batching_enabled,
+                     zend_newrelic_globals,
+                     newrelic_globals,
+                     nr_enabled_disabled_dh)
 
 /*
  * Library Support
@@ -3193,6 +3402,26 @@ STD_PHP_INI_ENTRY_EX("newrelic.cloud.aws.account_id",
                      newrelic_globals,
                      0)
 
+/*
+ * Memory sampler settings
+ */
+STD_PHP_INI_ENTRY_EX("newrelic.memory_sampler.policy",
+                     "always",
+                     NR_PHP_SYSTEM,
+                     nr_memory_sampler_policy_mh,
+                     memory_sampler_policy,
+                     zend_newrelic_globals,
+                     newrelic_globals,
+                     0)
+STD_PHP_INI_ENTRY_EX("newrelic.memory_sampler.interval",
+                     "1s",
+                     NR_PHP_SYSTEM,
+                     nr_time_mh,
+                     memory_sampler_interval,
+                     zend_newrelic_globals,
+                     newrelic_globals,
+                     0)
+
 /*
  * Messaging API
  */
@@ -220,15 +220,15 @@ const char* nr_php_pdo_get_driver_internal(pdo_dbh_t* dbh) {
 }
 
 const char* nr_php_pdo_get_driver(zval* obj TSRMLS_DC) {
-  pdo_dbh_t* dbh = NULL;
+  const nr_php_pdo_connection_t* conn
+      = nr_php_pdo_get_connection(obj TSRMLS_CC);
 
-  dbh = nr_php_pdo_get_database_object_from_object(obj TSRMLS_CC);
-  if (NULL == dbh) {
+  if (NULL == conn) {
     nrl_verbosedebug(NRL_SQL, "%s: unable to get pdo_dbh_t", __func__);
     return NULL;
   }
 
-  return nr_php_pdo_get_driver_internal(dbh);
+  return conn->driver_name;
 }
 
 nr_datastore_t nr_php_pdo_get_datastore_for_driver(const char* driver_name) {
@@ -257,9 +257,14 @@ nr_datastore_t nr_php_pdo_get_datastore_internal(pdo_dbh_t* dbh) {
 }
 
 nr_datastore_t nr_php_pdo_get_datastore(zval* obj TSRMLS_DC) {
-  pdo_dbh_t* dbh = nr_php_pdo_get_database_object_from_object(obj TSRMLS_CC);
+  const nr_php_pdo_connection_t* conn
+      = nr_php_pdo_get_connection(obj TSRMLS_CC);
 
-  return nr_php_pdo_get_datastore_internal(dbh);
+  if (NULL == conn) {
+    return NR_DATASTORE_PDO;
+  }
+
+  return conn->datastore;
 }
 
 char* nr_php_pdo_datastore_make_key(pdo_dbh_t* dbh) {
@@ -294,10 +299,17 @@ static const struct {
 static const size_t num_instance_handlers
     = sizeof(instance_handlers) / sizeof(instance_handlers[0]);
 
-nr_datastore_instance_t* nr_php_pdo_get_datastore_instance(
-    zval* obj TSRMLS_DC) {
+/*
+ * Purpose : Find or create the datastore instance metadata for a PDO
+ *           connection.
+ *
+ * Params  : 1. The connection.
+ *
+ * Returns : The datastore instance metadata, owned by the request globals.
+ */
+static nr_datastore_instance_t* nr_php_pdo_resolve_datastore_instance(
+    pdo_dbh_t* dbh TSRMLS_DC) {
   nr_datastore_t datastore;
-  pdo_dbh_t* dbh = nr_php_pdo_get_database_object_from_object(obj TSRMLS_CC);
   nr_datastore_instance_t* instance;
   size_t i;
   char* key;
@@ -341,16 +353,95 @@ end:
   return instance;
 }
 
+static void nr_php_pdo_connection_destroy(nr_php_pdo_connection_t* conn) {
+  nr_free(conn);
+}
+
+const nr_php_pdo_connection_t* nr_php_pdo_get_connection(zval* obj TSRMLS_DC) {
+  nr_php_pdo_connection_t* conn = NULL;
+  pdo_dbh_t* dbh = NULL;
+  zval* dbh_obj = NULL;
+
+  if (nr_php_object_instanceof_class(obj, "PDO" TSRMLS_CC)) {
+    dbh = nr_php_pdo_get_database_object_internal(obj TSRMLS_CC);
+    dbh_obj = obj;
+  } else if (nr_php_object_instanceof_class(obj, "PDOStatement" TSRMLS_CC)) {
+    pdo_stmt_t* stmt = nr_php_pdo_get_statement_object_internal(obj TSRMLS_CC);
+
+    if (NULL == stmt) {
+      return NULL;
+    }
+    dbh = stmt->dbh;
+    dbh_obj = &stmt->database_object_handle;
+  }
+
+  if ((NULL == dbh) || !nr_php_is_zval_valid_object(dbh_obj)) {
+    return NULL;
+  }
+
+  if (NRPRG(pdo_connections)) {
+    conn = (nr_php_pdo_connection_t*)nr_hashmap_index_get(
+        NRPRG(pdo_connections), (uint64_t)Z_OBJ_HANDLE_P(dbh_obj));
+
+    /*
+     * Entries are forgotten whenever PDO::__construct or PDO::connect() create
+     * a PDO object. Comparing the pdo_dbh_t is only a backstop for any other
+     * path: a destroyed object's handle and its pdo_dbh_t allocation are
+     * usually reused together.
+     */
+    if (conn && (conn->dbh == dbh)) {
+      return conn;
+    }
+  } else {
+    NRPRG(pdo_connections) = nr_hashmap_create(
+        (nr_hashmap_dtor_func_t)nr_php_pdo_connection_destroy);
+  }
+
+  conn = (nr_php_pdo_connection_t*)nr_malloc(sizeof(nr_php_pdo_connection_t));
+  conn->dbh = dbh;
+  conn->driver_name = nr_php_pdo_get_driver_internal(dbh);
+  conn->datastore = nr_php_pdo_get_datastore_for_driver(conn->driver_name);
+  conn->instance = nr_php_pdo_resolve_datastore_instance(dbh TSRMLS_CC);
+
+  nr_hashmap_index_update(NRPRG(pdo_connections),
+                          (uint64_t)Z_OBJ_HANDLE_P(dbh_obj), conn);
+
+  return conn;
+}
+
+void nr_php_pdo_connection_forget(zval* dbh TSRMLS_DC) {
+  if ((NULL == NRPRG(pdo_connections))
+      || !nr_php_is_zval_valid_object(dbh)) {
+    return;
+  }
+
+  nr_hashmap_index_delete(NRPRG(pdo_connections),
+                          (uint64_t)Z_OBJ_HANDLE_P(dbh));
+}
+
+nr_datastore_instance_t* nr_php_pdo_get_datastore_instance(
+    zval* obj TSRMLS_DC) {
+  const nr_php_pdo_connection_t* conn
+      = nr_php_pdo_get_connection(obj TSRMLS_CC);
+
+  if (NULL == conn) {
+    nrl_verbosedebug(NRL_SQL, "%s: cannot find connection for PDO object",
+                     __func__);
+    return NULL;
+  }
+
+  return conn->instance;
+}
+
 void nr_php_pdo_end_segment_sql(nr_segment_t* segment,
                                 const char* sqlstr,
                                 size_t sqlstrlen,
                                 zval* stmt_obj,
                                 zval* parameters,
                                 bool try_explain TSRMLS_DC) {
-  nr_datastore_t datastore;
-  pdo_dbh_t* dbh
-      = nr_php_pdo_get_database_object_from_object(stmt_obj TSRMLS_CC);
-  nr_datastore_instance_t* instance;
+  const nr_php_pdo_connection_t* conn = NULL;
+  nr_datastore_t datastore = NR_DATASTORE_PDO;
+  nr_datastore_instance_t* instance = NULL;
   nr_explain_plan_t* plan = NULL;
 
   if (try_explain && (NULL != segment)) {
@@ -366,8 +457,11 @@ void nr_php_pdo_end_segment_sql(nr_segment_t* segment,
                                         segment->stop_time TSRMLS_CC);
   }
 
-  datastore = nr_php_pdo_get_datastore_internal(dbh);
-  instance = nr_php_pdo_get_datastore_instance(stmt_obj TSRMLS_CC);
+  conn = nr_php_pdo_get_connection(stmt_obj TSRMLS_CC);
+  if (conn) {
+    datastore = conn->datastore;
+    instance = conn->instance;
+  }
   nr_php_txn_end_segment_sql(&segment, sqlstr, sqlstrlen, plan, datastore,
                              instance TSRMLS_CC);
 
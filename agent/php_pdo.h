@@ -98,6 +98,18 @@ extern nr_datastore_t nr_php_pdo_get_datastore(zval* obj TSRMLS_DC);
 extern nr_datastore_instance_t* nr_php_pdo_get_datastore_instance(
     zval* obj TSRMLS_DC);
 
+/*
+ * Purpose : Forget the connection metadata of a PDO object, so that it is
+ *           resolved again on its next query.
+ *
+ * Params  : 1. The PDO object.
+ *
+ * Note    : This must be called when a PDO object is constructed, as its
+ *           object handle may have belonged to a PDO object that has since
+ *           been destroyed.
+ */
+extern void nr_php_pdo_connection_forget(zval* dbh TSRMLS_DC);
+
 /*
  * Purpose : Create a new SQL trace node for a PDO query.
  *
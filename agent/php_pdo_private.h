@@ -39,6 +39,18 @@ static const nr_php_pdo_datastore_mapping_t nr_php_pdo_datastore_mappings[] = {
     {NULL, NR_DATASTORE_PDO},
 };
 
+/*
+ * The metadata of a PDO connection, which is resolved on the first query on a
+ * PDO object and kept for the rest of the request, indexed by the object
+ * handle of the PDO object.
+ */
+typedef struct _nr_php_pdo_connection_t {
+  const pdo_dbh_t* dbh; /* Used to detect a reused object handle */
+  const char* driver_name;
+  nr_datastore_t datastore;
+  nr_datastore_instance_t* instance; /* Owned by datastore_connections */
+} nr_php_pdo_connection_t;
+
 /*
  * Purpose : Create a unique key for the given PDO connection in a format
  *           usable by the datastore instance implementation.
@@ -50,6 +62,19 @@ static const nr_php_pdo_datastore_mapping_t nr_php_pdo_datastore_mappings[] = {
  */
 extern char* nr_php_pdo_datastore_make_key(pdo_dbh_t* dbh);
 
+/*
+ * Purpose : Return the metadata of the connection behind a PDO or
+ *           PDOStatement object, resolving it if this is the first query on
+ *           the connection.
+ *
+ * Params  : 1. The PDO or PDOStatement object.
+ *
+ * Returns : The connection metadata, which is owned by the request globals,
+ *           or NULL if the object isn't a valid PDO or PDOStatement.
+ */
+extern const nr_php_pdo_connection_t* nr_php_pdo_get_connection(
+    zval* obj TSRMLS_DC);
+
 /*
  * Purpose : Return the pdo_dbh_t struct for either a PDO or PDOStatement
  *           object.
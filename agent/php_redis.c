@@ -8,6 +8,9 @@
 #include "php_datastore.h"
 #include "php_redis.h"
 #include "php_redis_private.h"
+#include "nr_segment_datastore.h"
+#include "util_buffer.h"
+#include "util_logging.h"
 #include "util_system.h"
 
 const uint16_t nr_php_redis_default_port = 6379;
@@ -76,3 +79,277 @@ void nr_php_redis_remove_datastore_instance(const zval* redis_conn TSRMLS_DC) {
   nr_php_datastore_instance_remove(key TSRMLS_CC);
   nr_free(key);
 }
+
+/*
+ * The destinations of the attributes added to a batch segment.
+ */
+#define NR_PHP_REDIS_BATCH_ATTRIBUTE_DESTINATION \
+  (NR_ATTRIBUTE_DESTINATION_TXN_TRACE | NR_ATTRIBUTE_DESTINATION_SPAN)
+
+static void nr_php_redis_batch_op_destroy(void* element,
+                                          void* userdata NRUNUSED) {
+  nr_php_redis_batch_op_t* op = (nr_php_redis_batch_op_t*)element;
+
+  nr_free(op->name);
+  nr_free(op);
+}
+
+nr_php_redis_batch_t* nr_php_redis_batch_create(const char* operation) {
+  nr_php_redis_batch_t* batch = nr_zalloc(sizeof(nr_php_redis_batch_t));
+
+  batch->operation = nr_strdup(operation);
+  nr_vector_init(&batch->ops, 8, nr_php_redis_batch_op_destroy, NULL);
+
+  return batch;
+}
+
+void nr_php_redis_batch_add_command(nr_php_redis_batch_t* batch,
+                                    const char* operation,
+                                    nrtime_t duration) {
+  nr_php_redis_batch_op_t* op = NULL;
+  size_t i;
+  size_t size;
+
+  if (NULL == batch) {
+    return;
+  }
+
+  if (NULL == operation) {
+    operation = "other";
+  }
+
+  /*
+   * A pipeline only uses a handful of distinct operations, so a linear search
+   * of the operations seen so far is cheaper than hashing each command.
+   */
+  size = nr_vector_size(&batch->ops);
+  for (i = 0; i < size; i++) {
+    nr_php_redis_batch_op_t* candidate = nr_vector_get(&batch->ops, i);
+
+    if (0 == nr_strcmp(candidate->name, operation)) {
+      op = candidate;
+      break;
+    }
+  }
+
+  if (NULL == op) {
+    op = nr_zalloc(sizeof(nr_php_redis_batch_op_t));
+    op->name = nr_strdup(operation);
+    op->min = duration;
+    nr_vector_push_back(&batch->ops, op);
+  }
+
+  op->count += 1;
+  op->total += duration;
+  op->sum_of_squares += duration * duration;
+  if (duration < op->min) {
+    op->min = duration;
+  }
+  if (duration > op->max) {
+    op->max = duration;
+  }
+
+  batch->count += 1;
+}
+
+void nr_php_redis_batch_add_round_trip(nr_php_redis_batch_t* batch,
+                                       nrtime_t start,
+                                       nrtime_t stop) {
+  if (NULL == batch || stop < start) {
+    return;
+  }
+
+  if (!batch->sent || start < batch->start) {
+    batch->start = start;
+  }
+  if (!batch->sent || stop > batch->stop) {
+    batch->stop = stop;
+  }
+  batch->sent = true;
+}
+
+void nr_php_redis_batch_set_instance(nr_php_redis_batch_t* batch,
+                                     const nr_datastore_instance_t* instance) {
+  if (NULL == batch || NULL == instance || NULL != batch->instance) {
+    return;
+  }
+
+  batch->instance = nr_datastore_instance_create(
+      instance->host, instance->port_path_or_id, instance->database_name);
+}
+
+char* nr_php_redis_batch_breakdown(const nr_php_redis_batch_t* batch) {
+  nrbuf_t* buf;
+  char* breakdown;
+  size_t i;
+  size_t size;
+
+  if (NULL == batch || 0 == batch->count) {
+    return NULL;
+  }
+
+  buf = nr_buffer_create(128, 128);
+  size = nr_vector_size(&batch->ops);
+  for (i = 0; i < size; i++) {
+    const nr_php_redis_batch_op_t* op
+        = nr_vector_get((nr_vector_t*)&batch->ops, i);
+
+    if (i > 0) {
+      nr_buffer_add(buf, NR_PSTR(","));
+    }
+    nr_buffer_add(buf, op->name, nr_strlen(op->name));
+    nr_buffer_add(buf, NR_PSTR(":"));
+    nr_buffer_write_uint64_t_as_text(buf, (uint64_t)op->count);
+  }
+  nr_buffer_add(buf, NR_PSTR("\0"));
+
+  breakdown = nr_strdup((const char*)nr_buffer_cptr(buf));
+  nr_buffer_destroy(&buf);
+
+  return breakdown;
+}
+
+static void nr_php_redis_batch_report(const nr_php_redis_batch_t* batch,
+                                      nrtxn_t* txn) {
+  nr_segment_t* segment;
+  char* breakdown;
+  size_t i;
+  size_t size;
+  nr_segment_datastore_params_t params = {
+    .datastore = {
+      .type = NR_DATASTORE_REDIS,
+    },
+    .callbacks = {
+      .backtrace = nr_php_backtrace_callback,
+    },
+  };
+
+  if (NULL == batch || NULL == txn || !batch->sent) {
+    return;
+  }
+
+  /*
+   * The operation metrics are unscoped: the batch segment provides the scoped
+   * metric for the round trip as a whole.
+   */
+  size = nr_vector_size(&batch->ops);
+  for (i = 0; i < size; i++) {
+    const nr_php_redis_batch_op_t* op
+        = nr_vector_get((nr_vector_t*)&batch->ops, i);
+    char* name = nr_formatf("Datastore/operation/Redis/%s", op->name);
+
+    nrm_add_internal(0, txn->unscoped_metrics, name, op->count, op->total,
+                     op->total, op->min, op->max, op->sum_of_squares);
+    nr_free(name);
+  }
+
+  segment = nr_segment_start(txn, NULL, NULL);
+  if (NULL == segment) {
+    return;
+  }
+  nr_segment_set_timing(segment, batch->start,
+                        nr_time_duration(batch->start, batch->stop));
+
+  if (NULL == segment->attributes) {
+    segment->attributes = nr_attributes_create(txn->attribute_config);
+  }
+  breakdown = nr_php_redis_batch_breakdown(batch);
+  nr_attributes_agent_add_long(segment->attributes,
+                               NR_PHP_REDIS_BATCH_ATTRIBUTE_DESTINATION,
+                               "db.operation.batch.size",
+                               (long)batch->count);
+  if (breakdown) {
+    nr_attributes_agent_add_string(segment->attributes,
+                                   NR_PHP_REDIS_BATCH_ATTRIBUTE_DESTINATION,
+                                   "db.operation.batch.breakdown", breakdown);
+  }
+  nr_free(breakdown);
+
+  params.operation = batch->operation;
+  params.instance = batch->instance;
+  nr_segment_datastore_end(&segment, &params);
+}
+
+void nr_php_redis_batch_end(nr_php_redis_batch_t** batch_ptr, nrtxn_t* txn) {
+  if (NULL == batch_ptr) {
+    return;
+  }
+
+  nr_php_redis_batch_report(*batch_ptr, txn);
+  nr_php_redis_batch_destroy(batch_ptr);
+}
+
+void nr_php_redis_batch_destroy(nr_php_redis_batch_t** batch_ptr) {
+  nr_php_redis_batch_t* batch;
+
+  if (NULL == batch_ptr || NULL == *batch_ptr) {
+    return;
+  }
+  batch = *batch_ptr;
+
+  nr_free(batch->operation);
+  nr_datastore_instance_destroy(&batch->instance);
+  nr_vector_deinit(&batch->ops);
+  nr_realfree((void**)batch_ptr);
+}
+
+static void nr_php_redis_batch_hashmap_dtor(nr_php_redis_batch_t* batch) {
+  nr_php_redis_batch_destroy(&batch);
+}
+
+nr_php_redis_batch_t* nr_php_redis_get_batch(const zval* redis_conn TSRMLS_DC) {
+  if (!NRINI(redis_batching_enabled) || NULL == NRPRG(redis_batches)
+      || !nr_php_is_zval_valid_object(redis_conn)) {
+    return NULL;
+  }
+
+  return (nr_php_redis_batch_t*)nr_hashmap_index_get(
+      NRPRG(redis_batches), (uint64_t)Z_OBJ_HANDLE_P(redis_conn));
+}
+
+void nr_php_redis_start_batch(const zval* redis_conn TSRMLS_DC) {
+  uint64_t index;
+
+  if (!NRINI(redis_batching_enabled)
+      || !nr_php_is_zval_valid_object(redis_conn)) {
+    return;
+  }
+
+  if (NULL == NRPRG(redis_batches)) {
+    NRPRG(redis_batches) = nr_hashmap_create(
+        (nr_hashmap_dtor_func_t)nr_php_redis_batch_hashmap_dtor);
+  }
+
+  index = (uint64_t)Z_OBJ_HANDLE_P(redis_conn);
+  if (nr_hashmap_index_get(NRPRG(redis_batches), index)) {
+    return;
+  }
+
+  nr_hashmap_index_set(NRPRG(redis_batches), index,
+                       nr_php_redis_batch_create("pipeline"));
+}
+
+void nr_php_redis_end_batch(const zval* redis_conn,
+                            nrtime_t start,
+                            nrtime_t stop TSRMLS_DC) {
+  nr_php_redis_batch_t* batch;
+
+  batch = nr_php_redis_get_batch(redis_conn TSRMLS_CC);
+  if (NULL == batch) {
+    return;
+  }
+
+  nr_php_redis_batch_add_round_trip(batch, start, stop);
+  nr_php_redis_batch_report(batch, NRPRG(txn));
+  nr_php_redis_discard_batch(redis_conn TSRMLS_CC);
+}
+
+void nr_php_redis_discard_batch(const zval* redis_conn TSRMLS_DC) {
+  if (NULL == NRPRG(redis_batches)
+      || !nr_php_is_zval_valid_object(redis_conn)) {
+    return;
+  }
+
+  nr_hashmap_index_delete(NRPRG(redis_batches),
+                          (uint64_t)Z_OBJ_HANDLE_P(redis_conn));
+}
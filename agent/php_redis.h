@@ -7,6 +7,7 @@
 #define PHP_REDIS_HDR
 
 #include "nr_datastore_instance.h"
+#include "nr_txn.h"
 
 /*
  * The default Redis port.
@@ -43,4 +44,129 @@ extern nr_datastore_instance_t* nr_php_redis_retrieve_datastore_instance(
 extern void nr_php_redis_remove_datastore_instance(
     const zval* redis_conn TSRMLS_DC);
 
+/*
+ * The value of the Redis::PIPELINE constant, which may be given to
+ * Redis::multi() to enter pipeline mode.
+ */
+#define NR_PHP_REDIS_PIPELINE 2
+
+/*
+ * Redis batches
+ * =============
+ *
+ * When newrelic.datastore_tracer.redis_batching.enabled is set, the commands
+ * sent to Redis as part of a pipeline are aggregated into a batch instead of
+ * each creating their own datastore segment. When the pipeline ends, the batch
+ * is reported as a single datastore segment covering the round trip, with the
+ * number of commands and a per-operation breakdown as attributes, and with the
+ * operation metrics for each command added to the transaction in one update
+ * per operation.
+ */
+typedef struct _nr_php_redis_batch_t nr_php_redis_batch_t;
+
+/*
+ * Purpose : Create a new Redis batch.
+ *
+ * Params  : 1. The operation name used for the batch segment, such as
+ *              "pipeline".
+ *
+ * Returns : A newly allocated batch, which must be destroyed with
+ *           nr_php_redis_batch_destroy().
+ */
+extern nr_php_redis_batch_t* nr_php_redis_batch_create(const char* operation);
+
+/*
+ * Purpose : Add a command to a Redis batch.
+ *
+ * Params  : 1. The batch.
+ *           2. The operation name of the command, such as "get".
+ *           3. The duration of the command.
+ */
+extern void nr_php_redis_batch_add_command(nr_php_redis_batch_t* batch,
+                                           const char* operation,
+                                           nrtime_t duration);
+
+/*
+ * Purpose : Extend the time covered by a Redis batch to include a round trip
+ *           to the server.
+ *
+ * Params  : 1. The batch.
+ *           2. The start time of the round trip, relative to the transaction.
+ *           3. The stop time of the round trip, relative to the transaction.
+ */
+extern void nr_php_redis_batch_add_round_trip(nr_php_redis_batch_t* batch,
+                                              nrtime_t start,
+                                              nrtime_t stop);
+
+/*
+ * Purpose : Set the datastore instance the commands in a Redis batch were
+ *           sent to, if it hasn't already been set.
+ *
+ * Params  : 1. The batch.
+ *           2. The datastore instance, which is copied.
+ */
+extern void nr_php_redis_batch_set_instance(
+    nr_php_redis_batch_t* batch,
+    const nr_datastore_instance_t* instance);
+
+/*
+ * Purpose : Report a Redis batch as a datastore segment and destroy it.
+ *
+ * Params  : 1. A pointer to the batch.
+ *           2. The transaction.
+ *
+ * Note    : Nothing is reported if no round trip was added to the batch.
+ */
+extern void nr_php_redis_batch_end(nr_php_redis_batch_t** batch_ptr,
+                                   nrtxn_t* txn);
+
+/*
+ * Purpose : Destroy a Redis batch without reporting it.
+ *
+ * Params  : 1. A pointer to the batch.
+ */
+extern void nr_php_redis_batch_destroy(nr_php_redis_batch_t** batch_ptr);
+
+/*
+ * Purpose : Retrieve the batch for a phpredis connection in pipeline mode.
+ *
+ * Params  : 1. The Redis object.
+ *
+ * Returns : The batch, which is owned by the agent, or NULL if the connection
+ *           isn't in pipeline mode or batching is disabled.
+ */
+extern nr_php_redis_batch_t* nr_php_redis_get_batch(
+    const zval* redis_conn TSRMLS_DC);
+
+/*
+ * Purpose : Start a batch for a phpredis connection entering pipeline mode.
+ *           Nothing is done if batching is disabled or the connection already
+ *           has a batch.
+ *
+ * Params  : 1. The Redis object.
+ */
+extern void nr_php_redis_start_batch(const zval* redis_conn TSRMLS_DC);
+
+/*
+ * Purpose : Report and remove the batch for a phpredis connection leaving
+ *           pipeline mode.
+ *
+ * Params  : 1. The Redis object.
+ *           2. The start time of the round trip that sent the batch, relative
+ *              to the transaction.
+ *           3. The stop time of the round trip that sent the batch, relative
+ *              to the transaction.
+ */
+extern void nr_php_redis_end_batch(const zval* redis_conn,
+                                   nrtime_t start,
+                                   nrtime_t stop TSRMLS_DC);
+
+/*
+ * Purpose : Remove the batch for a phpredis connection without reporting it,
+ *           such as when the queued commands are discarded.
+ *
+ * Params  : 1. The Redis object.
+ */
+extern void nr_php_redis_discard_batch(const zval* redis_conn TSRMLS_DC);
+
 #endif /* PHP_REDIS_HDR */
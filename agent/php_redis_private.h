@@ -6,6 +6,8 @@
 #ifndef PHP_REDIS_PRIVATE_HDR
 #define PHP_REDIS_PRIVATE_HDR
 
+#include "util_vector.h"
+
 /*
  * Redis uses database numbers, rather than names. By default, Redis connects
  * to database 0.
@@ -36,4 +38,39 @@ extern nr_datastore_instance_t* nr_php_redis_create_datastore_instance(
     const char* host_or_socket,
     zend_long port);
 
+/*
+ * The aggregated timing of every command in a Redis batch that shares an
+ * operation name. These become the operation metric for that name when the
+ * batch ends.
+ */
+typedef struct _nr_php_redis_batch_op_t {
+  char* name;
+  nrtime_t count;
+  nrtime_t total;
+  nrtime_t min;
+  nrtime_t max;
+  nrtime_t sum_of_squares;
+} nr_php_redis_batch_op_t;
+
+struct _nr_php_redis_batch_t {
+  char* operation;                   /* The operation of the batch segment */
+  nr_datastore_instance_t* instance; /* The instance the batch was sent to */
+  nrtime_t start;                    /* The start of the first round trip */
+  nrtime_t stop;                     /* The end of the last round trip */
+  bool sent;                         /* Whether any round trip was made */
+  uint64_t count;                    /* The number of commands */
+  nr_vector_t ops; /* nr_php_redis_batch_op_t, in order of first use */
+};
+
+/*
+ * Purpose : Create the per-operation breakdown of a Redis batch.
+ *
+ * Params  : 1. The batch.
+ *
+ * Returns : A newly allocated string of the form "get:500,set:500", with the
+ *           operations in the order they were first used, or NULL if the
+ *           batch is empty.
+ */
+extern char* nr_php_redis_batch_breakdown(const nr_php_redis_batch_t* batch);
+
 #endif /* PHP_REDIS_PRIVATE_HDR */
@@ -11,6 +11,7 @@
 #include "php_error.h"
 #include "php_globals.h"
 #include "php_header.h"
+#include "php_redis.h"
 #include "php_user_instrument.h"
 #include "nr_datastore_instance.h"
 #include "nr_txn.h"
@@ -34,6 +35,10 @@ static void str_stack_dtor(void* e, NRUNUSED void* d) {
   char* str = (char*)e;
   nr_free(str);
 }
+static void redis_batch_stack_dtor(void* e, NRUNUSED void* d) {
+  nr_php_redis_batch_t* batch = (nr_php_redis_batch_t*)e;
+  nr_php_redis_batch_destroy(&batch);
+}
 static void zval_stack_dtor(void* e, NRUNUSED void* d) {
   zval* zv = (zval*)e;
   nr_php_zval_free(&zv);
@@ -47,6 +52,13 @@ PHP_RINIT_FUNCTION(newrelic) {
   (void)type;
   (void)module_number;
 
+  /*
+   * A transaction deferred by the previous request is normally finalised by
+   * the SAPI deactivate callback; make sure it can't linger if that didn't
+   * happen.
+   */
+  nr_php_txn_finalise_deferred(TSRMLS_C);
+
   NRPRG(current_framework) = NR_FW_UNSET;
   NRPRG(framework_version) = 0;
   NRPRG(php_cur_stack_depth) = 0;
@@ -122,11 +134,14 @@ PHP_RINIT_FUNCTION(newrelic) {
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
   NRPRG(check_cufa) = false;
   nr_stack_init(&NRPRG(predis_ctxs), NR_STACK_DEFAULT_CAPACITY);
+  nr_stack_init(&NRPRG(predis_batches), NR_STACK_DEFAULT_CAPACITY);
   nr_stack_init(&NRPRG(wordpress_tags), NR_STACK_DEFAULT_CAPACITY);
   nr_stack_init(&NRPRG(wordpress_tag_states), NR_STACK_DEFAULT_CAPACITY);
+  nr_stack_init(&NRPRG(wordpress_hook_marks), NR_STACK_DEFAULT_CAPACITY);
   nr_stack_init(&NRPRG(drupal_invoke_all_hooks), NR_STACK_DEFAULT_CAPACITY);
   nr_stack_init(&NRPRG(drupal_invoke_all_states), NR_STACK_DEFAULT_CAPACITY);
   NRPRG(predis_ctxs).dtor = str_stack_dtor;
+  NRPRG(predis_batches).dtor = redis_batch_stack_dtor;
   NRPRG(drupal_invoke_all_hooks).dtor = zval_stack_dtor;
 #endif
 
@@ -10,6 +10,7 @@
 #include "php_curl_md.h"
 #include "php_error.h"
 #include "php_globals.h"
+#include "php_redis.h"
 #include "php_user_instrument.h"
 #include "php_wrapper.h"
 #include "util_logging.h"
@@ -108,11 +109,19 @@ int nr_php_post_deactivate(void) {
   nr_matcher_destroy(&NRPRG(wordpress_core_matcher));
   nr_matcher_destroy(&NRPRG(wordpress_theme_matcher));
   nr_hashmap_destroy(&NRPRG(wordpress_file_metadata));
+  nr_free(NRPRG(wordpress_site_key));
+  NRPRG(wordpress_site_key_unavailable) = false;
+  nr_hashmap_destroy(&NRPRG(wordpress_hook_aggregates));
+  NRPRG(wordpress_hook_exclusive_time) = 0;
+  NRPRG(wordpress_plugin_cache_hits) = 0;
+  NRPRG(wordpress_plugin_cache_misses) = 0;
   nr_hashmap_destroy(&NRPRG(wordpress_clean_tag_cache));
 
   nr_free(NRPRG(mysql_last_conn));
   nr_free(NRPRG(pgsql_last_conn));
+  nr_hashmap_destroy(&NRPRG(pdo_connections));
   nr_hashmap_destroy(&NRPRG(datastore_connections));
+  nr_hashmap_destroy(&NRPRG(backtrace_json_cache));
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
      && !defined OVERWRITE_ZEND_EXECUTE_DATA
   /*
@@ -121,6 +130,7 @@ int nr_php_post_deactivate(void) {
    */
   nr_stack_destroy_fields(&NRPRG(wordpress_tags));
   nr_stack_destroy_fields(&NRPRG(wordpress_tag_states));
+  nr_stack_destroy_fields(&NRPRG(wordpress_hook_marks));
   nr_stack_destroy_fields(&NRPRG(drupal_invoke_all_hooks));
   nr_stack_destroy_fields(&NRPRG(drupal_invoke_all_states));
 #endif
@@ -128,10 +138,13 @@ int nr_php_post_deactivate(void) {
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA
   nr_stack_destroy_fields(&NRPRG(predis_ctxs));
+  nr_stack_destroy_fields(&NRPRG(predis_batches));
 #else
   nr_free(NRPRG(predis_ctx));
+  nr_php_redis_batch_destroy(&NRPRG(predis_batch));
 #endif /* OAPI */
   nr_hashmap_destroy(&NRPRG(predis_commands));
+  nr_hashmap_destroy(&NRPRG(redis_batches));
 
 #if ZEND_MODULE_API_NO >= ZEND_7_4_X_API_NO
   nr_php_reset_user_instrumentation();
@@ -149,5 +162,34 @@ int nr_php_post_deactivate(void) {
 #endif
 
   nrl_verbosedebug(NRL_INIT, "post-deactivate processing done");
+
+  /*
+   * Write out any log messages buffered during the request, so that they are
+   * never held back while the process waits for its next request.
+   */
+  nrl_flush_log();
+
   return SUCCESS;
 }
+
+/*
+ * This function replaces the SAPI module's deactivate callback, which PHP calls
+ * after the post-deactivate handlers above. SAPIs use that callback to finish
+ * the request: PHP-FPM, for instance, completes the FastCGI response there if
+ * fastcgi_finish_request() hasn't already done so. A transaction that was
+ * deferred by nr_php_txn_end() is finalised once the original callback returns.
+ */
+int nr_php_sapi_deactivate(TSRMLS_D) {
+  int rv = SUCCESS;
+
+  if (NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate)) {
+    rv = NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate)(TSRMLS_C);
+  }
+
+  if (NRPRG(deferred_txn)) {
+    nr_php_txn_finalise_deferred(TSRMLS_C);
+    nrl_flush_log();
+  }
+
+  return rv;
+}
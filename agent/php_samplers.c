@@ -11,6 +11,7 @@
 #include "util_strings.h"
 #include "util_syscalls.h"
 #include "util_system.h"
+#include "util_threads.h"
 
 #ifdef HAVE_SYS_RESOURCE_H
 #include <sys/resource.h>
@@ -28,6 +29,11 @@
 #include <sys/sysctl.h>
 #endif
 
+#if defined(NR_SYSTEM_LINUX) && defined(HAVE_PROC_SELF_STATM)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #ifdef NR_SYSTEM_SOLARIS
 #ifndef _LP64
 #undef _LARGEFILE_SOURCE
@@ -69,26 +75,45 @@ void nr_php_initialize_samplers(void) {
  * if we can't determine the memory usage method, return 0.
  */
 #if defined(NR_SYSTEM_LINUX) && defined(HAVE_PROC_SELF_STATM)
+/*
+ * /proc/self/statm is opened once and reread with pread(), rather than being
+ * opened, read through stdio and closed for every transaction. The descriptor
+ * refers to the process that opened it, so it's reopened in forked children.
+ * Callers must hold memory_sampler_lock.
+ */
+static int statm_fd = -1;
+static int statm_pid = 0;
+
 static int64_t get_physical_memory_used(void) {
-  FILE* fp = fopen("/proc/self/statm", "r");
-  char tmpbuf[1024];
+  char tmpbuf[128];
   char* ptr = NULL;
+  ssize_t len;
+  int pid = nr_getpid();
   int64_t rv;
 
-  if ((FILE*)0 == fp) {
-    nrl_verbosedebug(NRL_MISC, "/proc/self open failed - memory reported as 0");
-    return 0;
+  if ((statm_fd < 0) || (pid != statm_pid)) {
+    if (statm_fd >= 0) {
+      nr_close(statm_fd);
+    }
+
+    statm_fd = nr_open("/proc/self/statm", O_RDONLY | O_CLOEXEC, 0);
+    statm_pid = pid;
+    if (statm_fd < 0) {
+      nrl_verbosedebug(NRL_MISC,
+                       "/proc/self open failed - memory reported as 0");
+      return 0;
+    }
   }
 
-  if ((char*)0 == fgets(tmpbuf, sizeof(tmpbuf), fp)) {
+  len = pread(statm_fd, tmpbuf, sizeof(tmpbuf) - 1, 0);
+  if (len <= 0) {
     nrl_verbosedebug(NRL_MISC, "/proc/self read failed - memory reported as 0");
-    fclose(fp);
+    nr_close(statm_fd);
+    statm_fd = -1;
     return 0;
   }
 
-  fclose(fp);
-
-  tmpbuf[sizeof(tmpbuf) - 1] = 0;
+  tmpbuf[len] = 0;
 
   /*
    * Skip over the first number to get the RSS, but fall back to the full
@@ -106,6 +131,14 @@ static int64_t get_physical_memory_used(void) {
                    (long long int)rv, page_size);
   return (rv * page_size);
 }
+
+static void close_physical_memory_source(void) {
+  if (statm_fd >= 0) {
+    nr_close(statm_fd);
+  }
+  statm_fd = -1;
+  statm_pid = 0;
+}
 #elif defined(NR_SYSTEM_DARWIN)
 static int64_t get_physical_memory_used(void) {
   struct rusage rusage;
@@ -163,6 +196,83 @@ static int64_t get_physical_memory_used(void) {
 #endif
 #endif
 
+#if !defined(NR_SYSTEM_LINUX) || !defined(HAVE_PROC_SELF_STATM)
+static void close_physical_memory_source(void) {}
+#endif
+
+/*
+ * The most recent sample taken under NR_PHP_MEMORY_SAMPLER_INTERVAL. Until
+ * the interval has elapsed, transactions report this sample rather than
+ * reading the current RSS again. The sample is held rather than extrapolated
+ * from earlier ones, since RSS rarely moves in a straight line. It is keyed
+ * on the process, so forked children never report their parent's memory.
+ */
+static struct {
+  int pid;
+  nrtime_t when;
+  int64_t bytes;
+} memory_sample;
+static nrthread_mutex_t memory_sampler_lock = NRTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * ru_maxrss is the peak rather than the current RSS. Linux reports it in
+ * kilobytes; other platforms are scaled as get_physical_memory_used() does.
+ */
+static int64_t get_peak_physical_memory_used(const struct rusage* rusage) {
+  if (NULL == rusage) {
+    return 0;
+  }
+
+#if defined(NR_SYSTEM_LINUX) || defined(NR_SYSTEM_DARWIN)
+  return ((int64_t)rusage->ru_maxrss * 1024);
+#else
+  return ((int64_t)rusage->ru_maxrss * page_size);
+#endif
+}
+
+int64_t nr_php_physical_memory_used(nrtime_t now,
+                                    const struct rusage* rusage TSRMLS_DC) {
+  int64_t bytes;
+  int pid;
+
+  switch (NRINI(memory_sampler_policy)) {
+    case NR_PHP_MEMORY_SAMPLER_RUSAGE:
+      return get_peak_physical_memory_used(rusage);
+
+    case NR_PHP_MEMORY_SAMPLER_INTERVAL:
+      pid = nr_getpid();
+
+      nrt_mutex_lock(&memory_sampler_lock);
+      if ((pid != memory_sample.pid) || (now < memory_sample.when)
+          || (now - memory_sample.when >= NRINI(memory_sampler_interval))) {
+        memory_sample.pid = pid;
+        memory_sample.when = now;
+        memory_sample.bytes = get_physical_memory_used();
+      }
+      bytes = memory_sample.bytes;
+      nrt_mutex_unlock(&memory_sampler_lock);
+
+      return bytes;
+
+    case NR_PHP_MEMORY_SAMPLER_ALWAYS:
+    default:
+      nrt_mutex_lock(&memory_sampler_lock);
+      bytes = get_physical_memory_used();
+      nrt_mutex_unlock(&memory_sampler_lock);
+
+      return bytes;
+  }
+}
+
+void nr_php_shutdown_samplers(void) {
+  nrt_mutex_lock(&memory_sampler_lock);
+  close_physical_memory_source();
+  memory_sample.pid = 0;
+  memory_sample.when = 0;
+  memory_sample.bytes = 0;
+  nrt_mutex_unlock(&memory_sampler_lock);
+}
+
 void nr_php_resource_usage_sampler_start(TSRMLS_D) {
   int ret;
   nrtime_t now = nr_get_time();
@@ -187,7 +297,7 @@ void nr_php_resource_usage_sampler_start(TSRMLS_D) {
 void nr_php_resource_usage_sampler_end(TSRMLS_D) {
   int ret;
   int num_cpus;
-  int64_t mem_used = (get_physical_memory_used() * 1000000) / (1024 * 1024);
+  int64_t mem_used;
   nrtime_t now = nr_get_time();
   int64_t elapsed_time;
   int64_t start_sms;
@@ -200,6 +310,17 @@ void nr_php_resource_usage_sampler_end(TSRMLS_D) {
   int64_t fraction_usage;
   struct rusage rusage;
 
+  ret = getrusage(RUSAGE_SELF, &rusage);
+  if (-1 == ret) {
+    int err = errno;
+    nrl_verbosedebug(NRL_MISC, "getrusage() failed with %d (%.16s)", err,
+                     nr_errno(err));
+  }
+
+  mem_used = nr_php_physical_memory_used(
+      now, (-1 == ret) ? NULL : &rusage TSRMLS_CC);
+  mem_used = (mem_used * 1000000) / (1024 * 1024);
+
   /*
    * A brief note on why we multiply the memory values. The New Relic Platform
    * expects all metrics to be in float fractional seconds (with millisecond
@@ -232,11 +353,7 @@ void nr_php_resource_usage_sampler_end(TSRMLS_D) {
     return;
   }
 
-  ret = getrusage(RUSAGE_SELF, &rusage);
   if (-1 == ret) {
-    int err = errno;
-    nrl_verbosedebug(NRL_MISC, "getrusage() failed with %d (%.16s)", err,
-                     nr_errno(err));
     return;
   }
 
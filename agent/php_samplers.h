@@ -7,11 +7,48 @@
 #ifndef PHP_SAMPLERS_HDR
 #define PHP_SAMPLERS_HDR
 
+#include "util_time.h"
+
+struct rusage;
+
+/*
+ * How physical memory usage is sampled at the end of each transaction
+ * (newrelic.memory_sampler.policy).
+ */
+typedef enum _nr_php_memory_sampler_policy_t {
+  /* Read the current RSS at the end of every transaction */
+  NR_PHP_MEMORY_SAMPLER_ALWAYS = 0,
+  /* Read the current RSS at most once per newrelic.memory_sampler.interval */
+  NR_PHP_MEMORY_SAMPLER_INTERVAL = 1,
+  /* Use the peak RSS reported by getrusage(), which is sampled anyway */
+  NR_PHP_MEMORY_SAMPLER_RUSAGE = 2,
+} nr_php_memory_sampler_policy_t;
+
 /*
  * Purpose : Initialize the system samplers.
  */
 extern void nr_php_initialize_samplers(void);
 
+/*
+ * Purpose : Release any resources held by the system samplers.
+ */
+extern void nr_php_shutdown_samplers(void);
+
+/*
+ * Purpose : Get the physical memory used by this process, following the
+ *           policy set by newrelic.memory_sampler.policy.
+ *
+ * Params  : 1. The current time.
+ *           2. The resource usage of this process, or NULL if getrusage()
+ *              failed.
+ *
+ * Returns : The physical memory used in bytes, or 0 if it couldn't be
+ *           determined.
+ */
+extern int64_t nr_php_physical_memory_used(nrtime_t now,
+                                           const struct rusage* rusage
+                                               TSRMLS_DC);
+
 /*
  * Purpose : Sample system resources and store results so that system usage can
  *           later be properly calculated.
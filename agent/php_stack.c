@@ -9,6 +9,8 @@
 #include "php_hash.h"
 #include "php_agent.h"
 #include "util_buffer.h"
+#include "util_hashmap.h"
+#include "util_memory.h"
 #include "util_number_converter.h"
 #include "util_strings.h"
 #include "util_syscalls.h"
@@ -130,19 +132,356 @@ static char* nr_php_backtrace_to_json_internal(zval* trace TSRMLS_DC) {
   return json;
 }
 
+#ifdef PHP7
+/*
+ * A frame of a backtrace captured by walking the execute data directly. The
+ * strings are only borrowed from the engine, and some of them (such as the
+ * file names of eval()'d code) may be freed and their memory reused while the
+ * request is running, so the cached JSON is keyed on their contents rather
+ * than their addresses.
+ */
+typedef struct _nr_php_backtrace_frame_t {
+  zend_string* class_name; /* NULL if the function isn't a method */
+  zend_string* func_name;  /* NULL for include, require and eval */
+  const char* pseudo_func_name; /* "include", "eval", etc */
+  zend_string* file;            /* NULL if the call site isn't known */
+  uint32_t line;
+} nr_php_backtrace_frame_t;
+
+static inline void nr_php_backtrace_set_file(nr_php_backtrace_frame_t* frame,
+                                             zend_string* file,
+                                             uint32_t line) {
+  frame->file = file;
+  frame->line = line;
+}
+
+static inline bool nr_php_backtrace_is_user_code(const zend_execute_data* ex) {
+  return ex && ex->func && ZEND_USER_CODE(ex->func->common.type);
+}
+
+static uint32_t nr_php_backtrace_lineno(const zend_execute_data* ex) {
+  if (ZEND_HANDLE_EXCEPTION == ex->opline->opcode) {
+    if (EG(opline_before_exception)) {
+      return EG(opline_before_exception)->lineno;
+    }
+    return ex->func->op_array.line_end;
+  }
+
+  return ex->opline->lineno;
+}
+
+/*
+ * Purpose : Find the call site of a function that wasn't called from user
+ *           code. As debug_backtrace() does, this looks through trampolines
+ *           (such as __call) for the user code that called them.
+ */
+static void nr_php_backtrace_indirect_call_site(
+    nr_php_backtrace_frame_t* frame,
+    const zend_execute_data* prev) {
+  while (prev) {
+    const zend_execute_data* up;
+
+    if (prev->func && !ZEND_USER_CODE(prev->func->common.type)
+        && !(prev->func->common.fn_flags & ZEND_ACC_CALL_VIA_TRAMPOLINE)) {
+      return;
+    }
+
+    up = prev->prev_execute_data;
+    if (nr_php_backtrace_is_user_code(up)) {
+      nr_php_backtrace_set_file(frame, up->func->op_array.filename,
+                                up->opline->lineno);
+      return;
+    }
+    prev = up;
+  }
+}
+
+static const char* nr_php_backtrace_include_name(const zend_execute_data* ex) {
+  if (!nr_php_backtrace_is_user_code(ex)
+      || ZEND_INCLUDE_OR_EVAL != ex->opline->opcode) {
+    return NULL;
+  }
+
+  switch (ex->opline->extended_value) {
+    case ZEND_EVAL:
+      return "eval";
+    case ZEND_INCLUDE:
+      return "include";
+    case ZEND_REQUIRE:
+      return "require";
+    case ZEND_INCLUDE_ONCE:
+      return "include_once";
+    case ZEND_REQUIRE_ONCE:
+      return "require_once";
+    default:
+      return NULL;
+  }
+}
+
+/*
+ * Purpose : Capture the current backtrace by walking the execute data, in the
+ *           same way as zend_fetch_debug_backtrace() but without building a
+ *           PHP array.
+ *
+ * Params  : 1. An array of at least limit frames to populate.
+ *           2. The maximum number of frames to inspect.
+ *
+ * Returns : The number of frames populated.
+ */
+static size_t nr_php_backtrace_capture(nr_php_backtrace_frame_t* frames,
+                                       size_t limit) {
+  zend_execute_data* call = EG(current_execute_data);
+  zend_execute_data* prev;
+  bool fake_frame = false;
+  size_t frameno = 0;
+  size_t count = 0;
+
+  nr_memset(frames, 0, sizeof(nr_php_backtrace_frame_t) * limit);
+
+  while (call && frameno < limit) {
+    nr_php_backtrace_frame_t* frame = &frames[count];
+    zend_function* func = call->func;
+
+    prev = call->prev_execute_data;
+    if (NULL == prev) {
+      /*
+       * The {main} code has no frame of its own, but a function called
+       * directly from C does.
+       */
+      if (0 == (ZEND_CALL_INFO(call) & ZEND_CALL_TOP_FUNCTION)) {
+        break;
+      }
+    } else {
+      prev = zend_generator_check_placeholder_frame(prev);
+    }
+
+    frameno++;
+
+    if (nr_php_backtrace_is_user_code(prev)) {
+      nr_php_backtrace_set_file(frame, prev->func->op_array.filename,
+                                nr_php_backtrace_lineno(prev));
+    } else {
+      nr_php_backtrace_indirect_call_site(frame, prev);
+    }
+
+    if (!fake_frame && func && func->common.function_name) {
+      frame->func_name = func->common.function_name;
+      if (func->common.scope) {
+        frame->class_name = func->common.scope->name;
+      } else if (IS_OBJECT == Z_TYPE(call->This)) {
+        frame->class_name = Z_OBJCE(call->This)->name;
+      }
+      count++;
+    } else {
+      frame->pseudo_func_name = nr_php_backtrace_include_name(prev);
+      if (frame->pseudo_func_name) {
+        count++;
+      } else if (nr_php_backtrace_is_user_code(prev)) {
+        frame->pseudo_func_name = "unknown";
+        count++;
+      } else {
+        /*
+         * A dummy frame without a call site is skipped.
+         */
+        nr_memset(frame, 0, sizeof(*frame));
+      }
+    }
+
+    if (ZEND_CALL_TOP_FUNCTION == ZEND_CALL_KIND(call) && !fake_frame
+        && NULL != nr_php_backtrace_include_name(prev)) {
+      fake_frame = true;
+    } else {
+      fake_frame = false;
+      call = prev;
+    }
+  }
+
+  return count;
+}
+
+/*
+ * Purpose : Add a string to a cache key, prefixed by its length so that the
+ *           key can't be mistaken for that of different frames. A NULL string
+ *           is distinct from an empty one.
+ */
+static void nr_php_backtrace_key_add(nrbuf_t* key,
+                                     const char* str,
+                                     size_t len) {
+  uint32_t prefix = str ? (uint32_t)len : UINT32_MAX;
+
+  nr_buffer_add(key, &prefix, sizeof(prefix));
+  if (str) {
+    nr_buffer_add(key, str, (int)len);
+  }
+}
+
+static void nr_php_backtrace_key_add_zstr(nrbuf_t* key,
+                                          const zend_string* str) {
+  if (str) {
+    nr_php_backtrace_key_add(key, ZSTR_VAL(str), ZSTR_LEN(str));
+  } else {
+    nr_php_backtrace_key_add(key, NULL, 0);
+  }
+}
+
+/*
+ * Purpose : Build the cache key of a backtrace from the contents of its
+ *           frames.
+ */
+static void nr_php_backtrace_frames_to_key(
+    nrbuf_t* key,
+    const nr_php_backtrace_frame_t* frames,
+    size_t count) {
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    const nr_php_backtrace_frame_t* frame = &frames[i];
+
+    nr_php_backtrace_key_add_zstr(key, frame->class_name);
+    nr_php_backtrace_key_add_zstr(key, frame->func_name);
+    nr_php_backtrace_key_add(key, frame->pseudo_func_name,
+                             nr_strlen(frame->pseudo_func_name));
+    nr_php_backtrace_key_add_zstr(key, frame->file);
+    nr_buffer_add(key, &frame->line, sizeof(frame->line));
+  }
+}
+
+static char* nr_php_backtrace_frames_to_json(
+    const nr_php_backtrace_frame_t* frames,
+    size_t count) {
+  nrbuf_t* json = nr_buffer_create(1024, 1024);
+  nrbuf_t* buf = nr_buffer_create(256, 256);
+  char* result;
+  size_t i;
+
+  nr_buffer_add(json, NR_PSTR("["));
+
+  for (i = 0; i < count; i++) {
+    const nr_php_backtrace_frame_t* frame = &frames[i];
+
+    /*
+     * Each frame is described as nr_php_stack_iterator() describes the
+     * frames of a PHP backtrace array.
+     */
+    nr_buffer_reset(buf);
+    nr_buffer_add(buf, NR_PSTR(" in "));
+
+    if (frame->class_name && ZSTR_LEN(frame->class_name)) {
+      nr_buffer_add(buf, ZSTR_VAL(frame->class_name),
+                    ZSTR_LEN(frame->class_name));
+      nr_buffer_add(buf, NR_PSTR("::"));
+    }
+
+    if (frame->func_name && ZSTR_LEN(frame->func_name)) {
+      nr_buffer_add(buf, ZSTR_VAL(frame->func_name),
+                    ZSTR_LEN(frame->func_name));
+    } else if (frame->pseudo_func_name) {
+      nr_buffer_add(buf, frame->pseudo_func_name,
+                    nr_strlen(frame->pseudo_func_name));
+    } else {
+      nr_buffer_add(buf, NR_PSTR("?"));
+    }
+
+    nr_buffer_add(buf, NR_PSTR(" called at "));
+
+    if (frame->file && ZSTR_LEN(frame->file)) {
+      nr_buffer_add(buf, ZSTR_VAL(frame->file), ZSTR_LEN(frame->file));
+    } else {
+      nr_buffer_add(buf, NR_PSTR("?"));
+    }
+
+    if (frame->file) {
+      nr_buffer_add(buf, NR_PSTR(" ("));
+      nr_buffer_write_uint64_t_as_text(buf, frame->line);
+      nr_buffer_add(buf, NR_PSTR(")"));
+    } else {
+      nr_buffer_add(buf, NR_PSTR(" (?)"));
+    }
+
+    nr_buffer_add(buf, "\0", 1);
+
+    if (i > 0) {
+      nr_buffer_add(json, NR_PSTR(","));
+    }
+    nr_buffer_add_escape_json(json, (const char*)nr_buffer_cptr(buf));
+  }
+
+  nr_buffer_add(json, NR_PSTR("]"));
+  nr_buffer_add(json, "\0", 1);
+
+  result = nr_strdup((const char*)nr_buffer_cptr(json));
+
+  nr_buffer_destroy(&buf);
+  nr_buffer_destroy(&json);
+
+  return result;
+}
+
+/*
+ * Purpose : Produce the JSON for the current backtrace, reusing the JSON of
+ *           an identical backtrace captured earlier in the request.
+ */
+static char* nr_php_backtrace_walk_to_json(void) {
+  nr_php_backtrace_frame_t frames[NR_PHP_BACKTRACE_LIMIT];
+  nrbuf_t* key;
+  size_t count;
+  size_t key_len;
+  char* json = NULL;
+
+  count = nr_php_backtrace_capture(frames, NR_PHP_BACKTRACE_LIMIT);
+  if (0 == count) {
+    return nr_strdup("[]");
+  }
+
+  key = nr_buffer_create(1024, 1024);
+  nr_php_backtrace_frames_to_key(key, frames, count);
+  key_len = (size_t)nr_buffer_len(key);
+
+  if (NRPRG(backtrace_json_cache)
+      && nr_hashmap_get_into(NRPRG(backtrace_json_cache),
+                             (const char*)nr_buffer_cptr(key), key_len,
+                             (void**)&json)) {
+    nr_buffer_destroy(&key);
+    return nr_strdup(json);
+  }
+
+  json = nr_php_backtrace_frames_to_json(frames, count);
+
+  if (NULL == NRPRG(backtrace_json_cache)) {
+    NRPRG(backtrace_json_cache)
+        = nr_hashmap_create((nr_hashmap_dtor_func_t)nr_hashmap_dtor_str);
+  }
+  if (nr_hashmap_count(NRPRG(backtrace_json_cache))
+      < NR_PHP_BACKTRACE_CACHE_LIMIT) {
+    nr_hashmap_set(NRPRG(backtrace_json_cache),
+                   (const char*)nr_buffer_cptr(key), key_len, nr_strdup(json));
+  }
+
+  nr_buffer_destroy(&key);
+
+  return json;
+}
+#endif /* PHP7 */
+
 char* nr_php_backtrace_to_json(zval* itrace TSRMLS_DC) {
+#ifndef PHP7
   zval* trace;
   char* json;
+#endif /* !PHP7 */
 
   if (itrace) {
     return nr_php_backtrace_to_json_internal(itrace TSRMLS_CC);
   }
 
+#ifdef PHP7
+  return nr_php_backtrace_walk_to_json();
+#else
   trace = nr_php_backtrace(TSRMLS_C);
   json = nr_php_backtrace_to_json_internal(trace TSRMLS_CC);
   nr_php_zval_free(&trace);
 
   return json;
+#endif /* PHP7 */
 }
 
 zval* nr_php_backtrace(TSRMLS_D) {
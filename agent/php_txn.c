@@ -23,8 +23,10 @@
 #include "nr_rum.h"
 #include "nr_segment_children.h"
 #include "nr_txn.h"
+#include "nr_txn_finaliser.h"
 #include "nr_version.h"
 #include "fw_support.h"
+#include "fw_wordpress.h"
 #include "util_labels.h"
 #include "util_logging.h"
 #include "util_memory.h"
@@ -32,6 +34,7 @@
 #include "util_number_converter.h"
 #include "util_sleep.h"
 #include "util_strings.h"
+#include "util_threads.h"
 
 static void nr_php_collect_x_request_start(TSRMLS_D) {
   char* x_request_start;
@@ -882,6 +885,7 @@ nr_status_t nr_php_txn_begin(const char* appnames,
   int pfd;
   nrobj_t* log_forwarding_labels = NULL;
   nr_attribute_config_t* attribute_config;
+  nr_txn_app_snapshot_t app_snapshot;
   nr_app_info_t info;
   bool is_cli = (0 != NR_PHP_PROCESS_GLOBALS(cli));
 
@@ -1025,6 +1029,13 @@ nr_status_t nr_php_txn_begin(const char* appnames,
       = NRINI(custom_events_max_samples_stored);
   info.docker_id = nr_strdup(NR_PHP_PROCESS_GLOBALS(docker_id));
 
+  /*
+   * The attribute configuration doesn't depend on the application, so it is
+   * created before the application is locked to keep the time the lock is
+   * held as short as possible.
+   */
+  attribute_config = nr_php_create_attribute_config(TSRMLS_C);
+
   NRPRG(app) = nr_agent_find_or_add_app(
       nr_agent_applist, &info,
       /*
@@ -1040,16 +1051,23 @@ nr_status_t nr_php_txn_begin(const char* appnames,
   if (NULL == NRPRG(app)) {
     nrl_debug(NRL_INIT, "unable to begin transaction: app '%.128s' is unknown",
               appnames ? appnames : "");
+    nr_attribute_config_destroy(&attribute_config);
     return NR_FAILURE;
   }
 
-  attribute_config = nr_php_create_attribute_config(TSRMLS_C);
+  /*
+   * Take a reference to what the transaction needs from the application, so
+   * that the application can be unlocked before the transaction is created.
+   */
   log_forwarding_labels
       = nr_php_txn_get_log_forwarding_labels(NRPRG(app)->info.labels);
-  NRPRG(txn) = nr_txn_begin(NRPRG(app), &opts, attribute_config,
-                            log_forwarding_labels);
+  nr_txn_snapshot_app(&app_snapshot, NRPRG(app));
   nrt_mutex_unlock(&(NRPRG(app)->app_lock));
 
+  NRPRG(txn) = nr_txn_begin_snapshot(&app_snapshot, &opts, attribute_config,
+                                     log_forwarding_labels);
+
+  nr_txn_app_snapshot_destroy_fields(&app_snapshot);
   nr_attribute_config_destroy(&attribute_config);
   nro_delete(log_forwarding_labels);
 
@@ -1276,9 +1294,113 @@ static void nr_php_txn_set_response_header_attributes(nrtxn_t* txn TSRMLS_DC) {
                             content_length);
 }
 
-nr_status_t nr_php_txn_end(int ignoretxn, int in_post_deactivate TSRMLS_DC) {
-  nr_status_t ret;
+/*
+ * Ends a transaction that has had its final metrics and attributes added, and
+ * sends it to the daemon. This only touches the transaction, which is allocated
+ * independently of the Zend memory manager, and the daemon connection, so it's
+ * safe to call once the request has been torn down. Segments still point at
+ * the wraprecs that created them, but nothing in axiom dereferences those.
+ */
+static void nr_php_txn_finalise(nrtxn_t* txn) {
+  nr_txn_end(txn);
+
+  if (0 == txn->status.ignore) {
+    /*
+     * Check status.ignore again in case it has changed during nr_txn_end.
+     */
+    if (NR_FAILURE == nr_cmd_txndata_tx(nr_get_daemon_fd(), txn)) {
+      nrl_debug(NRL_TXN, "failed to send txn");
+    }
+  }
+}
+
+static nr_segment_iter_return_t nr_php_txn_detach_deferred_attributes(
+    nr_segment_t* segment,
+    void* userdata NRUNUSED) {
+  nr_segment_detach_deferred_attributes(segment);
+
+  return NR_SEGMENT_NO_POST_ITERATION_CALLBACK;
+}
+
+/*
+ * The number of completed transactions that may be waiting for the finaliser
+ * thread before transactions are finalised in the request again.
+ */
+#define NR_PHP_TXN_FINALISER_MAX_PENDING 64
+
+#ifdef ZTS
+static nrthread_mutex_t nr_php_txn_finaliser_lock
+    = NRTHREAD_MUTEX_INITIALIZER;
+
+static void nr_php_txn_finaliser_func(nrtxn_t* txn, void* userdata NRUNUSED) {
+  nr_php_txn_finalise(txn);
+}
+
+/*
+ * In ZTS builds the transaction is handed to a finaliser thread owned by this
+ * process. The thread is only started once a transaction needs it, so forking
+ * servers start it in each child after the fork rather than in the parent.
+ */
+static bool nr_php_txn_defer_finalisation(nrtxn_t** txn_ptr TSRMLS_DC) {
+  nr_txn_finaliser_t* finaliser;
+
+  NR_UNUSED_TSRMLS;
+
+  nrt_mutex_lock(&nr_php_txn_finaliser_lock);
+  finaliser = NR_PHP_PROCESS_GLOBALS(txn_finaliser);
+  if (!nr_txn_finaliser_is_owned(finaliser)) {
+    /*
+     * Either this is the first deferred transaction, or the finaliser was
+     * inherited from a parent process and has no thread here.
+     */
+    nr_txn_finaliser_destroy(&finaliser);
+    finaliser = nr_txn_finaliser_create(NR_PHP_TXN_FINALISER_MAX_PENDING,
+                                        nr_php_txn_finaliser_func, NULL);
+    NR_PHP_PROCESS_GLOBALS(txn_finaliser) = finaliser;
+  }
+  nrt_mutex_unlock(&nr_php_txn_finaliser_lock);
+
+  return nr_txn_finaliser_submit(finaliser, txn_ptr);
+}
+#else
+/*
+ * In NTS builds the transaction is kept until the SAPI deactivate callback has
+ * run: see nr_php_sapi_deactivate().
+ */
+static bool nr_php_txn_defer_finalisation(nrtxn_t** txn_ptr TSRMLS_DC) {
+  if (NULL == NR_PHP_PROCESS_GLOBALS(orig_sapi_deactivate)) {
+    /*
+     * Without a SAPI deactivate callback there is nothing to wait for.
+     */
+    return false;
+  }
+
+  nr_php_txn_finalise_deferred(TSRMLS_C);
+  NRPRG(deferred_txn) = *txn_ptr;
+  *txn_ptr = NULL;
+
+  return true;
+}
+#endif /* ZTS */
+
+void nr_php_txn_finalise_deferred(TSRMLS_D) {
+  if (NULL == NRPRG(deferred_txn)) {
+    return;
+  }
+
+  nr_php_txn_finalise(NRPRG(deferred_txn));
+  nr_txn_destroy(&NRPRG(deferred_txn));
+}
+
+void nr_php_txn_finaliser_shutdown(void) {
+#ifdef ZTS
+  nrt_mutex_lock(&nr_php_txn_finaliser_lock);
+  nr_txn_finaliser_destroy(&NR_PHP_PROCESS_GLOBALS(txn_finaliser));
+  nrt_mutex_unlock(&nr_php_txn_finaliser_lock);
+#endif
+}
 
+nr_status_t nr_php_txn_end(int ignoretxn, int in_post_deactivate TSRMLS_DC) {
   if (NULL == NRPRG(txn)) {
     return NR_SUCCESS;
   }
@@ -1334,6 +1456,8 @@ nr_status_t nr_php_txn_end(int ignoretxn, int in_post_deactivate TSRMLS_DC) {
                   "Supportability/execute/allocated_segment_count",
                   nr_txn_allocated_segment_count(txn));
 
+    nr_wordpress_txn_end_metrics(txn TSRMLS_CC);
+
     /* Agent and PHP version metrics*/
     nr_php_txn_create_agent_php_version_metrics(txn);
 
@@ -1353,16 +1477,26 @@ nr_status_t nr_php_txn_end(int ignoretxn, int in_post_deactivate TSRMLS_DC) {
 
     nr_txn_finalize_parent_stacks(txn);
 
-    nr_txn_end(txn);
+    /*
+     * Deferred segment attributes may refer to memory owned by the request, so
+     * they have to be detached from it before finalisation is deferred past
+     * the end of the request. They are still only added to the segments that
+     * are kept.
+     */
+    if (in_post_deactivate
+        && NR_PHP_PROCESS_GLOBALS(deferred_txn_finalization)) {
+      nr_segment_iterate(txn->segment_root,
+                         nr_php_txn_detach_deferred_attributes, NULL);
+    }
 
-    if (0 == txn->status.ignore) {
-      /*
-       * Check status.ignore again in case it has changed during nr_txn_end.
-       */
-      ret = nr_cmd_txndata_tx(nr_get_daemon_fd(), txn);
-      if (NR_FAILURE == ret) {
-        nrl_debug(NRL_TXN, "failed to send txn");
-      }
+    /*
+     * Transactions ended by the API are finalised immediately, since the
+     * request carries on afterwards and may start a new transaction.
+     */
+    if (0 == in_post_deactivate
+        || 0 == NR_PHP_PROCESS_GLOBALS(deferred_txn_finalization)
+        || !nr_php_txn_defer_finalisation(&NRPRG(txn) TSRMLS_CC)) {
+      nr_php_txn_finalise(txn);
     }
   }
 
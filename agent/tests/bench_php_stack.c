@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times creating the JSON for a 50 frame deep backtrace from the array
+ * returned by zend_fetch_debug_backtrace() and by walking the execute data.
+ */
+#include "tlib_php.h"
+
+#include "php_agent.h"
+#include "php_wrapper.h"
+#include "php_zval.h"
+#include "util_time.h"
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+#ifdef PHP7
+#define NR_BENCH_BACKTRACE_ITERATIONS 10000
+
+NR_PHP_WRAPPER(bench_backtrace) {
+  nrtime_t fetched;
+  nrtime_t walked;
+  nrtime_t start;
+  int i;
+
+  (void)wraprec;
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_BACKTRACE_ITERATIONS; i++) {
+    zval* trace = nr_php_backtrace(TSRMLS_C);
+    char* json = nr_php_backtrace_to_json(trace TSRMLS_CC);
+
+    nr_free(json);
+    nr_php_zval_free(&trace);
+  }
+  fetched = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_BACKTRACE_ITERATIONS; i++) {
+    char* json = nr_php_backtrace_to_json(NULL TSRMLS_CC);
+
+    nr_free(json);
+  }
+  walked = nr_time_duration(start, nr_get_time());
+
+  printf("backtrace json: %.3fms fetched, %.3fms walked\n",
+         (double)fetched / NR_TIME_DIVISOR_MS_D,
+         (double)walked / NR_TIME_DIVISOR_MS_D);
+
+  NR_PHP_WRAPPER_CALL;
+}
+NR_PHP_WRAPPER_END
+
+static void bench_walked_backtrace(TSRMLS_D) {
+  tlib_php_request_start();
+
+  tlib_php_request_eval(
+      "function backtrace_bench_leaf() { return 1; }"
+      "function backtrace_bench($n) {"
+      "  return $n > 0 ? backtrace_bench($n - 1) : backtrace_bench_leaf();"
+      "}" TSRMLS_CC);
+  nr_php_wrap_user_function(NR_PSTR("backtrace_bench_leaf"),
+                            bench_backtrace TSRMLS_CC);
+  tlib_php_request_eval("backtrace_bench(50);" TSRMLS_CC);
+
+  tlib_php_request_end();
+}
+#endif /* PHP7 */
+
+void test_main(void* p NRUNUSED) {
+#if defined(ZTS) && !defined(PHP7)
+  void*** tsrm_ls = NULL;
+#endif /* ZTS && !PHP7 */
+  tlib_php_engine_create("" PTSRMLS_CC);
+#ifdef PHP7
+  bench_walked_backtrace(TSRMLS_C);
+#endif /* PHP7 */
+  tlib_php_engine_destroy(TSRMLS_C);
+}
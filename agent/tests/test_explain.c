@@ -0,0 +1,179 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "tlib_php.h"
+
+#include "php_agent.h"
+#include "php_explain.h"
+#include "util_sleep.h"
+#include "util_strings.h"
+
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+#define HIT_METRIC "Supportability/DatabaseUtils/ExplainPlanCache/Hit"
+#define MISS_METRIC "Supportability/DatabaseUtils/ExplainPlanCache/Miss"
+
+static nr_datastore_instance_t instance = {
+    .host = "db.example.com",
+    .port_path_or_id = "3306",
+    .database_name = "app",
+};
+
+static nr_datastore_instance_t other_instance = {
+    .host = "db.example.com",
+    .port_path_or_id = "3306",
+    .database_name = "other",
+};
+
+static nr_explain_plan_t* test_plan_create(void) {
+  nr_explain_plan_t* plan = nr_explain_plan_create();
+  nrobj_t* row = nro_new_array();
+
+  nr_explain_plan_add_column(plan, "id");
+  nr_explain_plan_add_column(plan, "table");
+  nro_set_array_long(row, 0, 1);
+  nro_set_array_string(row, 0, "users");
+  nr_explain_plan_add_row(plan, row);
+  nro_delete(row);
+
+  return plan;
+}
+
+static nrtime_t test_metric_count(const char* name TSRMLS_DC) {
+  return nrm_count(nrm_find(NRPRG(txn)->unscoped_metrics, name));
+}
+
+static void test_cache_key(TSRMLS_D) {
+  char* key;
+  char* other_key;
+
+  tlib_php_request_start();
+
+  tlib_pass_if_null("NULL instance",
+                    nr_php_explain_plan_cache_key(NULL, "SELECT 1" TSRMLS_CC));
+  tlib_pass_if_null("NULL sql",
+                    nr_php_explain_plan_cache_key(&instance, NULL TSRMLS_CC));
+
+  /*
+   * Queries that only differ in their literals share a key.
+   */
+  key = nr_php_explain_plan_cache_key(
+      &instance, "SELECT * FROM users WHERE id = 1" TSRMLS_CC);
+  other_key = nr_php_explain_plan_cache_key(
+      &instance, "SELECT * FROM users WHERE id = 42" TSRMLS_CC);
+  tlib_pass_if_not_null("key", key);
+  tlib_pass_if_str_equal("literals are ignored", key, other_key);
+  nr_free(other_key);
+
+  other_key = nr_php_explain_plan_cache_key(
+      &instance, "SELECT * FROM orders WHERE id = 1" TSRMLS_CC);
+  tlib_pass_if_true("different query", 0 != nr_strcmp(key, other_key),
+                    "key=%s other_key=%s", key, other_key);
+  nr_free(other_key);
+
+  other_key = nr_php_explain_plan_cache_key(
+      &other_instance, "SELECT * FROM users WHERE id = 1" TSRMLS_CC);
+  tlib_pass_if_true("different instance", 0 != nr_strcmp(key, other_key),
+                    "key=%s other_key=%s", key, other_key);
+  nr_free(other_key);
+  nr_free(key);
+
+  /*
+   * The cache is disabled by a zero TTL or size.
+   */
+  NRINI(explain_cache_ttl) = 0;
+  tlib_pass_if_null("zero ttl", nr_php_explain_plan_cache_key(
+                                    &instance, "SELECT 1" TSRMLS_CC));
+
+  tlib_php_request_end();
+}
+
+static void test_cache(TSRMLS_D) {
+  nr_explain_plan_t* plan;
+  nr_explain_plan_t* cached;
+  char* key;
+  char* json;
+  char* cached_json;
+
+  tlib_php_request_start();
+  NRINI(explain_cache_ttl) = 60 * NR_TIME_DIVISOR;
+  NRINI(explain_cache_size) = 2;
+
+  /*
+   * Bad parameters.
+   */
+  tlib_pass_if_null("NULL key",
+                    nr_php_explain_plan_cache_get(NRPRG(txn), NULL));
+  nr_php_explain_plan_cache_add(NULL, NULL TSRMLS_CC);
+
+  key = nr_php_explain_plan_cache_key(
+      &instance, "SELECT * FROM users WHERE id = 1" TSRMLS_CC);
+  nr_php_explain_plan_cache_add(key, NULL TSRMLS_CC);
+
+  tlib_pass_if_null("miss", nr_php_explain_plan_cache_get(NRPRG(txn), key));
+  tlib_pass_if_time_equal("miss metric", 1,
+                          test_metric_count(MISS_METRIC TSRMLS_CC));
+
+  /*
+   * A cached plan is returned as a copy.
+   */
+  plan = test_plan_create();
+  nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
+  cached = nr_php_explain_plan_cache_get(NRPRG(txn), key);
+  tlib_pass_if_not_null("hit", cached);
+  tlib_pass_if_true("copy", cached != plan, "cached=%p plan=%p", cached, plan);
+  tlib_pass_if_time_equal("hit metric", 1,
+                          test_metric_count(HIT_METRIC TSRMLS_CC));
+
+  json = nr_explain_plan_to_json(plan);
+  cached_json = nr_explain_plan_to_json(cached);
+  tlib_pass_if_str_equal("cached plan", json, cached_json);
+  nr_free(json);
+  nr_free(cached_json);
+  nr_explain_plan_destroy(&cached);
+
+  /*
+   * The cache is flushed once full.
+   */
+  nr_free(key);
+  key = nr_php_explain_plan_cache_key(&instance,
+                                      "SELECT * FROM orders" TSRMLS_CC);
+  nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
+  nr_free(key);
+  key = nr_php_explain_plan_cache_key(&instance,
+                                      "SELECT * FROM items" TSRMLS_CC);
+  nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
+  nr_free(key);
+  key = nr_php_explain_plan_cache_key(
+      &instance, "SELECT * FROM users WHERE id = 2" TSRMLS_CC);
+  tlib_pass_if_null("flushed", nr_php_explain_plan_cache_get(NRPRG(txn), key));
+
+  /*
+   * Plans expire once the TTL has elapsed.
+   */
+  NRINI(explain_cache_ttl) = 10 * NR_TIME_DIVISOR_MS;
+  nr_php_explain_plan_cache_add(key, plan TSRMLS_CC);
+  cached = nr_php_explain_plan_cache_get(NRPRG(txn), key);
+  tlib_pass_if_not_null("unexpired", cached);
+  nr_explain_plan_destroy(&cached);
+
+  nr_msleep(20);
+  tlib_pass_if_null("expired", nr_php_explain_plan_cache_get(NRPRG(txn), key));
+
+  nr_free(key);
+  nr_explain_plan_destroy(&plan);
+  nr_php_explain_plan_cache_destroy();
+  tlib_php_request_end();
+}
+
+void test_main(void* p NRUNUSED) {
+#if defined(ZTS) && !defined(PHP7)
+  void*** tsrm_ls = NULL;
+#endif /* ZTS && !PHP7 */
+  tlib_php_engine_create("" PTSRMLS_CC);
+  test_cache_key(TSRMLS_C);
+  test_cache(TSRMLS_C);
+  tlib_php_engine_destroy(TSRMLS_C);
+}
@@ -123,6 +123,125 @@ static void test_wordpress_plugin_matcher() {
   nr_free(plugin);
 }
 
+/*
+ * This will test the process-wide plugin/theme attribution cache.
+ */
+static void test_wordpress_plugin_cache() {
+  char* plugin = NULL;
+  const char* filename = "/var/www/wp-content/plugins/akismet/akismet.php";
+  const char* core_filename = "/var/www/wp-includes/query.php";
+  const char* site = "/var/www/wp-content/plugins|/var/www/wp-content|wp-includes|";
+  const char* other_site = "/srv/wp-content/plugins|/srv/wp-content|wp-includes|";
+  int found;
+
+  /* Test with invalid input. */
+  found = nr_php_wordpress_plugin_cache_get(NULL, filename,
+                                            nr_strlen(filename), &plugin);
+  tlib_pass_if_int_equal("A NULL site key should not be found", 0, found);
+  found = nr_php_wordpress_plugin_cache_get(site, NULL, 0, &plugin);
+  tlib_pass_if_int_equal("A NULL filename should not be found", 0, found);
+  nr_php_wordpress_plugin_cache_set(NULL, filename, nr_strlen(filename),
+                                    "akismet");
+
+  found = nr_php_wordpress_plugin_cache_get(site, filename,
+                                            nr_strlen(filename), &plugin);
+  tlib_pass_if_int_equal("An empty cache should miss", 0, found);
+
+  /* Test with valid input. */
+  nr_php_wordpress_plugin_cache_set(site, filename, nr_strlen(filename),
+                                    "akismet");
+  nr_php_wordpress_plugin_cache_set(site, core_filename,
+                                    nr_strlen(core_filename), NULL);
+
+  found = nr_php_wordpress_plugin_cache_get(site, filename,
+                                            nr_strlen(filename), &plugin);
+  tlib_pass_if_int_equal("A cached plugin should be found", 1, found);
+  tlib_pass_if_str_equal("A cached plugin should be returned", "akismet",
+                         plugin);
+  nr_free(plugin);
+
+  plugin = "not null";
+  found = nr_php_wordpress_plugin_cache_get(site, core_filename,
+                                            nr_strlen(core_filename), &plugin);
+  tlib_pass_if_int_equal("A cached core file should be found", 1, found);
+  tlib_pass_if_null("A cached core file should have no plugin", plugin);
+
+  found = nr_php_wordpress_plugin_cache_get(other_site, filename,
+                                            nr_strlen(filename), &plugin);
+  tlib_pass_if_int_equal("A different site key should miss", 0, found);
+
+  nr_php_wordpress_plugin_cache_destroy();
+  found = nr_php_wordpress_plugin_cache_get(site, filename,
+                                            nr_strlen(filename), &plugin);
+  tlib_pass_if_int_equal("A destroyed cache should miss", 0, found);
+}
+
+/*
+ * This will test the aggregation of hook callback timings.
+ */
+static void test_wordpress_hook_aggregate(TSRMLS_D) {
+  nrmtable_t* table = nrm_table_create(0);
+  const nrmetric_t* metric = NULL;
+  char long_hook[1024];
+
+  /* Test with invalid input. */
+  nr_php_wordpress_hook_aggregate_add(NULL, NULL, 10, 10 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_metrics(table TSRMLS_CC);
+  tlib_pass_if_int_equal("No metrics should be created for NULL hooks", 0,
+                         nrm_table_size(table));
+
+  /* Test with valid input. */
+  nr_php_wordpress_hook_aggregate_add("akismet", "init", 10, 4 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_add("akismet", "init", 30, 30 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_add("akismet", "wp_loaded", 5, 5 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_add("jetpack", "init", 20, 0 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_add(NULL, "the_content", 1, 1 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_metrics(table TSRMLS_CC);
+  tlib_pass_if_null("The aggregate table should be cleared",
+                    NRPRG(wordpress_hook_aggregates));
+
+  metric = nrm_find(table, "Framework/WordPress/Hook/init");
+  tlib_pass_if_not_null("Hook metric should exist", metric);
+  tlib_pass_if_time_equal("Hook metric count", 3, nrm_count(metric));
+  tlib_pass_if_time_equal("Hook metric total", 60, nrm_total(metric));
+  tlib_pass_if_time_equal("Hook metric exclusive", 34, nrm_exclusive(metric));
+  tlib_pass_if_time_equal("Hook metric min", 10, nrm_min(metric));
+  tlib_pass_if_time_equal("Hook metric max", 30, nrm_max(metric));
+
+  metric = nrm_find(table, "Framework/WordPress/Plugin/akismet");
+  tlib_pass_if_not_null("Plugin metric should exist", metric);
+  tlib_pass_if_time_equal("Plugin metric count", 3, nrm_count(metric));
+  tlib_pass_if_time_equal("Plugin metric total", 45, nrm_total(metric));
+  tlib_pass_if_time_equal("Plugin metric exclusive", 39,
+                          nrm_exclusive(metric));
+  tlib_pass_if_time_equal("Plugin metric min", 5, nrm_min(metric));
+  tlib_pass_if_time_equal("Plugin metric max", 30, nrm_max(metric));
+
+  metric = nrm_find(table, "Framework/WordPress/Hook/the_content");
+  tlib_pass_if_not_null("Core hook metric should exist", metric);
+  tlib_pass_if_time_equal("Core hook metric count", 1, nrm_count(metric));
+  tlib_pass_if_int_equal("Metric table size", 5, nrm_table_size(table));
+
+  nrm_table_destroy(&table);
+
+  /* Test with a hook name longer than the stack buffer for the key. */
+  table = nrm_table_create(0);
+  nr_memset(long_hook, 'h', sizeof(long_hook) - 1);
+  long_hook[sizeof(long_hook) - 1] = '\0';
+  nr_php_wordpress_hook_aggregate_add("akismet", long_hook, 10, 10 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_add("akismet", long_hook, 20, 20 TSRMLS_CC);
+  nr_php_wordpress_hook_aggregate_metrics(table TSRMLS_CC);
+
+  metric = nrm_find(table, "Framework/WordPress/Plugin/akismet");
+  tlib_pass_if_not_null("Long hook plugin metric should exist", metric);
+  tlib_pass_if_time_equal("Long hook plugin metric count", 2,
+                          nrm_count(metric));
+  tlib_pass_if_int_equal("Long hook metric table size", 2,
+                         nrm_table_size(table));
+
+  nrm_table_destroy(&table);
+}
+
 void test_main(void* p NRUNUSED) {
 #if defined(ZTS) && !defined(PHP7)
   void*** tsrm_ls = NULL;
@@ -130,5 +249,7 @@ void test_main(void* p NRUNUSED) {
   tlib_php_engine_create("" PTSRMLS_CC);
   test_wordpress_plugin_matcher();
   test_wordpress_core_matcher();
+  test_wordpress_plugin_cache();
+  test_wordpress_hook_aggregate(TSRMLS_C);
   tlib_php_engine_destroy(TSRMLS_C);
 }
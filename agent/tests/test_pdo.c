@@ -10,6 +10,7 @@
 #include "php_hash.h"
 #include "php_pdo.h"
 #include "php_pdo_private.h"
+#include "util_hashmap.h"
 
 tlib_parallel_info_t parallel_info
     = {.suggested_nthreads = -1, .state_size = 0};
@@ -137,6 +138,70 @@ static void test_get_database_object_from_object(TSRMLS_D) {
   tlib_php_request_end();
 }
 
+static void test_get_connection(TSRMLS_D) {
+  const nr_php_pdo_connection_t* conn;
+  zval* obj;
+  zval* pdo;
+  zval* stmt;
+
+  tlib_php_request_start();
+
+  /*
+   * Test : Bad parameters.
+   */
+  tlib_pass_if_null("NULL zval", nr_php_pdo_get_connection(NULL TSRMLS_CC));
+
+  obj = nr_php_zval_alloc();
+  object_init(obj);
+  tlib_pass_if_null("non-PDO object zval",
+                    nr_php_pdo_get_connection(obj TSRMLS_CC));
+  nr_php_pdo_connection_forget(obj TSRMLS_CC);
+  nr_php_zval_free(&obj);
+
+  /*
+   * Test : The connection is resolved once, and shared by the PDO object and
+   *        its statements.
+   */
+  pdo = pdo_new("sqlite::memory:" TSRMLS_CC);
+  conn = nr_php_pdo_get_connection(pdo TSRMLS_CC);
+  tlib_pass_if_not_null("PDO object", conn);
+  tlib_pass_if_ptr_equal("PDO object dbh",
+                         nr_php_pdo_get_database_object_from_object(
+                             pdo TSRMLS_CC),
+                         conn->dbh);
+  tlib_pass_if_str_equal("PDO object driver", "sqlite", conn->driver_name);
+  tlib_pass_if_int_equal("PDO object datastore", NR_DATASTORE_SQLITE,
+                         conn->datastore);
+  tlib_pass_if_null("PDO object instance", conn->instance);
+  tlib_pass_if_ptr_equal("cached", conn,
+                         nr_php_pdo_get_connection(pdo TSRMLS_CC));
+  tlib_pass_if_size_t_equal("one connection", 1,
+                            nr_hashmap_count(NRPRG(pdo_connections)));
+
+  stmt = pdostatement_new(pdo, "SELECT * FROM SQLITE_MASTER" TSRMLS_CC);
+  tlib_pass_if_ptr_equal("PDOStatement object", conn,
+                         nr_php_pdo_get_connection(stmt TSRMLS_CC));
+  tlib_pass_if_str_equal("PDOStatement driver", "sqlite",
+                         nr_php_pdo_get_driver(stmt TSRMLS_CC));
+  tlib_pass_if_int_equal("PDOStatement datastore", NR_DATASTORE_SQLITE,
+                         nr_php_pdo_get_datastore(stmt TSRMLS_CC));
+
+  /*
+   * Test : A forgotten connection is resolved again.
+   */
+  nr_php_pdo_connection_forget(pdo TSRMLS_CC);
+  tlib_pass_if_size_t_equal("forgotten", 0,
+                            nr_hashmap_count(NRPRG(pdo_connections)));
+  conn = nr_php_pdo_get_connection(stmt TSRMLS_CC);
+  tlib_pass_if_not_null("resolved again", conn);
+  tlib_pass_if_str_equal("resolved again", "sqlite", conn->driver_name);
+
+  nr_php_zval_free(&stmt);
+  nr_php_zval_free(&pdo);
+
+  tlib_php_request_end();
+}
+
 static void test_get_datastore_for_driver(void) {
   size_t i;
 
@@ -368,6 +433,7 @@ void test_main(void* p NRUNUSED) {
     if (tlib_php_require_extension("pdo_sqlite" TSRMLS_CC)) {
       test_datastore_make_key();
       test_get_database_object_from_object(TSRMLS_C);
+      test_get_connection(TSRMLS_C);
       test_get_datastore_for_driver();
       test_get_datastore_internal();
       test_get_driver_internal();
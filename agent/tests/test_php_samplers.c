@@ -0,0 +1,145 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "tlib_php.h"
+
+#include <sys/resource.h>
+
+#include "php_agent.h"
+#include "php_samplers.h"
+#include "util_memory.h"
+#include "util_metrics.h"
+
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+#define TEST_ALLOCATION_SIZE (32 * 1024 * 1024)
+
+static void test_rusage(TSRMLS_D) {
+  struct rusage rusage;
+
+  tlib_php_request_start();
+  NRINI(memory_sampler_policy) = NR_PHP_MEMORY_SAMPLER_RUSAGE;
+
+  nr_memset(&rusage, 0, sizeof(rusage));
+  rusage.ru_maxrss = 1000;
+
+  tlib_pass_if_int64_t_equal(
+      "NULL rusage", 0,
+      nr_php_physical_memory_used(nr_get_time(), NULL TSRMLS_CC));
+
+#if defined(NR_SYSTEM_LINUX) || defined(NR_SYSTEM_DARWIN)
+  tlib_pass_if_int64_t_equal(
+      "peak rss", 1000 * 1024,
+      nr_php_physical_memory_used(nr_get_time(), &rusage TSRMLS_CC));
+#endif
+
+  tlib_php_request_end();
+}
+
+#if defined(NR_SYSTEM_LINUX)
+static void test_always(TSRMLS_D) {
+  tlib_php_request_start();
+  NRINI(memory_sampler_policy) = NR_PHP_MEMORY_SAMPLER_ALWAYS;
+
+  tlib_pass_if_true(
+      "current rss",
+      nr_php_physical_memory_used(nr_get_time(), NULL TSRMLS_CC) > 0,
+      "memory should be reported");
+  tlib_pass_if_true(
+      "current rss reread",
+      nr_php_physical_memory_used(nr_get_time(), NULL TSRMLS_CC) > 0,
+      "memory should be reported");
+
+  /*
+   * The samplers can be used again after they've been shut down.
+   */
+  nr_php_shutdown_samplers();
+  tlib_pass_if_true(
+      "current rss after shutdown",
+      nr_php_physical_memory_used(nr_get_time(), NULL TSRMLS_CC) > 0,
+      "memory should be reported");
+
+  tlib_php_request_end();
+}
+
+static void test_interval(TSRMLS_D) {
+  nrtime_t interval = 10 * NR_TIME_DIVISOR;
+  nrtime_t now = nr_get_time();
+  int64_t sample;
+  int64_t cached;
+  int64_t fresh;
+  char* buf;
+
+  tlib_php_request_start();
+  NRINI(memory_sampler_policy) = NR_PHP_MEMORY_SAMPLER_INTERVAL;
+  NRINI(memory_sampler_interval) = interval;
+  nr_php_shutdown_samplers();
+
+  sample = nr_php_physical_memory_used(now, NULL TSRMLS_CC);
+  tlib_pass_if_true("first sample", sample > 0, "sample=%lld",
+                    (long long)sample);
+
+  /*
+   * Grow the RSS, so that it's clear whether memory is read again.
+   */
+  buf = (char*)nr_malloc(TEST_ALLOCATION_SIZE);
+  nr_memset(buf, 1, TEST_ALLOCATION_SIZE);
+
+  cached = nr_php_physical_memory_used(now + interval - 1, NULL TSRMLS_CC);
+  tlib_pass_if_int64_t_equal("within the interval", sample, cached);
+
+  fresh = nr_php_physical_memory_used(now + interval, NULL TSRMLS_CC);
+  tlib_pass_if_true("after the interval", fresh > sample,
+                    "fresh=%lld sample=%lld", (long long)fresh,
+                    (long long)sample);
+
+  /*
+   * A clock that goes backwards causes a new sample to be taken.
+   */
+  tlib_pass_if_true("clock went backwards",
+                    nr_php_physical_memory_used(now, NULL TSRMLS_CC) > 0,
+                    "memory should be reported");
+
+  /*
+   * A zero interval reads memory every time.
+   */
+  NRINI(memory_sampler_interval) = 0;
+  tlib_pass_if_true("zero interval",
+                    nr_php_physical_memory_used(now, NULL TSRMLS_CC) > 0,
+                    "memory should be reported");
+
+  nr_free(buf);
+  nr_php_shutdown_samplers();
+  tlib_php_request_end();
+}
+#endif /* NR_SYSTEM_LINUX */
+
+static void test_sampler_end(TSRMLS_D) {
+  tlib_php_request_start();
+  NRINI(memory_sampler_policy) = NR_PHP_MEMORY_SAMPLER_RUSAGE;
+
+  nr_php_resource_usage_sampler_start(TSRMLS_C);
+  nr_php_resource_usage_sampler_end(TSRMLS_C);
+
+  tlib_pass_if_not_null(
+      "memory metric",
+      nrm_find(NRPRG(txn)->unscoped_metrics, "Memory/Physical"));
+
+  tlib_php_request_end();
+}
+
+void test_main(void* p NRUNUSED) {
+#if defined(ZTS) && !defined(PHP7)
+  void*** tsrm_ls = NULL;
+#endif /* ZTS && !PHP7 */
+  tlib_php_engine_create("" PTSRMLS_CC);
+  test_rusage(TSRMLS_C);
+#if defined(NR_SYSTEM_LINUX)
+  test_always(TSRMLS_C);
+  test_interval(TSRMLS_C);
+#endif /* NR_SYSTEM_LINUX */
+  test_sampler_end(TSRMLS_C);
+  tlib_php_engine_destroy(TSRMLS_C);
+}
@@ -7,6 +7,7 @@
 
 #include "php_agent.h"
 #include "php_hash.h"
+#include "php_wrapper.h"
 #include "php_zval.h"
 
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
@@ -87,11 +88,118 @@ static void test_stack_trace_limit(TSRMLS_D) {
   tlib_php_request_end();
 }
 
+#ifdef PHP7
+/*
+ * The backtrace captured by the wrapper below, both by walking the execute
+ * data and by formatting the array returned by zend_fetch_debug_backtrace().
+ */
+static char* walked_json = NULL;
+static char* fetched_json = NULL;
+
+NR_PHP_WRAPPER(test_capture_backtrace) {
+  zval* trace;
+
+  (void)wraprec;
+
+  nr_free(walked_json);
+  nr_free(fetched_json);
+
+  walked_json = nr_php_backtrace_to_json(NULL TSRMLS_CC);
+  trace = nr_php_backtrace(TSRMLS_C);
+  fetched_json = nr_php_backtrace_to_json(trace TSRMLS_CC);
+  nr_php_zval_free(&trace);
+
+  NR_PHP_WRAPPER_CALL;
+}
+NR_PHP_WRAPPER_END
+
+static void test_walked_backtrace_matches(const char* testname,
+                                          const char* code TSRMLS_DC) {
+  nr_free(walked_json);
+  nr_free(fetched_json);
+
+  tlib_php_request_eval(code TSRMLS_CC);
+
+  tlib_pass_if_not_null(testname, walked_json);
+  tlib_pass_if_str_equal(testname, fetched_json, walked_json);
+}
+
+static void test_walked_backtrace(TSRMLS_D) {
+  char* first = NULL;
+  nrobj_t* trace_array;
+
+  tlib_php_request_start();
+
+  tlib_php_request_eval(
+      "function backtrace_leaf() { return 1; }"
+      "function backtrace_recurse($n) {"
+      "  return $n > 0 ? backtrace_recurse($n - 1) : backtrace_leaf();"
+      "}"
+      "class BacktraceTest {"
+      "  public function instance() { return static::stat(); }"
+      "  public static function stat() {"
+      "    $f = function () { return backtrace_leaf(); };"
+      "    return $f();"
+      "  }"
+      "  public function __call($name, $args) { return backtrace_leaf(); }"
+      "}" TSRMLS_CC);
+  nr_php_wrap_user_function(NR_PSTR("backtrace_leaf"),
+                            test_capture_backtrace TSRMLS_CC);
+
+  test_walked_backtrace_matches("function", "backtrace_leaf();" TSRMLS_CC);
+  test_walked_backtrace_matches(
+      "methods and closures",
+      "$o = new BacktraceTest; $o->instance();" TSRMLS_CC);
+  test_walked_backtrace_matches(
+      "trampoline", "$o = new BacktraceTest; $o->missing();" TSRMLS_CC);
+  test_walked_backtrace_matches("eval",
+                                "eval('backtrace_recurse(2);');" TSRMLS_CC);
+  test_walked_backtrace_matches(
+      "internal function", "array_map('backtrace_leaf', [1]);" TSRMLS_CC);
+  test_walked_backtrace_matches("closure called by an internal function",
+                                "call_user_func(function () {"
+                                "  return backtrace_recurse(1);"
+                                "});" TSRMLS_CC);
+
+  /*
+   * Backtraces through different eval()'d code are cached separately, even
+   * if the code's file names are allocated at the same address.
+   */
+  test_walked_backtrace_matches("first eval",
+                                "eval('backtrace_leaf();');" TSRMLS_CC);
+  test_walked_backtrace_matches(
+      "second eval", "eval(\"\\n\\nbacktrace_leaf();\");" TSRMLS_CC);
+  test_walked_backtrace_matches("deep", "backtrace_recurse(50);" TSRMLS_CC);
+
+  trace_array = nro_create_from_json(walked_json);
+  tlib_pass_if_int_equal("deep backtrace is truncated", NR_PHP_BACKTRACE_LIMIT,
+                         nro_getsize(trace_array));
+  nro_delete(trace_array);
+
+  /*
+   * The same backtrace is served from the request's cache.
+   */
+  first = nr_strdup(walked_json);
+  test_walked_backtrace_matches("cached", "backtrace_recurse(50);" TSRMLS_CC);
+  tlib_pass_if_str_equal("cached", first, walked_json);
+  tlib_pass_if_not_null("cache is populated", NRPRG(backtrace_json_cache));
+
+  nr_free(first);
+  nr_free(walked_json);
+  nr_free(fetched_json);
+  tlib_php_request_end();
+}
+
+#endif /* PHP7 */
+
 void test_main(void* p NRUNUSED) {
 #if defined(ZTS) && !defined(PHP7)
   void*** tsrm_ls = NULL;
 #endif /* ZTS && !PHP7 */
   tlib_php_engine_create("" PTSRMLS_CC);
   test_stack_trace_limit(TSRMLS_C);
+#ifdef PHP7
+  test_walked_backtrace(TSRMLS_C);
+#endif /* PHP7 */
   tlib_php_engine_destroy(TSRMLS_C);
 }
@@ -215,6 +215,129 @@ static void test_save_datastore_instance(TSRMLS_D) {
   tlib_php_request_end();
 }
 
+static void test_batch(TSRMLS_D) {
+  nr_php_redis_batch_t* batch;
+  char* breakdown;
+  const nrmetric_t* metric;
+  nr_datastore_instance_t instance = {
+      .host = "host.name",
+      .port_path_or_id = "6379",
+      .database_name = "0",
+  };
+
+  tlib_php_request_start();
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_php_redis_batch_add_command(NULL, "get", 0);
+  nr_php_redis_batch_add_round_trip(NULL, 0, 10);
+  nr_php_redis_batch_set_instance(NULL, &instance);
+  nr_php_redis_batch_end(NULL, NRPRG(txn));
+  nr_php_redis_batch_destroy(NULL);
+  tlib_pass_if_null("NULL batch", nr_php_redis_batch_breakdown(NULL));
+
+  /*
+   * Test : A batch without a round trip isn't reported.
+   */
+  batch = nr_php_redis_batch_create("pipeline");
+  tlib_pass_if_null("empty batch", nr_php_redis_batch_breakdown(batch));
+  nr_php_redis_batch_add_command(batch, "get", 10);
+  nr_php_redis_batch_end(&batch, NRPRG(txn));
+  tlib_pass_if_null("batch destroyed", batch);
+  tlib_pass_if_null("unsent batch",
+                    nrm_find(NRPRG(txn)->unscoped_metrics, "Datastore/all"));
+
+  /*
+   * Test : Normal operation.
+   */
+  batch = nr_php_redis_batch_create("pipeline");
+  nr_php_redis_batch_set_instance(batch, &instance);
+  nr_php_redis_batch_add_command(batch, "get", 10);
+  nr_php_redis_batch_add_command(batch, "set", 20);
+  nr_php_redis_batch_add_command(batch, "get", 30);
+  nr_php_redis_batch_add_round_trip(batch, 100, 150);
+  nr_php_redis_batch_add_round_trip(batch, 120, 200);
+
+  tlib_pass_if_uint64_t_equal("count", 3, batch->count);
+  tlib_pass_if_time_equal("start", 100, batch->start);
+  tlib_pass_if_time_equal("stop", 200, batch->stop);
+
+  breakdown = nr_php_redis_batch_breakdown(batch);
+  tlib_pass_if_str_equal("breakdown", "get:2,set:1", breakdown);
+  nr_free(breakdown);
+
+  nr_php_redis_batch_end(&batch, NRPRG(txn));
+
+  metric = nrm_find(NRPRG(txn)->unscoped_metrics, "Datastore/all");
+  tlib_pass_if_time_equal("one segment", 1, nrm_count(metric));
+
+  metric = nrm_find(NRPRG(txn)->unscoped_metrics,
+                    "Datastore/operation/Redis/get");
+  tlib_pass_if_time_equal("get count", 2, nrm_count(metric));
+  tlib_pass_if_time_equal("get total", 40, nrm_total(metric));
+  tlib_pass_if_time_equal("get min", 10, nrm_min(metric));
+  tlib_pass_if_time_equal("get max", 30, nrm_max(metric));
+
+  metric = nrm_find(NRPRG(txn)->unscoped_metrics,
+                    "Datastore/operation/Redis/set");
+  tlib_pass_if_time_equal("set count", 1, nrm_count(metric));
+
+  tlib_php_request_end();
+}
+
+static void test_connection_batch(TSRMLS_D) {
+  zval* conn;
+
+  tlib_php_request_start();
+  conn = tlib_php_request_eval_expr("new stdClass" TSRMLS_CC);
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_php_redis_start_batch(NULL TSRMLS_CC);
+  nr_php_redis_end_batch(NULL, 0, 10 TSRMLS_CC);
+  nr_php_redis_discard_batch(NULL TSRMLS_CC);
+  tlib_pass_if_null("NULL redis_conn",
+                    nr_php_redis_get_batch(NULL TSRMLS_CC));
+
+  /*
+   * Test : Batching disabled.
+   */
+  NRINI(redis_batching_enabled) = 0;
+  nr_php_redis_start_batch(conn TSRMLS_CC);
+  tlib_pass_if_null("disabled", nr_php_redis_get_batch(conn TSRMLS_CC));
+
+  /*
+   * Test : Normal operation.
+   */
+  NRINI(redis_batching_enabled) = 1;
+  nr_php_redis_start_batch(conn TSRMLS_CC);
+  tlib_pass_if_not_null("started", nr_php_redis_get_batch(conn TSRMLS_CC));
+
+  nr_php_redis_batch_add_command(nr_php_redis_get_batch(conn TSRMLS_CC),
+                                 "get", 10);
+  nr_php_redis_discard_batch(conn TSRMLS_CC);
+  tlib_pass_if_null("discarded", nr_php_redis_get_batch(conn TSRMLS_CC));
+
+  nr_php_redis_start_batch(conn TSRMLS_CC);
+  nr_php_redis_batch_add_command(nr_php_redis_get_batch(conn TSRMLS_CC),
+                                 "incr", 10);
+  nr_php_redis_end_batch(conn, 100, 200 TSRMLS_CC);
+  tlib_pass_if_null("ended", nr_php_redis_get_batch(conn TSRMLS_CC));
+  tlib_pass_if_time_equal(
+      "ended metric", 1,
+      nrm_count(nrm_find(NRPRG(txn)->unscoped_metrics,
+                         "Datastore/operation/Redis/incr")));
+  tlib_pass_if_null("discarded metric",
+                    nrm_find(NRPRG(txn)->unscoped_metrics,
+                             "Datastore/operation/Redis/get"));
+
+  NRINI(redis_batching_enabled) = 0;
+  nr_php_zval_free(&conn);
+  tlib_php_request_end();
+}
+
 void test_main(void* p NRUNUSED) {
 #if defined(ZTS) && !defined(PHP7)
   void*** tsrm_ls = NULL;
@@ -228,6 +351,9 @@ void test_main(void* p NRUNUSED) {
 
   tlib_php_engine_create("" PTSRMLS_CC);
 
+  test_batch(TSRMLS_C);
+  test_connection_batch(TSRMLS_C);
+
   if (tlib_php_require_extension("redis" TSRMLS_CC)) {
     test_remove_datastore_instance(TSRMLS_C);
     test_retrieve_datastore_instance(TSRMLS_C);
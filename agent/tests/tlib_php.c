@@ -1181,6 +1181,7 @@ static nr_status_t stub_cmd_appinfo_tx(int daemon_fd NRUNUSED, nrapp_t* app) {
   nr_segment_terms_destroy(&app->segment_terms);
   app->segment_terms = nr_segment_terms_create_from_obj(
       nro_get_hash_array(app->connect_reply, "transaction_segment_terms", 0));
+  nr_app_publish_connect_state(app);
 
   return NR_SUCCESS;
 }
@@ -245,6 +245,33 @@ int nr_command_is_flatbuffer_invalid(nr_flatbuffer_t* msg, size_t msglen) {
   return 0;
 }
 
+size_t nr_command_flatbuffer_len(const nr_flatbuffer_t* msg) {
+  return nr_flatbuffers_len(msg) + nr_flatbuffers_external_len(msg);
+}
+
+nr_status_t nr_command_write_flatbuffer(int daemon_fd,
+                                        const nr_flatbuffer_t* msg,
+                                        nrtime_t deadline) {
+  const uint8_t* data = nr_flatbuffers_data(msg);
+  const uint8_t* external = nr_flatbuffers_external_data(msg);
+  struct iovec iov[2];
+  int iovcnt = 1;
+
+  /*
+   * writev() doesn't modify the buffers, despite iov_base not being const.
+   */
+  iov[0].iov_base = (void*)((uintptr_t)data);
+  iov[0].iov_len = nr_flatbuffers_len(msg);
+
+  if (nr_flatbuffers_external_len(msg) > 0) {
+    iov[1].iov_base = (void*)((uintptr_t)external);
+    iov[1].iov_len = nr_flatbuffers_external_len(msg);
+    iovcnt = 2;
+  }
+
+  return nr_write_message_vectored(daemon_fd, iov, iovcnt, deadline);
+}
+
 void nr_cmd_appinfo_process_harvest_timing(nr_flatbuffers_table_t* reply,
                                            nrapp_t* app) {
   nrtime_t connect_timestamp;
@@ -412,6 +439,11 @@ nr_status_t nr_cmd_appinfo_process_reply(const uint8_t* data,
    */
   nr_cmd_appinfo_process_harvest_timing(&reply, app);
 
+  /*
+   * Publish the new connect state for transactions to share.
+   */
+  nr_app_publish_connect_state(app);
+
   return NR_SUCCESS;
 }
 
@@ -22,8 +22,12 @@ static uint32_t nr_span_batch_prepend_batch(
     const nr_span_encoding_result_t* encoded_batch) {
   uint32_t offset;
 
-  offset = nr_flatbuffers_prepend_bytes(fb, encoded_batch->data,
-                                        encoded_batch->len);
+  /*
+   * The encoded batch is the first value prepended, so it's written straight
+   * from the encoder's buffer after the rest of the message.
+   */
+  offset = nr_flatbuffers_prepend_bytes_external(fb, encoded_batch->data,
+                                                 encoded_batch->len);
 
   nr_flatbuffers_object_begin(fb, SPAN_BATCH_NUM_FIELDS);
   nr_flatbuffers_object_prepend_uoffset(fb, SPAN_BATCH_FIELD_ENCODED, offset,
@@ -86,7 +90,7 @@ nr_status_t nr_cmd_span_batch_tx(
   }
 
   msg = nr_span_batch_encode(agent_run_id, encoded_batch);
-  msglen = nr_flatbuffers_len(msg);
+  msglen = nr_command_flatbuffer_len(msg);
 
   nrl_verbosedebug(NRL_DAEMON, "sending span batch message, len=%zu", msglen);
 
@@ -101,8 +105,7 @@ nr_status_t nr_cmd_span_batch_tx(
 
     deadline = nr_get_time()
                + (NR_SPAN_BATCH_SEND_TIMEOUT_MSEC * NR_TIME_DIVISOR_MS);
-    st = nr_write_message(daemon_fd, nr_flatbuffers_data(msg), msglen,
-                          deadline);
+    st = nr_command_write_flatbuffer(daemon_fd, msg, deadline);
   }
   nr_agent_unlock_daemon_mutex();
   nr_flatbuffers_destroy(&msg);
@@ -32,12 +32,14 @@
 #include "util_buffer.h"
 #include "util_errno.h"
 #include "util_flatbuffers.h"
+#include "util_hash.h"
 #include "util_labels.h"
 #include "util_logging.h"
 #include "util_memory.h"
 #include "util_network.h"
 #include "util_strings.h"
 #include "util_syscalls.h"
+#include "util_threads.h"
 
 char* nr_txndata_error_to_json(const nrtxn_t* txn) {
   nrobj_t* agent_attributes;
@@ -526,7 +528,8 @@ static uint32_t nr_txndata_prepend_error_events(nr_flatbuffer_t* fb,
 }
 
 static uint32_t nr_txndata_prepend_trace_to_flatbuffer(nr_flatbuffer_t* fb,
-                                                       const nrtxn_t* txn) {
+                                                       const nrtxn_t* txn,
+                                                       bool external) {
   double duration_ms;
   double timestamp_ms;
   uint32_t data;
@@ -537,7 +540,12 @@ static uint32_t nr_txndata_prepend_trace_to_flatbuffer(nr_flatbuffer_t* fb,
     return 0;
   }
 
-  data = nr_flatbuffers_prepend_string(fb, txn->final_data.trace_json);
+  if (external) {
+    data = nr_flatbuffers_prepend_string_external(fb,
+                                                  txn->final_data.trace_json);
+  } else {
+    data = nr_flatbuffers_prepend_string(fb, txn->final_data.trace_json);
+  }
   guid = nr_flatbuffers_prepend_string(fb, nr_txn_get_guid(txn));
 
   timestamp_ms = nr_txn_start_time(txn) / NR_TIME_DIVISOR_MS_D;
@@ -619,7 +627,8 @@ static uint32_t nr_txndata_prepend_php_packages(nr_flatbuffer_t* fb,
 
 static uint32_t nr_txndata_prepend_transaction(nr_flatbuffer_t* fb,
                                                const nrtxn_t* txn,
-                                               int32_t pid) {
+                                               int32_t pid,
+                                               bool external_trace) {
   uint32_t custom_events;
   uint32_t error_events;
   uint32_t errors;
@@ -635,7 +644,11 @@ static uint32_t nr_txndata_prepend_transaction(nr_flatbuffer_t* fb,
   uint32_t php_packages;
   uint32_t log_labels;
 
-  txn_trace = nr_txndata_prepend_trace_to_flatbuffer(fb, txn);
+  /*
+   * The trace is prepended first, so that it can be left out of the buffer
+   * and written from the transaction when the message is sent.
+   */
+  txn_trace = nr_txndata_prepend_trace_to_flatbuffer(fb, txn, external_trace);
   span_events = nr_txndata_prepend_span_events(fb, txn->final_data.span_events,
                                                txn->app_limits.span_events);
   log_events
@@ -689,14 +702,177 @@ static uint32_t nr_txndata_prepend_transaction(nr_flatbuffer_t* fb,
   return nr_flatbuffers_object_end(fb);
 }
 
-nr_flatbuffer_t* nr_txndata_encode(const nrtxn_t* txn) {
+/*
+ * Encoding a large transaction into a buffer that starts out empty means
+ * growing, and therefore copying, the buffer many times. The encoded size of
+ * a transaction is fairly stable for a given transaction name, so a small
+ * table of size estimates is kept to size the buffer up front. Each entry is
+ * keyed by the full name of the last transaction recorded in it; names that
+ * hash to the same entry replace each other, which keeps the table's size
+ * fixed.
+ *
+ * An estimate is the largest size seen in the current window of
+ * NR_TXNDATA_SIZE_WINDOW transactions and the one before it, so a single
+ * large transaction stops inflating the estimate after at most two windows.
+ * Sizes are clamped to NR_TXNDATA_BUILDER_MAX_RETAINED, so an outlier never
+ * makes later transactions reserve a buffer that won't be kept.
+ *
+ * The buffer used to send transactions is also kept for the next transaction,
+ * unless it has grown beyond NR_TXNDATA_BUILDER_MAX_RETAINED.
+ */
+#define NR_TXNDATA_SIZE_ESTIMATES 64
+#define NR_TXNDATA_SIZE_WINDOW 8
+#define NR_TXNDATA_BUILDER_MAX_RETAINED (8 * 1024 * 1024)
+
+typedef struct _nr_txndata_size_estimate_t {
+  char* name;
+  size_t window_max;
+  size_t previous_max;
+  unsigned int samples;
+} nr_txndata_size_estimate_t;
+
+static struct {
+  nrthread_mutex_t mutex;
+  nr_txndata_size_estimate_t size_estimates[NR_TXNDATA_SIZE_ESTIMATES];
+  nr_flatbuffer_t* builder;
+} nr_txndata_encoder = {
+    .mutex = NRTHREAD_MUTEX_INITIALIZER,
+    .builder = NULL,
+};
+
+static size_t nr_txndata_size_estimate_index(const char* name) {
+  return nr_mkhash(name, NULL) % NR_TXNDATA_SIZE_ESTIMATES;
+}
+
+static size_t nr_txndata_size_estimate_value(
+    const nr_txndata_size_estimate_t* estimate) {
+  return estimate->window_max > estimate->previous_max
+             ? estimate->window_max
+             : estimate->previous_max;
+}
+
+static void nr_txndata_size_estimate_add(nr_txndata_size_estimate_t* estimate,
+                                         size_t size) {
+  if (size > NR_TXNDATA_BUILDER_MAX_RETAINED) {
+    size = NR_TXNDATA_BUILDER_MAX_RETAINED;
+  }
+
+  if (size > estimate->window_max) {
+    estimate->window_max = size;
+  }
+
+  estimate->samples += 1;
+  if (estimate->samples >= NR_TXNDATA_SIZE_WINDOW) {
+    estimate->previous_max = estimate->window_max;
+    estimate->window_max = 0;
+    estimate->samples = 0;
+  }
+}
+
+size_t nr_txndata_size_estimate(const nrtxn_t* txn) {
+  const nr_txndata_size_estimate_t* estimate;
+  size_t size = 0;
+
+  if (NULL == txn || NULL == txn->name) {
+    return 0;
+  }
+
+  nrt_mutex_lock(&nr_txndata_encoder.mutex);
+  estimate = &nr_txndata_encoder
+                  .size_estimates[nr_txndata_size_estimate_index(txn->name)];
+  if (0 == nr_strcmp(estimate->name, txn->name)) {
+    size = nr_txndata_size_estimate_value(estimate);
+  }
+  nrt_mutex_unlock(&nr_txndata_encoder.mutex);
+
+  return size;
+}
+
+void nr_txndata_record_size(const nrtxn_t* txn, size_t size) {
+  nr_txndata_size_estimate_t* estimate;
+
+  if (NULL == txn || NULL == txn->name) {
+    return;
+  }
+
+  nrt_mutex_lock(&nr_txndata_encoder.mutex);
+  estimate = &nr_txndata_encoder
+                  .size_estimates[nr_txndata_size_estimate_index(txn->name)];
+  if (0 != nr_strcmp(estimate->name, txn->name)) {
+    nr_free(estimate->name);
+    nr_memset(estimate, 0, sizeof(*estimate));
+    estimate->name = nr_strdup(txn->name);
+  }
+  nr_txndata_size_estimate_add(estimate, size);
+  nrt_mutex_unlock(&nr_txndata_encoder.mutex);
+}
+
+/*
+ * Purpose : Take the process' transaction buffer, or create a new one if
+ *           another thread is using it.
+ */
+static nr_flatbuffer_t* nr_txndata_builder_take(void) {
+  nr_flatbuffer_t* fb;
+
+  nrt_mutex_lock(&nr_txndata_encoder.mutex);
+  fb = nr_txndata_encoder.builder;
+  nr_txndata_encoder.builder = NULL;
+  nrt_mutex_unlock(&nr_txndata_encoder.mutex);
+
+  if (NULL == fb) {
+    fb = nr_flatbuffers_create(0);
+  }
+
+  return fb;
+}
+
+/*
+ * Purpose : Give a transaction buffer back to the process for reuse.
+ */
+static void nr_txndata_builder_release(nr_flatbuffer_t** fb_ptr) {
+  nr_flatbuffer_t* fb = *fb_ptr;
+
+  *fb_ptr = NULL;
+  if (nr_flatbuffers_capacity(fb) <= NR_TXNDATA_BUILDER_MAX_RETAINED) {
+    nr_flatbuffers_reset(fb);
+
+    nrt_mutex_lock(&nr_txndata_encoder.mutex);
+    if (NULL == nr_txndata_encoder.builder) {
+      nr_txndata_encoder.builder = fb;
+      fb = NULL;
+    }
+    nrt_mutex_unlock(&nr_txndata_encoder.mutex);
+  }
+
+  nr_flatbuffers_destroy(&fb);
+}
+
+void nr_cmd_txndata_shutdown(void) {
   nr_flatbuffer_t* fb;
+  size_t i;
+
+  nrt_mutex_lock(&nr_txndata_encoder.mutex);
+  fb = nr_txndata_encoder.builder;
+  nr_txndata_encoder.builder = NULL;
+  for (i = 0; i < NR_TXNDATA_SIZE_ESTIMATES; i++) {
+    nr_free(nr_txndata_encoder.size_estimates[i].name);
+    nr_memset(&nr_txndata_encoder.size_estimates[i], 0,
+              sizeof(nr_txndata_size_estimate_t));
+  }
+  nrt_mutex_unlock(&nr_txndata_encoder.mutex);
+
+  nr_flatbuffers_destroy(&fb);
+}
+
+static void nr_txndata_encode_message(nr_flatbuffer_t* fb,
+                                      const nrtxn_t* txn,
+                                      bool external_trace) {
   uint32_t message;
   uint32_t agent_run_id;
   uint32_t transaction;
 
-  fb = nr_flatbuffers_create(0);
-  transaction = nr_txndata_prepend_transaction(fb, txn, (int32_t)nr_getpid());
+  transaction = nr_txndata_prepend_transaction(fb, txn, (int32_t)nr_getpid(),
+                                               external_trace);
   agent_run_id = nr_flatbuffers_prepend_string(fb, txn->agent_run_id);
 
   nr_flatbuffers_object_begin(fb, MESSAGE_NUM_FIELDS);
@@ -708,6 +884,34 @@ nr_flatbuffer_t* nr_txndata_encode(const nrtxn_t* txn) {
   message = nr_flatbuffers_object_end(fb);
 
   nr_flatbuffers_finish(fb, message);
+}
+
+/*
+ * Purpose : Encode a transaction into an empty buffer, sizing the buffer from
+ *           the estimate for the transaction's name first, and record the
+ *           encoded size for the next transaction with the same name. If
+ *           external_trace is true, the trace is left in the transaction as
+ *           the buffer's external tail.
+ */
+static void nr_txndata_encode_presized(nr_flatbuffer_t* fb,
+                                       const nrtxn_t* txn,
+                                       bool external_trace) {
+  /*
+   * Leave some headroom, since the final alignment needs a little more
+   * than the encoded size.
+   */
+  nr_flatbuffers_reserve(fb, nr_txndata_size_estimate(txn) + 64);
+
+  nr_txndata_encode_message(fb, txn, external_trace);
+
+  nr_txndata_record_size(txn, nr_flatbuffers_len(fb));
+}
+
+nr_flatbuffer_t* nr_txndata_encode(const nrtxn_t* txn) {
+  nr_flatbuffer_t* fb;
+
+  fb = nr_flatbuffers_create(0);
+  nr_txndata_encode_message(fb, txn, false);
 
   return fb;
 }
@@ -746,13 +950,16 @@ nr_status_t nr_cmd_txndata_tx(int daemon_fd, const nrtxn_t* txn) {
       nr_txn_duration(txn), txn->options.tt_threshold,
       (double)nr_distributed_trace_get_priority(txn->distributed_trace));
 
-  msg = nr_txndata_encode(txn);
-  msglen = nr_flatbuffers_len(msg);
+  msg = nr_txndata_builder_take();
+  nr_txndata_encode_presized(msg, txn, true);
+  msglen = nr_command_flatbuffer_len(msg);
 
-  nrl_verbosedebug(NRL_DAEMON, "sending transaction message, len=%zu", msglen);
+  nrl_verbosedebug(NRL_DAEMON,
+                   "sending transaction message, len=%zu copied=%zu", msglen,
+                   nr_flatbuffers_bytes_copied(msg));
 
   if (nr_command_is_flatbuffer_invalid(msg, msglen)) {
-    nr_flatbuffers_destroy(&msg);
+    nr_txndata_builder_release(&msg);
     return NR_FAILURE;
   }
 
@@ -762,11 +969,10 @@ nr_status_t nr_cmd_txndata_tx(int daemon_fd, const nrtxn_t* txn) {
 
     deadline
         = nr_get_time() + (NR_TXNDATA_SEND_TIMEOUT_MSEC * NR_TIME_DIVISOR_MS);
-    st = nr_write_message(daemon_fd, nr_flatbuffers_data(msg), msglen,
-                          deadline);
+    st = nr_command_write_flatbuffer(daemon_fd, msg, deadline);
   }
   nr_agent_unlock_daemon_mutex();
-  nr_flatbuffers_destroy(&msg);
+  nr_txndata_builder_release(&msg);
 
   if (NR_SUCCESS != st) {
     nrl_error(NRL_DAEMON, "TXNDATA failure: len=%zu errno=%s", msglen,
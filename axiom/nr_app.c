@@ -126,6 +126,7 @@ void nr_app_destroy(nrapp_t** app_ptr) {
   nr_segment_terms_destroy(&app->segment_terms);
   nro_delete(app->connect_reply);
   nro_delete(app->security_policies);
+  nr_app_connect_state_release(&app->connect_state);
   nr_random_destroy(&app->rnd);
 
   nrt_mutex_unlock(&app->app_lock);
@@ -184,6 +185,7 @@ void nr_applist_destroy(nrapplist_t** applist_ptr) {
 
 nrapp_t* nr_app_verify_id(nrapplist_t* applist, const char* agent_run_id) {
   int i;
+  int num_apps;
   nrapp_t* app = 0;
 
   if (0 == applist) {
@@ -194,27 +196,28 @@ nrapp_t* nr_app_verify_id(nrapplist_t* applist, const char* agent_run_id) {
     return NULL;
   }
 
-  nrt_mutex_lock(&applist->applist_lock);
-  {
-    for (i = 0; i < applist->num_apps; i++) {
-      app = applist->apps[i];
+  /*
+   * The state and agent run ID of an app may change at any time, so each app
+   * is locked while it is checked. The list itself is not locked: see the
+   * "Application Locking" comment in nr_app.h.
+   */
+  num_apps = nrt_atomic_load_acquire(&applist->num_apps);
+  for (i = 0; i < num_apps; i++) {
+    app = nrt_atomic_load_acquire(&applist->apps[i]);
 
-      if (NULL == app) {
-        continue;
-      }
+    if (NULL == app) {
+      continue;
+    }
 
-      nrt_mutex_lock(&app->app_lock);
-      {
-        if ((NR_APP_OK == app->state)
-            && (0 == nr_strcmp(agent_run_id, app->agent_run_id))) {
-          nrt_mutex_unlock(&applist->applist_lock);
-          return app;
-        }
+    nrt_mutex_lock(&app->app_lock);
+    {
+      if ((NR_APP_OK == app->state)
+          && (0 == nr_strcmp(agent_run_id, app->agent_run_id))) {
+        return app;
       }
-      nrt_mutex_unlock(&app->app_lock);
     }
+    nrt_mutex_unlock(&app->app_lock);
   }
-  nrt_mutex_unlock(&applist->applist_lock);
 
   return NULL;
 }
@@ -339,9 +342,41 @@ static int nr_app_info_valid(const nr_app_info_t* info) {
   return 1;
 }
 
+/*
+ * Purpose : Search the published applications for one matching the given
+ *           information, without locking the application list.
+ *
+ * Params  : 1. The application list.
+ *           2. The application information.
+ *           3. Pointer to receive the number of applications searched.
+ *
+ * Returns : The matching application, unlocked, or NULL if none matched.
+ *
+ * Note    : Matching only reads the identifying info fields of each app, which
+ *           are immutable once the app has been published.
+ */
+static nrapp_t* nr_app_find_published(nrapplist_t* applist,
+                                      const nr_app_info_t* info,
+                                      int* num_apps_ptr) {
+  int i;
+  int num_apps = nrt_atomic_load_acquire(&applist->num_apps);
+
+  *num_apps_ptr = num_apps;
+  for (i = 0; i < num_apps; i++) {
+    nrapp_t* test_app = nrt_atomic_load_acquire(&applist->apps[i]);
+
+    if ((NULL != test_app) && (NR_SUCCESS == nr_app_match(test_app, info))) {
+      return test_app;
+    }
+  }
+
+  return NULL;
+}
+
 nrapp_t* nr_app_find_or_add_app(nrapplist_t* applist,
                                 const nr_app_info_t* info) {
   nrapp_t* app = 0;
+  int num_apps;
 
   if (0 == nr_app_info_valid(info)) {
     return 0;
@@ -350,61 +385,55 @@ nrapp_t* nr_app_find_or_add_app(nrapplist_t* applist,
     return 0;
   }
 
-  nrt_mutex_lock(&applist->applist_lock);
-  {
-    int i;
-    int num_apps = applist->num_apps;
+  app = nr_app_find_published(applist, info, &num_apps);
 
-    /*
-     * Search for the application.
-     */
-    app = 0;
-    for (i = 0; i < num_apps; i++) {
-      nrapp_t* test_app = applist->apps[i];
-
-      if (0 != test_app) {
-        nrt_mutex_lock(&test_app->app_lock);
-        {
-          if (NR_SUCCESS == nr_app_match(test_app, info)) {
-            /*
-             * The app is returned locked.
-             */
-            app = test_app;
-            break;
-          }
-        }
-        nrt_mutex_unlock(&test_app->app_lock);
-      }
-    }
-
-    if (app) {
-      /*
-       * A matching application was found in the loop above.
-       * Check that high security is set correctly.
-       * Note that it is impossible to have two applications with the same
-       * name and license but different high_security values:  New Relic's
-       * backend would reject one of the connections, since the account is
-       * either set to high security or not.
-       */
-      if (info->high_security != app->info.high_security) {
-        nr_app_log_high_security_mismatch(info->appname);
-        nrt_mutex_unlock(&app->app_lock);
-        app = 0;
-      }
-    } else {
+  if (NULL == app) {
+    nrt_mutex_lock(&applist->applist_lock);
+    {
       /*
-       * The app was not found and must be added if the app list is not full.
+       * Another thread may have added the application since the search
+       * above, so search again now that additions are excluded.
        */
-      if (num_apps >= NR_APP_LIMIT) {
-        log_app_limit_hard(info->appname);
-      } else {
-        app = create_new_app(info);
-        applist->apps[num_apps] = app;
-        applist->num_apps += 1;
+      app = nr_app_find_published(applist, info, &num_apps);
+
+      if (NULL == app) {
+        /*
+         * The app was not found and must be added if the app list is not
+         * full. New apps are created locked, and the app pointer is published
+         * before the count so that readers never see an unset slot.
+         */
+        if (num_apps >= NR_APP_LIMIT) {
+          log_app_limit_hard(info->appname);
+        } else {
+          app = create_new_app(info);
+          nrt_atomic_store_release(&applist->apps[num_apps], app);
+          nrt_atomic_store_release(&applist->num_apps, num_apps + 1);
+        }
+
+        nrt_mutex_unlock(&applist->applist_lock);
+        return app;
       }
     }
+    nrt_mutex_unlock(&applist->applist_lock);
+  }
+
+  /*
+   * The app is returned locked.
+   */
+  nrt_mutex_lock(&app->app_lock);
+
+  /*
+   * Check that high security is set correctly.
+   * Note that it is impossible to have two applications with the same
+   * name and license but different high_security values:  New Relic's
+   * backend would reject one of the connections, since the account is
+   * either set to high security or not.
+   */
+  if (info->high_security != app->info.high_security) {
+    nr_app_log_high_security_mismatch(info->appname);
+    nrt_mutex_unlock(&app->app_lock);
+    app = 0;
   }
-  nrt_mutex_unlock(&applist->applist_lock);
 
   return app;
 }
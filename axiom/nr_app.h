@@ -47,6 +47,14 @@
  * app which has been reclaimed. Threads that wish to hold a reference to an
  * unlocked application should instead hold an agent_run_id.
  *
+ * Applications are only ever appended to the application list, and are not
+ * reclaimed until the list itself is destroyed. The lookup functions below
+ * therefore search the list without taking the list lock: an application and
+ * its identifying info fields (license, appname and trace observer) are fully
+ * initialized before it is published to the list, and never change afterwards.
+ * Only the matching application is locked, and the list lock is only taken to
+ * add an application.
+ *
  * NOTE: This app limit should match the daemon's app limit set in limits.go.
  */
 #define NR_APP_LIMIT 250
@@ -95,6 +103,27 @@ typedef struct _nr_app_limits_t {
   int log_events;
 } nr_app_limits_t;
 
+/*
+ * The parts of an application that are needed to begin a transaction, as of
+ * its last connect. A new connect state is built and published each time the
+ * application connects, and is never modified afterwards: the application and
+ * every transaction begun from it share it by reference, so that beginning a
+ * transaction doesn't copy the connect reply.
+ */
+typedef struct _nr_app_connect_state_t {
+  int refcount; /* Updated atomically */
+  char* agent_run_id;
+  char* license;
+  char* entity_name;
+  char* host_display_name;
+  char* trace_observer_host;
+  int high_security;
+  bool lasp; /* Whether the app has a security policies token */
+  nrobj_t* connect_reply;
+  nrobj_t* security_policies;
+  nr_app_limits_t limits;
+} nr_app_connect_state_t;
+
 typedef struct _nrapp_t {
   nr_app_info_t info;
   nr_random_t* rnd;         /* Random number generator */
@@ -128,6 +157,10 @@ typedef struct _nrapp_t {
    * The exception are the span_event and log_event which is negotiated with the
    * backend. */
   nr_app_limits_t limits;
+
+  /* The connect state published by the last connect, or NULL if the app has
+   * never connected. A reference must be taken while the app is locked. */
+  nr_app_connect_state_t* connect_state;
 } nrapp_t;
 
 typedef enum _nrapptype_t {
@@ -138,9 +171,9 @@ typedef enum _nrapptype_t {
 } nrapptype_t;
 
 typedef struct _nrapplist_t {
-  int num_apps;
-  nrapp_t** apps;
-  nrthread_mutex_t applist_lock;
+  int num_apps;   /* Number of published apps; read with acquire semantics */
+  nrapp_t** apps; /* Fixed array of NR_APP_LIMIT app pointers */
+  nrthread_mutex_t applist_lock; /* Serializes adding apps */
 } nrapplist_t;
 
 /*
@@ -246,6 +279,44 @@ extern char* nr_app_get_primary_app_name(const char* appname);
  */
 bool nr_app_consider_appinfo(nrapp_t* app, time_t now);
 
+/*
+ * Purpose : Create a connect state from an application's current fields.
+ *
+ * Params  : 1. The application, which is assumed to be locked.
+ *
+ * Returns : A new connect state with a single reference, to be released with
+ *           nr_app_connect_state_release().
+ */
+extern nr_app_connect_state_t* nr_app_connect_state_create(const nrapp_t* app);
+
+/*
+ * Purpose : Take a reference to a connect state.
+ *
+ * Params  : 1. The connect state, which may be NULL.
+ *
+ * Returns : The connect state.
+ */
+extern nr_app_connect_state_t* nr_app_connect_state_ref(
+    nr_app_connect_state_t* state);
+
+/*
+ * Purpose : Release a reference to a connect state, destroying it once the
+ *           last reference is released.
+ *
+ * Params  : 1. A pointer to the reference, which is set to NULL.
+ */
+extern void nr_app_connect_state_release(nr_app_connect_state_t** state_ptr);
+
+/*
+ * Purpose : Build a connect state from an application's current fields and
+ *           publish it in place of the previous one, which is released.
+ *           Transactions that hold a reference to the previous connect state
+ *           keep using it.
+ *
+ * Params  : 1. The application, which is assumed to be locked.
+ */
+extern void nr_app_publish_connect_state(nrapp_t* app);
+
 /*
  * Purpose : Return the entity name related to the given application.
  *
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * This file contains functions to manage the connect state that an
+ * application shares with the transactions begun from it. They are kept apart
+ * from nr_app.c so that transactions can use them without pulling in the
+ * application list.
+ */
+#include "nr_axiom.h"
+
+#include "nr_app.h"
+#include "util_memory.h"
+#include "util_strings.h"
+#include "util_threads.h"
+
+nr_app_connect_state_t* nr_app_connect_state_create(const nrapp_t* app) {
+  nr_app_connect_state_t* state;
+
+  if (NULL == app) {
+    return NULL;
+  }
+
+  state = (nr_app_connect_state_t*)nr_zalloc(sizeof(nr_app_connect_state_t));
+  state->refcount = 1;
+  state->agent_run_id = nr_strdup(app->agent_run_id);
+  state->license = nr_strdup(app->info.license);
+  state->entity_name = nr_strdup(app->entity_name);
+  state->host_display_name = nr_strdup(app->info.host_display_name);
+  state->trace_observer_host = nr_strdup(app->info.trace_observer_host);
+  state->high_security = app->info.high_security;
+  state->lasp = !nr_strempty(app->info.security_policies_token);
+  state->connect_reply = nro_copy(app->connect_reply);
+  state->security_policies = nro_copy(app->security_policies);
+  state->limits = app->limits;
+
+  return state;
+}
+
+nr_app_connect_state_t* nr_app_connect_state_ref(
+    nr_app_connect_state_t* state) {
+  if (NULL != state) {
+    nrt_atomic_add_fetch(&state->refcount, 1);
+  }
+
+  return state;
+}
+
+void nr_app_connect_state_release(nr_app_connect_state_t** state_ptr) {
+  nr_app_connect_state_t* state;
+
+  if (NULL == state_ptr || NULL == *state_ptr) {
+    return;
+  }
+
+  state = *state_ptr;
+  *state_ptr = NULL;
+
+  if (0 != nrt_atomic_sub_fetch(&state->refcount, 1)) {
+    return;
+  }
+
+  nr_free(state->agent_run_id);
+  nr_free(state->license);
+  nr_free(state->entity_name);
+  nr_free(state->host_display_name);
+  nr_free(state->trace_observer_host);
+  nro_delete(state->connect_reply);
+  nro_delete(state->security_policies);
+  nr_free(state);
+}
+
+void nr_app_publish_connect_state(nrapp_t* app) {
+  nr_app_connect_state_t* previous;
+
+  if (NULL == app) {
+    return;
+  }
+
+  /*
+   * The connect state is built before it is published, so that a reference
+   * taken to it always sees it complete.
+   */
+  previous = app->connect_state;
+  nrt_atomic_store_release(&app->connect_state,
+                           nr_app_connect_state_create(app));
+  nr_app_connect_state_release(&previous);
+}
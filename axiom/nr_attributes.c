@@ -16,6 +16,7 @@
 #include "util_logging.h"
 #include "util_memory.h"
 #include "util_strings.h"
+#include "util_threads.h"
 
 static void nr_attribute_config_modify_destinations_internal(
     nr_attribute_config_t* config,
@@ -329,6 +330,9 @@ static void nr_attribute_config_modify_destinations_internal(
     return;
   }
 
+  /* The compiled filter no longer matches the modifier list. */
+  nr_attribute_filter_release(&config->filter);
+
   entry_ptr = &config->modifier_list;
   entry = *entry_ptr;
 
@@ -394,6 +398,403 @@ nr_attribute_destination_modifier_copy(
   return new_entry;
 }
 
+/*
+ * Compiled filters are kept in a small process-wide registry, guarded by a
+ * mutex, so that identical configurations share a filter.
+ */
+static struct {
+  nrthread_mutex_t mutex;
+  nr_attribute_filter_t* registry[NR_ATTRIBUTE_FILTER_REGISTRY_SIZE];
+} nr_attribute_filters = {
+    .mutex = NRTHREAD_MUTEX_INITIALIZER,
+};
+
+/*
+ * Each filter memoises the decisions for recently seen keys without locking.
+ * A memo slot is filled at most once, by publishing an entry with a compare
+ * and exchange, and entries are only freed with the filter. A reader that
+ * loads an entry therefore never sees it change or go away, and a key whose
+ * slot is taken by another key is simply looked up in the trie.
+ */
+typedef struct _nr_attribute_filter_memo_entry_t {
+  uint32_t key_hash;
+  nr_attribute_transform_t transform;
+  char key[];
+} nr_attribute_filter_memo_entry_t;
+
+static const nr_attribute_transform_t nr_attribute_transform_identity
+    = {.keep = ~(uint32_t)0, .set = 0};
+
+/*
+ * Returns the transform that applies first and then second.
+ */
+static nr_attribute_transform_t nr_attribute_transform_compose(
+    nr_attribute_transform_t first,
+    nr_attribute_transform_t second) {
+  nr_attribute_transform_t composed;
+
+  composed.keep = first.keep & second.keep;
+  composed.set = (first.set & second.keep) | second.set;
+
+  return composed;
+}
+
+static nr_attribute_transform_t nr_attribute_destination_modifier_transform(
+    const nr_attribute_destination_modifier_t* modifier) {
+  nr_attribute_transform_t transform;
+
+  /* As in nr_attribute_destination_modifier_apply, exclude has priority. */
+  transform.keep = ~modifier->exclude_destinations;
+  transform.set
+      = modifier->include_destinations & ~modifier->exclude_destinations;
+
+  return transform;
+}
+
+static uint32_t nr_attribute_filter_add_node(nr_attribute_filter_t* filter,
+                                             uint32_t parent,
+                                             char c) {
+  nr_attribute_filter_node_t* node;
+  uint32_t index;
+
+  if (filter->num_nodes == filter->capacity) {
+    filter->capacity *= 2;
+    filter->nodes = (nr_attribute_filter_node_t*)nr_realloc(
+        filter->nodes, filter->capacity * sizeof(nr_attribute_filter_node_t));
+  }
+
+  index = filter->num_nodes++;
+  node = &filter->nodes[index];
+  node->first_child = 0;
+  node->next_sibling = 0;
+  node->parent = parent;
+  node->c = c;
+  node->prefix = nr_attribute_transform_identity;
+  node->exact = nr_attribute_transform_identity;
+
+  if (index > 0) {
+    node->next_sibling = filter->nodes[parent].first_child;
+    filter->nodes[parent].first_child = index;
+  }
+
+  return index;
+}
+
+static uint32_t nr_attribute_filter_child(const nr_attribute_filter_t* filter,
+                                          uint32_t parent,
+                                          char c) {
+  uint32_t child;
+
+  for (child = filter->nodes[parent].first_child; child;
+       child = filter->nodes[child].next_sibling) {
+    if (filter->nodes[child].c == c) {
+      return child;
+    }
+  }
+
+  return 0;
+}
+
+static uint32_t nr_attribute_filter_fingerprint(
+    const nr_attribute_destination_modifier_t* modifiers) {
+  const nr_attribute_destination_modifier_t* modifier;
+  uint32_t fingerprint = 0;
+
+  for (modifier = modifiers; modifier; modifier = modifier->next) {
+    fingerprint = fingerprint * 31 + modifier->match_hash;
+    fingerprint = fingerprint * 31 + (uint32_t)modifier->has_wildcard_suffix;
+    fingerprint = fingerprint * 31 + modifier->include_destinations;
+    fingerprint = fingerprint * 31 + modifier->exclude_destinations;
+  }
+
+  return fingerprint;
+}
+
+static bool nr_attribute_filter_modifiers_equal(
+    const nr_attribute_destination_modifier_t* a,
+    const nr_attribute_destination_modifier_t* b) {
+  while (a && b) {
+    if ((a->has_wildcard_suffix != b->has_wildcard_suffix)
+        || (a->include_destinations != b->include_destinations)
+        || (a->exclude_destinations != b->exclude_destinations)
+        || (0 != nr_strcmp(a->match, b->match))) {
+      return false;
+    }
+    a = a->next;
+    b = b->next;
+  }
+
+  return (NULL == a) && (NULL == b);
+}
+
+static void nr_attribute_filter_destroy(nr_attribute_filter_t** filter_ptr) {
+  nr_attribute_filter_t* filter = *filter_ptr;
+  nr_attribute_destination_modifier_t* modifier;
+
+  if (NULL == filter) {
+    return;
+  }
+
+  modifier = filter->modifiers;
+  while (modifier) {
+    nr_attribute_destination_modifier_t* next = modifier->next;
+
+    nr_attribute_destination_modifier_destroy(&modifier);
+    modifier = next;
+  }
+
+  if (filter->memo) {
+    uint32_t i;
+
+    for (i = 0; i < NR_ATTRIBUTE_FILTER_MEMO_SIZE; i++) {
+      nr_free(filter->memo[i]);
+    }
+    nr_free(filter->memo);
+  }
+
+  nr_free(filter->nodes);
+  nr_realfree((void**)filter_ptr);
+}
+
+static nr_attribute_filter_t* nr_attribute_filter_compile(
+    const nr_attribute_destination_modifier_t* modifiers) {
+  nr_attribute_filter_t* filter;
+  const nr_attribute_destination_modifier_t* modifier;
+  nr_attribute_destination_modifier_t** copy_ptr;
+  uint32_t i;
+
+  filter = (nr_attribute_filter_t*)nr_zalloc(sizeof(nr_attribute_filter_t));
+  filter->fingerprint = nr_attribute_filter_fingerprint(modifiers);
+  filter->capacity = 8;
+  filter->nodes = (nr_attribute_filter_node_t*)nr_malloc(
+      filter->capacity * sizeof(nr_attribute_filter_node_t));
+  nr_attribute_filter_add_node(filter, 0, '\0');
+
+  /*
+   * Insert each modifier's match into the trie, combining the transforms of
+   * modifiers that end at the same node in list order.
+   */
+  copy_ptr = &filter->modifiers;
+  for (modifier = modifiers; modifier; modifier = modifier->next) {
+    nr_attribute_filter_node_t* node;
+    uint32_t index = 0;
+    int j;
+
+    for (j = 0; j < modifier->match_len; j++) {
+      uint32_t child
+          = nr_attribute_filter_child(filter, index, modifier->match[j]);
+
+      if (0 == child) {
+        child = nr_attribute_filter_add_node(filter, index, modifier->match[j]);
+      }
+      index = child;
+    }
+
+    node = &filter->nodes[index];
+    if (modifier->has_wildcard_suffix) {
+      node->prefix = nr_attribute_transform_compose(
+          node->prefix, nr_attribute_destination_modifier_transform(modifier));
+    } else {
+      node->exact = nr_attribute_transform_compose(
+          node->exact, nr_attribute_destination_modifier_transform(modifier));
+    }
+
+    *copy_ptr = nr_attribute_destination_modifier_copy(modifier);
+    copy_ptr = &(*copy_ptr)->next;
+  }
+
+  /*
+   * The list is sorted so that the modifiers matching a key are applied from
+   * the shortest match to the longest, and a wildcard before an exact match
+   * of the same string. Accumulate the transforms down the trie in that
+   * order. Parents are always added before their children.
+   */
+  for (i = 0; i < filter->num_nodes; i++) {
+    nr_attribute_filter_node_t* node = &filter->nodes[i];
+
+    if (i > 0) {
+      node->prefix = nr_attribute_transform_compose(
+          filter->nodes[node->parent].prefix, node->prefix);
+    }
+    node->exact = nr_attribute_transform_compose(node->prefix, node->exact);
+  }
+
+  /*
+   * A filter without modifiers leaves every key unchanged, so there is
+   * nothing worth remembering.
+   */
+  if (filter->num_nodes > 1) {
+    filter->memo = (nr_attribute_filter_memo_entry_t**)nr_calloc(
+        NR_ATTRIBUTE_FILTER_MEMO_SIZE,
+        sizeof(nr_attribute_filter_memo_entry_t*));
+  }
+
+  return filter;
+}
+
+nr_attribute_filter_t* nr_attribute_filter_acquire(
+    const nr_attribute_destination_modifier_t* modifiers) {
+  nr_attribute_filter_t* filter = NULL;
+  nr_attribute_filter_t* evicted = NULL;
+  uint32_t fingerprint = nr_attribute_filter_fingerprint(modifiers);
+  int i;
+
+  nrt_mutex_lock(&nr_attribute_filters.mutex);
+  for (i = 0; i < NR_ATTRIBUTE_FILTER_REGISTRY_SIZE; i++) {
+    nr_attribute_filter_t* registered = nr_attribute_filters.registry[i];
+
+    if (registered && (registered->fingerprint == fingerprint)
+        && nr_attribute_filter_modifiers_equal(registered->modifiers,
+                                               modifiers)) {
+      nrt_atomic_add_fetch(&registered->refcount, 1);
+      filter = registered;
+      break;
+    }
+  }
+  nrt_mutex_unlock(&nr_attribute_filters.mutex);
+
+  if (filter) {
+    return filter;
+  }
+
+  filter = nr_attribute_filter_compile(modifiers);
+  filter->refcount = 1;
+
+  /*
+   * Register the new filter in an empty slot or, failing that, in place of a
+   * filter that nothing but the registry refers to. If every registered
+   * filter is in use, the new filter simply isn't shared.
+   */
+  nrt_mutex_lock(&nr_attribute_filters.mutex);
+  for (i = 0; i < NR_ATTRIBUTE_FILTER_REGISTRY_SIZE; i++) {
+    if (NULL == nr_attribute_filters.registry[i]) {
+      break;
+    }
+  }
+  if (NR_ATTRIBUTE_FILTER_REGISTRY_SIZE == i) {
+    for (i = 0; i < NR_ATTRIBUTE_FILTER_REGISTRY_SIZE; i++) {
+      /*
+       * Only the registry can take a reference to a filter that nothing
+       * else refers to, so this can't race with another reference.
+       */
+      if (1 == nrt_atomic_load_acquire(
+              &nr_attribute_filters.registry[i]->refcount)) {
+        evicted = nr_attribute_filters.registry[i];
+        break;
+      }
+    }
+  }
+  if (i < NR_ATTRIBUTE_FILTER_REGISTRY_SIZE) {
+    nr_attribute_filters.registry[i] = filter;
+    nrt_atomic_add_fetch(&filter->refcount, 1);
+  }
+  nrt_mutex_unlock(&nr_attribute_filters.mutex);
+
+  nr_attribute_filter_release(&evicted);
+
+  return filter;
+}
+
+static nr_attribute_filter_t* nr_attribute_filter_ref(
+    nr_attribute_filter_t* filter) {
+  nrt_atomic_add_fetch(&filter->refcount, 1);
+
+  return filter;
+}
+
+void nr_attribute_filter_release(nr_attribute_filter_t** filter_ptr) {
+  if ((NULL == filter_ptr) || (NULL == *filter_ptr)) {
+    return;
+  }
+
+  if (0 == nrt_atomic_sub_fetch(&(*filter_ptr)->refcount, 1)) {
+    nr_attribute_filter_destroy(filter_ptr);
+  }
+  *filter_ptr = NULL;
+}
+
+void nr_attribute_filter_cache_clear(void) {
+  nr_attribute_filter_t* registry[NR_ATTRIBUTE_FILTER_REGISTRY_SIZE];
+  int i;
+
+  nrt_mutex_lock(&nr_attribute_filters.mutex);
+  nr_memcpy(registry, nr_attribute_filters.registry, sizeof(registry));
+  nr_memset(nr_attribute_filters.registry, 0,
+            sizeof(nr_attribute_filters.registry));
+  nrt_mutex_unlock(&nr_attribute_filters.mutex);
+
+  for (i = 0; i < NR_ATTRIBUTE_FILTER_REGISTRY_SIZE; i++) {
+    nr_attribute_filter_release(&registry[i]);
+  }
+}
+
+nr_attribute_transform_t nr_attribute_filter_lookup(
+    const nr_attribute_filter_t* filter,
+    const char* key) {
+  uint32_t index = 0;
+
+  for (; *key; key++) {
+    uint32_t child = nr_attribute_filter_child(filter, index, *key);
+
+    if (0 == child) {
+      /*
+       * No modifier matches anything longer than the prefix walked so far.
+       */
+      return filter->nodes[index].prefix;
+    }
+    index = child;
+  }
+
+  return filter->nodes[index].exact;
+}
+
+/*
+ * Purpose : Find the transform for a key, using the filter's memo if
+ *           possible.
+ */
+static nr_attribute_transform_t nr_attribute_filter_decide(
+    nr_attribute_filter_t* filter,
+    const char* key,
+    uint32_t key_hash) {
+  nr_attribute_filter_memo_entry_t** slot;
+  nr_attribute_filter_memo_entry_t* entry;
+  nr_attribute_filter_memo_entry_t* expected = NULL;
+  nr_attribute_transform_t transform;
+  size_t key_len;
+
+  if (NULL == filter->memo) {
+    return filter->nodes[0].exact;
+  }
+
+  key_len = (size_t)nr_strlen(key);
+  if (key_len >= NR_ATTRIBUTE_FILTER_MEMO_KEY_SIZE) {
+    return nr_attribute_filter_lookup(filter, key);
+  }
+
+  slot = &filter->memo[key_hash % NR_ATTRIBUTE_FILTER_MEMO_SIZE];
+  entry = nrt_atomic_load_acquire(slot);
+  if (entry) {
+    if ((entry->key_hash == key_hash) && (0 == nr_strcmp(entry->key, key))) {
+      return entry->transform;
+    }
+    return nr_attribute_filter_lookup(filter, key);
+  }
+
+  transform = nr_attribute_filter_lookup(filter, key);
+
+  entry = (nr_attribute_filter_memo_entry_t*)nr_malloc(
+      sizeof(nr_attribute_filter_memo_entry_t) + key_len + 1);
+  entry->key_hash = key_hash;
+  entry->transform = transform;
+  nr_memcpy(entry->key, key, key_len + 1);
+  if (!nrt_atomic_compare_exchange(slot, &expected, entry)) {
+    /* Another thread filled the slot first. */
+    nr_free(entry);
+  }
+
+  return transform;
+}
+
 nr_attribute_config_t* nr_attribute_config_copy(
     const nr_attribute_config_t* config) {
   nr_attribute_config_t* new_config;
@@ -418,13 +819,23 @@ nr_attribute_config_t* nr_attribute_config_copy(
     new_entry_ptr = &new_entry->next;
   }
 
+  /*
+   * Configurations are copied for each transaction and attribute store, so
+   * this is where the modifier list is compiled.
+   */
+  if (config->filter) {
+    new_config->filter = nr_attribute_filter_ref(config->filter);
+  } else {
+    new_config->filter = nr_attribute_filter_acquire(config->modifier_list);
+  }
+
   return new_config;
 }
 
-uint32_t nr_attribute_config_apply(const nr_attribute_config_t* config,
-                                   const char* key,
-                                   uint32_t key_hash,
-                                   uint32_t destinations) {
+uint32_t nr_attribute_config_apply_list(const nr_attribute_config_t* config,
+                                        const char* key,
+                                        uint32_t key_hash,
+                                        uint32_t destinations) {
   nr_attribute_destination_modifier_t* modifier;
 
   if (0 == key) {
@@ -451,6 +862,29 @@ uint32_t nr_attribute_config_apply(const nr_attribute_config_t* config,
   return destinations;
 }
 
+uint32_t nr_attribute_config_apply(const nr_attribute_config_t* config,
+                                   const char* key,
+                                   uint32_t key_hash,
+                                   uint32_t destinations) {
+  nr_attribute_transform_t transform;
+
+  if ((0 == key) || (0 == config) || (NULL == config->filter)) {
+    return nr_attribute_config_apply_list(config, key, key_hash,
+                                          destinations);
+  }
+
+  transform = nr_attribute_filter_decide(config->filter, key, key_hash);
+  destinations = (destinations & transform.keep) | transform.set;
+
+  /*
+   * Apply the disabled destinations filter last, since it has priority over
+   * all include/exclude settings.
+   */
+  destinations &= ~config->disabled_destinations;
+
+  return destinations;
+}
+
 void nr_attribute_config_destroy(nr_attribute_config_t** config_ptr) {
   nr_attribute_destination_modifier_t* modifier;
   nr_attribute_config_t* config;
@@ -471,6 +905,7 @@ void nr_attribute_config_destroy(nr_attribute_config_t** config_ptr) {
     modifier = next;
   }
 
+  nr_attribute_filter_release(&config->filter);
   nr_realfree((void**)config_ptr);
 }
 
@@ -154,6 +154,11 @@ extern void nr_attribute_config_modify_destinations(
 
 /*
  * Purpose : Copy an attribute configuration.
+ *
+ * Note    : The copy's destination modifiers are compiled into a filter that
+ *           is shared with every other copy of an identical configuration, so
+ *           that applying the configuration to a key doesn't depend on the
+ *           number of modifiers. Modifying the copy discards its filter.
  */
 extern nr_attribute_config_t* nr_attribute_config_copy(
     const nr_attribute_config_t* config);
@@ -163,6 +168,13 @@ extern nr_attribute_config_t* nr_attribute_config_copy(
  */
 extern void nr_attribute_config_destroy(nr_attribute_config_t** config_ptr);
 
+/*
+ * Purpose : Release the compiled filters and memoised decisions kept for
+ *           later configurations. Filters still in use are freed when the
+ *           last configuration using them is destroyed.
+ */
+extern void nr_attribute_filter_cache_clear(void);
+
 /*
  * Purpose : Create a new empty attribute store.
  */
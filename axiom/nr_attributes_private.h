@@ -27,9 +27,76 @@ typedef struct _nr_attribute_destination_modifier_t {
       next; /* Next linked list entry */
 } nr_attribute_destination_modifier_t;
 
+/*
+ * A change to a set of destinations: destinations = (destinations & keep) |
+ * set. Applying a modifier, or any sequence of modifiers, is such a change,
+ * so a sequence of modifiers can be composed into a single transform.
+ */
+typedef struct _nr_attribute_transform_t {
+  uint32_t keep;
+  uint32_t set;
+} nr_attribute_transform_t;
+
+/*
+ * A node in the prefix trie of a compiled attribute filter. The path from the
+ * root to a node spells out a key prefix.
+ */
+typedef struct _nr_attribute_filter_node_t {
+  uint32_t first_child;  /* Index of the first child, or 0 if none */
+  uint32_t next_sibling; /* Index of the next sibling, or 0 if none */
+  uint32_t parent;       /* Index of the parent */
+  char c;                /* The last byte of this node's prefix */
+  nr_attribute_transform_t prefix; /* The combined transform of every
+                                      wildcard modifier matching a key that
+                                      starts with this node's prefix */
+  nr_attribute_transform_t exact;  /* The combined transform of every
+                                      modifier matching a key equal to this
+                                      node's prefix */
+} nr_attribute_filter_node_t;
+
+/*
+ * A destination modifier list compiled into a prefix trie, so that the
+ * transform for a key is found by walking the key once, rather than by
+ * matching it against every modifier.
+ *
+ * Apart from their memos, filters are immutable once compiled. They are
+ * shared by reference counting between the copies of a configuration.
+ * Filters compiled from identical modifier lists are also shared across
+ * configurations, so that the configuration built for each request reuses
+ * the same filter and the same memoised decisions.
+ */
+typedef struct _nr_attribute_filter_t {
+  uint32_t fingerprint; /* A hash of the modifiers */
+  int refcount;         /* Updated atomically */
+  nr_attribute_destination_modifier_t* modifiers; /* The modifiers the filter
+                                                     was compiled from */
+  nr_attribute_filter_node_t* nodes; /* nodes[0] is the root */
+  uint32_t num_nodes;
+  uint32_t capacity;
+  struct _nr_attribute_filter_memo_entry_t** memo; /* The memoised decisions,
+                                                      or NULL if the filter
+                                                      has no modifiers */
+} nr_attribute_filter_t;
+
+/*
+ * The number of distinct compiled filters shared across configurations.
+ * A filter compiled once the registry is full replaces one that is no longer
+ * in use, or else is used without being shared.
+ */
+#define NR_ATTRIBUTE_FILTER_REGISTRY_SIZE 16
+
+/*
+ * The number of slots in each filter's memo of decisions, which maps a key to
+ * its transform. Keys of this length or longer are not memoised.
+ */
+#define NR_ATTRIBUTE_FILTER_MEMO_SIZE 256
+#define NR_ATTRIBUTE_FILTER_MEMO_KEY_SIZE 48
+
 struct _nr_attribute_config_t {
   uint32_t
       disabled_destinations; /* Destinations that no attributes should go to. */
+  nr_attribute_filter_t* filter; /* The compiled modifier list, or NULL if it
+                                    hasn't been compiled */
   /*
    * Linked list of destination modifiers.
    * The order of this list is important.  This ordering is based primarily on
@@ -86,6 +153,38 @@ extern uint32_t nr_attribute_config_apply(const nr_attribute_config_t* config,
                                           const char* key,
                                           uint32_t key_hash,
                                           uint32_t destinations);
+
+/*
+ * Purpose : Apply a configuration to a key by matching the key against every
+ *           destination modifier in turn. This is the reference behaviour for
+ *           compiled filters, and is used for configurations that haven't
+ *           been compiled.
+ */
+extern uint32_t nr_attribute_config_apply_list(
+    const nr_attribute_config_t* config,
+    const char* key,
+    uint32_t key_hash,
+    uint32_t destinations);
+
+/*
+ * Purpose : Return a compiled filter for a modifier list, either by sharing
+ *           an identical filter that has already been compiled, or by
+ *           compiling a new one.
+ *
+ * Returns : A filter, which must be released with
+ *           nr_attribute_filter_release().
+ */
+extern nr_attribute_filter_t* nr_attribute_filter_acquire(
+    const nr_attribute_destination_modifier_t* modifiers);
+
+extern void nr_attribute_filter_release(nr_attribute_filter_t** filter_ptr);
+
+/*
+ * Purpose : Find the transform for a key by walking the filter's trie.
+ */
+extern nr_attribute_transform_t nr_attribute_filter_lookup(
+    const nr_attribute_filter_t* filter,
+    const char* key);
 extern void nr_attribute_destroy(nr_attribute_t** attribute_ptr);
 extern void nr_attributes_remove_duplicate(nr_attributes_t* ats,
                                            const char* key,
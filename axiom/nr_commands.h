@@ -73,6 +73,11 @@ extern nr_status_t nr_cmd_span_batch_tx(
  */
 extern nr_status_t nr_cmd_txndata_tx(int daemon_fd, const nrtxn_t* txn);
 
+/*
+ * Purpose : Free the buffer kept for encoding transactions.
+ */
+extern void nr_cmd_txndata_shutdown(void);
+
 /* Hook for stubbing APPINFO messages during testing. */
 extern nr_status_t (*nr_cmd_appinfo_hook)(int daemon_fd, nrapp_t* app);
 
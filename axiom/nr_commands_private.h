@@ -10,6 +10,7 @@
 #define NR_COMMANDS_PRIVATE_HDR
 
 #include "util_flatbuffers.h"
+#include "util_time.h"
 
 /*
  * The minimum size of a flatbuffer message (no agent run or message body).
@@ -26,6 +27,27 @@
 extern int nr_command_is_flatbuffer_invalid(nr_flatbuffer_t* msg,
                                             size_t msglen);
 
+/*
+ * Purpose : Returns the length of a message, including its external tail.
+ */
+extern size_t nr_command_flatbuffer_len(const nr_flatbuffer_t* msg);
+
+/*
+ * Purpose : Write a message to the daemon. The flatbuffer and its external
+ *           tail are framed and written with a single vectored write, rather
+ *           than being assembled in contiguous memory first.
+ *
+ * Params  : 1. The daemon file descriptor.
+ *           2. The message.
+ *           3. The write deadline.
+ *
+ * Returns : NR_SUCCESS if the complete message was written; otherwise,
+ *           NR_FAILURE.
+ */
+extern nr_status_t nr_command_write_flatbuffer(int daemon_fd,
+                                               const nr_flatbuffer_t* msg,
+                                               nrtime_t deadline);
+
 /*
  * The following enums define the field indexes for the various types
  * of data that sent to and received from the daemon. These *MUST*
@@ -223,4 +245,24 @@ extern uint32_t nr_txndata_prepend_span_events(nr_flatbuffer_t* fb,
 
 extern nr_flatbuffer_t* nr_txndata_encode(const nrtxn_t* txn);
 
+/*
+ * Purpose : Return the estimated encoded size of a transaction, based on the
+ *           sizes of earlier transactions with the same name.
+ *
+ * Params  : 1. The transaction.
+ *
+ * Returns : The estimated size in bytes, or 0 if there is no estimate.
+ */
+extern size_t nr_txndata_size_estimate(const nrtxn_t* txn);
+
+/*
+ * Purpose : Record the encoded size of a transaction, to update the estimate
+ *           for its name. Sizes larger than the transaction buffer that is
+ *           kept for reuse are recorded as that size.
+ *
+ * Params  : 1. The transaction.
+ *           2. The encoded size in bytes.
+ */
+extern void nr_txndata_record_size(const nrtxn_t* txn, size_t size);
+
 #endif /* NR_COMMANDS_PRIVATE_HDR */
@@ -118,6 +118,11 @@ nr_argv_t* nr_daemon_args_to_argv(const char* name,
                           args->app_timeout);
     }
 
+    if (args->connect_cache_file && ('\0' != args->connect_cache_file[0])) {
+      nr_argv_append_flag(argv, "--define", "connect_cache_file=%s",
+                          args->connect_cache_file);
+    }
+
     /* utilization */
     nr_argv_append_flag(argv, "--define", "utilization.detect_aws=%s",
                         args->utilization.aws ? "true" : "false");
@@ -34,8 +34,9 @@ typedef struct _nr_daemon_args_t {
   const char* tls_capath; /* use custom X509 certificates found by scanning this
                              directory  */
 
-  const char* app_timeout;   /* application inactivity timeout */
-  const char* start_timeout; /* timeout for acquiring a socket */
+  const char* app_timeout;        /* application inactivity timeout */
+  const char* connect_cache_file; /* file used to persist connect replies */
+  const char* start_timeout;      /* timeout for acquiring a socket */
 
   /*
    * The following options control additional diagnostic and testing
@@ -12,9 +12,10 @@
 
 #include "nr_distributed_trace.h"
 #include "nr_distributed_trace_private.h"
+#include "util_buffer.h"
+#include "util_json.h"
 #include "util_memory.h"
 #include "util_object.h"
-#include "util_regex.h"
 #include "util_time.h"
 #include "util_strings.h"
 #include "util_logging.h"
@@ -227,6 +228,9 @@ nrobj_t* nr_distributed_trace_convert_payload_to_object(const char* payload,
   return obj_payload;
 }
 
+static void nr_distributed_trace_outbound_clear(
+    nr_distributed_trace_outbound_t* outbound);
+
 void nr_distributed_trace_destroy(nr_distributed_trace_t** ptr) {
   nr_distributed_trace_t* trace = NULL;
 
@@ -251,6 +255,8 @@ void nr_distributed_trace_destroy(nr_distributed_trace_t** ptr) {
   nr_free(trace->inbound.raw_tracing_vendors);
   nr_free(trace->inbound.trusted_parent_id);
 
+  nr_distributed_trace_outbound_clear(&trace->outbound);
+
   nr_realfree((void**)ptr);
 }
 
@@ -844,106 +850,390 @@ bool nr_distributed_trace_accept_inbound_w3c_payload(
   return true;
 }
 
+/*
+ * The length of a version 00 trace parent header:
+ * version-trace_id-parent_id-trace_flags.
+ */
+#define NR_W3C_TRACEPARENT_LEN 55
+
+/*
+ * New Relic trace state entries longer than this are truncated before they
+ * are parsed.
+ */
+#define NR_W3C_TRACESTATE_NR_ENTRY_MAX 259
+
+typedef enum _nr_w3c_charclass_t {
+  NR_W3C_DIGITS,  /* [0-9] */
+  NR_W3C_ALNUM,   /* [0-9a-zA-Z] */
+  NR_W3C_DECIMAL, /* [0-9.] */
+} nr_w3c_charclass_t;
+
+static inline bool nr_w3c_is_lower_hex(const char* s, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (!nr_isdigit(s[i]) && ((s[i] < 'a') || (s[i] > 'f'))) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static inline bool nr_w3c_is_all_zeros(
+    const nr_distributed_trace_w3c_field_t* f) {
+  size_t i;
+
+  for (i = 0; i < f->len; i++) {
+    if ('0' != f->value[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static inline void nr_w3c_field_set(nr_distributed_trace_w3c_field_t* f,
+                                    const char* value,
+                                    size_t len) {
+  f->value = value;
+  f->len = len;
+}
+
+/*
+ * Purpose : Copy a field into a buffer as a string, so that it can be passed
+ *           to the C library's number parsing functions. Fields of the New
+ *           Relic trace state entry are never longer than the entry itself.
+ */
+static const char* nr_w3c_field_to_buffer(
+    const nr_distributed_trace_w3c_field_t* f,
+    char* buf,
+    size_t buf_size) {
+  size_t len = (f->len < buf_size) ? f->len : buf_size - 1;
+
+  nr_memcpy(buf, f->value, len);
+  buf[len] = '\0';
+
+  return buf;
+}
+
+/*
+ * Purpose : Find the next non-empty item in a delimited list, trimming
+ *           whitespace, in the same way as nr_strsplit().
+ *
+ * Params  : 1. The current position, which is updated.
+ *           2. The end of the list.
+ *           3. The delimiter.
+ *           4. The item to populate.
+ *
+ * Returns : True if an item was found.
+ */
+static bool nr_w3c_next_item(const char** cursor,
+                             const char* end,
+                             char delim,
+                             nr_distributed_trace_w3c_field_t* item) {
+  const char* s = *cursor;
+
+  while (NULL != s) {
+    const char* item_end = (const char*)memchr(s, delim, end - s);
+    const char* next = NULL;
+
+    if (NULL == item_end) {
+      item_end = end;
+    } else {
+      next = item_end + 1;
+    }
+
+    while ((item_end > s) && nr_isspace(item_end[-1])) {
+      item_end--;
+    }
+    while ((s < item_end) && nr_isspace(*s)) {
+      s++;
+    }
+
+    if (item_end > s) {
+      nr_w3c_field_set(item, s, item_end - s);
+      *cursor = next;
+      return true;
+    }
+
+    s = next;
+  }
+
+  *cursor = NULL;
+  return false;
+}
+
+static bool nr_w3c_is_nr_entry(const nr_distributed_trace_w3c_field_t* entry,
+                               const char* trusted_account_key) {
+  size_t key_len = nr_strlen(trusted_account_key);
+
+  return (entry->len >= key_len + nr_strlen("@nr="))
+         && (0 == nr_strncmp(entry->value, trusted_account_key, key_len))
+         && (0 == nr_strncmp(entry->value + key_len, "@nr=", 4));
+}
+
+/*
+ * Purpose : Get the key of another vendor's trace state entry: the first
+ *           non-empty item before an '='.
+ *
+ * Returns : True if the entry has a key.
+ */
+static bool nr_w3c_vendor_key(const nr_distributed_trace_w3c_field_t* entry,
+                              nr_distributed_trace_w3c_field_t* key) {
+  const char* cursor = entry->value;
+
+  return nr_w3c_next_item(&cursor, entry->value + entry->len, '=', key);
+}
+
+/*
+ * Purpose : Join the other vendors' trace state entries, or their keys, with
+ *           commas.
+ *
+ * Returns : A newly allocated string.
+ */
+static char* nr_w3c_join_vendors(
+    const nr_distributed_trace_w3c_headers_t* headers,
+    bool keys_only) {
+  const char* end = headers->tracestate + nr_strlen(headers->tracestate);
+  nr_distributed_trace_w3c_field_t entry;
+  nr_distributed_trace_w3c_field_t item;
+  const char* cursor;
+  char* joined;
+  int pass;
+
+  /*
+   * The first pass measures the joined string and the second fills it in.
+   */
+  joined = NULL;
+  for (pass = 0; pass < 2; pass++) {
+    size_t offset = 0;
+
+    cursor = headers->tracestate;
+    while (nr_w3c_next_item(&cursor, end, ',', &entry)) {
+      if (nr_w3c_is_nr_entry(&entry, headers->trusted_account_key)) {
+        continue;
+      }
+      item = entry;
+      if (keys_only && !nr_w3c_vendor_key(&entry, &item)) {
+        continue;
+      }
+
+      if (offset) {
+        if (joined) {
+          joined[offset] = ',';
+        }
+        offset++;
+      }
+      if (joined) {
+        nr_memcpy(joined + offset, item.value, item.len);
+      }
+      offset += item.len;
+    }
+
+    if (joined) {
+      joined[offset] = '\0';
+    } else {
+      joined = (char*)nr_malloc(offset + 1);
+    }
+  }
+
+  return joined;
+}
+
 /*
  * Purpose : Parse a W3C trace parent header.
  *
  *           Refer to this specification for further details:
  *           https://w3c.github.io/trace-context/#traceparent-header
+ *
+ *           The header must match:
+ *
+ *             ^[0-9a-f]{2}-[0-9a-f]{32}-[0-9a-f]{16}-[0-9a-f]{2}(-.*)?$
+ *
+ *           where, as in PCRE, '.' doesn't match a newline and '$' also
+ *           matches before a final newline.
  */
-static const char* nr_distributed_trace_convert_w3c_headers_traceparent(
-    nrobj_t* obj,
+static bool nr_w3c_parse_traceparent(
+    nr_distributed_trace_w3c_headers_t* headers,
     const char* traceparent) {
-  nrobj_t* traceparent_obj = NULL;
-  char* str = NULL;
-  char* additional = NULL;
-  const char* error = NULL;
-  nr_regex_t* regex = NULL;
-  nr_regex_substrings_t* ss = NULL;
-
-  if (NULL == traceparent || NULL == obj) {
+  const char* rest;
+  const char* newline;
+  bool additional = false;
+  char flags[3];
+
+  if (NULL == traceparent) {
     nrl_debug(NRL_CAT, "Inbound W3C trace parent: NULL given");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    goto end;
+    return false;
   }
 
   /* Note: the W3C Trace Context spec indicates lowercase alpha characters
    * in all hex values */
-  regex = nr_regex_create(
-      "^"
-      "(?P<version>[0-9a-f]{2})-"
-      "(?P<trace_id>[0-9a-f]{32})-"
-      "(?P<parent_id>[0-9a-f]{16})-"
-      "(?P<trace_flags>[0-9a-f]{2})"
-      "(?P<additional>-.*)?$",
-      0, 0);
-
-  ss = nr_regex_match_capture(regex, traceparent, strlen(traceparent));
-
-  if (NULL == ss) {
-    nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: cannot parse '%s'",
-                traceparent);
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    goto end;
+  if ((nr_strlen(traceparent) < NR_W3C_TRACEPARENT_LEN)
+      || !nr_w3c_is_lower_hex(traceparent, 2) || ('-' != traceparent[2])
+      || !nr_w3c_is_lower_hex(traceparent + 3, 32) || ('-' != traceparent[35])
+      || !nr_w3c_is_lower_hex(traceparent + 36, 16)
+      || ('-' != traceparent[52])
+      || !nr_w3c_is_lower_hex(traceparent + 53, 2)) {
+    goto invalid;
+  }
+
+  rest = traceparent + NR_W3C_TRACEPARENT_LEN;
+  if ('-' == rest[0]) {
+    additional = true;
+  } else if (('\0' != rest[0]) && (0 != nr_strcmp(rest, "\n"))) {
+    goto invalid;
+  }
+  newline = nr_strchr(rest, '\n');
+  if (NULL != newline && '\0' != newline[1]) {
+    goto invalid;
   }
 
-  traceparent_obj = nro_new_hash();
+  nr_w3c_field_set(&headers->version, traceparent, 2);
+  nr_w3c_field_set(&headers->trace_id, traceparent + 3, 32);
+  nr_w3c_field_set(&headers->parent_id, traceparent + 36, 16);
 
-  str = nr_regex_substrings_get_named(ss, "version");
-  if (0 == nr_strcmp(str, "ff")) {
+  if (0 == nr_strncmp(traceparent, "ff", 2)) {
     nrl_warning(NRL_CAT,
                 "Inbound W3C trace parent invalid: version 0xff is forbidden");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    nr_free(str);
-    goto end;
+    return false;
   }
-  additional = nr_regex_substrings_get_named(ss, "additional");
-  if (0 == nr_strcmp(str, "00") && NULL != additional) {
+  if (0 == nr_strncmp(traceparent, "00", 2) && additional) {
     nrl_warning(NRL_CAT,
                 "Inbound W3C trace parent invalid: received additional fields "
                 "that are not valid for trace parent version 00");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    nr_free(str);
-    nr_free(additional);
-    goto end;
+    return false;
+  }
+  if (nr_w3c_is_all_zeros(&headers->trace_id)) {
+    nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: trace id '%.*s'",
+                (int)headers->trace_id.len, headers->trace_id.value);
+    return false;
+  }
+  if (nr_w3c_is_all_zeros(&headers->parent_id)) {
+    nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: parent id '%.*s'",
+                (int)headers->parent_id.len, headers->parent_id.value);
+    return false;
   }
-  nro_set_hash_string(traceparent_obj, "version", str);
-  nr_free(str);
-  nr_free(additional);
 
-  str = nr_regex_substrings_get_named(ss, "trace_id");
-  if (0 == nr_strcmp(str, "00000000000000000000000000000000")) {
-    nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: trace id '%s'",
-                str);
-    nr_free(str);
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    goto end;
+  flags[0] = traceparent[53];
+  flags[1] = traceparent[54];
+  flags[2] = '\0';
+  headers->trace_flags = (int)strtol(flags, NULL, 16);
+
+  return true;
+
+invalid:
+  nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: cannot parse '%s'",
+              traceparent);
+  return false;
+}
+
+static bool nr_w3c_scan_field(const char** cursor,
+                              const char* end,
+                              nr_w3c_charclass_t charclass,
+                              bool required,
+                              bool dash_follows,
+                              nr_distributed_trace_w3c_field_t* field) {
+  const char* s = *cursor;
+
+  for (; s < end; s++) {
+    if (nr_isdigit(*s) || ((NR_W3C_ALNUM == charclass) && nr_isalpha(*s))
+        || ((NR_W3C_DECIMAL == charclass) && ('.' == *s))) {
+      continue;
+    }
+    break;
   }
-  nro_set_hash_string(traceparent_obj, "trace_id", str);
-  nr_free(str);
 
-  str = nr_regex_substrings_get_named(ss, "parent_id");
-  if (0 == nr_strcmp(str, "0000000000000000")) {
-    nrl_warning(NRL_CAT, "Inbound W3C trace parent invalid: parent id '%s'",
-                str);
-    nr_free(str);
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
-    goto end;
+  if (required && (s == *cursor)) {
+    return false;
+  }
+  nr_w3c_field_set(field, *cursor, s - *cursor);
+
+  if (dash_follows) {
+    if ((s >= end) || ('-' != *s)) {
+      return false;
+    }
+    s++;
+  }
+
+  *cursor = s;
+  return true;
+}
+
+/*
+ * Purpose : Parse the New Relic entry of a W3C trace state header. Anything
+ *           after the timestamp is ignored, so that newer versions of the
+ *           entry can add fields.
+ */
+static bool nr_w3c_parse_nr_entry(
+    nr_distributed_trace_w3c_headers_t* headers,
+    const nr_distributed_trace_w3c_field_t* entry) {
+  char buf[NR_W3C_TRACESTATE_NR_ENTRY_MAX + 1];
+  nr_distributed_trace_w3c_field_t version;
+  nr_distributed_trace_w3c_field_t parent_type;
+  nr_distributed_trace_w3c_field_t sampled;
+  nr_distributed_trace_w3c_field_t priority;
+  nr_distributed_trace_w3c_field_t timestamp;
+  size_t len = (entry->len < NR_W3C_TRACESTATE_NR_ENTRY_MAX)
+                   ? entry->len
+                   : NR_W3C_TRACESTATE_NR_ENTRY_MAX;
+  const char* end = entry->value + len;
+  const char* cursor = entry->value + nr_strlen(headers->trusted_account_key)
+                       + nr_strlen("@nr=");
+
+  if (cursor > end
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_DIGITS, true, true, &version)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_DIGITS, true, true,
+                            &parent_type)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_ALNUM, true, true,
+                            &headers->parent_account_id)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_ALNUM, true, true,
+                            &headers->parent_application_id)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_ALNUM, false, true,
+                            &headers->span_id)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_ALNUM, false, true,
+                            &headers->transaction_id)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_DIGITS, false, true, &sampled)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_DECIMAL, false, true,
+                            &priority)
+      || !nr_w3c_scan_field(&cursor, end, NR_W3C_DIGITS, true, false,
+                            &timestamp)) {
+    return false;
   }
-  nro_set_hash_string(traceparent_obj, "parent_id", str);
-  nr_free(str);
 
-  str = nr_regex_substrings_get_named(ss, "trace_flags");
-  nro_set_hash_int(traceparent_obj, "trace_flags", strtol(str, NULL, 16));
-  nr_free(str);
+  headers->nr_version
+      = (int)strtol(nr_w3c_field_to_buffer(&version, buf, sizeof(buf)), NULL,
+                    10);
+  headers->parent_type = (int)strtol(
+      nr_w3c_field_to_buffer(&parent_type, buf, sizeof(buf)), NULL, 10);
 
-  nro_set_hash(obj, "traceparent", traceparent_obj);
+  if (sampled.len) {
+    headers->has_sampled = true;
+    headers->sampled = (int)strtol(
+        nr_w3c_field_to_buffer(&sampled, buf, sizeof(buf)), NULL, 10);
+  }
 
-end:
-  nro_delete(traceparent_obj);
-  nr_regex_substrings_destroy(&ss);
-  nr_regex_destroy(&regex);
+  if (priority.len) {
+    char* endptr = NULL;
+    double value
+        = strtod(nr_w3c_field_to_buffer(&priority, buf, sizeof(buf)), &endptr);
 
-  return error;
+    if (endptr && *endptr != '\0') {
+      /* According to the specification, an invalid priority value
+       * should be treated as though it were omitted. */
+      nrl_warning(NRL_CAT, "Inbound W3C trace state invalid: priority '%s'",
+                  buf);
+    } else {
+      headers->has_priority = true;
+      headers->priority = value;
+    }
+  }
+
+  headers->timestamp = (int64_t)strtoull(
+      nr_w3c_field_to_buffer(&timestamp, buf, sizeof(buf)), NULL, 10);
+
+  headers->has_nr_entry = true;
+  return true;
 }
 
 /*
@@ -972,184 +1262,129 @@ end:
  *
  *           For example:
  *           190@nr=0-0-709288-8599547-f85f42fd82a4cf1d-164d3b4b0d09cb05-1-0.789-1563574856827
+ *
+ *           Other vendors' entries are only recorded here; they are copied
+ *           when the headers are accepted.
  */
-static const char* nr_distributed_trace_convert_w3c_headers_tracestate(
-    nrobj_t* obj,
+static const char* nr_w3c_parse_tracestate(
+    nr_distributed_trace_w3c_headers_t* headers,
     const char* tracestate,
-    const char* trusted_account_key NRUNUSED) {
-  nrobj_t* vendors = NULL;
-  char* tracing_vendors = NULL;
-  char* headers_to_be_forwarded = NULL;
-  nrobj_t* tracestate_obj = NULL;
-  const char* error = NULL;
-  char header_key[260] = {0};
-  char header_value[260] = {0};
-  const char* value;
-  int index;
-  char* regex_str = NULL;
-  char* str = NULL;
-  double priority;
-  char* endptr = NULL;
-  nr_regex_t* regex = NULL;
-  nr_regex_substrings_t* ss = NULL;
-  nrobj_t* parsed_vendor = NULL;
-
-  if (NULL == tracestate || NULL == obj || NULL == trusted_account_key) {
+    const char* trusted_account_key) {
+  nr_distributed_trace_w3c_field_t entry;
+  nr_distributed_trace_w3c_field_t nr_entry = {NULL, 0};
+  nr_distributed_trace_w3c_field_t key;
+  const char* end;
+  const char* cursor;
+  bool any_entries = false;
+
+  if (NULL == tracestate || NULL == trusted_account_key) {
     nrl_debug(NRL_CAT, "Inbound W3C trace state: NULL given");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
-    goto end;
+    return NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
   }
 
+  headers->tracestate = tracestate;
+  headers->trusted_account_key = trusted_account_key;
+
   /*
-   * Split the trace state header into key-value pairs.
+   * An empty header is a single empty entry from another vendor, which has
+   * an empty key.
    */
-  snprintf(header_key, sizeof(header_key), "%s@nr=", trusted_account_key);
-
-  vendors = nr_strsplit(tracestate, ",", 0);
-
-  if (nro_getsize(vendors) == 0) {
-    nrl_debug(NRL_CAT, "Inbound W3C trace state: no vendor strings");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
-    goto end;
+  if ('\0' == tracestate[0]) {
+    headers->has_other_vendors = true;
+    any_entries = true;
   }
 
   /*
-   * Separate the relevant New Relic key-value pair from others.
+   * Separate the relevant New Relic entry from the others. If there are
+   * several New Relic entries, the last one is used.
    */
-  for (index = 1; index <= nro_getsize(vendors); index++) {
-    value = nro_get_array_string(vendors, index, NULL);
-
-    if (0 == nr_strncmp(value, header_key, nr_strlen(header_key))) {
-      nr_strlcpy(header_value, value, sizeof(header_value));
-    } else {
-      /*
-       * Keep the other raw tracestate headers
-       */
-      headers_to_be_forwarded
-          = nr_str_append(headers_to_be_forwarded, value, ",");
-
-      /*
-       * Keep the other tracing vendors
-       */
-      parsed_vendor = nr_strsplit(value, "=", 0);
-      tracing_vendors = nr_str_append(
-          tracing_vendors, nro_get_array_string(parsed_vendor, 1, NULL), ",");
-      nro_delete(parsed_vendor);
+  end = tracestate + nr_strlen(tracestate);
+  cursor = tracestate;
+  while (nr_w3c_next_item(&cursor, end, ',', &entry)) {
+    any_entries = true;
+    if (nr_w3c_is_nr_entry(&entry, trusted_account_key)) {
+      nr_entry = entry;
+    } else if (nr_w3c_vendor_key(&entry, &key)) {
+      headers->has_other_vendors = true;
     }
   }
 
-  if (NULL != tracing_vendors) {
-    nrl_debug(NRL_CAT, "Inbound W3C trace state: found %s other vendors",
-              tracing_vendors);
-    nro_set_hash_string(obj, "tracingVendors", tracing_vendors);
-    nro_set_hash_string(obj, "rawTracingVendors", headers_to_be_forwarded);
+  if (!any_entries) {
+    nrl_debug(NRL_CAT, "Inbound W3C trace state: no vendor strings");
+    headers->tracestate = NULL;
+    return NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
+  }
+
+  if (headers->has_other_vendors) {
+    nrl_debug(NRL_CAT, "Inbound W3C trace state: found other vendors");
   }
 
-  if (0 == nr_strlen(header_value)) {
+  if (NULL == nr_entry.value) {
     nrl_debug(NRL_CAT, "Inbound W3C trace state: no NR entry");
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
-    goto end;
-  } else {
-    nrl_debug(NRL_CAT, "Inbound W3C trace state: found NR entry '%s'",
-              header_value);
+    return NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_NONRENTRY;
   }
+  nrl_debug(NRL_CAT, "Inbound W3C trace state: found NR entry '%.*s'",
+            (int)nr_entry.len, nr_entry.value);
 
-  /*
-   * Parse relevant New Relic key-value pair
-   */
-  regex_str = nr_formatf(
-      "^"
-      "%s"
-      "(?P<version>[0-9]+)-"
-      "(?P<parent_type>[0-9]+)-"
-      "(?P<parent_account_id>[0-9a-zA-Z]+)-"
-      "(?P<parent_application_id>[0-9a-zA-Z]+)-"
-      "(?P<span_id>[0-9a-zA-Z]*)-"
-      "(?P<transaction_id>[0-9a-zA-Z]*)-"
-      "(?P<sampled>[0-9]*)-"
-      "(?P<priority>[0-9.]*)-"
-      "(?P<timestamp>[0-9]+)",
-      header_key);
-
-  regex = nr_regex_create(regex_str, 0, 0);
-
-  ss = nr_regex_match_capture(regex, header_value, strlen(header_value));
-
-  if (NULL == ss) {
+  if (!nr_w3c_parse_nr_entry(headers, &nr_entry)) {
     nrl_warning(NRL_CAT,
-                "Inbound W3C trace state invalid: cannot parse NR entry '%s'",
-                header_value);
-    error = NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_INVALIDNRENTRY;
-    goto end;
+                "Inbound W3C trace state invalid: cannot parse NR entry '%.*s'",
+                (int)nr_entry.len, nr_entry.value);
+    return NR_DISTRIBUTED_TRACE_W3C_TRACESTATE_INVALIDNRENTRY;
   }
 
-  tracestate_obj = nro_new_hash();
-
-  str = nr_regex_substrings_get_named(ss, "version");
-  nro_set_hash_int(tracestate_obj, "version", strtol(str, NULL, 10));
-  nr_free(str);
-
-  str = nr_regex_substrings_get_named(ss, "parent_type");
-  nro_set_hash_int(tracestate_obj, "parent_type", strtol(str, NULL, 10));
-  nr_free(str);
-
-  str = nr_regex_substrings_get_named(ss, "parent_account_id");
-  nro_set_hash_string(tracestate_obj, "parent_account_id", str);
-  nr_free(str);
-
-  str = nr_regex_substrings_get_named(ss, "parent_application_id");
-  nro_set_hash_string(tracestate_obj, "parent_application_id", str);
-  nr_free(str);
+  return NULL;
+}
 
-  str = nr_regex_substrings_get_named(ss, "span_id");
-  if (nr_strlen(str)) {
-    nro_set_hash_string(tracestate_obj, "span_id", str);
-  }
-  nr_free(str);
+bool nr_distributed_trace_parse_w3c_headers(
+    nr_distributed_trace_w3c_headers_t* headers,
+    const char* traceparent,
+    const char* tracestate,
+    const char* trusted_account_key,
+    const char** error) {
+  const char* error_metric = NULL;
+  bool valid = false;
 
-  str = nr_regex_substrings_get_named(ss, "transaction_id");
-  if (nr_strlen(str)) {
-    nro_set_hash_string(tracestate_obj, "transaction_id", str);
+  if (NULL == headers) {
+    return false;
   }
-  nr_free(str);
+  nr_memset(headers, 0, sizeof(*headers));
 
-  str = nr_regex_substrings_get_named(ss, "sampled");
-  if (nr_strlen(str)) {
-    nro_set_hash_int(tracestate_obj, "sampled", strtol(str, NULL, 10));
-  }
-  nr_free(str);
+  /*
+   * Step 1 : Parse the trace parent header.
+   */
+  nrl_debug(NRL_CAT, "Inbound W3C trace parent: parsing '%s'",
+            NRSAFESTR(traceparent));
 
-  str = nr_regex_substrings_get_named(ss, "priority");
-  if (nr_strlen(str)) {
-    endptr = NULL;
-    priority = strtod(str, &endptr);
-    if (endptr && *endptr != '\0') {
-      /* According to the specification, an invalid priority value
-       * should be treated as though it were omitted. */
-      nrl_warning(NRL_CAT, "Inbound W3C trace state invalid: priority '%s'",
-                  str);
-    } else {
-      nro_set_hash_double(tracestate_obj, "priority", priority);
-    }
+  if (!nr_w3c_parse_traceparent(headers, traceparent)) {
+    error_metric = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
+    goto end;
   }
-  nr_free(str);
+  valid = true;
 
-  str = nr_regex_substrings_get_named(ss, "timestamp");
-  nro_set_hash_long(tracestate_obj, "timestamp", strtoull(str, NULL, 10));
-  nr_free(str);
+  /*
+   * Step 2 : Parse the trace state header.
+   */
+  nrl_debug(NRL_CAT, "Inbound W3C trace state: parsing '%s'",
+            NRSAFESTR(tracestate));
 
-  nro_set_hash(obj, "tracestate", tracestate_obj);
+  error_metric
+      = nr_w3c_parse_tracestate(headers, tracestate, trusted_account_key);
 
 end:
-  nro_delete(tracestate_obj);
-  nr_free(headers_to_be_forwarded);
-  nr_free(tracing_vendors);
-  nro_delete(vendors);
-  nr_free(regex_str);
-  nr_regex_substrings_destroy(&ss);
-  nr_regex_destroy(&regex);
+  if (error_metric && error) {
+    *error = error_metric;
+  }
+  return valid;
+}
+
+static void nr_w3c_set_hash_field(nrobj_t* obj,
+                                  const char* key,
+                                  const nr_distributed_trace_w3c_field_t* f) {
+  char* value = nr_strndup(f->value, f->len);
 
-  return error;
+  nro_set_hash_string(obj, key, value);
+  nr_free(value);
 }
 
 nrobj_t* nr_distributed_trace_convert_w3c_headers_to_object(
@@ -1157,39 +1392,153 @@ nrobj_t* nr_distributed_trace_convert_w3c_headers_to_object(
     const char* tracestate,
     const char* trusted_account_key,
     const char** error) {
-  nrobj_t* obj = NULL;
-  const char* error_metric = NULL;
+  nr_distributed_trace_w3c_headers_t headers;
+  nrobj_t* obj;
+  nrobj_t* child;
+
+  if (!nr_distributed_trace_parse_w3c_headers(
+          &headers, traceparent, tracestate, trusted_account_key, error)) {
+    return NULL;
+  }
 
   obj = nro_new_hash();
 
-  /*
-   * Step 1 : Parse the trace parent header.
-   */
-  nrl_debug(NRL_CAT, "Inbound W3C trace parent: parsing '%s'", traceparent);
+  child = nro_new_hash();
+  nr_w3c_set_hash_field(child, "version", &headers.version);
+  nr_w3c_set_hash_field(child, "trace_id", &headers.trace_id);
+  nr_w3c_set_hash_field(child, "parent_id", &headers.parent_id);
+  nro_set_hash_int(child, "trace_flags", headers.trace_flags);
+  nro_set_hash(obj, "traceparent", child);
+  nro_delete(child);
+
+  if (headers.has_other_vendors) {
+    char* vendors = nr_w3c_join_vendors(&headers, true);
+    char* raw_vendors = nr_w3c_join_vendors(&headers, false);
+
+    nro_set_hash_string(obj, "tracingVendors", vendors);
+    nro_set_hash_string(obj, "rawTracingVendors", raw_vendors);
+    nr_free(vendors);
+    nr_free(raw_vendors);
+  }
+
+  if (headers.has_nr_entry) {
+    child = nro_new_hash();
+    nro_set_hash_int(child, "version", headers.nr_version);
+    nro_set_hash_int(child, "parent_type", headers.parent_type);
+    nr_w3c_set_hash_field(child, "parent_account_id",
+                          &headers.parent_account_id);
+    nr_w3c_set_hash_field(child, "parent_application_id",
+                          &headers.parent_application_id);
+    if (headers.span_id.len) {
+      nr_w3c_set_hash_field(child, "span_id", &headers.span_id);
+    }
+    if (headers.transaction_id.len) {
+      nr_w3c_set_hash_field(child, "transaction_id", &headers.transaction_id);
+    }
+    if (headers.has_sampled) {
+      nro_set_hash_int(child, "sampled", headers.sampled);
+    }
+    if (headers.has_priority) {
+      nro_set_hash_double(child, "priority", headers.priority);
+    }
+    nro_set_hash_long(child, "timestamp", headers.timestamp);
+    nro_set_hash(obj, "tracestate", child);
+    nro_delete(child);
+  }
 
-  error_metric
-      = nr_distributed_trace_convert_w3c_headers_traceparent(obj, traceparent);
-  if (error_metric) {
-    nro_delete(obj);
-    goto end;
+  return obj;
+}
+
+/*
+ * Purpose : Assign a header field to a distributed trace field, in the same
+ *           way as set_dt_field().
+ */
+static inline void set_dt_field_from_w3c(
+    char** field,
+    const nr_distributed_trace_w3c_field_t* value) {
+  nr_free(*field);
+
+  if (value->len) {
+    *field = nr_strndup(value->value, value->len);
   }
+}
 
-  /*
-   * Step 2 : Parse the trace state header.
-   */
-  nrl_debug(NRL_CAT, "Inbound W3C trace state: parsing '%s'", tracestate);
+/*
+ * Purpose : Assign a newly allocated string to a distributed trace field, in
+ *           the same way as set_dt_field().
+ */
+static inline void set_dt_field_owned(char** field, char* value) {
+  nr_free(*field);
 
-  error_metric = nr_distributed_trace_convert_w3c_headers_tracestate(
-      obj, tracestate, trusted_account_key);
-  if (error_metric) {
-    goto end;
+  if (nr_strempty(value)) {
+    nr_free(value);
   }
+  *field = value;
+}
 
-end:
-  if (error_metric && error) {
-    *error = error_metric;
+bool nr_distributed_trace_accept_inbound_w3c_headers(
+    nr_distributed_trace_t* dt,
+    const nr_distributed_trace_w3c_headers_t* headers,
+    const char* transport_type,
+    const char** error) {
+  if (nrunlikely(NULL == error || NULL != *error)) {
+    return false;
   }
-  return obj;
+
+  if (NULL == dt) {
+    *error = NR_DISTRIBUTED_TRACE_W3C_TRACECONTEXT_ACCEPT_EXCEPTION;
+    return false;
+  }
+
+  // The trace parent trace and span IDs are required.
+  if (NULL == headers || 0 == headers->trace_id.len
+      || 0 == headers->parent_id.len) {
+    *error = NR_DISTRIBUTED_TRACE_W3C_TRACEPARENT_PARSE_EXCEPTION;
+    return false;
+  }
+
+  // When a trace starts with another vendor we won't have a valid tracestate.
+  // This is still a valid trace.
+  if (headers->has_nr_entry) {
+    if (headers->span_id.len) {
+      set_dt_field_from_w3c(&dt->inbound.trusted_parent_id, &headers->span_id);
+    }
+    set_dt_field_from_w3c(&dt->inbound.account_id,
+                          &headers->parent_account_id);
+    set_dt_field_from_w3c(&dt->inbound.app_id,
+                          &headers->parent_application_id);
+    if (headers->transaction_id.len) {
+      set_dt_field_from_w3c(&dt->inbound.txn_id, &headers->transaction_id);
+    }
+
+    /*
+     * As when accepting the headers as an object, an entry without a sampled
+     * flag leaves the trace sampled.
+     */
+    dt->sampled = headers->has_sampled ? (0 != headers->sampled) : true;
+
+    if (headers->has_priority && 0 < headers->priority) {
+      dt->priority = headers->priority;
+    }
+
+    dt->inbound.timestamp = (nrtime_t)headers->timestamp * NR_TIME_DIVISOR_MS;
+    nr_distributed_trace_set_parent_type(dt, headers->parent_type);
+  }
+
+  if (headers->has_other_vendors) {
+    set_dt_field_owned(&dt->inbound.tracing_vendors,
+                       nr_w3c_join_vendors(headers, true));
+    set_dt_field_owned(&dt->inbound.raw_tracing_vendors,
+                       nr_w3c_join_vendors(headers, false));
+  }
+
+  nr_distributed_trace_inbound_set_transport_type(dt, transport_type);
+  set_dt_field_from_w3c(&dt->inbound.guid, &headers->parent_id);
+
+  set_dt_field_from_w3c(&dt->trace_id, &headers->trace_id);
+
+  dt->inbound.set = true;
+  return true;
 }
 
 char* nr_distributed_trace_create_w3c_tracestate_header(
@@ -1253,33 +1602,51 @@ char* nr_distributed_trace_create_w3c_tracestate_header(
   return trace_context_header;
 }
 
-char* nr_distributed_trace_create_w3c_traceparent_header(const char* trace_id,
-                                                         const char* span_id,
-                                                         bool sampled) {
-  char* trace_parent_header = NULL;
-  char* flags = "00";
-  char formatted_trace_id[33];
+/*
+ * Purpose : Format a trace id for a traceparent header.
+ *
+ * Params  : 1. The buffer to write the formatted trace id to.
+ *           2. The size of the buffer, which must be at least
+ *              NR_TRACE_ID_MAX_SIZE + 1.
+ *           3. The trace id.
+ */
+static void nr_distributed_trace_format_w3c_trace_id(char* buf,
+                                                     size_t len,
+                                                     const char* trace_id) {
   char* tmp = NULL;
   int padding = 0;
 
-  if (nrunlikely(NULL == trace_id || NULL == span_id)) {
-    return NULL;
-  }
-
   /*
    * The trace_id for a traceparent header is required to be 32 characters
    * long and lowercase. A trace_id is less than that will be left padded with
    * 0's.
    */
   tmp = nr_string_to_lowercase(trace_id);
-  padding = 32 - nr_strlen(tmp);
+  padding = NR_TRACE_ID_MAX_SIZE - nr_strlen(tmp);
   if (padding > 0) {
-    snprintf(formatted_trace_id, sizeof(formatted_trace_id), "%0*d%s", padding,
-             0, tmp);
+    snprintf(buf, len, "%0*d%s", padding, 0, tmp);
   } else {
-    snprintf(formatted_trace_id, sizeof(formatted_trace_id), "%s", tmp);
+    snprintf(buf, len, "%s", tmp);
+  }
+
+  nr_free(tmp);
+}
+
+char* nr_distributed_trace_create_w3c_traceparent_header(const char* trace_id,
+                                                         const char* span_id,
+                                                         bool sampled) {
+  char* trace_parent_header = NULL;
+  char* flags = "00";
+  char formatted_trace_id[NR_TRACE_ID_MAX_SIZE + 1];
+
+  if (nrunlikely(NULL == trace_id || NULL == span_id)) {
+    return NULL;
   }
 
+  nr_distributed_trace_format_w3c_trace_id(formatted_trace_id,
+                                           sizeof(formatted_trace_id),
+                                           trace_id);
+
   /*
    * The flags field is 2 digit hex. At time time of writing this we only
    * use sampled. If we add functionality for more flags this logic will
@@ -1294,7 +1661,346 @@ char* nr_distributed_trace_create_w3c_traceparent_header(const char* trace_id,
   trace_parent_header
       = nr_formatf("00-%s-%s-%s", formatted_trace_id, span_id, flags);
 
-  nr_free(tmp);
-
   return trace_parent_header;
 }
+
+/*
+ * The number of characters needed to format a 64 bit unsigned integer in
+ * decimal.
+ */
+#define NR_DISTRIBUTED_TRACE_UINT64_DIGITS 20
+
+/*
+ * Span ids whose JSON representation fits in this many characters are escaped
+ * on the stack.
+ */
+#define NR_DISTRIBUTED_TRACE_SPAN_JSON_SIZE 128
+
+/*
+ * A part of an outbound header. Parts are not null terminated.
+ */
+typedef struct _nr_distributed_trace_part_t {
+  const char* str;
+  size_t len;
+} nr_distributed_trace_part_t;
+
+static inline nr_distributed_trace_part_t nr_distributed_trace_part(
+    const char* str) {
+  nr_distributed_trace_part_t part = {.str = str, .len = nr_strlen(str)};
+
+  return part;
+}
+
+/*
+ * Purpose : Concatenate header parts into a newly allocated string.
+ */
+static char* nr_distributed_trace_splice(
+    const nr_distributed_trace_part_t* parts,
+    size_t count) {
+  char* header;
+  char* dest;
+  size_t len = 0;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    len += parts[i].len;
+  }
+
+  header = (char*)nr_malloc(len + 1);
+  dest = header;
+  for (i = 0; i < count; i++) {
+    if (parts[i].len) {
+      nr_memcpy(dest, parts[i].str, parts[i].len);
+      dest += parts[i].len;
+    }
+  }
+  *dest = '\0';
+
+  return header;
+}
+
+/*
+ * Purpose : Format a timestamp in milliseconds without going through printf.
+ *
+ * Params  : 1. A buffer of at least NR_DISTRIBUTED_TRACE_UINT64_DIGITS
+ *              characters.
+ *           2. The time.
+ *
+ * Returns : The formatted timestamp, which ends at the end of the buffer and
+ *           is not null terminated.
+ */
+static nr_distributed_trace_part_t nr_distributed_trace_format_ms(
+    char* buf,
+    nrtime_t now) {
+  char* end = buf + NR_DISTRIBUTED_TRACE_UINT64_DIGITS;
+  char* start = end;
+  uint64_t ms = (uint64_t)(now / NR_TIME_DIVISOR_MS);
+  nr_distributed_trace_part_t part;
+
+  do {
+    start--;
+    *start = (char)('0' + (ms % 10));
+    ms /= 10;
+  } while (ms);
+
+  part.str = start;
+  part.len = (size_t)(end - start);
+
+  return part;
+}
+
+static inline char* nr_distributed_trace_outbound_dup(const char* value) {
+  return value ? nr_strdup(value) : NULL;
+}
+
+static inline bool nr_distributed_trace_outbound_matches(const char* cached,
+                                                         const char* value) {
+  if (NULL == cached || NULL == value) {
+    return cached == value;
+  }
+
+  return 0 == nr_strcmp(cached, value);
+}
+
+static void nr_distributed_trace_outbound_clear(
+    nr_distributed_trace_outbound_t* outbound) {
+  nr_free(outbound->account_id);
+  nr_free(outbound->app_id);
+  nr_free(outbound->txn_id);
+  nr_free(outbound->trace_id);
+  nr_free(outbound->trusted_key);
+  nr_free(outbound->traceparent_head);
+  nr_free(outbound->tracestate_head);
+  nr_free(outbound->tracestate_tail);
+  nr_free(outbound->payload_head);
+  nr_free(outbound->payload_tail);
+  nr_free(outbound->payload_end);
+  outbound->valid = false;
+}
+
+static bool nr_distributed_trace_outbound_is_current(
+    const nr_distributed_trace_t* dt) {
+  const nr_distributed_trace_outbound_t* outbound = &dt->outbound;
+
+  return outbound->valid && outbound->sampled == dt->sampled
+         && outbound->priority == dt->priority
+         && nr_distributed_trace_outbound_matches(outbound->account_id,
+                                                  dt->account_id)
+         && nr_distributed_trace_outbound_matches(outbound->app_id,
+                                                  dt->app_id)
+         && nr_distributed_trace_outbound_matches(outbound->txn_id,
+                                                  dt->txn_id)
+         && nr_distributed_trace_outbound_matches(outbound->trace_id,
+                                                  dt->trace_id)
+         && nr_distributed_trace_outbound_matches(outbound->trusted_key,
+                                                  dt->trusted_key);
+}
+
+static void nr_distributed_trace_outbound_add_field(nrbuf_t* buf,
+                                                    const char* key,
+                                                    const char* value) {
+  if (value) {
+    nr_buffer_add(buf, NR_PSTR(","));
+    nr_buffer_add_escape_json(buf, key);
+    nr_buffer_add(buf, NR_PSTR(":"));
+    nr_buffer_add_escape_json(buf, value);
+  }
+}
+
+static char* nr_distributed_trace_outbound_buffer_str(nrbuf_t* buf) {
+  char* str;
+
+  nr_buffer_add(buf, NR_PSTR("\0"));
+  str = nr_strdup((const char*)nr_buffer_cptr(buf));
+  nr_buffer_reset(buf);
+
+  return str;
+}
+
+/*
+ * Purpose : Build the parts of the outbound headers that don't depend on the
+ *           span id or the timestamp. Each part mirrors the corresponding
+ *           section of the uncached header functions above.
+ */
+static void nr_distributed_trace_outbound_build(nr_distributed_trace_t* dt) {
+  nr_distributed_trace_outbound_t* outbound = &dt->outbound;
+  char formatted_trace_id[NR_TRACE_ID_MAX_SIZE + 1];
+  char* priority;
+  nrobj_t* obj;
+  char* json;
+  nrbuf_t* buf;
+
+  nr_distributed_trace_outbound_clear(outbound);
+
+  outbound->account_id = nr_distributed_trace_outbound_dup(dt->account_id);
+  outbound->app_id = nr_distributed_trace_outbound_dup(dt->app_id);
+  outbound->txn_id = nr_distributed_trace_outbound_dup(dt->txn_id);
+  outbound->trace_id = nr_distributed_trace_outbound_dup(dt->trace_id);
+  outbound->trusted_key = nr_distributed_trace_outbound_dup(dt->trusted_key);
+  outbound->priority = dt->priority;
+  outbound->sampled = dt->sampled;
+
+  if (dt->trace_id) {
+    nr_distributed_trace_format_w3c_trace_id(
+        formatted_trace_id, sizeof(formatted_trace_id), dt->trace_id);
+    outbound->traceparent_head = nr_formatf("00-%s-", formatted_trace_id);
+  }
+
+  if (dt->trusted_key && dt->account_id && dt->app_id) {
+    priority = nr_priority_double_to_str(dt->priority);
+    outbound->tracestate_head = nr_formatf(
+        "%s@nr=0-0-%s-%s-", dt->trusted_key, dt->account_id, dt->app_id);
+    outbound->tracestate_tail = nr_formatf(
+        "-%s-%s-", dt->sampled ? "1" : "0", NRBLANKSTR(priority));
+    nr_free(priority);
+  }
+
+  buf = nr_buffer_create(256, 256);
+
+  json = nr_formatf("{\"v\":[%d,%d],\"d\":{\"ty\":\"App\"",
+                    NR_DISTRIBUTED_TRACE_VERSION_MAJOR,
+                    NR_DISTRIBUTED_TRACE_VERSION_MINOR);
+  nr_buffer_add(buf, json, nr_strlen(json));
+  nr_free(json);
+  nr_distributed_trace_outbound_add_field(buf, "ac", dt->account_id);
+  nr_distributed_trace_outbound_add_field(buf, "ap", dt->app_id);
+  outbound->payload_head = nr_distributed_trace_outbound_buffer_str(buf);
+
+  nr_distributed_trace_outbound_add_field(buf, "tr", dt->trace_id);
+  nr_distributed_trace_outbound_add_field(buf, "tx", dt->txn_id);
+  obj = nro_new_double(dt->priority);
+  json = nro_to_json(obj);
+  nr_buffer_add(buf, NR_PSTR(",\"pr\":"));
+  nr_buffer_add(buf, json, nr_strlen(json));
+  nr_free(json);
+  nro_delete(obj);
+  if (dt->sampled) {
+    nr_buffer_add(buf, NR_PSTR(",\"sa\":true"));
+  } else {
+    nr_buffer_add(buf, NR_PSTR(",\"sa\":false"));
+  }
+  nr_buffer_add(buf, NR_PSTR(",\"ti\":"));
+  outbound->payload_tail = nr_distributed_trace_outbound_buffer_str(buf);
+
+  /*
+   * According to the spec the trusted key is relevant only when it differs
+   * from the account id.
+   */
+  if (0 != nr_strcmp(dt->trusted_key, dt->account_id)) {
+    nr_distributed_trace_outbound_add_field(buf, "tk", dt->trusted_key);
+  }
+  nr_buffer_add(buf, NR_PSTR("}}"));
+  outbound->payload_end = nr_distributed_trace_outbound_buffer_str(buf);
+
+  nr_buffer_destroy(&buf);
+
+  outbound->valid = true;
+}
+
+static inline void nr_distributed_trace_outbound_ensure(
+    nr_distributed_trace_t* dt) {
+  if (!nr_distributed_trace_outbound_is_current(dt)) {
+    nr_distributed_trace_outbound_build(dt);
+  }
+}
+
+char* nr_distributed_trace_outbound_payload_text(nr_distributed_trace_t* dt,
+                                                 const char* span_id,
+                                                 nrtime_t now) {
+  char span_buf[NR_DISTRIBUTED_TRACE_SPAN_JSON_SIZE];
+  char ms_buf[NR_DISTRIBUTED_TRACE_UINT64_DIGITS];
+  char* span_json = NULL;
+  char* text;
+  nr_distributed_trace_part_t parts[5];
+  size_t span_json_size;
+  size_t count = 0;
+
+  if (NULL == dt || (NULL == span_id && NULL == dt->txn_id)) {
+    return NULL;
+  }
+
+  nr_distributed_trace_outbound_ensure(dt);
+
+  parts[count++] = nr_distributed_trace_part(dt->outbound.payload_head);
+  if (span_id) {
+    /*
+     * Span ids are generated guids, so the JSON escaped form almost always
+     * fits on the stack.
+     */
+    span_json_size = sizeof(",\"id\":") + (nr_strlen(span_id) * 6) + 3;
+    span_json = span_buf;
+    if (span_json_size > sizeof(span_buf)) {
+      span_json = (char*)nr_malloc(span_json_size);
+    }
+    parts[count].str = span_json;
+    nr_memcpy(span_json, NR_PSTR(",\"id\":"));
+    parts[count].len = sizeof(",\"id\":") - 1;
+    parts[count].len
+        += (size_t)nr_json_escape(span_json + parts[count].len, span_id);
+    count++;
+  }
+  parts[count++] = nr_distributed_trace_part(dt->outbound.payload_tail);
+  parts[count++] = nr_distributed_trace_format_ms(ms_buf, now);
+  parts[count++] = nr_distributed_trace_part(dt->outbound.payload_end);
+
+  text = nr_distributed_trace_splice(parts, count);
+
+  if (span_json != span_buf) {
+    nr_free(span_json);
+  }
+
+  return text;
+}
+
+char* nr_distributed_trace_outbound_traceparent(nr_distributed_trace_t* dt,
+                                                const char* span_id) {
+  nr_distributed_trace_part_t parts[3];
+
+  if (NULL == dt || NULL == span_id) {
+    return NULL;
+  }
+
+  nr_distributed_trace_outbound_ensure(dt);
+
+  if (NULL == dt->outbound.traceparent_head) {
+    return NULL;
+  }
+
+  parts[0] = nr_distributed_trace_part(dt->outbound.traceparent_head);
+  parts[1] = nr_distributed_trace_part(span_id);
+  parts[2] = nr_distributed_trace_part(dt->sampled ? "-01" : "-00");
+
+  return nr_distributed_trace_splice(parts, 3);
+}
+
+char* nr_distributed_trace_outbound_tracestate(nr_distributed_trace_t* dt,
+                                               const char* span_id,
+                                               const char* txn_id,
+                                               nrtime_t now) {
+  char ms_buf[NR_DISTRIBUTED_TRACE_UINT64_DIGITS];
+  nr_distributed_trace_part_t parts[6];
+  size_t count = 0;
+
+  if (NULL == dt) {
+    return NULL;
+  }
+
+  nr_distributed_trace_outbound_ensure(dt);
+
+  /*
+   * The uncached function logs why the header can't be created.
+   */
+  if (NULL == dt->outbound.tracestate_head) {
+    return nr_distributed_trace_create_w3c_tracestate_header(dt, span_id,
+                                                             txn_id);
+  }
+
+  parts[count++] = nr_distributed_trace_part(dt->outbound.tracestate_head);
+  parts[count++] = nr_distributed_trace_part(span_id);
+  parts[count++] = nr_distributed_trace_part("-");
+  parts[count++] = nr_distributed_trace_part(txn_id);
+  parts[count++] = nr_distributed_trace_part(dt->outbound.tracestate_tail);
+  parts[count++] = nr_distributed_trace_format_ms(ms_buf, now);
+
+  return nr_distributed_trace_splice(parts, count);
+}
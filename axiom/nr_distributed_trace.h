@@ -7,6 +7,8 @@
 #define NR_DISTRIBUTED_TRACE_HDR
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "util_sampling.h"
 #include "util_time.h"
@@ -107,6 +109,68 @@ bool nr_distributed_trace_accept_inbound_payload(nr_distributed_trace_t* dt,
 nrobj_t* nr_distributed_trace_convert_payload_to_object(const char* payload,
                                                         const char** error);
 
+/*
+ * A substring of a W3C header value. The value is not NUL terminated.
+ */
+typedef struct _nr_distributed_trace_w3c_field_t {
+  const char* value;
+  size_t len;
+} nr_distributed_trace_w3c_field_t;
+
+/*
+ * W3C TraceContext headers, as parsed by
+ * nr_distributed_trace_parse_w3c_headers(). This is intended to live on the
+ * stack: string fields refer into the header values rather than copying them,
+ * so the header values must outlive it.
+ */
+typedef struct _nr_distributed_trace_w3c_headers_t {
+  /* traceparent */
+  nr_distributed_trace_w3c_field_t version;
+  nr_distributed_trace_w3c_field_t trace_id;
+  nr_distributed_trace_w3c_field_t parent_id;
+  int trace_flags;
+
+  /* tracestate, other vendors' entries */
+  const char* tracestate;
+  const char* trusted_account_key;
+  bool has_other_vendors; /* Whether any other vendor entry has a key */
+
+  /* tracestate, New Relic entry */
+  bool has_nr_entry;
+  int nr_version;
+  int parent_type;
+  nr_distributed_trace_w3c_field_t parent_account_id;
+  nr_distributed_trace_w3c_field_t parent_application_id;
+  nr_distributed_trace_w3c_field_t span_id;        /* may be empty */
+  nr_distributed_trace_w3c_field_t transaction_id; /* may be empty */
+  bool has_sampled;
+  int sampled;
+  bool has_priority;
+  double priority;
+  int64_t timestamp; /* milliseconds */
+} nr_distributed_trace_w3c_headers_t;
+
+/*
+ * Purpose : Parse W3C TraceContext headers in place, without allocating.
+ *
+ * Params  : 1. The headers struct to populate.
+ *           2. A W3C trace parent header value.
+ *           3. A W3C trace state header value.
+ *           4. The trusted account key.
+ *           5. An error string to be populated if an error occurs.
+ *
+ * Returns : True if the trace parent header is valid and the headers may be
+ *           accepted; false otherwise. The error is populated with the
+ *           supportability metric name to report when either header is
+ *           invalid, or the trace state has no New Relic entry.
+ */
+extern bool nr_distributed_trace_parse_w3c_headers(
+    nr_distributed_trace_w3c_headers_t* headers,
+    const char* traceparent,
+    const char* tracestate,
+    const char* trusted_account_key,
+    const char** error);
+
 /*
  * Purpose : Accepts W3C TraceContext headers and returns an nrobj version of
  *           the information.
@@ -393,6 +457,40 @@ char* nr_distributed_trace_create_w3c_traceparent_header(const char* trace_id,
                                                          const char* span_id,
                                                          bool sampled);
 
+/*
+ * Purpose : Create the outbound headers for an external call.
+ *
+ *           These produce the same headers as
+ *           nr_distributed_trace_payload_as_text(),
+ *           nr_distributed_trace_create_w3c_traceparent_header() and
+ *           nr_distributed_trace_create_w3c_tracestate_header(), but only
+ *           build the parts that don't depend on the span id or the timestamp
+ *           once per transaction.
+ *
+ * Params  : 1. The distributed trace object from the current transaction.
+ *           2. The current span id. This is required for the traceparent
+ *              header, and may be NULL otherwise.
+ *           3. The current transaction id, which may be NULL (tracestate
+ *              only).
+ *           4. The current time.
+ *
+ * Returns : A newly allocated header, which the caller must destroy with
+ *           nr_free(), or NULL on error. The newrelic payload is returned as
+ *           JSON; it is not base64 encoded.
+ */
+extern char* nr_distributed_trace_outbound_payload_text(
+    nr_distributed_trace_t* dt,
+    const char* span_id,
+    nrtime_t now);
+extern char* nr_distributed_trace_outbound_traceparent(
+    nr_distributed_trace_t* dt,
+    const char* span_id);
+extern char* nr_distributed_trace_outbound_tracestate(
+    nr_distributed_trace_t* dt,
+    const char* span_id,
+    const char* txn_id,
+    nrtime_t now);
+
 /*
  * Purpose : Accept a W3C header.
  *
@@ -409,4 +507,26 @@ bool nr_distributed_trace_accept_inbound_w3c_payload(
     const char* transport_type,
     const char** error);
 
+/*
+ * Purpose : Accept W3C headers parsed by
+ *           nr_distributed_trace_parse_w3c_headers().
+ *
+ *           This is equivalent to converting the headers to an object and
+ *           accepting that with
+ *           nr_distributed_trace_accept_inbound_w3c_payload(), but only
+ *           copies the values that the distributed trace retains.
+ *
+ * Params : 1. The distributed trace object.
+ *          2. The parsed trace headers.
+ *          3. Transport type.
+ *          4. Errors
+ *
+ * Returns : True on success, false on error.
+ */
+bool nr_distributed_trace_accept_inbound_w3c_headers(
+    nr_distributed_trace_t* dt,
+    const nr_distributed_trace_w3c_headers_t* headers,
+    const char* transport_type,
+    const char** error);
+
 #endif /* NR_DISTRIBUTED_TRACE_HDR */
@@ -12,6 +12,49 @@
 static const int NR_DISTRIBUTED_TRACE_VERSION_MAJOR = 0;
 static const int NR_DISTRIBUTED_TRACE_VERSION_MINOR = 1;
 
+/*
+ * Outbound Header Cache
+ *
+ * Every outbound header created during a transaction only differs in the span
+ * id and the timestamp, so the rest of each header is built once and spliced
+ * around those two values for each external call.
+ *
+ * The metadata the parts were built from is kept alongside them, and the
+ * cache is rebuilt on first use after any of it changes (for example, when an
+ * inbound payload is accepted). A part is NULL when the metadata doesn't allow
+ * the header to be created.
+ */
+typedef struct _nr_distributed_trace_outbound_t {
+  bool valid; /* Whether the parts below have been built */
+
+  /* The metadata the parts were built from */
+  char* account_id;
+  char* app_id;
+  char* txn_id;
+  char* trace_id;
+  char* trusted_key;
+  nr_sampling_priority_t priority;
+  bool sampled;
+
+  /* traceparent: "00-<trace id>-" <span id> "-<flags>" */
+  char* traceparent_head;
+
+  /*
+   * tracestate: "<key>@nr=0-0-<account>-<app>-" <span id> "-" <txn id>
+   * "-<sampled>-<priority>-" <timestamp>
+   */
+  char* tracestate_head;
+  char* tracestate_tail;
+
+  /*
+   * newrelic: payload_head [",\"id\":" <span id>] payload_tail <timestamp>
+   * payload_end
+   */
+  char* payload_head;
+  char* payload_tail;
+  char* payload_end;
+} nr_distributed_trace_outbound_t;
+
 /*
  * Distributed Tracing Metadata
  *
@@ -52,6 +95,8 @@ struct _nr_distributed_trace_t {
     char* trusted_parent_id; /* The spanId from a New Relic W3C tracestate entry
                                 with a matching trusted account key */
   } inbound;
+
+  nr_distributed_trace_outbound_t outbound; /* Cached outbound header parts */
 };
 
 /*
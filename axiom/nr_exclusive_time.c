@@ -284,3 +284,65 @@ nrtime_t nr_exclusive_time_calculate(nr_exclusive_time_t* et) {
 end:
   return exclusive_time;
 }
+
+void nr_exclusive_time_sweep_init(nr_exclusive_time_sweep_t* sweep,
+                                  nrtime_t start_time,
+                                  nrtime_t stop_time) {
+  if (nrunlikely(NULL == sweep)) {
+    return;
+  }
+
+  sweep->start_time = start_time;
+  sweep->stop_time = stop_time;
+  sweep->last_stop = 0;
+  sweep->child_time = 0;
+}
+
+bool nr_exclusive_time_sweep_add_child(nr_exclusive_time_sweep_t* sweep,
+                                       nrtime_t start_time,
+                                       nrtime_t stop_time) {
+  nrtime_t clamped_start;
+  nrtime_t clamped_stop;
+
+  if (nrunlikely(NULL == sweep)) {
+    return false;
+  }
+
+  if (start_time > stop_time) {
+    return true;
+  }
+
+  if (start_time < sweep->last_stop) {
+    return false;
+  }
+  sweep->last_stop = stop_time;
+
+  /*
+   * Since the children don't overlap, the time that can't be attributed to
+   * the parent is simply the sum of the child durations, clamped to the
+   * parent's start and stop times.
+   */
+  clamped_start = (start_time > sweep->start_time) ? start_time
+                                                   : sweep->start_time;
+  clamped_stop
+      = (stop_time < sweep->stop_time) ? stop_time : sweep->stop_time;
+  sweep->child_time += nr_time_duration(clamped_start, clamped_stop);
+
+  return true;
+}
+
+nrtime_t nr_exclusive_time_sweep_calculate(
+    const nr_exclusive_time_sweep_t* sweep) {
+  nrtime_t duration;
+
+  if (nrunlikely(NULL == sweep)) {
+    return 0;
+  }
+
+  duration = nr_time_duration(sweep->start_time, sweep->stop_time);
+  if (nrunlikely(sweep->child_time > duration)) {
+    return 0;
+  }
+
+  return duration - sweep->child_time;
+}
@@ -17,6 +17,20 @@
 
 typedef struct _nr_exclusive_time_t nr_exclusive_time_t;
 
+/*
+ * A single pass alternative to nr_exclusive_time_t for the common case of a
+ * segment whose children were added in time order and do not overlap, as is
+ * the case for synchronous PHP code. It lives on the stack and needs no
+ * allocation; children that break the ordering are rejected so that the
+ * caller can fall back to nr_exclusive_time_t.
+ */
+typedef struct _nr_exclusive_time_sweep_t {
+  nrtime_t start_time; /* The start time of the parent segment */
+  nrtime_t stop_time;  /* The stop time of the parent segment */
+  nrtime_t last_stop;  /* The stop time of the last child added */
+  nrtime_t child_time; /* The child time within the parent so far */
+} nr_exclusive_time_sweep_t;
+
 /*
  * Purpose : Create an exclusive time structure.
  *
@@ -93,4 +107,47 @@ extern bool nr_exclusive_time_ensure(nr_exclusive_time_t** et_ptr,
                                      nrtime_t start_time,
                                      nrtime_t stop_time);
 
+/*
+ * Purpose : Initialise an exclusive time sweep.
+ *
+ * Params  : 1. A pointer to the sweep.
+ *           2. The start time of the parent segment.
+ *           3. The stop time of the parent segment.
+ */
+extern void nr_exclusive_time_sweep_init(nr_exclusive_time_sweep_t* sweep,
+                                         nrtime_t start_time,
+                                         nrtime_t stop_time);
+
+/*
+ * Purpose : Add a child period to an exclusive time sweep.
+ *
+ *           Children must be added in order of their start times, and each
+ *           child must start no earlier than the previous child stopped.
+ *           Children with a start time after their stop time are ignored, as
+ *           they are by nr_exclusive_time_add_child().
+ *
+ * Params  : 1. A pointer to the sweep.
+ *           2. The start time of the child segment.
+ *           3. The stop time of the child segment.
+ *
+ * Returns : True if the child was added; false if the child overlaps or
+ *           precedes a previously added child, in which case the sweep cannot
+ *           be used and nr_exclusive_time_t must be used instead.
+ */
+extern bool nr_exclusive_time_sweep_add_child(nr_exclusive_time_sweep_t* sweep,
+                                              nrtime_t start_time,
+                                              nrtime_t stop_time);
+
+/*
+ * Purpose : Calculate how much exclusive time the parent segment of a sweep
+ *           had.
+ *
+ * Params  : 1. A pointer to the sweep.
+ *
+ * Returns : The amount of exclusive time, which is the same as
+ *           nr_exclusive_time_calculate() would return for the same children.
+ */
+extern nrtime_t nr_exclusive_time_sweep_calculate(
+    const nr_exclusive_time_sweep_t* sweep);
+
 #endif /* NR_EXCLUSIVE_TIME_HDR */
@@ -91,6 +91,32 @@ char* nr_explain_plan_to_json(const nr_explain_plan_t* plan) {
   return json;
 }
 
+nr_explain_plan_t* nr_explain_plan_create_from_json(const char* json) {
+  nr_explain_plan_t* plan = NULL;
+  nrobj_t* obj = NULL;
+  const nrobj_t* columns;
+  const nrobj_t* rows;
+
+  obj = nro_create_from_json(json);
+  if ((NULL == obj) || (2 != nro_getsize(obj))) {
+    goto end;
+  }
+
+  columns = nro_get_array_array(obj, 1, NULL);
+  rows = nro_get_array_array(obj, 2, NULL);
+  if ((NULL == columns) || (NULL == rows)) {
+    goto end;
+  }
+
+  plan = (nr_explain_plan_t*)nr_zalloc(sizeof(nr_explain_plan_t));
+  plan->columns = nro_copy(columns);
+  plan->rows = nro_copy(rows);
+
+end:
+  nro_delete(obj);
+  return plan;
+}
+
 nrobj_t* nr_explain_plan_to_object(const nr_explain_plan_t* plan) {
   nrobj_t* obj = NULL;
 
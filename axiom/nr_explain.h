@@ -74,4 +74,15 @@ extern void nr_explain_plan_add_row(nr_explain_plan_t* plan,
  */
 extern char* nr_explain_plan_to_json(const nr_explain_plan_t* plan);
 
+/*
+ * Purpose : Creates an explain plan from JSON previously exported with
+ *           nr_explain_plan_to_json.
+ *
+ * Params  : 1. The JSON.
+ *
+ * Returns : A newly allocated explain plan, or NULL if the JSON isn't a valid
+ *           explain plan.
+ */
+extern nr_explain_plan_t* nr_explain_plan_create_from_json(const char* json);
+
 #endif /* NR_EXPLAIN_HDR */
@@ -10,6 +10,7 @@
 
 #include "nr_limits.h"
 #include "nr_log_events.h"
+#include "nr_log_event_private.h"
 #include "util_memory.h"
 #include "util_minmax_heap.h"
 #include "util_vector.h"
@@ -146,6 +147,40 @@ bool nr_log_events_add_event(nr_log_events_t* events, nr_log_event_t* event) {
   return events_sampled;
 }
 
+bool nr_log_events_admits(const nr_log_events_t* events,
+                          int priority,
+                          nrtime_t timestamp) {
+  nr_log_event_t probe = {.priority = priority};
+
+  if (NULL == events || NULL == events->events
+      || 0 == events->events_allocated) {
+    return false;
+  }
+
+  if (events->events_used < events->events_allocated) {
+    return true;
+  }
+
+  /*
+   * The heap discards a new event that compares lower than its current
+   * minimum, so compare a probe event carrying only the fields that the
+   * comparator looks at.
+   */
+  nr_log_event_set_timestamp(&probe, timestamp);
+
+  return nr_log_event_wrapped_priority_comparator(
+             nr_minmax_heap_peek_min(events->events), &probe, NULL)
+         <= 0;
+}
+
+void nr_log_events_add_skipped_event(nr_log_events_t* events) {
+  if (NULL == events) {
+    return;
+  }
+
+  events->events_seen++;
+}
+
 /*
  * Purpose : Place an nr_log_event_t pointer in a heap into a nr_vector_t,
  *             or "heap to vector".
@@ -37,6 +37,35 @@ typedef struct _nr_log_events_t nr_log_events_t;
 extern bool nr_log_events_add_event(nr_log_events_t* events,
                                     nr_log_event_t* event);
 
+/*
+ * Purpose : Determine whether a log event with the given priority and
+ *           timestamp would be kept by a log event pool, before the event is
+ *           built.
+ *
+ * Params  : 1. Log event pool
+ *           2. Priority of the prospective event
+ *           3. Timestamp of the prospective event
+ *
+ * Returns : true if nr_log_events_add_event() would store such an event,
+ *           either because the pool isn't full yet or because the event would
+ *           replace the lowest priority event in the pool; false otherwise.
+ *
+ * Notes   : The decision uses the same ordering as the sampling algorithm in
+ *           nr_log_events_add_event(), so an event that isn't admitted is
+ *           exactly one that would have been discarded on insertion.
+ */
+extern bool nr_log_events_admits(const nr_log_events_t* events,
+                                 int priority,
+                                 nrtime_t timestamp);
+
+/*
+ * Purpose : Record that a log event was seen by a log event pool but not
+ *           built, because nr_log_events_admits() refused it.
+ *
+ * Params  : 1. Log event pool
+ */
+extern void nr_log_events_add_skipped_event(nr_log_events_t* events);
+
 /*
  * Purpose : Create a log event pool of specified size.
  *           An event pool allocated using this function must be
@@ -30,6 +30,52 @@ struct _nr_span_event_and_counter_t {
 
 typedef struct _nr_span_event_and_counter_t nr_span_event_and_counter_t;
 
+/*
+ * Purpose: Calculate the exclusive time of a segment in a single pass over its
+ *          children, without needing an exclusive time structure.
+ *
+ *          This is possible when the segment has no exclusive time structure
+ *          yet, and its children in the same execution context are ordered by
+ *          start time and do not overlap, which is almost always true for
+ *          synchronous segments.
+ *
+ * Params:  1. The segment.
+ *          2. A pointer to the exclusive time to set, or NULL if only the
+ *             applicability of the single pass calculation is to be checked.
+ *
+ * Returns: True if the exclusive time was calculated; false if an exclusive
+ *          time structure has to be used instead.
+ */
+static bool nr_segment_sweep_exclusive_time(nr_segment_t* segment,
+                                            nrtime_t* exclusive_time_ptr) {
+  nr_exclusive_time_sweep_t sweep;
+  size_t num_children;
+
+  if (NULL != segment->exclusive_time) {
+    return false;
+  }
+
+  nr_exclusive_time_sweep_init(&sweep, segment->start_time,
+                               segment->stop_time);
+
+  num_children = nr_segment_children_size(&segment->children);
+  for (size_t i = 0; i < num_children; i++) {
+    const nr_segment_t* child = nr_segment_children_get(&segment->children, i);
+
+    if (child && child->async_context == segment->async_context
+        && !nr_exclusive_time_sweep_add_child(&sweep, child->start_time,
+                                              child->stop_time)) {
+      return false;
+    }
+  }
+
+  if (exclusive_time_ptr) {
+    *exclusive_time_ptr = nr_exclusive_time_sweep_calculate(&sweep);
+  }
+
+  return true;
+}
+
 /*
  * Purpose: Merges metrics from a discarded segment into transaction
  *          metrics.
@@ -103,35 +149,30 @@ static void nr_segment_discard_merge_metrics(nr_segment_t* segment) {
   num_children = nr_segment_children_size(&segment->children);
 
   /*
-   * If this segment has children this has to be considered in the
-   * exclusive time calculation for metrics.
+   * If no exclusive time data structure is initialized this means that this
+   * segment has no discarded children that had metrics. If its children are
+   * also ordered and don't overlap, which includes the case of a leaf node
+   * of the "metrics tree", the exclusive time is calculated in a single pass.
+   *
+   * If that's not the case, the children have to be considered in the
+   * exclusive time data structure, which is then used to calculate exclusive
+   * time.
    */
-  if (num_children) {
-    nr_exclusive_time_ensure(&segment->exclusive_time, num_children,
-                             segment->start_time, segment->stop_time);
-
-    for (size_t i = 0; i < num_children; i++) {
-      nr_segment_t* child = nr_segment_children_get(&segment->children, i);
-
-      if (child && child->async_context == segment->async_context) {
-        nr_exclusive_time_add_child(segment->exclusive_time, child->start_time,
-                                    child->stop_time);
+  if (!nr_segment_sweep_exclusive_time(segment, &exclusive_time)) {
+    if (num_children) {
+      nr_exclusive_time_ensure(&segment->exclusive_time, num_children,
+                               segment->start_time, segment->stop_time);
+
+      for (size_t i = 0; i < num_children; i++) {
+        nr_segment_t* child = nr_segment_children_get(&segment->children, i);
+
+        if (child && child->async_context == segment->async_context) {
+          nr_exclusive_time_add_child(segment->exclusive_time,
+                                      child->start_time, child->stop_time);
+        }
       }
     }
-  }
 
-  /*
-   * If no exclusive time data structure is initialized this means we are on
-   * a leaf node of the "metrics tree". This means that this segment
-   * has no children and no discarded children that had metrics. In that
-   * case the exclusive time equals the duration.
-   *
-   * If that's not the case, we use the exclusive time data structure to
-   * calculate exclusive time.
-   */
-  if (NULL == segment->exclusive_time) {
-    exclusive_time = duration;
-  } else {
     exclusive_time = nr_exclusive_time_calculate(segment->exclusive_time);
   }
 
@@ -532,6 +573,7 @@ nr_span_event_t* nr_segment_to_span_event(nr_segment_t* segment) {
   event_and_counter.event = event;
   event_and_counter.counter = NR_ATTRIBUTE_USER_LIMIT;
 
+  nr_segment_add_deferred_attributes(segment);
   if (segment->attributes) {
     user_attributes = nr_attributes_user_to_obj(segment->attributes,
                                                 NR_ATTRIBUTE_DESTINATION_SPAN);
@@ -1038,8 +1080,16 @@ static void nr_segment_stoh_post_iterator_callback(
     return;
   }
 
-  // Calculate the exclusive time.
-  exclusive_time = nr_exclusive_time_calculate(segment->exclusive_time);
+  /*
+   * Calculate the exclusive time. If the segment has no exclusive time
+   * structure, its children were found to be ordered and non-overlapping
+   * before they were visited.
+   */
+  if (NULL == segment->exclusive_time) {
+    nr_segment_sweep_exclusive_time(segment, &exclusive_time);
+  } else {
+    exclusive_time = nr_exclusive_time_calculate(segment->exclusive_time);
+  }
 
   // Update the transaction total time.
   metadata->total_time += exclusive_time;
@@ -1067,21 +1117,20 @@ static void nr_segment_stoh_post_iterator_callback(
 }
 
 /*
- * Purpose : Place an nr_segment_t pointer into a nr_minmax_heap,
- *             or "segments to heap".
+ * Purpose : Collect an nr_segment_t pointer during the first pass over the
+ *           tree, or "segments to heap".
  *
- * Params  : 1. The segment pointer to place into the heap.
- *           2. A void* pointer to be recast as the pointer to the heap.
+ * Params  : 1. The segment pointer to collect.
+ *           2. A void* pointer to be recast as the pointer to the
+ *              nr_segment_tree_to_heap_metadata_t for this pass.
  *
  * Note    : This is the callback function supplied to nr_segment_iterate(),
  *           used for iterating over a tree of segments and placing each
- *           segment into the heap.
+ *           segment into the metadata's vector, if there is one.
  */
 static nr_segment_iter_return_t nr_segment_stoh_iterator_callback(
     nr_segment_t* segment,
     void* userdata) {
-  nr_minmax_heap_t* trace_heap = NULL;
-  nr_minmax_heap_t* span_heap = NULL;
   nr_segment_tree_to_heap_metadata_t* metadata
       = (nr_segment_tree_to_heap_metadata_t*)userdata;
 
@@ -1089,13 +1138,26 @@ static nr_segment_iter_return_t nr_segment_stoh_iterator_callback(
     return NR_SEGMENT_NO_POST_ITERATION_CALLBACK;
   }
 
-  /* Set up the exclusive time so that children can adjust it as necessary. */
-  nr_exclusive_time_ensure(&segment->exclusive_time,
-                           nr_segment_children_size(&segment->children),
-                           segment->start_time, segment->stop_time);
+  /*
+   * Set up the exclusive time so that children can adjust it as necessary,
+   * unless the children are ordered and don't overlap: in that case the
+   * exclusive time is calculated in a single pass over the children in the
+   * post callback, and no exclusive time structure is allocated. The root
+   * segment always gets an exclusive time structure, as it is needed when
+   * creating transaction metrics.
+   */
+  if (NULL == segment->parent
+      || !nr_segment_sweep_exclusive_time(segment, NULL)) {
+    nr_exclusive_time_ensure(&segment->exclusive_time,
+                             nr_segment_children_size(&segment->children),
+                             segment->start_time, segment->stop_time);
+  }
 
-  /* Adjust the parent's exclusive time. */
-  if (segment->parent
+  /*
+   * Adjust the parent's exclusive time, unless the parent is using the single
+   * pass calculation.
+   */
+  if (segment->parent && segment->parent->exclusive_time
       && segment->parent->async_context == segment->async_context) {
     nr_exclusive_time_add_child(segment->parent->exclusive_time,
                                 segment->start_time, segment->stop_time);
@@ -1115,15 +1177,9 @@ static nr_segment_iter_return_t nr_segment_stoh_iterator_callback(
                                 segment->stop_time);
   }
 
-  trace_heap = metadata->trace_heap;
-  span_heap = metadata->span_heap;
-
-  if (NULL != trace_heap) {
-    nr_minmax_heap_insert(trace_heap, segment);
-  }
-
-  if (NULL != span_heap) {
-    nr_minmax_heap_insert(span_heap, segment);
+  if (NULL != metadata->segments) {
+    segment->index = nr_vector_size(metadata->segments);
+    nr_vector_push_back(metadata->segments, segment);
   }
 
   // clang-format off
@@ -1140,45 +1196,41 @@ void nr_segment_tree_to_heap(nr_segment_t* root,
   if (NULL == root || NULL == metadata) {
     return;
   }
-  /* Convert the tree to two minmax heap.  The bound, or
-   * size, of the heaps, and the comparison functions installed
-   * by the nr_segment_heap_create() calls will assure that the
-   * segments in the heaps are of highest priority. */
+  /* Collect the segments into the vector, if one was given. The highest
+   * priority segments are then chosen by nr_segment_select_to_bitset(). */
   nr_segment_iterate(root, (nr_segment_iter_t)nr_segment_stoh_iterator_callback,
                      metadata);
 }
 
-/*
- * Purpose : Place an nr_segment_t pointer in a heap into a nr_set_t,
- *             or "heap to set".
- *
- * Params  : 1. The segment pointer in the heap.
- *           2. A void* pointer to be recast as the pointer to the set.
- *
- * Note    : This is the callback function supplied to nr_minmax_heap_iterate
- *           used for iterating over a heap of segments and placing each
- *           segment into a set.
- */
-static bool nr_segment_htos_iterator_callback(void* value, void* userdata) {
-  if (nrlikely(value && userdata)) {
-    nr_set_t* set = (nr_set_t*)userdata;
-    nr_set_insert(set, value);
-  }
-
-  return true;
-}
+void nr_segment_select_to_bitset(nr_vector_t* segments,
+                                 size_t bound,
+                                 nr_vector_cmp_t comparator,
+                                 nr_bitset_t* bitset) {
+  size_t count;
+  size_t first;
+  size_t i;
 
-void nr_segment_heap_to_set(nr_minmax_heap_t* heap, nr_set_t* set) {
-  if (NULL == heap || NULL == set) {
+  if (NULL == segments || NULL == comparator || NULL == bitset || 0 == bound) {
     return;
   }
 
-  /* Convert the heap to a set */
-  nr_minmax_heap_iterate(
-      heap, (nr_minmax_heap_iter_t)nr_segment_htos_iterator_callback,
-      (void*)set);
+  /*
+   * Move the bound highest priority segments to the end of the vector.
+   */
+  count = nr_vector_size(segments);
+  if (count > bound) {
+    first = count - bound;
+    nr_vector_select(segments, first, comparator, NULL);
+  } else {
+    first = 0;
+  }
+
+  for (i = first; i < count; i++) {
+    const nr_segment_t* segment
+        = (const nr_segment_t*)nr_vector_get(segments, i);
 
-  return;
+    nr_bitset_set(bitset, segment->index);
+  }
 }
 
 char* nr_segment_ensure_id(nr_segment_t* segment, const nrtxn_t* txn) {
@@ -1304,6 +1356,65 @@ bool nr_segment_attributes_user_txn_event_add(nr_segment_t* segment,
   return (NR_SUCCESS == status);
 }
 
+void nr_segment_set_deferred_attributes(
+    nr_segment_t* segment,
+    const nr_segment_deferred_attributes_t* callbacks,
+    void* data) {
+  if (NULL == segment || NULL == callbacks) {
+    if (callbacks && callbacks->dtor) {
+      (callbacks->dtor)(data);
+    }
+    return;
+  }
+
+  nr_segment_release_deferred_attributes(segment);
+  segment->deferred_attributes = callbacks;
+  segment->deferred_attributes_data = data;
+}
+
+void nr_segment_add_deferred_attributes(nr_segment_t* segment) {
+  const nr_segment_deferred_attributes_t* callbacks;
+  void* data;
+
+  if (NULL == segment || NULL == segment->deferred_attributes) {
+    return;
+  }
+
+  /*
+   * Clear the fields before invoking the callbacks, so that the attributes
+   * can't be added twice.
+   */
+  callbacks = segment->deferred_attributes;
+  data = segment->deferred_attributes_data;
+  segment->deferred_attributes = NULL;
+  segment->deferred_attributes_data = NULL;
+
+  if (callbacks->add) {
+    (callbacks->add)(segment, data);
+  }
+  if (callbacks->dtor) {
+    (callbacks->dtor)(data);
+  }
+}
+
+void nr_segment_detach_deferred_attributes(nr_segment_t* segment) {
+  const nr_segment_deferred_attributes_t* callbacks;
+  void* data;
+
+  if (NULL == segment || NULL == segment->deferred_attributes
+      || NULL == segment->deferred_attributes->detach) {
+    return;
+  }
+
+  callbacks = segment->deferred_attributes;
+  data = (callbacks->detach)(segment, segment->deferred_attributes_data);
+
+  /*
+   * This releases the original data.
+   */
+  nr_segment_set_deferred_attributes(segment, callbacks->detached, data);
+}
+
 ssize_t nr_segment_get_child_ix(const nr_segment_t* segment) {
   if (NULL == segment) {
     return -1;
@@ -25,6 +25,7 @@ typedef struct _nrtxn_t nrtxn_t;
 #include "nr_segment_children.h"
 #include "nr_span_event.h"
 #include "nr_txn.h"
+#include "util_bitset.h"
 #include "util_metrics.h"
 #include "util_minmax_heap.h"
 #include "util_object.h"
@@ -39,16 +40,17 @@ typedef enum _nr_segment_type_t {
 } nr_segment_type_t;
 
 /*
- * The first iteration over the tree will put segments into two heaps: one for
- * span events, and the other for traces. It keeps a running total of the
+ * The first iteration over the tree can collect all segments into a vector,
+ * giving each segment its index within the vector, from which the segments to
+ * keep for traces and span events can be selected in linear time with
+ * nr_segment_select_to_bitset(). It keeps a running total of the
  * transaction's total time, which is the sum of all exclusive time.
  *
- * This struct is used to pass in the two heaps, along with the field to track
+ * This struct is used to pass in the vector, along with the field to track
  * the total time.
  */
 typedef struct {
-  nr_minmax_heap_t* span_heap;
-  nr_minmax_heap_t* trace_heap;
+  nr_vector_t* segments;
   nrtime_t total_time;
   nr_exclusive_time_t* main_context;
 } nr_segment_tree_to_heap_metadata_t;
@@ -92,6 +94,27 @@ typedef enum _nr_segment_color_t {
 #define NR_SEGMENT_PRIORITY_LOG (1 << 14)
 #define NR_SEGMENT_PRIORITY_ATTR (1 << 13)
 
+/*
+ * Deferred attributes are attributes that are only added to a segment once
+ * the segment is known to be kept in the transaction trace or turned into a
+ * span event, so that attributes that are costly to create aren't created for
+ * segments that are later discarded by sampling.
+ *
+ * The add callback is invoked at most once, after which the data is released
+ * with the dtor callback. If the segment is destroyed first, only the dtor
+ * callback is invoked. Either callback may be NULL.
+ *
+ * Data that refers to memory that doesn't live as long as the transaction
+ * provides a detach callback, which returns a copy of the data that doesn't,
+ * and the callbacks for that copy: see nr_segment_detach_deferred_attributes().
+ */
+typedef struct _nr_segment_deferred_attributes_t {
+  void (*add)(nr_segment_t* segment, void* data);
+  void (*dtor)(void* data);
+  void* (*detach)(nr_segment_t* segment, void* data);
+  const struct _nr_segment_deferred_attributes_t* detached;
+} nr_segment_deferred_attributes_t;
+
 typedef struct _nr_segment_datastore_t {
   char* component; /* The name of the database vendor or driver */
   char* sql;
@@ -203,6 +226,9 @@ typedef struct _nr_segment_t {
   nr_segment_children_t children;
   size_t child_ix; /* index of this segment in its parent->children vector */
   nr_segment_color_t color;
+  size_t index; /* Dense index of this segment, assigned when the segments are
+                   collected during finalisation; used to key the bitsets of
+                   sampled segments */
 
   /* Generic segment fields. */
 
@@ -242,6 +268,10 @@ typedef struct _nr_segment_t {
                                                       external, datastore,
                                                       or message segments. */
   nr_segment_error_t* error; /* segment error attributes */
+  const nr_segment_deferred_attributes_t*
+      deferred_attributes;         /* Callbacks for attributes that have not
+                                      been added yet, if any */
+  void* deferred_attributes_data; /* Data for the deferred attributes */
 #if ZEND_MODULE_API_NO >= ZEND_8_0_X_API_NO \
     && !defined OVERWRITE_ZEND_EXECUTE_DATA /* PHP 8.0+ and OAPI */
 
@@ -508,6 +538,42 @@ extern bool nr_segment_attributes_user_txn_event_add(nr_segment_t* segment,
                                                      const char* name,
                                                      const nrobj_t* value);
 
+/*
+ * Purpose  : Defer adding attributes to a segment until the segment is kept
+ *            in the transaction trace or turned into a span event.
+ *
+ * Params   : 1. The pointer to the segment.
+ *            2. The callbacks, which must outlive the segment.
+ *            3. The data to pass to the callbacks, which is owned by the
+ *               segment from this point. It's released with the dtor callback
+ *               if the segment can't take it.
+ *
+ * Note     : A segment has at most one set of deferred attributes: setting
+ *            them again releases the previous data without adding it.
+ */
+extern void nr_segment_set_deferred_attributes(
+    nr_segment_t* segment,
+    const nr_segment_deferred_attributes_t* callbacks,
+    void* data);
+
+/*
+ * Purpose  : Add any deferred attributes to a segment.
+ *
+ * Params   : 1. The pointer to the segment.
+ */
+extern void nr_segment_add_deferred_attributes(nr_segment_t* segment);
+
+/*
+ * Purpose  : Replace a segment's deferred attributes with a copy that doesn't
+ *            refer to memory outside of the transaction, without adding them.
+ *
+ * Params   : 1. The pointer to the segment.
+ *
+ * Note     : Deferred attributes without a detach callback are left as they
+ *            are.
+ */
+extern void nr_segment_detach_deferred_attributes(nr_segment_t* segment);
+
 /*
  * Purpose : End a segment within a transaction's trace.
  *
@@ -614,7 +680,8 @@ extern nr_segment_iter_return_t nr_segment_stot_iterator_callback(
     void* userdata);
 
 /*
- * Purpose : Given a root of a tree of segments, create a heap of segments.
+ * Purpose : Given a root of a tree of segments, calculate exclusive and total
+ *           time and collect the segments into a vector.
  *
  * Params  : 1. A pointer to the root segment.
  *           2. A pointer to the metadata for this pass.
@@ -624,13 +691,23 @@ extern void nr_segment_tree_to_heap(
     nr_segment_tree_to_heap_metadata_t* metadata);
 
 /*
- * Purpose : Given a heap of segments, create a set containing the highest
- *           priority segments.
+ * Purpose : Given a vector of segments collected by nr_segment_tree_to_heap(),
+ *           create a bitset containing the indices of the highest priority
+ *           segments.
+ *
+ *           This takes linear time. Where segments compare equal, which of
+ *           them is kept is unspecified. The order of the vector is changed.
  *
- * Params  : 1. The heap.
- *           2. The set to populate.
+ * Params  : 1. The vector of segments.
+ *           2. The maximum number of segments to place in the bitset.
+ *           3. The comparator used to prioritise segments.
+ *           4. The bitset to populate, which must be large enough to hold the
+ *              index of every segment in the vector.
  */
-extern void nr_segment_heap_to_set(nr_minmax_heap_t* heap, nr_set_t* set);
+extern void nr_segment_select_to_bitset(nr_vector_t* segments,
+                                        size_t bound,
+                                        nr_vector_cmp_t comparator,
+                                        nr_bitset_t* bitset);
 
 /*
  * Purpose : Free a tree of segments.
@@ -76,11 +76,28 @@ void nr_segment_destroy_typed_attributes(
   *attributes = NULL;
 }
 
+void nr_segment_release_deferred_attributes(nr_segment_t* segment) {
+  const nr_segment_deferred_attributes_t* callbacks;
+
+  if (NULL == segment || NULL == segment->deferred_attributes) {
+    return;
+  }
+
+  callbacks = segment->deferred_attributes;
+  if (callbacks->dtor) {
+    (callbacks->dtor)(segment->deferred_attributes_data);
+  }
+  segment->deferred_attributes = NULL;
+  segment->deferred_attributes_data = NULL;
+}
+
 void nr_segment_destroy_fields(nr_segment_t* segment) {
   if (nrunlikely(NULL == segment)) {
     return;
   }
 
+  nr_segment_release_deferred_attributes(segment);
+
   nr_free(segment->id);
   nr_vector_destroy(&segment->metrics);
   nr_exclusive_time_destroy(&segment->exclusive_time);
@@ -47,6 +47,13 @@ void nr_segment_message_destroy_fields(nr_segment_message_t* message);
  */
 void nr_segment_metric_destroy_fields(nr_segment_metric_t* sm);
 
+/*
+ * Purpose : Release a segment's deferred attributes without adding them.
+ *
+ * Params  : 1. A pointer to the segment.
+ */
+void nr_segment_release_deferred_attributes(nr_segment_t* segment);
+
 /*
  * Purpose : Free all data related to a segment error.
  *
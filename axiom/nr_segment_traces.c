@@ -188,7 +188,7 @@ static void add_typed_attributes_to_buffer(nrbuf_t* buf,
 }
 
 static inline bool nr_segment_is_sampled(const nr_segment_t* segment,
-                                         nr_set_t* set) {
+                                         const nr_bitset_t* set) {
   if (nrunlikely(NULL == segment)) {
     return false;
   }
@@ -196,7 +196,7 @@ static inline bool nr_segment_is_sampled(const nr_segment_t* segment,
   if (NULL == set) {
     return true;
   }
-  return nr_set_contains(set, (const void*)segment);
+  return nr_bitset_contains(set, segment->index);
 }
 
 static void nr_segment_traces_stot_iterator_post_callback(
@@ -213,7 +213,7 @@ static void nr_segment_traces_stot_iterator_post_callback(
     return;
   }
 
-  current_trace_segment = nr_vector_get(userdata->trace.current_path, 0);
+  current_trace_segment = nr_stack_get_top(&userdata->trace.current_path);
 
   /*
    * The segment is sampled for the the trace output. It has to be popped off
@@ -224,8 +224,7 @@ static void nr_segment_traces_stot_iterator_post_callback(
     nr_buffer_add(userdata->trace.buf, "]", 1);
     nr_buffer_add(userdata->trace.buf, "]", 1);
 
-    nr_vector_remove(userdata->trace.current_path, 0,
-                     (void**)&current_trace_segment);
+    nr_stack_pop(&userdata->trace.current_path);
   }
 
   /*
@@ -242,11 +241,12 @@ static void nr_segment_iteration_pass_trace(nr_segment_t* segment,
                                             const char* segment_name) {
   nr_segment_userdata_trace_t* tracedata = &(userdata->trace);
   bool trace_is_sampled = (NULL != tracedata->sample);
-  bool segment_is_sampled = nr_set_contains(tracedata->sample, (void*)segment);
+  bool segment_is_sampled
+      = trace_is_sampled
+        && nr_bitset_contains(tracedata->sample, segment->index);
   nrpool_t* segment_names = userdata->segment_names;
   nrbuf_t* buf = userdata->trace.buf;
   int idx;
-  nr_segment_t* parent = NULL;
   nrobj_t* user_attributes = NULL;
   nrobj_t* agent_attributes = NULL;
 
@@ -257,24 +257,17 @@ static void nr_segment_iteration_pass_trace(nr_segment_t* segment,
     return;
   }
 
-  /* Get nearest sampled ancestor segment. This will serve as parent. */
-  parent = (nr_segment_t*)nr_vector_get(tracedata->current_path, 0);
-
   /* Update the current ancestor path of segments added to the trace
    * output. */
-  nr_vector_push_front(tracedata->current_path, (void*)segment);
+  nr_stack_push(&tracedata->current_path, (void*)segment);
 
-  /* Examine the sampled_ancestors.  If the closest sampled ancestor of this
-   * segment appears in the set, this means the current segment has a previous
-   * sibling. and so the JSON needs a comma. */
-  if (nr_set_contains(tracedata->sampled_ancestors_with_child, parent)) {
+  /* If a previous sibling has already been printed into the children array
+   * of the nearest sampled ancestor, the buffer ends with that sibling's
+   * closing bracket and the JSON needs a comma. */
+  if (']' == nr_buffer_peek_end(buf)) {
     nr_buffer_add(buf, ",", 1);
   }
 
-  if (NULL != parent) {
-    nr_set_insert(tracedata->sampled_ancestors_with_child, (void*)parent);
-  }
-
   /* Get the name index.
    * The internal string tables index at 1, and we wish to index by 0 here. */
   idx = nr_string_add(segment_names, segment_name);
@@ -313,6 +306,7 @@ static void nr_segment_iteration_pass_trace(nr_segment_t* segment,
     add_async_attribute_to_buffer(buf, segment, segment_names);
   }
 
+  nr_segment_add_deferred_attributes(segment);
   if (segment->attributes) {
     user_attributes = nr_attributes_user_to_obj(
         segment->attributes, NR_ATTRIBUTE_DESTINATION_TXN_TRACE);
@@ -433,8 +427,8 @@ nr_segment_iter_return_t nr_segment_traces_stot_iterator_callback(
 
 bool nr_segment_traces_json_print_segments(nrbuf_t* buf,
                                            nr_vector_t* span_events,
-                                           nr_set_t* trace_set,
-                                           nr_set_t* span_set,
+                                           nr_bitset_t* trace_set,
+                                           nr_bitset_t* span_set,
                                            const nrtxn_t* txn,
                                            nr_segment_t* root,
                                            nrpool_t* segment_names) {
@@ -459,22 +453,20 @@ bool nr_segment_traces_json_print_segments(nrbuf_t* buf,
          .trace = {
            .buf = buf,
            .sample = trace_set,
-           .current_path = nr_vector_create(12, NULL, NULL),
-           .sampled_ancestors_with_child = nr_set_create(),
          },
          .spans = {
            .events = span_events,
            .sample = span_set,
          },
   };
+  nr_stack_init(&userdata->trace.current_path, 12);
   nr_stack_init(&userdata->spans.parent_ids, 12);
 
   nr_segment_iterate(
       root, (nr_segment_iter_t)nr_segment_traces_stot_iterator_callback,
       userdata);
 
-  nr_set_destroy(&(userdata->trace.sampled_ancestors_with_child));
-  nr_vector_destroy(&(userdata->trace.current_path));
+  nr_stack_destroy_fields(&userdata->trace.current_path);
   nr_stack_destroy_fields(&userdata->spans.parent_ids);
 
   return userdata->success;
@@ -497,7 +489,7 @@ void nr_segment_traces_create_data(
   if ((NULL == txn) || (0 == txn->segment_count) || (0 == duration)
       || NULL == metadata || NULL == metadata->out
       || (NULL != metadata->trace_set
-          && NR_MAX_SEGMENTS < nr_set_size(metadata->trace_set))) {
+          && NR_MAX_SEGMENTS < nr_bitset_count(metadata->trace_set))) {
     return;
   }
 
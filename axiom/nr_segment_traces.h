@@ -9,6 +9,7 @@
 #include "nr_segment.h"
 #include "nr_segment_tree.h"
 #include "nr_span_event.h"
+#include "util_bitset.h"
 #include "util_stack.h"
 #include "util_set.h"
 
@@ -26,21 +27,18 @@
  * trace or span event creation is stored in dedicated nested structs.
  */
 typedef struct {
-  nrbuf_t* buf;     /* The buffer to print JSON into */
-  nr_set_t* sample; /* The set of segments that should be added to the trace */
-  nr_vector_t* current_path; /* The path of ancestor segments that were added to
-                                the trace; used to determine parents and to
-                                determine state in the post traversal callback
-                              */
-  nr_set_t* sampled_ancestors_with_child; /* The set of sampled ancestors that
-                                             have at least one child; used to
-                                             determine siblings */
+  nrbuf_t* buf;        /* The buffer to print JSON into */
+  nr_bitset_t* sample; /* The indices of the segments that should be added to
+                          the trace */
+  nr_stack_t current_path; /* The path of ancestor segments that were added to
+                              the trace; used to determine state in the post
+                              traversal callback */
 } nr_segment_userdata_trace_t;
 
 typedef struct {
   nr_vector_t* events; /* The output vector to add span events to */
-  nr_set_t* sample; /* The set of segments that should be added to the list of
-                       spans */
+  nr_bitset_t* sample; /* The indices of the segments that should be added to
+                          the list of spans */
   nr_stack_t parent_ids; /* The path of ancestor span IDs */
 } nr_segment_userdata_spans_t;
 
@@ -91,10 +89,10 @@ void nr_segment_traces_create_data(
  *
  * Params  : 1. The buffer.
  *           2. An output vector to store generated span events.
- *           3. The set of segments that should be in the trace. NULL if all
- *              segments should be in the trace.
- *           4. The set of segments that should be span events. NULL if all
- *              segments should be span events.
+ *           3. The indices of the segments that should be in the trace. NULL
+ *              if all segments should be in the trace.
+ *           4. The indices of the segments that should be span events. NULL
+ *              if all segments should be span events.
  *           5. The transaction, largely for the transaction's string pool and
  *              async duration.
  *           6. The root pointer for the tree of segments.
@@ -106,8 +104,8 @@ void nr_segment_traces_create_data(
  */
 bool nr_segment_traces_json_print_segments(nrbuf_t* buf,
                                            nr_vector_t* span_events,
-                                           nr_set_t* trace_set,
-                                           nr_set_t* span_set,
+                                           nr_bitset_t* trace_set,
+                                           nr_bitset_t* span_set,
                                            const nrtxn_t* txn,
                                            nr_segment_t* root,
                                            nrpool_t* segment_names);
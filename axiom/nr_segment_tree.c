@@ -23,8 +23,7 @@ nrtxnfinal_t nr_segment_tree_finalise(nrtxn_t* txn,
       .total_time = 0,
   };
   nr_segment_tree_to_heap_metadata_t first_pass_metadata = {
-      .trace_heap = NULL,
-      .span_heap = NULL,
+      .segments = NULL,
       .total_time = 0,
       .main_context = NULL,
   };
@@ -44,13 +43,15 @@ nrtxnfinal_t nr_segment_tree_finalise(nrtxn_t* txn,
                       && NULL == txn->span_queue;
   should_sample_spans = txn->segment_count > span_limit;
 
-  if (should_save_spans && should_sample_spans) {
-    first_pass_metadata.span_heap = nr_segment_heap_create(
-        span_limit, nr_segment_wrapped_span_priority_comparator);
-  }
-  if (should_save_trace && should_sample_trace) {
-    first_pass_metadata.trace_heap = nr_segment_heap_create(
-        trace_limit, nr_segment_wrapped_duration_comparator);
+  /*
+   * If either the trace or the span events need to be sampled, collect the
+   * segments during the first pass. The segments to keep are then selected in
+   * linear time, rather than maintaining bounded heaps while traversing.
+   */
+  if ((should_save_spans && should_sample_spans)
+      || (should_save_trace && should_sample_trace)) {
+    first_pass_metadata.segments
+        = nr_vector_create(txn->segment_count + 1, NULL, NULL);
   }
 
   /*
@@ -63,9 +64,9 @@ nrtxnfinal_t nr_segment_tree_finalise(nrtxn_t* txn,
   }
 
   /*
-   * Do the first pass over the tree: we need to generate the heaps tracking the
-   * segments that will be used in any transaction trace or span event
-   * reservoir and calculate the total time for the transaction.
+   * Do the first pass over the tree: we need to collect the segments that may
+   * be used in any transaction trace or span event reservoir and calculate the
+   * total time for the transaction.
    */
   nr_segment_tree_to_heap(txn->segment_root, &first_pass_metadata);
 
@@ -116,17 +117,29 @@ nrtxnfinal_t nr_segment_tree_finalise(nrtxn_t* txn,
         .out = &result,
     };
 
+    /*
+     * Prepare for the second pass of the tree; select the segments to keep.
+     * Every segment was given a dense index when it was collected, so the
+     * selected segments can be tracked in bitsets.
+     */
+    size_t segment_count = nr_vector_size(first_pass_metadata.segments);
+
     if (should_sample_trace) {
-      /* Prepare for the second pass of the tree; convert the heap to a set. */
-      metadata.trace_set = nr_set_create();
-      nr_segment_heap_to_set(first_pass_metadata.trace_heap,
-                             metadata.trace_set);
+      metadata.trace_set = nr_bitset_create(segment_count);
+      if (should_save_trace) {
+        nr_segment_select_to_bitset(first_pass_metadata.segments, trace_limit,
+                                    nr_segment_wrapped_duration_comparator,
+                                    metadata.trace_set);
+      }
     }
 
     if (should_sample_spans) {
-      /* Prepare for the second pass of the tree; convert the heap to a set. */
-      metadata.span_set = nr_set_create();
-      nr_segment_heap_to_set(first_pass_metadata.span_heap, metadata.span_set);
+      metadata.span_set = nr_bitset_create(segment_count);
+      if (should_save_spans) {
+        nr_segment_select_to_bitset(
+            first_pass_metadata.segments, span_limit,
+            nr_segment_wrapped_span_priority_comparator, metadata.span_set);
+      }
     }
 
     agent_attributes = nr_attributes_agent_to_obj(
@@ -143,12 +156,12 @@ nrtxnfinal_t nr_segment_tree_finalise(nrtxn_t* txn,
     nro_delete(agent_attributes);
     nro_delete(user_attributes);
 
-    nr_set_destroy(&metadata.trace_set);
-    nr_set_destroy(&metadata.span_set);
-    nr_minmax_heap_destroy(&first_pass_metadata.trace_heap);
-    nr_minmax_heap_destroy(&first_pass_metadata.span_heap);
+    nr_bitset_destroy(&metadata.trace_set);
+    nr_bitset_destroy(&metadata.span_set);
   }
 
+  nr_vector_destroy(&first_pass_metadata.segments);
+
   return result;
 }
 
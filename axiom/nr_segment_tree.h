@@ -14,16 +14,18 @@
 #include "nr_segment_traces.h"
 #include "nr_txn.h"
 
+#include "util_bitset.h"
 #include "util_set.h"
 
 /*
  * To assemble the transaction trace and the array of span events, the axiom
  * library must iterate over the tree of segments. This struct contains the
- * input metadata and result storage for that operation.
+ * input metadata and result storage for that operation. The sampled segments
+ * are given as bitsets of segment indices.
  */
 typedef struct {
-  nr_set_t* trace_set;
-  nr_set_t* span_set;
+  nr_bitset_t* trace_set;
+  nr_bitset_t* span_set;
   nrtxnfinal_t* out;
 } nr_segment_tree_sampling_metadata_t;
 
@@ -20,18 +20,40 @@ static inline void pack_batch(const Com__Newrelic__Trace__V1__SpanBatch* batch,
   com__newrelic__trace__v1__span_batch__pack(batch, result->data);
 }
 
-bool nr_span_encoding_batch_v1(const nr_span_event_t** events,
-                               size_t len,
-                               nr_span_encoding_result_t* result) {
+nr_span_encoding_context_t* nr_span_encoding_context_create(void) {
+  nr_span_encoding_context_t* ctx = (nr_span_encoding_context_t*)nr_malloc(
+      sizeof(nr_span_encoding_context_t));
+
+  ctx->arena = nr_arena_create(0);
+
+  return ctx;
+}
+
+void nr_span_encoding_context_destroy(nr_span_encoding_context_t** ctx_ptr) {
+  if (NULL == ctx_ptr || NULL == *ctx_ptr) {
+    return;
+  }
+
+  nr_arena_destroy(&(*ctx_ptr)->arena);
+  nr_realfree((void**)ctx_ptr);
+}
+
+bool nr_span_encoding_batch_with_context_v1(
+    nr_span_encoding_context_t* ctx,
+    const nr_span_event_t** events,
+    size_t len,
+    nr_span_encoding_result_t* result) {
   Com__Newrelic__Trace__V1__SpanBatch batch;
-  nr_span_encoding_context_t ctx;
   size_t i;
-  bool rv = false;
+  bool rv = true;
 
-  if (NULL == events || NULL == result) {
+  if (NULL == ctx || NULL == events || NULL == result) {
     return false;
   }
 
+  // Anything left from the previous batch is finished with.
+  nr_arena_reset(ctx->arena);
+
   com__newrelic__trace__v1__span_batch__init(&batch);
 
   if (0 == len) {
@@ -42,32 +64,51 @@ bool nr_span_encoding_batch_v1(const nr_span_event_t** events,
     return true;
   }
 
-  nr_span_encoding_context_init(&ctx, len);
   batch.n_spans = len;
-  batch.spans = nr_calloc(len, sizeof(Com__Newrelic__Trace__V1__Span*));
+  batch.spans = nr_arena_alloc_array(ctx->arena, len,
+                                     sizeof(Com__Newrelic__Trace__V1__Span*));
 
   for (i = 0; i < len; i++) {
-    batch.spans[i] = nr_slab_next(ctx.span_slab);
+    batch.spans[i]
+        = nr_arena_alloc(ctx->arena, sizeof(Com__Newrelic__Trace__V1__Span));
 
-    if (!nr_span_encoding_encode_span_v1(events[i], batch.spans[i], &ctx)) {
+    if (!nr_span_encoding_encode_span_v1(events[i], batch.spans[i], ctx)) {
       nrl_warning(NRL_AGENT, "%s: error encoding span event %zu", __func__, i);
-      goto end;
+      rv = false;
+      break;
     }
   }
 
-  pack_batch(&batch, result);
-  rv = true;
+  if (rv) {
+    pack_batch(&batch, result);
+  }
+
+  // Give back the memory an unusually large batch needed, rather than holding
+  // on to it for the lifetime of the context.
+  nr_arena_trim(ctx->arena, NR_SPAN_ENCODING_CONTEXT_MAX_CAPACITY);
+  return rv;
+}
 
-end:
-  nr_free(batch.spans);
-  nr_span_encoding_context_deinit(&ctx);
+bool nr_span_encoding_batch_v1(const nr_span_event_t** events,
+                               size_t len,
+                               nr_span_encoding_result_t* result) {
+  nr_span_encoding_context_t* ctx;
+  bool rv;
+
+  if (NULL == events || NULL == result) {
+    return false;
+  }
+
+  ctx = nr_span_encoding_context_create();
+  rv = nr_span_encoding_batch_with_context_v1(ctx, events, len, result);
+  nr_span_encoding_context_destroy(&ctx);
 
   return rv;
 }
 
 bool nr_span_encoding_single_v1(const nr_span_event_t* event,
                                 nr_span_encoding_result_t* result) {
-  nr_span_encoding_context_t ctx;
+  nr_span_encoding_context_t* ctx;
   bool rv;
   Com__Newrelic__Trace__V1__Span span;
 
@@ -75,13 +116,11 @@ bool nr_span_encoding_single_v1(const nr_span_event_t* event,
     return false;
   }
 
-  // Technically, we're doing a bit more work than we need to here: we don't
-  // need a span slab to allocate one span! Nevertheless, we'll reuse the same
-  // context here for simplicity; this function is only used for testing right
-  // now anyway.
-  nr_span_encoding_context_init(&ctx, 1);
+  // This function is only used for testing right now, so there's no context
+  // to reuse.
+  ctx = nr_span_encoding_context_create();
 
-  rv = nr_span_encoding_encode_span_v1(event, &span, &ctx);
+  rv = nr_span_encoding_encode_span_v1(event, &span, ctx);
   if (!rv) {
     goto end;
   }
@@ -92,7 +131,7 @@ bool nr_span_encoding_single_v1(const nr_span_event_t* event,
   com__newrelic__trace__v1__span__pack(&span, result->data);
 
 end:
-  nr_span_encoding_context_deinit(&ctx);
+  nr_span_encoding_context_destroy(&ctx);
   return rv;
 }
 
@@ -187,14 +226,17 @@ bool nr_span_encoding_encode_attribute_value_v1(
                                                                              \
     if (len > 0) {                                                           \
       int i;                                                                 \
+      TYPE* entries                                                          \
+          = nr_arena_alloc_array(ctx->arena, *out_len, sizeof(TYPE));        \
+      Com__Newrelic__Trace__V1__AttributeValue* avs = nr_arena_alloc_array(  \
+          ctx->arena, *out_len,                                              \
+          sizeof(Com__Newrelic__Trace__V1__AttributeValue));                 \
                                                                              \
-      *out_ptr = nr_calloc(len, sizeof(TYPE*));                              \
-      nr_vector_push_back(&ctx->proto_arrays, *out_ptr);                     \
+      *out_ptr = nr_arena_alloc_array(ctx->arena, *out_len, sizeof(TYPE*));  \
                                                                              \
       for (i = 0; i < len; i++) {                                            \
-        Com__Newrelic__Trace__V1__AttributeValue* av                         \
-            = nr_slab_next(ctx->attribute_value_slab);                       \
-        TYPE* entry = nr_slab_next(ctx->entry_slab);                         \
+        Com__Newrelic__Trace__V1__AttributeValue* av = &avs[i];              \
+        TYPE* entry = &entries[i];                                           \
         const char* key = NULL;                                              \
         const nrobj_t* value;                                                \
                                                                              \
@@ -275,57 +317,3 @@ bool nr_span_encoding_encode_span_v1(const nr_span_event_t* event,
 
   return true;
 }
-
-static void nr_span_encoding_proto_array_destroy(void* ptr,
-                                                 void* userdata NRUNUSED) {
-  nr_free(ptr);
-}
-
-void nr_span_encoding_context_init(nr_span_encoding_context_t* ctx,
-                                   size_t span_count) {
-  size_t entry_size = 0;
-  static const size_t entry_sizes[3] = {
-      sizeof(Com__Newrelic__Trace__V1__Span__AgentAttributesEntry),
-      sizeof(Com__Newrelic__Trace__V1__Span__IntrinsicsEntry),
-      sizeof(Com__Newrelic__Trace__V1__Span__UserAttributesEntry),
-  };
-  size_t i;
-
-  // We need to know what the largest of the attribute entry types are. In
-  // practice, they should all be the same, but this is a simple enough check
-  // that we might as well do it and be extra safe.
-  for (i = 0; i < (sizeof(entry_sizes) / sizeof(entry_sizes[0])); i++) {
-    if (entry_sizes[i] > entry_size) {
-      entry_size = entry_sizes[i];
-    }
-  }
-
-  // We don't know how many attributes there will be, but we can at least make
-  // the page size reasonably large to start with.
-  ctx->attribute_value_slab = nr_slab_create(
-      sizeof(Com__Newrelic__Trace__V1__AttributeValue),
-      span_count * sizeof(Com__Newrelic__Trace__V1__AttributeValue));
-
-  // Each span event has three sets of "entries" (attributes), so we can size
-  // the slab to the size we need right away and it should never need to grow.
-  ctx->entry_slab = nr_slab_create(entry_size, 3 * span_count * entry_size);
-
-  // Again, since we know the number of span events, we can size this slab in
-  // advance.
-  ctx->span_slab
-      = nr_slab_create(sizeof(Com__Newrelic__Trace__V1__Span),
-                       span_count * sizeof(Com__Newrelic__Trace__V1__Span));
-
-  // Finally, we'll initialise the vector we're going to use as scratch space
-  // for the double pointer arrays that are needed to get the entries onto the
-  // encoded spans.
-  nr_vector_init(&ctx->proto_arrays, 3 * span_count,
-                 nr_span_encoding_proto_array_destroy, NULL);
-}
-
-void nr_span_encoding_context_deinit(nr_span_encoding_context_t* ctx) {
-  nr_slab_destroy(&ctx->attribute_value_slab);
-  nr_slab_destroy(&ctx->entry_slab);
-  nr_slab_destroy(&ctx->span_slab);
-  nr_vector_deinit(&ctx->proto_arrays);
-}
@@ -25,6 +25,29 @@ static const nr_span_encoding_result_t NR_SPAN_ENCODING_RESULT_INIT = {
     .span_count = 0,
 };
 
+/*
+ * A span encoding context holds the scratch memory used while encoding a span
+ * batch. Reusing a context for successive batches avoids allocating that
+ * memory again for each batch.
+ */
+typedef struct _nr_span_encoding_context_t nr_span_encoding_context_t;
+
+/*
+ * Purpose : Create a span encoding context.
+ *
+ * Returns : A new context, which must be destroyed with
+ *           nr_span_encoding_context_destroy().
+ */
+extern nr_span_encoding_context_t* nr_span_encoding_context_create(void);
+
+/*
+ * Purpose : Destroy a span encoding context.
+ *
+ * Params  : 1. A pointer to the context.
+ */
+extern void nr_span_encoding_context_destroy(
+    nr_span_encoding_context_t** ctx_ptr);
+
 /*
  * Purpose : Encode an array of span events into a v1 8T span batch.
  *
@@ -38,6 +61,26 @@ extern bool nr_span_encoding_batch_v1(const nr_span_event_t** events,
                                       size_t len,
                                       nr_span_encoding_result_t* result);
 
+/*
+ * Purpose : Encode an array of span events into a v1 8T span batch, using the
+ *           given context for scratch memory.
+ *
+ * Params  : 1. The span encoding context. Any memory used by a previous batch
+ *              encoded with the context is reused.
+ *           2. The span events to encode.
+ *           3. The number of span events.
+ *           4. A pointer to the result structure.
+ *
+ * Returns : True on success; false otherwise.
+ *
+ * Warning : A context must not be used by more than one thread at a time.
+ */
+extern bool nr_span_encoding_batch_with_context_v1(
+    nr_span_encoding_context_t* ctx,
+    const nr_span_event_t** events,
+    size_t len,
+    nr_span_encoding_result_t* result);
+
 /*
  * Purpose : Encode a single span event into a v1 8T span.
  *
@@ -7,9 +7,8 @@
 #define NR_SPAN_ENCODING_PRIVATE_HDR
 
 #include "nr_span_encoding.h"
+#include "util_arena.h"
 #include "util_object.h"
-#include "util_slab.h"
-#include "util_vector.h"
 #include "v1.pb-c.h"
 
 // Building a span batch is tricky: the code generated by protobuf-c represents
@@ -19,19 +18,21 @@
 // that we control, keep them in memory until encoding is complete, then we can
 // dispose of them completely.
 //
-// This context is used while encoding a span batch to manage that memory. Since
-// each of those data types are homogeneous, we can use slabs to allocate those
-// instances, and then clean up quickly once we're done.
+// This context is used while encoding a span batch to manage that memory. All
+// of it -- spans, entries, attribute values, and the arrays of pointers to them
+// -- is bump allocated from an arena, which is reset at the start of each batch
+// so that a context reused across batches stops allocating once it has grown
+// to fit its batches. After each batch the arena is trimmed back to
+// NR_SPAN_ENCODING_CONTEXT_MAX_CAPACITY, so that a single outsized batch
+// doesn't pin its memory for the lifetime of a long lived context.
 //
-// We also have variable length arrays encapsulating the attribute maps: these
-// are owned by the proto_arrays vector, which again simplifies our memory
-// management story.
-typedef struct _nr_span_encoding_context_t {
-  nr_slab_t* attribute_value_slab;
-  nr_slab_t* entry_slab;
-  nr_slab_t* span_slab;
-  nr_vector_t proto_arrays;
-} nr_span_encoding_context_t;
+// Attribute keys and string values aren't copied: the entries point into the
+// span events, which outlive the encoding.
+#define NR_SPAN_ENCODING_CONTEXT_MAX_CAPACITY (1024 * 1024)
+
+struct _nr_span_encoding_context_t {
+  nr_arena_t* arena;
+};
 
 /*
  * Purpose : Encode a scalar nrobj_t value into an appropriately typed Protobuf
@@ -64,24 +65,4 @@ extern bool nr_span_encoding_encode_span_v1(
     Com__Newrelic__Trace__V1__Span* span,
     nr_span_encoding_context_t* ctx);
 
-/*
- * Purpose : Initialise a span encoding context.
- *
- * Params  : 1. The context to initialise.
- *           2. The number of spans that will be encoded.
- *
- * Warning : No NULL checks are performed on the parameters.
- */
-extern void nr_span_encoding_context_init(nr_span_encoding_context_t* ctx,
-                                          size_t span_count);
-
-/*
- * Purpose : Finalise a span encoding context.
- *
- * Params  : 1. The context to finalise.
- *
- * Warning : No NULL checks are performed on the parameters.
- */
-extern void nr_span_encoding_context_deinit(nr_span_encoding_context_t* ctx);
-
 #endif /* NR_SPAN_ENCODING_PRIVATE_HDR */
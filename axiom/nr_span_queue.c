@@ -10,12 +10,27 @@
 #include "nr_span_queue_private.h"
 #include "nr_txn.h"
 #include "util_logging.h"
+#include "util_syscalls.h"
+#include "util_threads.h"
 
-static nr_span_batch_t* nr_span_batch_create(size_t capacity) {
-  nr_span_batch_t* batch = nr_malloc(sizeof(nr_span_batch_t)
-                                     + capacity * sizeof(nr_span_event_t*));
+static nr_span_encoder_t nr_span_encoder = {
+    .mutex = NRTHREAD_MUTEX_INITIALIZER,
+    .wake = NRTHREAD_COND_INITIALIZER,
+    .idle = NRTHREAD_COND_INITIALIZER,
+    .head = NULL,
+    .tail = NULL,
+    .encoding_context = NULL,
+    .pid = 0,
+    .shutdown = false,
+};
 
-  batch->capacity = capacity;
+static nr_span_batch_t* nr_span_batch_create(nr_span_queue_t* queue) {
+  nr_span_batch_t* batch = nr_malloc(
+      sizeof(nr_span_batch_t) + queue->batch_size * sizeof(nr_span_event_t*));
+
+  batch->next = NULL;
+  batch->queue = queue;
+  batch->capacity = queue->batch_size;
   batch->used = 0;
   batch->start_time = nr_get_time();
 
@@ -38,76 +53,339 @@ static void nr_span_batch_destroy(nr_span_batch_t** batch_ptr) {
   nr_realfree((void**)batch_ptr);
 }
 
+static void nr_span_queue_free(nr_span_queue_t* queue) {
+  if (queue->batch_handler_userdata_dtor) {
+    (queue->batch_handler_userdata_dtor)(queue->batch_handler_userdata);
+  }
+
+  nr_span_batch_destroy(&queue->current_batch);
+  nr_free(queue);
+}
+
+/*
+ * Encodes a batch and passes it to the queue's batch handler. The batch itself
+ * is left for the caller to destroy. If ctx is NULL, scratch memory is
+ * allocated for this batch alone.
+ */
+static bool nr_span_queue_send_batch(nr_span_encoding_context_t* ctx,
+                                     nr_span_batch_t* batch) {
+  nr_span_queue_t* queue = batch->queue;
+  nr_span_encoding_result_t encoded = NR_SPAN_ENCODING_RESULT_INIT;
+  bool rv;
+
+  nrl_verbosedebug(NRL_AGENT,
+                   "flushing a queue of %zu span(s) to the span batch handler",
+                   batch->used);
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+  if (ctx) {
+    rv = nr_span_encoding_batch_with_context_v1(
+        ctx, (const nr_span_event_t**)batch->spans, batch->used, &encoded);
+  } else {
+    rv = nr_span_encoding_batch_v1((const nr_span_event_t**)batch->spans,
+                                   batch->used, &encoded);
+  }
+#pragma GCC diagnostic pop
+
+  if (!rv) {
+    nrl_warning(NRL_AGENT, "cannot encode span batch with %zu span(s)",
+                batch->used);
+    return false;
+  }
+
+  return (queue->batch_handler)(&encoded, queue->batch_handler_userdata);
+}
+
+static void* nr_span_encoder_main(void* arg NRUNUSED) {
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  for (;;) {
+    nr_span_batch_t* batch;
+    nr_span_queue_t* queue;
+    bool free_queue;
+
+    while (NULL == nr_span_encoder.head && !nr_span_encoder.shutdown) {
+      nrt_cond_wait(&nr_span_encoder.wake, &nr_span_encoder.mutex);
+    }
+
+    /*
+     * Batches that are still waiting at shutdown are sent before the encoder
+     * exits.
+     */
+    if (NULL == nr_span_encoder.head) {
+      break;
+    }
+
+    batch = nr_span_encoder.head;
+    nr_span_encoder.head = batch->next;
+    if (NULL == nr_span_encoder.head) {
+      nr_span_encoder.tail = NULL;
+    }
+    nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+    queue = batch->queue;
+    nr_span_queue_send_batch(nr_span_encoder.encoding_context, batch);
+    nr_span_batch_destroy(&batch);
+
+    nrt_mutex_lock(&nr_span_encoder.mutex);
+    queue->pending -= 1;
+    free_queue = queue->released && 0 == queue->pending;
+    nrt_cond_broadcast(&nr_span_encoder.idle);
+
+    if (free_queue) {
+      nrt_mutex_unlock(&nr_span_encoder.mutex);
+      nr_span_queue_free(queue);
+      nrt_mutex_lock(&nr_span_encoder.mutex);
+    }
+  }
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+  return NULL;
+}
+
+/*
+ * Returns true if the encoder thread belongs to another process: that is,
+ * this is a forked child of the process that started it.
+ */
+static bool nr_span_encoder_is_inherited(void) {
+  int pid = nrt_atomic_load_acquire(&nr_span_encoder.pid);
+
+  return 0 != pid && nr_getpid() != pid;
+}
+
+/*
+ * Returns true if this process has started an encoder thread.
+ */
+static bool nr_span_encoder_is_running(void) {
+  return nr_getpid() == nrt_atomic_load_acquire(&nr_span_encoder.pid);
+}
+
+/*
+ * Forgets the encoder inherited from the parent in a forked child. The thread
+ * doesn't exist in the child and the mutex may have been held when the fork
+ * happened, so the synchronisation primitives are reinitialised and the
+ * child's copies of the waiting batches are released.
+ *
+ * Like the transaction finaliser, this assumes that the child has only one
+ * thread using span queues until its own encoder has started.
+ */
+static void nr_span_encoder_forget_parent(void) {
+  nr_span_batch_t* batch = nr_span_encoder.head;
+
+  nrt_mutex_init(&nr_span_encoder.mutex, NULL);
+  nrt_cond_init(&nr_span_encoder.wake);
+  nrt_cond_init(&nr_span_encoder.idle);
+
+  while (batch) {
+    nr_span_batch_t* next = batch->next;
+    nr_span_queue_t* queue = batch->queue;
+
+    nr_span_batch_destroy(&batch);
+    queue->pending -= 1;
+    if (queue->released && 0 == queue->pending) {
+      nr_span_queue_free(queue);
+    }
+
+    batch = next;
+  }
+
+  nr_span_encoder.head = NULL;
+  nr_span_encoder.tail = NULL;
+  nrt_atomic_store_release(&nr_span_encoder.pid, 0);
+  nr_span_encoder.shutdown = false;
+}
+
+/*
+ * Starts the encoder thread if this process doesn't have one yet. Must be
+ * called with the encoder's mutex held. Returns false if there is no encoder
+ * thread that can be used, in which case batches are sent synchronously.
+ */
+static bool nr_span_encoder_ensure_locked(void) {
+  int pid = nr_getpid();
+
+  if (pid == nrt_atomic_load_acquire(&nr_span_encoder.pid)) {
+    return true;
+  }
+
+  if (NULL == nr_span_encoder.encoding_context) {
+    nr_span_encoder.encoding_context = nr_span_encoding_context_create();
+  }
+
+  nr_span_encoder.shutdown = false;
+  if (NR_SUCCESS
+      != nrt_create(&nr_span_encoder.thread, NULL, nr_span_encoder_main,
+                    NULL)) {
+    return false;
+  }
+
+  nrt_atomic_store_release(&nr_span_encoder.pid, pid);
+
+  return true;
+}
+
+/*
+ * Hands a batch to the encoder thread. The batch is sent synchronously if
+ * there is no encoder thread, and dropped if the encoder is too far behind
+ * with this queue's batches. Returns false if the batch was dropped or a
+ * synchronous send failed.
+ */
+static bool nr_span_queue_hand_off(nr_span_queue_t* queue,
+                                   nr_span_batch_t* batch) {
+  bool rv = true;
+
+  if (nr_span_encoder_is_inherited()) {
+    nr_span_encoder_forget_parent();
+  }
+
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  if (!nr_span_encoder_ensure_locked()) {
+    nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+    // If the send fails, nr_span_queue_send_batch() will have logged a
+    // message.
+    rv = nr_span_queue_send_batch(NULL, batch);
+    nr_span_batch_destroy(&batch);
+    return rv;
+  }
+
+  if (queue->pending >= NR_SPAN_QUEUE_MAX_PENDING_BATCHES) {
+    nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+    nrl_verbosedebug(NRL_AGENT,
+                     "span batch encoder is behind; dropping %zu span(s)",
+                     batch->used);
+    queue->dropped_spans += batch->used;
+    nr_span_batch_destroy(&batch);
+    return false;
+  }
+
+  queue->pending += 1;
+  if (nr_span_encoder.tail) {
+    nr_span_encoder.tail->next = batch;
+  } else {
+    nr_span_encoder.head = batch;
+  }
+  nr_span_encoder.tail = batch;
+
+  nrt_cond_signal(&nr_span_encoder.wake);
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+  return true;
+}
+
+/*
+ * Replaces the current batch, handing the old one to the encoder thread if it
+ * holds any spans. Even an empty batch is replaced, to reset its timer.
+ */
+static bool nr_span_queue_hand_off_current(nr_span_queue_t* queue) {
+  nr_span_batch_t* batch = queue->current_batch;
+
+  queue->current_batch = nr_span_batch_create(queue);
+
+  if (0 == batch->used) {
+    nr_span_batch_destroy(&batch);
+    return true;
+  }
+
+  return nr_span_queue_hand_off(queue, batch);
+}
+
 nr_span_queue_t* nr_span_queue_create(
     size_t batch_size,
     nrtime_t batch_timeout,
     nr_span_queue_batch_handler_t batch_handler,
-    void* batch_handler_userdata) {
+    void* batch_handler_userdata,
+    nr_span_queue_userdata_dtor_t batch_handler_userdata_dtor) {
   nr_span_queue_t* queue;
 
   if (0 == batch_size || 0 == batch_timeout || NULL == batch_handler) {
     return NULL;
   }
 
-  queue = nr_malloc(sizeof(nr_span_queue_t));
+  queue = nr_zalloc(sizeof(nr_span_queue_t));
   queue->batch_size = batch_size;
   queue->batch_timeout = batch_timeout;
   queue->batch_handler = batch_handler;
   queue->batch_handler_userdata = batch_handler_userdata;
-  queue->current_batch = nr_span_batch_create(batch_size);
+  queue->batch_handler_userdata_dtor = batch_handler_userdata_dtor;
+  queue->current_batch = nr_span_batch_create(queue);
 
   return queue;
 }
 
 void nr_span_queue_destroy(nr_span_queue_t** queue_ptr) {
+  nr_span_queue_t* queue;
+  bool free_queue;
+
   if (NULL == queue_ptr || NULL == *queue_ptr) {
     return;
   }
 
-  nr_span_batch_destroy(&(*queue_ptr)->current_batch);
-  nr_realfree((void**)queue_ptr);
+  queue = *queue_ptr;
+  *queue_ptr = NULL;
+
+  if (nr_span_encoder_is_inherited()) {
+    nr_span_encoder_forget_parent();
+  }
+
+  /*
+   * If the encoder thread still has batches from this queue, it frees the
+   * queue once it has sent the last of them.
+   */
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  queue->released = true;
+  free_queue = (0 == queue->pending);
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+  if (free_queue) {
+    nr_span_queue_free(queue);
+  }
 }
 
 bool nr_span_queue_flush(nr_span_queue_t* queue) {
-  nr_span_batch_t* batch;
-  nr_span_encoding_result_t encoded = NR_SPAN_ENCODING_RESULT_INIT;
-  bool rv = true;
-
   if (NULL == queue) {
     return false;
   }
 
-  // Even if it's a zero length batch, we should re-create to reset the timer.
-  batch = queue->current_batch;
-  queue->current_batch = nr_span_batch_create(queue->batch_size);
+  return nr_span_queue_hand_off_current(queue);
+}
 
-  // Short circuit if there's nothing to do.
-  if (0 == batch->used) {
-    goto end;
+void nr_span_queue_wait(nr_span_queue_t* queue) {
+  if (NULL == queue || !nr_span_encoder_is_running()) {
+    return;
   }
 
-  nrl_verbosedebug(NRL_AGENT,
-                   "flushing a queue of %zu span(s) to the span batch handler",
-                   batch->used);
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  while (0 != queue->pending) {
+    nrt_cond_wait(&nr_span_encoder.idle, &nr_span_encoder.mutex);
+  }
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+}
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-qual"
-  if (!nr_span_encoding_batch_v1((const nr_span_event_t**)batch->spans,
-                                 batch->used, &encoded)) {
-    nrl_warning(NRL_AGENT, "cannot encode span batch with %zu span(s)",
-                batch->used);
-    rv = false;
-    goto end;
+void nr_span_queue_encoder_shutdown(void) {
+  if (!nr_span_encoder_is_running()) {
+    return;
   }
-#pragma GCC diagnostic pop
 
-  // Since the encoded result won't ever be touched again, this could be moved
-  // to a separate thread, either here or in the handler.
-  rv = (queue->batch_handler)(&encoded, queue->batch_handler_userdata);
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  nr_span_encoder.shutdown = true;
+  nrt_cond_signal(&nr_span_encoder.wake);
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+
+  nrt_join(nr_span_encoder.thread, NULL);
+
+  nrt_mutex_lock(&nr_span_encoder.mutex);
+  nrt_atomic_store_release(&nr_span_encoder.pid, 0);
+  nr_span_encoding_context_destroy(&nr_span_encoder.encoding_context);
+  nrt_mutex_unlock(&nr_span_encoder.mutex);
+}
+
+uint64_t nr_span_queue_dropped_spans(const nr_span_queue_t* queue) {
+  if (NULL == queue) {
+    return 0;
+  }
 
-end:
-  nr_span_batch_destroy(&batch);
-  return rv;
+  return queue->dropped_spans;
 }
 
 bool nr_span_queue_push(nr_span_queue_t* queue, nr_span_event_t* event) {
@@ -124,10 +402,9 @@ bool nr_span_queue_push(nr_span_queue_t* queue, nr_span_event_t* event) {
   if (queue->current_batch->used >= queue->current_batch->capacity
       || nr_get_time()
              > queue->current_batch->start_time + queue->batch_timeout) {
-    // If the flush fails, nr_span_queue_flush() will have logged a message.
-    // We'll swallow sadness and move on, since we still want to enqueue the
-    // span event we were given.
-    nr_span_queue_flush(queue);
+    // The batch is encoded and sent on the encoder thread, so the caller only
+    // pays for swapping in a new batch. Any failure will be logged there.
+    nr_span_queue_hand_off_current(queue);
   }
 
   queue->current_batch->spans[queue->current_batch->used++] = event;
@@ -12,16 +12,22 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /*
  * A span queue. Spans pushed into this queue will be held until the queue fills
  * or a timeout is hit, at which point the queue will be flushed to a handler.
+ *
+ * Those flushes happen on an encoder thread that is shared by every queue in
+ * the process. It is started the first time a batch is ready, and a forked
+ * child starts its own. Only one thread may push spans into a queue.
  */
 typedef struct _nr_span_queue_t nr_span_queue_t;
 
 /*
  * A span queue batch handler. This function receives the encoded span batch,
- * along with whatever userdata is registered.
+ * along with whatever userdata is registered. It may be called on the encoder
+ * thread, after the queue has been destroyed.
  *
  * Note that ownership of encoded passes to the handler, and therefore the
  * handler is responsible for invoking nr_span_encoding_result_deinit().
@@ -30,6 +36,12 @@ typedef bool (*nr_span_queue_batch_handler_t)(
     nr_span_encoding_result_t* encoded,
     void* userdata);
 
+/*
+ * A destructor for the batch handler's userdata, called once the queue has
+ * been destroyed and the encoder thread has sent its last batch.
+ */
+typedef void (*nr_span_queue_userdata_dtor_t)(void* userdata);
+
 /*
  * Purpose : Create a new span queue.
  *
@@ -39,6 +51,7 @@ typedef bool (*nr_span_queue_batch_handler_t)(
  *              before the queue is flushed.
  *           3. The handler that will received flushed span batches.
  *           4. Userdata to give to the handler when invoked.
+ *           5. An optional destructor for the userdata.
  *
  * Returns : A new span queue, which must be destroyed with
  *           nr_span_queue_destroy(), or NULL on error.
@@ -47,7 +60,8 @@ extern nr_span_queue_t* nr_span_queue_create(
     size_t batch_size,
     nrtime_t batch_timeout,
     nr_span_queue_batch_handler_t batch_handler,
-    void* batch_handler_userdata);
+    void* batch_handler_userdata,
+    nr_span_queue_userdata_dtor_t batch_handler_userdata_dtor);
 
 /*
  * Purpose : Destroy a span queue.
@@ -56,19 +70,40 @@ extern nr_span_queue_t* nr_span_queue_create(
  *
  * Warning : This function will not flush spans currently in the queue; call
  *           nr_span_queue_flush() before this function if you don't want to
- *           lose spans.
+ *           lose spans. It doesn't wait for batches that were already handed
+ *           to the encoder thread: they are still sent, and the queue is freed
+ *           once the last of them has been.
  */
 extern void nr_span_queue_destroy(nr_span_queue_t** queue_ptr);
 
 /*
  * Purpose : Flush a span queue to the handler.
  *
+ *           This hands the current batch to the encoder thread and returns
+ *           without waiting for it to be sent. If there is no encoder thread,
+ *           the batch is sent on the calling thread.
+ *
  * Params  : 1. The queue to flush.
  *
- * Returns : True if the flush succeeded; false otherwise.
+ * Returns : True if the current batch was empty, handed off, or sent
+ *           successfully; false if it was dropped or could not be sent.
  */
 extern bool nr_span_queue_flush(nr_span_queue_t* queue);
 
+/*
+ * Purpose : Wait until the encoder thread has sent every batch handed to it by
+ *           a queue.
+ *
+ * Params  : 1. The queue.
+ */
+extern void nr_span_queue_wait(nr_span_queue_t* queue);
+
+/*
+ * Purpose : Stop the process' encoder thread once it has sent every batch it
+ *           has been given. A later hand-off starts a new thread.
+ */
+extern void nr_span_queue_encoder_shutdown(void);
+
 /*
  * Purpose : Push a new span event into the queue.
  *
@@ -80,4 +115,14 @@ extern bool nr_span_queue_flush(nr_span_queue_t* queue);
  */
 extern bool nr_span_queue_push(nr_span_queue_t* queue, nr_span_event_t* event);
 
+/*
+ * Purpose : Return the number of spans that were dropped because the encoder
+ *           thread could not keep up with the spans being pushed.
+ *
+ * Params  : 1. The span queue.
+ *
+ * Returns : The number of dropped spans.
+ */
+extern uint64_t nr_span_queue_dropped_spans(const nr_span_queue_t* queue);
+
 #endif /* NR_SPAN_QUEUE_HDR */
@@ -7,8 +7,18 @@
 #define NR_SPAN_QUEUE_PRIVATE_HDR
 
 #include "nr_span_queue.h"
+#include "util_threads.h"
+
+/*
+ * The number of full batches from one queue that may be waiting for the
+ * encoder thread. When the encoder falls further behind than this, new batches
+ * from that queue are dropped rather than letting memory grow without bound.
+ */
+#define NR_SPAN_QUEUE_MAX_PENDING_BATCHES 4
 
 typedef struct _nr_span_batch_t {
+  struct _nr_span_batch_t* next; /* The next batch waiting for the encoder */
+  nr_span_queue_t* queue;        /* The queue the batch came from */
   size_t capacity;
   size_t used;
   nrtime_t start_time;
@@ -20,7 +30,44 @@ struct _nr_span_queue_t {
   nrtime_t batch_timeout;
   nr_span_queue_batch_handler_t batch_handler;
   void* batch_handler_userdata;
+  nr_span_queue_userdata_dtor_t batch_handler_userdata_dtor;
   nr_span_batch_t* current_batch;
+  uint64_t dropped_spans; /* Spans dropped because the encoder was behind */
+
+  /*
+   * These fields are protected by the encoder's mutex. A queue is freed by
+   * whichever of its owner and the encoder thread is last to finish with it:
+   * nr_span_queue_destroy() sets released, and the encoder thread decrements
+   * pending as it finishes each batch.
+   */
+  size_t pending; /* Batches handed to the encoder and not yet sent */
+  bool released;  /* True once the owner has destroyed the queue */
 };
 
+/*
+ * The process-wide encoder. Batches from every queue wait in a single list,
+ * and are encoded and sent in order by one thread. The thread is started the
+ * first time a batch is handed off, and belongs to the process that started
+ * it: a forked child starts its own.
+ *
+ * Spans are pushed onto their queue's current batch without locking, since
+ * each queue has a single producer. The mutex is only taken once per batch,
+ * to hand it off.
+ */
+typedef struct _nr_span_encoder_t {
+  nrthread_mutex_t mutex;
+  nrthread_cond_t wake; /* Signalled when a batch is handed off, or on
+                           shutdown */
+  nrthread_cond_t idle; /* Signalled when the encoder finishes a batch */
+  nr_span_batch_t* head;
+  nr_span_batch_t* tail;
+  nr_span_encoding_context_t* encoding_context; /* Only used by the encoder
+                                                   thread */
+  nrthread_t thread;
+  int pid; /* The process that started the thread, or 0 if there is none.
+              Read and written atomically, as it's checked without the
+              mutex */
+  bool shutdown;
+} nr_span_encoder_t;
+
 #endif /* NR_SPAN_QUEUE_PRIVATE_HDR */
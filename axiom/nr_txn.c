@@ -444,23 +444,96 @@ end:
   return rv;
 }
 
+/*
+ * The span queue keeps its own copy of the agent run ID, since its batches may
+ * still be sent after the transaction has been destroyed.
+ */
+static void nr_txn_span_batch_userdata_dtor(void* agent_run_id) {
+  nr_free(agent_run_id);
+}
+
+void nr_txn_snapshot_app(nr_txn_app_snapshot_t* snapshot, nrapp_t* app) {
+  if (NULL == snapshot) {
+    return;
+  }
+
+  nr_memset(snapshot, 0, sizeof(*snapshot));
+  if (NULL == app) {
+    return;
+  }
+
+  snapshot->state = app->state;
+  if (NR_APP_OK != app->state) {
+    return;
+  }
+
+  /*
+   * Applications assembled field by field, rather than connected through the
+   * daemon, have no published connect state: they get a private one.
+   */
+  if (app->connect_state) {
+    snapshot->connect_state = nr_app_connect_state_ref(app->connect_state);
+  } else {
+    snapshot->connect_state = nr_app_connect_state_create(app);
+  }
+  snapshot->rnd = app->rnd;
+
+  /*
+   * The random number generator and the harvest sampling state belong to the
+   * application, so everything that uses them is done here.
+   */
+  snapshot->guid = nr_guid_create(app->rnd);
+  snapshot->priority = nr_generate_initial_priority(app->rnd);
+  snapshot->sampled = nr_app_harvest_should_sample(&app->harvest, app->rnd);
+}
+
+void nr_txn_app_snapshot_destroy_fields(nr_txn_app_snapshot_t* snapshot) {
+  if (NULL == snapshot) {
+    return;
+  }
+
+  nr_app_connect_state_release(&snapshot->connect_state);
+  nr_free(snapshot->guid);
+  nr_memset(snapshot, 0, sizeof(*snapshot));
+}
+
 nrtxn_t* nr_txn_begin(nrapp_t* app,
                       const nrtxnopt_t* opts,
                       const nr_attribute_config_t* attribute_config,
                       const nrobj_t* log_forwarding_labels) {
+  nr_txn_app_snapshot_t snapshot;
+  nrtxn_t* nt;
+
+  if (NULL == app || NR_APP_OK != app->state || NULL == opts) {
+    return NULL;
+  }
+
+  nr_txn_snapshot_app(&snapshot, app);
+  nt = nr_txn_begin_snapshot(&snapshot, opts, attribute_config,
+                             log_forwarding_labels);
+  nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+  return nt;
+}
+
+nrtxn_t* nr_txn_begin_snapshot(nr_txn_app_snapshot_t* snapshot,
+                               const nrtxnopt_t* opts,
+                               const nr_attribute_config_t* attribute_config,
+                               const nrobj_t* log_forwarding_labels) {
   nrtxn_t* nt;
-  char* guid;
   nr_status_t err = 0;
   nr_sampling_priority_t priority;
   nr_slab_t* segment_slab;
+  nr_app_connect_state_t* connect_state;
 
-  if (NULL == app) {
+  if (NULL == snapshot) {
     return 0;
   }
 
-  if (NR_APP_OK != app->state) {
+  if (NR_APP_OK != snapshot->state || NULL == snapshot->connect_state) {
     return 0;
   }
+  connect_state = snapshot->connect_state;
 
   if (NULL == opts) {
     return NULL;
@@ -479,8 +552,8 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
   nt = (nrtxn_t*)nr_zalloc(sizeof(nrtxn_t));
   nt->status.path_is_frozen = 0;
   nt->status.path_type = NR_PATH_TYPE_UNKNOWN;
-  nt->agent_run_id = nr_strdup(app->agent_run_id);
-  nt->rnd = app->rnd;
+  nt->agent_run_id = nr_strdup(connect_state->agent_run_id);
+  nt->rnd = snapshot->rnd;
   nt->segment_slab = segment_slab;
 
   /*
@@ -491,7 +564,8 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
   nr_memcpy(&nt->options, opts, sizeof(nrtxnopt_t));
 
   nt->options.apdex_t
-      = (nrtime_t)(nr_reply_get_double(app->connect_reply, "apdex_t", 0.5)
+      = (nrtime_t)(nr_reply_get_double(connect_state->connect_reply, "apdex_t",
+                                       0.5)
                    * NR_TIME_DIVISOR_D);
 
   if (nt->options.tt_is_apdex_f) {
@@ -503,32 +577,35 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
    * necessary.
    */
   nt->options.analytics_events_enabled
-      = nt->options.analytics_events_enabled && app->limits.analytics_events;
+      = nt->options.analytics_events_enabled
+        && connect_state->limits.analytics_events;
   nt->options.custom_events_enabled
-      = nt->options.custom_events_enabled && app->limits.custom_events;
+      = nt->options.custom_events_enabled
+        && connect_state->limits.custom_events;
   nt->options.error_events_enabled
-      = nt->options.error_events_enabled && app->limits.error_events;
+      = nt->options.error_events_enabled && connect_state->limits.error_events;
   nt->options.span_events_enabled
-      = nt->options.span_events_enabled && app->limits.span_events;
+      = nt->options.span_events_enabled && connect_state->limits.span_events;
 
   /*
    * Enforce SSC and LASP if enabled
    */
-  nr_txn_enforce_security_settings(&nt->options, app->connect_reply,
-                                   app->security_policies);
+  nr_txn_enforce_security_settings(&nt->options, connect_state->connect_reply,
+                                   connect_state->security_policies);
 
   /*
    * Update the options based on the 8T configuration.
    */
   if (nt->options.span_events_enabled) {
-    if (nr_strempty(app->info.trace_observer_host)) {
+    if (nr_strempty(connect_state->trace_observer_host)) {
       nt->options.span_queue_batch_size = 0;
     }
     if (nt->options.span_queue_batch_size) {
       nt->span_queue = nr_span_queue_create(
           nt->options.span_queue_batch_size,
           nt->options.span_queue_batch_timeout, nr_txn_flush_span_batch,
-          (void*)nt->agent_run_id);
+          (void*)nr_strdup(nt->agent_run_id),
+          nr_txn_span_batch_userdata_dtor);
     }
   }
 
@@ -541,8 +618,9 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
   nt->attributes = nr_attributes_create(attribute_config);
   nt->intrinsics = nro_new_hash();
 
-  nt->custom_events = nr_analytics_events_create(app->limits.custom_events);
-  nt->log_events = nr_log_events_create(app->limits.log_events);
+  nt->custom_events
+      = nr_analytics_events_create(connect_state->limits.custom_events);
+  nt->log_events = nr_log_events_create(connect_state->limits.log_events);
   nt->log_forwarding_labels = nro_copy(log_forwarding_labels);
 
   nt->php_packages = nr_php_packages_create();
@@ -605,26 +683,31 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
   nr_get_cpu_usage(&nt->user_cpu[NR_CPU_USAGE_START],
                    &nt->sys_cpu[NR_CPU_USAGE_START]);
 
-  nt->license = nr_strdup(app->info.license);
+  nt->license = nr_strdup(connect_state->license);
 
-  nt->app_connect_reply = nro_copy(app->connect_reply);
-  nt->app_limits = app->limits;
-  nt->primary_app_name = nr_strdup(app->entity_name);
+  /*
+   * The snapshot's reference to the connect state is handed to the
+   * transaction, which reads the connect reply from it.
+   */
+  nt->app_connect_state = connect_state;
+  snapshot->connect_state = NULL;
+  nt->app_connect_reply = connect_state->connect_reply;
+  nt->app_limits = connect_state->limits;
+  nt->primary_app_name = nr_strdup(connect_state->entity_name);
 
   nt->cat.alternate_path_hashes = nro_new_hash();
 
-  if (app->info.high_security) {
+  if (connect_state->high_security) {
     nt->high_security = 1;
   }
 
-  if (NULL != app->info.security_policies_token
-      && '\0' != app->info.security_policies_token[0]) {
+  if (connect_state->lasp) {
     nt->lasp = 1;
     nt->options.request_params_enabled = 0;  // Force disabled
   }
 
   nr_txn_set_string_attribute(nt, nr_txn_host_display_name,
-                              app->info.host_display_name);
+                              connect_state->host_display_name);
 
   nt->distributed_trace = nr_distributed_trace_create();
 
@@ -636,9 +719,8 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
    * The trace id will be overwritten by accepting an inbound DT
    * payload.
    */
-  guid = nr_guid_create(app->rnd);
-  nr_distributed_trace_set_txn_id(nt->distributed_trace, guid);
-  nr_distributed_trace_set_trace_id(nt->distributed_trace, guid,
+  nr_distributed_trace_set_txn_id(nt->distributed_trace, snapshot->guid);
+  nr_distributed_trace_set_trace_id(nt->distributed_trace, snapshot->guid,
                                     opts->distributed_tracing_pad_trace_id);
 
   nr_distributed_trace_set_trusted_key(
@@ -652,15 +734,13 @@ nrtxn_t* nr_txn_begin(nrapp_t* app,
       nro_get_hash_string(nt->app_connect_reply, "primary_application_id",
                           &err));
 
-  priority = nr_generate_initial_priority(app->rnd);
-  if (nr_app_harvest_should_sample(&app->harvest, app->rnd)) {
+  priority = snapshot->priority;
+  if (snapshot->sampled) {
     nr_distributed_trace_set_sampled(nt->distributed_trace, true);
     priority += 1.0;
   }
   nr_distributed_trace_set_priority(nt->distributed_trace, priority);
 
-  nr_free(guid);
-
   return nt;
 }
 
@@ -1282,7 +1362,8 @@ void nr_txn_destroy_fields(nrtxn_t* txn) {
 
   nro_delete(txn->log_forwarding_labels);
 
-  nro_delete(txn->app_connect_reply);
+  txn->app_connect_reply = NULL;
+  nr_app_connect_state_release(&txn->app_connect_state);
   nr_free(txn->primary_app_name);
   nr_synthetics_destroy(&txn->synthetics);
 
@@ -1453,9 +1534,32 @@ void nr_txn_end(nrtxn_t* txn) {
   nr_segment_end(&root);
 
   /*
-   * Flush any 8T spans.
+   * Hand any 8T spans to the encoder thread. This doesn't wait for them to be
+   * sent.
    */
   nr_span_queue_flush(txn->span_queue);
+  if (nr_span_queue_dropped_spans(txn->span_queue)) {
+    nrm_add_internal(1, txn->unscoped_metrics,
+                     "Supportability/InfiniteTracing/Span/AgentQueueDumped",
+                     nr_span_queue_dropped_spans(txn->span_queue), 0, 0, 0, 0,
+                     0);
+  }
+
+  /*
+   * Record how well the segment slab was served by the page cache.
+   */
+  if (nr_slab_page_cache_hits(txn->segment_slab)) {
+    nrm_add_internal(1, txn->unscoped_metrics,
+                     "Supportability/Segment/PageCache/Hit",
+                     nr_slab_page_cache_hits(txn->segment_slab), 0, 0, 0, 0,
+                     0);
+  }
+  if (nr_slab_page_cache_misses(txn->segment_slab)) {
+    nrm_add_internal(1, txn->unscoped_metrics,
+                     "Supportability/Segment/PageCache/Miss",
+                     nr_slab_page_cache_misses(txn->segment_slab), 0, 0, 0, 0,
+                     0);
+  }
 
   /*
    * Finalise the segment tree.
@@ -2775,14 +2879,12 @@ char* nr_txn_create_w3c_traceparent_header(nrtxn_t* txn,
   // If spans are off we must send a random guid.
   if (NULL == span_id) {
     span_id = nr_guid_create(txn->rnd);
-    header = nr_distributed_trace_create_w3c_traceparent_header(
-        trace_id, span_id,
-        nr_distributed_trace_is_sampled(txn->distributed_trace));
+    header = nr_distributed_trace_outbound_traceparent(txn->distributed_trace,
+                                                       span_id);
     nr_free(span_id);
   } else {
-    header = nr_distributed_trace_create_w3c_traceparent_header(
-        trace_id, span_id,
-        nr_distributed_trace_is_sampled(txn->distributed_trace));
+    header = nr_distributed_trace_outbound_traceparent(txn->distributed_trace,
+                                                       span_id);
   }
 
 end:
@@ -2797,8 +2899,8 @@ end:
 
 char* nr_txn_create_w3c_tracestate_header(const nrtxn_t* txn,
                                           nr_segment_t* segment) {
-  char* span_id = NULL;
-  char* txn_id = NULL;
+  const char* span_id = NULL;
+  const char* txn_id = NULL;
   char* header = NULL;
 
   if (NULL == txn || NULL == txn->distributed_trace) {
@@ -2810,11 +2912,11 @@ char* nr_txn_create_w3c_tracestate_header(const nrtxn_t* txn,
   }
 
   if (txn->options.analytics_events_enabled) {
-    txn_id = nr_strdup(nr_distributed_trace_get_txn_id(txn->distributed_trace));
+    txn_id = nr_distributed_trace_get_txn_id(txn->distributed_trace);
   }
 
-  header = nr_distributed_trace_create_w3c_tracestate_header(
-      txn->distributed_trace, span_id, txn_id);
+  header = nr_distributed_trace_outbound_tracestate(
+      txn->distributed_trace, span_id, txn_id, nr_get_time());
 
   if (txn->special_flags.debug_dt) {
     nrl_verbosedebug(NRL_CAT,
@@ -2822,13 +2924,11 @@ char* nr_txn_create_w3c_tracestate_header(const nrtxn_t* txn,
                      NRSAFESTR(header));
   }
 
-  nr_free(txn_id);
   return header;
 }
 
 char* nr_txn_create_distributed_trace_payload(nrtxn_t* txn,
                                               nr_segment_t* segment) {
-  nr_distributed_trace_payload_t* payload;
   char* text = NULL;
 
   if (NULL == txn || NULL == segment) {
@@ -2867,10 +2967,9 @@ char* nr_txn_create_distributed_trace_payload(nrtxn_t* txn,
     goto end;
   }
 
-  payload = nr_distributed_trace_payload_create(
-      txn->distributed_trace, nr_segment_ensure_id(segment, txn));
-  text = nr_distributed_trace_payload_as_text(payload);
-  nr_distributed_trace_payload_destroy(&payload);
+  text = nr_distributed_trace_outbound_payload_text(
+      txn->distributed_trace, nr_segment_ensure_id(segment, txn),
+      nr_get_time());
 
   nr_segment_set_priority_flag(segment, NR_SEGMENT_PRIORITY_DT);
 
@@ -2937,9 +3036,8 @@ static bool nr_txn_accept_w3c_trace_context_headers(
     const char* traceparent,
     const char* tracestate,
     const char* transport_type) {
-  nrobj_t* trace_headers = NULL;
+  nr_distributed_trace_w3c_headers_t trace_headers;
   const char* error_metrics = NULL;
-  nr_status_t* err = NULL;
   const char* trusted_account_key = NULL;
 
   if (NULL == txn || NULL == txn->distributed_trace) {
@@ -2956,38 +3054,33 @@ static bool nr_txn_accept_w3c_trace_context_headers(
   trusted_account_key = nro_get_hash_string(txn->app_connect_reply,
                                             "trusted_account_key", NULL);
 
-  trace_headers = nr_distributed_trace_convert_w3c_headers_to_object(
-      traceparent, tracestate, trusted_account_key, &error_metrics);
-
-  if (error_metrics) {
+  /*
+   * The headers are parsed in place, so that only the values that the
+   * distributed trace keeps are copied.
+   */
+  if (!nr_distributed_trace_parse_w3c_headers(&trace_headers, traceparent,
+                                              tracestate, trusted_account_key,
+                                              &error_metrics)) {
     nr_txn_force_single_count(txn, error_metrics);
+    nrl_verbosedebug(NRL_CAT, "Unable to parse headers");
+    return false;
   }
 
-  if (nrunlikely(NULL == trace_headers)) {
-    nrl_verbosedebug(NRL_CAT, "Unable to parse headers");
-    goto failed;
+  if (error_metrics) {
+    nr_txn_force_single_count(txn, error_metrics);
   }
 
   error_metrics = NULL;
-  nr_distributed_trace_accept_inbound_w3c_payload(
-      txn->distributed_trace, trace_headers, transport_type, &error_metrics);
+  nr_distributed_trace_accept_inbound_w3c_headers(
+      txn->distributed_trace, &trace_headers, transport_type, &error_metrics);
 
   if (error_metrics) {
     nr_txn_force_single_count(txn, error_metrics);
   }
 
-  if (nrunlikely(NR_SUCCESS != err)) {
-    goto failed;
-  }
-
   nr_txn_force_single_count(txn, NR_DISTRIBUTED_TRACE_W3C_ACCEPT_SUCCESS);
 
-  nro_delete(trace_headers);
   return true;
-
-failed:
-  nro_delete(trace_headers);
-  return false;
 }
 
 bool nr_txn_accept_distributed_trace_payload(nrtxn_t* txn,
@@ -3386,31 +3479,35 @@ bool nr_txn_log_forwarding_labels_enabled(nrtxn_t* txn) {
 #define ENSURE_LOG_LEVEL_NAME(level_name) \
   (nr_strempty(level_name) ? "UNKNOWN" : level_name)
 
+/*
+ * The priority given to a log event recorded now: that of the current
+ * segment, including the flag that the segment has a log event, so that log
+ * events are sampled along with the spans they link to.
+ */
+static int nr_txn_log_event_priority(nrtxn_t* txn) {
+  nr_segment_t* segment = nr_txn_get_current_segment(txn, NULL);
+
+  if (NULL == segment) {
+    return 0;
+  }
+
+  return nr_segment_get_priority_flag(segment) | NR_SEGMENT_PRIORITY_LOG;
+}
+
 static void log_event_set_linking_metadata(nr_log_event_t* e,
+                                           int priority,
                                            nrtxn_t* txn,
                                            nrapp_t* app) {
   char* trace_id = NULL;
   char* span_id = NULL;
-  nr_segment_t* segment = NULL;
 
   if (NULL == e) {
     return;
   }
 
-  /* default priority to lowest value */
-  nr_log_event_set_priority(e, 0);
+  nr_log_event_set_priority(e, priority);
 
   if (nrlikely(txn)) {
-    segment = nr_txn_get_current_segment(txn, NULL);
-    if (NULL != segment) {
-      /*
-       * bump segment priority to increase chance it is saved
-       * if sampling occurs
-       */
-      nr_segment_set_priority_flag(segment, NR_SEGMENT_PRIORITY_LOG);
-      nr_log_event_set_priority(e, nr_segment_get_priority_flag(segment));
-    }
-
     trace_id = nr_txn_get_current_trace_id(txn);
     nr_log_event_set_trace_id(e, trace_id);
     nr_free(trace_id);
@@ -3431,6 +3528,7 @@ static void log_event_set_linking_metadata(nr_log_event_t* e,
 static nr_log_event_t* log_event_create(const char* log_level_name,
                                         const char* log_message,
                                         nrtime_t timestamp,
+                                        int priority,
                                         nr_attributes_t* context_attributes,
                                         nrtxn_t* txn,
                                         nrapp_t* app) {
@@ -3443,11 +3541,26 @@ static nr_log_event_t* log_event_create(const char* log_level_name,
   nr_log_event_set_timestamp(e, timestamp);
   nr_log_event_set_context_attributes(e, context_attributes);
 
-  log_event_set_linking_metadata(e, txn, app);
+  log_event_set_linking_metadata(e, priority, txn, app);
 
   return e;
 }
 
+bool nr_txn_log_event_is_admitted(nrtxn_t* txn,
+                                  const char* log_level_name,
+                                  nrtime_t timestamp) {
+  if (!nr_txn_log_forwarding_enabled(txn)) {
+    return false;
+  }
+
+  if (!nr_txn_log_forwarding_log_level_verify(txn, log_level_name)) {
+    return false;
+  }
+
+  return nr_log_events_admits(txn->log_events, nr_txn_log_event_priority(txn),
+                              timestamp);
+}
+
 static void nr_txn_add_log_event(nrtxn_t* txn,
                                  const char* log_level_name,
                                  const char* log_message,
@@ -3455,33 +3568,52 @@ static void nr_txn_add_log_event(nrtxn_t* txn,
                                  nr_attributes_t* context_attributes,
                                  nrapp_t* app) {
   nr_log_event_t* e = NULL;
+  nr_segment_t* segment = NULL;
   bool event_dropped = false;
+  int priority;
 
-  if (nrunlikely(NULL == txn)) {
+  if (!nr_txn_log_forwarding_enabled(txn) || nr_strempty(log_message)) {
+    nr_attributes_destroy(&context_attributes);
     return;
   }
 
-  if (!nr_txn_log_forwarding_enabled(txn)) {
+  /* log events filtered out by log level will go into the Dropped metric */
+  if (!nr_txn_log_forwarding_log_level_verify(txn, log_level_name)) {
+    nr_attributes_destroy(&context_attributes);
+    nrm_force_add(txn->unscoped_metrics, "Logging/Forwarding/Dropped", 0);
     return;
   }
 
-  if (nr_strempty(log_message)) {
+  /*
+   * bump segment priority to increase chance it is saved if sampling occurs,
+   * whether or not the log event itself is kept
+   */
+  segment = nr_txn_get_current_segment(txn, NULL);
+  if (NULL != segment) {
+    nr_segment_set_priority_flag(segment, NR_SEGMENT_PRIORITY_LOG);
+  }
+  priority = nr_txn_log_event_priority(txn);
+
+  /*
+   * Once the log event pool is full, most events on a busy transaction would
+   * be discarded as soon as they were inserted. Decide that up front, so that
+   * such events are never built.
+   */
+  if (!nr_log_events_admits(txn->log_events, priority, timestamp)) {
+    nr_attributes_destroy(&context_attributes);
+    nr_log_events_add_skipped_event(txn->log_events);
+    nrm_force_add(txn->unscoped_metrics, "Logging/Forwarding/Dropped", 0);
     return;
   }
 
-  /* log events filtered out by log level will go into the Dropped metric */
-  if (!nr_txn_log_forwarding_log_level_verify(txn, log_level_name)) {
+  e = log_event_create(log_level_name, log_message, timestamp, priority,
+                       context_attributes, txn, app);
+  if (NULL == e) {
+    nrl_debug(NRL_TXN, "%s: failed to create log event", __func__);
+    nr_attributes_destroy(&context_attributes);
     event_dropped = true;
   } else {
-    /* event passed log level filter so add it */
-    e = log_event_create(log_level_name, log_message, timestamp,
-                         context_attributes, txn, app);
-    if (NULL == e) {
-      nrl_debug(NRL_TXN, "%s: failed to create log event", __func__);
-      event_dropped = true;
-    } else {
-      event_dropped = nr_log_events_add_event(txn->log_events, e);
-    }
+    event_dropped = nr_log_events_add_event(txn->log_events, e);
   }
 
   if (event_dropped) {
@@ -3515,6 +3647,7 @@ void nr_txn_record_log_event(nrtxn_t* txn,
                              nr_attributes_t* context_attributes,
                              nrapp_t* app) {
   if (nrunlikely(NULL == txn)) {
+    nr_attributes_destroy(&context_attributes);
     return;
   }
 
@@ -306,8 +306,11 @@ typedef struct _nrtxn_t {
 
   nrtxntype_t type; /* The transaction type(s), as a bitfield */
 
+  nr_app_connect_state_t* app_connect_state; /* The application's connect
+                                                state; a reference */
   nrobj_t* app_connect_reply; /* Contents of application collector connect
-                                 command reply */
+                                 command reply; borrowed from
+                                 app_connect_state and not modified */
   nr_app_limits_t app_limits; /* Application data limits */
   char* primary_app_name; /* The primary app name in use (ie the first rollup
                              entry) */
@@ -381,6 +384,66 @@ void nr_txn_enforce_security_settings(nrtxnopt_t* opts,
                                       const nrobj_t* connect_reply,
                                       const nrobj_t* security_policies);
 
+/*
+ * The parts of an application that are needed to begin a transaction. Taking a
+ * snapshot while the application is locked allows the lock to be released
+ * before the transaction is created. The snapshot only takes a reference to
+ * the application's connect state, so the lock is held as briefly as possible.
+ */
+typedef struct _nr_txn_app_snapshot_t {
+  int state;
+  nr_app_connect_state_t* connect_state; /* A reference; NULL unless the
+                                            state is NR_APP_OK */
+  nr_random_t* rnd; /* The application's generator; not owned */
+
+  /*
+   * The transaction's GUID, initial priority and sampling decision, which
+   * depend on the application's random number generator and harvest state.
+   */
+  char* guid;
+  nr_sampling_priority_t priority;
+  bool sampled;
+} nr_txn_app_snapshot_t;
+
+/*
+ * Purpose : Take a snapshot of an application for nr_txn_begin_snapshot().
+ *
+ * Params  : 1. The snapshot to fill in. Its fields must be destroyed with
+ *              nr_txn_app_snapshot_destroy_fields().
+ *           2. The application, which is assumed to be locked and is not
+ *              unlocked by this function. This counts as one transaction for
+ *              the application's harvest sampling.
+ */
+extern void nr_txn_snapshot_app(nr_txn_app_snapshot_t* snapshot, nrapp_t* app);
+
+/*
+ * Purpose : Destroy the fields of an application snapshot.
+ */
+extern void nr_txn_app_snapshot_destroy_fields(
+    nr_txn_app_snapshot_t* snapshot);
+
+/*
+ * Purpose : Start a new transaction from a snapshot of its application. The
+ *           application does not need to be locked.
+ *
+ * Params  : 1. The application snapshot. Its reference to the connect state
+ *              is moved into the transaction.
+ *           2. Pointer to the starting options for the transaction.
+ *           3. Attributes configuration, usually generated by
+ *              nr_php_create_attribute_config()
+ *           4. A hash containing log forwarding labels to be added to log
+ *              events, usually genereated with
+ *              nr_php_txn_get_log_forwarding_labels()
+ *
+ * Returns : A newly created transaction pointer or NULL if the request could
+ *           not be completed.
+ */
+extern nrtxn_t* nr_txn_begin_snapshot(
+    nr_txn_app_snapshot_t* snapshot,
+    const nrtxnopt_t* opts,
+    const nr_attribute_config_t* attribute_config,
+    const nrobj_t* log_forwarding_labels);
+
 /*
  * Purpose : Start a new transaction belonging to the given application.
  *
@@ -679,6 +742,27 @@ extern bool nr_txn_log_metrics_enabled(nrtxn_t* txn);
  */
 extern bool nr_txn_log_decorating_enabled(nrtxn_t* txn);
 
+/*
+ * Purpose : Determine whether a log event recorded now would be kept by the
+ *           transaction, so that callers can avoid gathering data for one that
+ *           would be discarded.
+ *
+ * Params  : 1. The transaction.
+ *           2. Log record level name
+ *           3. Log record timestamp
+ *
+ * Returns : true if nr_txn_record_log_event() would keep a log event with
+ *           this level and timestamp; false if log forwarding is disabled,
+ *           the level is filtered out, or the event would be sampled out.
+ *
+ * Notes   : Events that aren't admitted should still be passed to
+ *           nr_txn_record_log_event(), without context attributes, so that
+ *           they are counted.
+ */
+extern bool nr_txn_log_event_is_admitted(nrtxn_t* txn,
+                                         const char* log_level_name,
+                                         nrtime_t timestamp);
+
 /*
  * Purpose : Add a log event to transaction
  *
@@ -686,9 +770,12 @@ extern bool nr_txn_log_decorating_enabled(nrtxn_t* txn);
  *           2. Log record level name
  *           3. Log record message
  *           4. Log record timestamp
- *           5. Attribute data for Monolog context data (can be NULL)
+ *           5. Attribute data for Monolog context data (can be NULL), which
+ *              is owned by the transaction after this call
  *           6. The application (to get linking meta data)
  *
+ * Notes   : Once the transaction's log event pool is full, events that would
+ *           be sampled out are counted but not built.
  */
 extern void nr_txn_record_log_event(nrtxn_t* txn,
                                     const char* level_name,
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include "nr_txn_finaliser.h"
+#include "util_logging.h"
+#include "util_memory.h"
+#include "util_random.h"
+#include "util_syscalls.h"
+#include "util_threads.h"
+#include "util_vector.h"
+
+struct _nr_txn_finaliser_t {
+  nrthread_mutex_t mutex;
+  nrthread_cond_t work_available; /* Signalled when a txn is queued, or on
+                                     shutdown */
+  nrthread_cond_t idle;           /* Signalled when the queue is drained */
+  nrthread_t thread;
+  nr_vector_t pending; /* Transactions waiting to be finalised, oldest first */
+  size_t max_pending;
+  bool busy;     /* Whether the worker is finalising a transaction */
+  bool shutdown; /* Whether the worker has been asked to stop */
+  int pid;       /* The process that owns the worker thread */
+  nr_random_t* rnd; /* Random number generator used by the worker */
+  nr_txn_finaliser_func_t func;
+  void* userdata;
+};
+
+static void nr_txn_finaliser_pending_dtor(void* element,
+                                          void* userdata NRUNUSED) {
+  nrtxn_t* txn = (nrtxn_t*)element;
+
+  nr_txn_destroy(&txn);
+}
+
+static void* nr_txn_finaliser_worker(void* arg) {
+  nr_txn_finaliser_t* finaliser = (nr_txn_finaliser_t*)arg;
+
+  nrt_mutex_lock(&finaliser->mutex);
+  for (;;) {
+    void* element = NULL;
+    nrtxn_t* txn;
+
+    while (0 == nr_vector_size(&finaliser->pending) && !finaliser->shutdown) {
+      nrt_cond_wait(&finaliser->work_available, &finaliser->mutex);
+    }
+
+    /*
+     * Transactions that are still waiting at shutdown are finalised before
+     * the worker exits.
+     */
+    if (!nr_vector_pop_front(&finaliser->pending, &element)) {
+      break;
+    }
+
+    finaliser->busy = true;
+    nrt_mutex_unlock(&finaliser->mutex);
+
+    txn = (nrtxn_t*)element;
+    (finaliser->func)(txn, finaliser->userdata);
+    nr_txn_destroy(&txn);
+
+    nrt_mutex_lock(&finaliser->mutex);
+    finaliser->busy = false;
+    if (0 == nr_vector_size(&finaliser->pending)) {
+      nrt_cond_broadcast(&finaliser->idle);
+    }
+  }
+  nrt_mutex_unlock(&finaliser->mutex);
+
+  return NULL;
+}
+
+nr_txn_finaliser_t* nr_txn_finaliser_create(size_t max_pending,
+                                            nr_txn_finaliser_func_t func,
+                                            void* userdata) {
+  nr_txn_finaliser_t* finaliser;
+
+  if (NULL == func || 0 == max_pending) {
+    return NULL;
+  }
+
+  finaliser = (nr_txn_finaliser_t*)nr_zalloc(sizeof(nr_txn_finaliser_t));
+  finaliser->max_pending = max_pending;
+  finaliser->func = func;
+  finaliser->userdata = userdata;
+  finaliser->pid = nr_getpid();
+  finaliser->rnd = nr_random_create();
+  nr_random_seed_from_time(finaliser->rnd);
+  nr_vector_init(&finaliser->pending, max_pending,
+                 nr_txn_finaliser_pending_dtor, NULL);
+
+  if (NR_SUCCESS != nrt_mutex_init(&finaliser->mutex, NULL)) {
+    goto error_mutex;
+  }
+  if (NR_SUCCESS != nrt_cond_init(&finaliser->work_available)) {
+    goto error_work_available;
+  }
+  if (NR_SUCCESS != nrt_cond_init(&finaliser->idle)) {
+    goto error_idle;
+  }
+  if (NR_SUCCESS
+      != nrt_create(&finaliser->thread, NULL, nr_txn_finaliser_worker,
+                    finaliser)) {
+    goto error_thread;
+  }
+
+  return finaliser;
+
+error_thread:
+  nrt_cond_destroy(&finaliser->idle);
+error_idle:
+  nrt_cond_destroy(&finaliser->work_available);
+error_work_available:
+  nrt_mutex_destroy(&finaliser->mutex);
+error_mutex:
+  nr_vector_deinit(&finaliser->pending);
+  nr_random_destroy(&finaliser->rnd);
+  nr_free(finaliser);
+  return NULL;
+}
+
+bool nr_txn_finaliser_is_owned(const nr_txn_finaliser_t* finaliser) {
+  return (NULL != finaliser) && (nr_getpid() == finaliser->pid);
+}
+
+bool nr_txn_finaliser_submit(nr_txn_finaliser_t* finaliser,
+                             nrtxn_t** txn_ptr) {
+  bool accepted = false;
+
+  if (NULL == txn_ptr || NULL == *txn_ptr
+      || !nr_txn_finaliser_is_owned(finaliser)) {
+    return false;
+  }
+
+  nrt_mutex_lock(&finaliser->mutex);
+  if (!finaliser->shutdown
+      && nr_vector_size(&finaliser->pending) < finaliser->max_pending) {
+    (*txn_ptr)->rnd = finaliser->rnd;
+    accepted = nr_vector_push_back(&finaliser->pending, *txn_ptr);
+  }
+  if (accepted) {
+    nrt_cond_signal(&finaliser->work_available);
+  }
+  nrt_mutex_unlock(&finaliser->mutex);
+
+  if (accepted) {
+    *txn_ptr = NULL;
+  } else {
+    nrl_verbosedebug(NRL_TXN,
+                     "transaction finaliser is full; finalising the "
+                     "transaction in the request");
+  }
+
+  return accepted;
+}
+
+void nr_txn_finaliser_drain(nr_txn_finaliser_t* finaliser) {
+  if (!nr_txn_finaliser_is_owned(finaliser)) {
+    return;
+  }
+
+  nrt_mutex_lock(&finaliser->mutex);
+  while (0 != nr_vector_size(&finaliser->pending) || finaliser->busy) {
+    nrt_cond_wait(&finaliser->idle, &finaliser->mutex);
+  }
+  nrt_mutex_unlock(&finaliser->mutex);
+}
+
+void nr_txn_finaliser_destroy(nr_txn_finaliser_t** finaliser_ptr) {
+  nr_txn_finaliser_t* finaliser;
+
+  if (NULL == finaliser_ptr || NULL == *finaliser_ptr) {
+    return;
+  }
+
+  finaliser = *finaliser_ptr;
+
+  /*
+   * A forked child has no worker thread to stop, and the mutex may have been
+   * held by another thread of the parent when the fork happened; the parent's
+   * transactions are simply released.
+   */
+  if (nr_txn_finaliser_is_owned(finaliser)) {
+    nrt_mutex_lock(&finaliser->mutex);
+    finaliser->shutdown = true;
+    nrt_cond_signal(&finaliser->work_available);
+    nrt_mutex_unlock(&finaliser->mutex);
+
+    nrt_join(finaliser->thread, NULL);
+
+    nrt_cond_destroy(&finaliser->idle);
+    nrt_cond_destroy(&finaliser->work_available);
+    nrt_mutex_destroy(&finaliser->mutex);
+  }
+
+  nr_vector_deinit(&finaliser->pending);
+  nr_random_destroy(&finaliser->rnd);
+  nr_realfree((void**)finaliser_ptr);
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * This file contains a worker thread that finalises completed transactions
+ * after the request that created them has finished.
+ *
+ * Finalising a transaction (ending it, building the trace and span events,
+ * encoding it and sending it to the daemon) only needs the transaction itself,
+ * so it can be handed off to a worker thread that owns it from then on. This
+ * removes that work from the request's critical path.
+ *
+ * A finaliser belongs to the process that created it: a forked child cannot
+ * use its parent's finaliser, since the worker thread doesn't exist in the
+ * child.
+ */
+#ifndef NR_TXN_FINALISER_HDR
+#define NR_TXN_FINALISER_HDR
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "nr_txn.h"
+
+typedef struct _nr_txn_finaliser_t nr_txn_finaliser_t;
+
+/*
+ * The function called on the worker thread for each transaction. The
+ * transaction is destroyed by the finaliser once the function returns.
+ */
+typedef void (*nr_txn_finaliser_func_t)(nrtxn_t* txn, void* userdata);
+
+/*
+ * Purpose : Create a finaliser and start its worker thread.
+ *
+ * Params  : 1. The maximum number of transactions that may be waiting to be
+ *              finalised. Submissions beyond this are refused, so that a slow
+ *              daemon can't cause unbounded memory growth.
+ *           2. The function to call for each transaction.
+ *           3. Userdata to pass to the function.
+ *
+ * Returns : A newly allocated finaliser, which must be destroyed with
+ *           nr_txn_finaliser_destroy(), or NULL on error.
+ */
+extern nr_txn_finaliser_t* nr_txn_finaliser_create(
+    size_t max_pending,
+    nr_txn_finaliser_func_t func,
+    void* userdata);
+
+/*
+ * Purpose : Hand a completed transaction to the finaliser.
+ *
+ *           On success, the finaliser takes ownership of the transaction and
+ *           the caller's pointer is set to NULL. The transaction's random
+ *           number generator, which is owned by the application, is replaced
+ *           by one owned by the finaliser.
+ *
+ * Params  : 1. The finaliser.
+ *           2. A pointer to the transaction.
+ *
+ * Returns : True if the transaction was accepted. False if the finaliser is
+ *           full, belongs to another process, or on error, in which case the
+ *           caller still owns the transaction and must finalise it itself.
+ */
+extern bool nr_txn_finaliser_submit(nr_txn_finaliser_t* finaliser,
+                                    nrtxn_t** txn_ptr);
+
+/*
+ * Purpose : Wait until every transaction submitted to the finaliser has been
+ *           finalised.
+ *
+ * Params  : 1. The finaliser.
+ */
+extern void nr_txn_finaliser_drain(nr_txn_finaliser_t* finaliser);
+
+/*
+ * Purpose : Return whether the finaliser was created by the current process.
+ *
+ * Params  : 1. The finaliser.
+ *
+ * Returns : True if the finaliser's worker thread runs in this process.
+ */
+extern bool nr_txn_finaliser_is_owned(const nr_txn_finaliser_t* finaliser);
+
+/*
+ * Purpose : Destroy a finaliser.
+ *
+ *           Any transactions that are still waiting are finalised before the
+ *           worker thread is stopped. In a forked child, the parent's waiting
+ *           transactions are discarded instead, since the parent will send
+ *           them.
+ *
+ * Params  : 1. A pointer to the finaliser.
+ */
+extern void nr_txn_finaliser_destroy(nr_txn_finaliser_t** finaliser_ptr);
+
+#endif /* NR_TXN_FINALISER_HDR */
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times the application handling done by ZTS worker threads at transaction
+ * start: find the app, take a snapshot of it for the transaction while it is
+ * locked, then verify its agent run ID. Half of the lookups go to a single hot
+ * app shared by all threads.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_app.h"
+#include "nr_app_private.h"
+#include "nr_txn.h"
+#include "util_memory.h"
+#include "util_strings.h"
+#include "util_threads.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_THREADS 8
+#define NR_BENCH_APPS 16
+#define NR_BENCH_ITERATIONS 20000
+
+typedef struct _bench_thread_t {
+  nrapplist_t* applist;
+  int thread_id;
+  int lookups;
+} bench_thread_t;
+
+static void bench_app_info(nr_app_info_t* info,
+                           char* license,
+                           nrobj_t* environment,
+                           int n) {
+  nr_memset(info, 0, sizeof(*info));
+  snprintf(license, NR_LICENSE_SIZE + 1,
+           "12345%05d000000000000000000000000006789", n);
+  info->license = license;
+  info->appname = "bench-app";
+  info->version = "my_version";
+  info->lang = "my_language";
+  info->environment = environment;
+  info->redirect_collector = "collector.newrelic.com";
+}
+
+/*
+ * Connects the app the way the daemon's APPINFO reply does, publishing its
+ * connect state.
+ */
+static void bench_connect_app(nrapp_t* app, int n) {
+  app->agent_run_id = nr_formatf("run%d", n);
+  app->connect_reply = nro_create_from_json(
+      "{\"apdex_t\":0.5,\"encoding_key\":\"d67afc830dab717fd163bfcb0b8b88423e9"
+      "a1a3b\",\"trusted_account_key\":\"1\",\"account_id\":\"1\"}");
+  app->security_policies = nro_new_hash();
+  nr_app_harvest_init(&app->harvest, nr_get_time(), 60 * NR_TIME_DIVISOR, 10);
+  app->state = NR_APP_OK;
+  nr_app_publish_connect_state(app);
+}
+
+static void* bench_thread(void* arg) {
+  bench_thread_t* bt = (bench_thread_t*)arg;
+  nr_app_info_t info;
+  char license[NR_LICENSE_SIZE + 1];
+  nrobj_t* environment = nro_create_from_json("[\"my_environment\"]");
+  int i;
+
+  for (i = 0; i < NR_BENCH_ITERATIONS; i++) {
+    int n = (i & 1) ? 0 : ((bt->thread_id + i) % NR_BENCH_APPS);
+    nr_txn_app_snapshot_t snapshot;
+    char run_id[32];
+    nrapp_t* app;
+
+    bench_app_info(&info, license, environment, n);
+    app = nr_app_find_or_add_app(bt->applist, &info);
+    if (NULL == app) {
+      continue;
+    }
+    if (NR_APP_OK != app->state) {
+      bench_connect_app(app, n);
+    }
+    nr_txn_snapshot_app(&snapshot, app);
+    nrt_mutex_unlock(&app->app_lock);
+    nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+    snprintf(run_id, sizeof(run_id), "run%d", n);
+    app = nr_app_verify_id(bt->applist, run_id);
+    if (NULL == app) {
+      continue;
+    }
+    nrt_mutex_unlock(&app->app_lock);
+
+    bt->lookups++;
+  }
+
+  nro_delete(environment);
+  return NULL;
+}
+
+static void bench_txn_begin_lookups(void) {
+  nrapplist_t* applist = nr_applist_create();
+  nrthread_t threads[NR_BENCH_THREADS];
+  bench_thread_t states[NR_BENCH_THREADS];
+  nrtime_t start;
+  nrtime_t duration;
+  int lookups = 0;
+  int i;
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_THREADS; i++) {
+    states[i].applist = applist;
+    states[i].thread_id = i;
+    states[i].lookups = 0;
+    nrt_create(&threads[i], NULL, bench_thread, &states[i]);
+  }
+
+  for (i = 0; i < NR_BENCH_THREADS; i++) {
+    nrt_join(threads[i], NULL);
+    lookups += states[i].lookups;
+  }
+  duration = nr_time_duration(start, nr_get_time());
+
+  printf("applist: %d threads, %d txn begin lookups in %.3fs (%.0f/s)\n",
+         NR_BENCH_THREADS, lookups, (double)duration / NR_TIME_DIVISOR_D,
+         duration ? (double)lookups * NR_TIME_DIVISOR_D / (double)duration
+                  : 0.0);
+
+  nr_applist_destroy(&applist);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_txn_begin_lookups();
+}
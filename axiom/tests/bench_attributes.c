@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times applying a configuration with as many modifiers as the agent creates
+ * from a typical set of attribute settings, by walking the modifier list and
+ * through the compiled filter.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_attributes.h"
+#include "nr_attributes_private.h"
+#include "util_hash.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_APPLIES 200000
+
+static void bench_filter(void) {
+  static const char* keys[] = {
+      "request.headers.host",  "request.headers.userAgent",
+      "request.method",        "request.uri",
+      "response.statusCode",   "request.parameters.id",
+      "request.parameters.q",  "context.user",
+      "httpResponseCode",      "SERVER_NAME",
+  };
+  static const char* matches[] = {
+      "request.parameters.*", "request.headers.cookie",
+      "request.headers.*",    "response.headers.*",
+      "message.parameters.*", "context.*",
+      "custom.secret*",       "custom.secret.allowed",
+      "httpResponseCode",     "job.sidekiq.args.*",
+      "a*",                   "b*",
+      "c*",                   "d*",
+      "e*",                   "f*",
+  };
+  size_t num_keys = sizeof(keys) / sizeof(keys[0]);
+  uint32_t hashes[sizeof(keys) / sizeof(keys[0])];
+  nr_attribute_config_t* config = nr_attribute_config_create();
+  nr_attribute_config_t* compiled;
+  nrtime_t start;
+  nrtime_t list_duration;
+  nrtime_t compiled_duration;
+  uint32_t list_total = 0;
+  uint32_t compiled_total = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof(matches) / sizeof(matches[0]); i++) {
+    nr_attribute_config_modify_destinations(
+        config, matches[i], (i % 2) ? NR_ATTRIBUTE_DESTINATION_TXN_EVENT : 0,
+        (i % 2) ? 0 : NR_ATTRIBUTE_DESTINATION_TXN_TRACE);
+  }
+  compiled = nr_attribute_config_copy(config);
+  for (i = 0; i < num_keys; i++) {
+    hashes[i] = nr_mkhash(keys[i], 0);
+  }
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_APPLIES; i++) {
+    list_total += nr_attribute_config_apply_list(
+        config, keys[i % num_keys], hashes[i % num_keys],
+        NR_ATTRIBUTE_DESTINATION_ALL);
+  }
+  list_duration = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_APPLIES; i++) {
+    compiled_total += nr_attribute_config_apply(
+        compiled, keys[i % num_keys], hashes[i % num_keys],
+        NR_ATTRIBUTE_DESTINATION_ALL);
+  }
+  compiled_duration = nr_time_duration(start, nr_get_time());
+
+  tlib_pass_if_uint32_t_equal("benchmark results", list_total,
+                              compiled_total);
+  printf("attribute filter: %d applies: %.3fms list, %.3fms compiled\n",
+         NR_BENCH_APPLIES, (double)list_duration / NR_TIME_DIVISOR_MS_D,
+         (double)compiled_duration / NR_TIME_DIVISOR_MS_D);
+
+  nr_attribute_config_destroy(&config);
+  nr_attribute_config_destroy(&compiled);
+  nr_attribute_filter_cache_clear();
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_filter();
+}
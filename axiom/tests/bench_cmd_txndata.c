@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times encoding a large transaction into a new buffer that grows as
+ * required, and into a buffer presized from the estimate for the
+ * transaction's name.
+ */
+#include "cmd_txndata_transmit.c"
+
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_commands_private.h"
+#include "nr_span_event.h"
+#include "nr_txn.h"
+#include "nr_txn_private.h"
+#include "util_flatbuffers.h"
+#include "util_memory.h"
+#include "util_strings.h"
+#include "util_time.h"
+#include "util_vector.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_ENCODES 20
+#define NR_BENCH_SPAN_EVENTS 5000
+#define NR_BENCH_TRACE_SIZE (64 * 1024)
+
+static void bench_destroy_span_event(void* ptr, void* userdata NRUNUSED) {
+  nr_span_event_destroy((nr_span_event_t**)&ptr);
+}
+
+static void bench_txn_init(nrtxn_t* txn) {
+  char* trace_json;
+  size_t i;
+
+  nr_memset(txn, 0, sizeof(*txn));
+  txn->status.recording = 1;
+  txn->name = nr_strdup("WebTransaction/Uri/large");
+  nr_txn_set_guid(txn, "0123456789abcdef");
+
+  trace_json = (char*)nr_malloc(NR_BENCH_TRACE_SIZE + 1);
+  nr_memset(trace_json, 'x', NR_BENCH_TRACE_SIZE);
+  trace_json[NR_BENCH_TRACE_SIZE] = '\0';
+  txn->final_data.trace_json = trace_json;
+
+  txn->app_limits.span_events = NR_BENCH_SPAN_EVENTS;
+  txn->final_data.span_events = nr_vector_create(
+      NR_BENCH_SPAN_EVENTS, bench_destroy_span_event, NULL);
+  for (i = 0; i < NR_BENCH_SPAN_EVENTS; i++) {
+    nr_span_event_t* span = nr_span_event_create();
+
+    nr_span_event_set_guid(span, "abcdefgh");
+    nr_span_event_set_name(span, "Custom/large_txn_segment");
+    nr_vector_push_back(txn->final_data.span_events, span);
+  }
+}
+
+static void bench_encode(void) {
+  nrtxn_t txn;
+  nr_flatbuffer_t* fb;
+  nrtime_t start;
+  nrtime_t grown_duration;
+  nrtime_t presized_duration;
+  size_t grown_copied = 0;
+  size_t presized_copied = 0;
+  size_t len = 0;
+  int i;
+
+  bench_txn_init(&txn);
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_ENCODES; i++) {
+    fb = nr_txndata_encode(&txn);
+    grown_copied += nr_flatbuffers_bytes_copied(fb);
+    len = nr_flatbuffers_len(fb);
+    nr_flatbuffers_destroy(&fb);
+  }
+  grown_duration = nr_time_duration(start, nr_get_time());
+
+  /*
+   * Record the size estimate for the transaction's name before timing.
+   */
+  nr_txndata_record_size(&txn, len);
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_ENCODES; i++) {
+    fb = nr_flatbuffers_create(0);
+    nr_txndata_encode_presized(fb, &txn, false);
+    presized_copied += nr_flatbuffers_bytes_copied(fb);
+    nr_flatbuffers_destroy(&fb);
+  }
+  presized_duration = nr_time_duration(start, nr_get_time());
+
+  printf(
+      "txndata: %d encodes of a %zu byte transaction: %.3fms and %zu bytes "
+      "copied growing new buffers, %.3fms and %zu bytes copied presized\n",
+      NR_BENCH_ENCODES, len, (double)grown_duration / NR_TIME_DIVISOR_MS_D,
+      grown_copied, (double)presized_duration / NR_TIME_DIVISOR_MS_D,
+      presized_copied);
+
+  nr_txn_destroy_fields(&txn);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_encode();
+}
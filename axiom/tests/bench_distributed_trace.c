@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times accepting inbound W3C headers through an intermediate object and
+ * from headers parsed in place, and building the outbound headers for every
+ * external call and from the cached parts.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_distributed_trace.h"
+#include "nr_distributed_trace_private.h"
+#include "util_memory.h"
+#include "util_object.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_W3C_ACCEPTS 20000
+#define NR_BENCH_OUTBOUND_CALLS 20000
+
+static void bench_w3c_accept(void) {
+  const char* traceparent
+      = "00-74be672b84ddc4e4b28be285632bbc0a-27ddd2d8890283b4-01";
+  const char* tracestate
+      = "dd=s:1;o:rum,"
+        "190@nr=0-0-709288-8599547-f85f42fd82a4cf1d-164d3b4b0d09cb05-1-0.789-"
+        "1563574856827,"
+        "congo=t61rcWkgMzE";
+  nrtime_t start;
+  nrtime_t object_duration;
+  nrtime_t parsed_duration;
+  int i;
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_W3C_ACCEPTS; i++) {
+    nr_distributed_trace_t* dt = nr_distributed_trace_create();
+    const char* error = NULL;
+    nrobj_t* obj = nr_distributed_trace_convert_w3c_headers_to_object(
+        traceparent, tracestate, "190", &error);
+
+    error = NULL;
+    nr_distributed_trace_accept_inbound_w3c_payload(dt, obj, "HTTP", &error);
+    nro_delete(obj);
+    nr_distributed_trace_destroy(&dt);
+  }
+  object_duration = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_W3C_ACCEPTS; i++) {
+    nr_distributed_trace_t* dt = nr_distributed_trace_create();
+    nr_distributed_trace_w3c_headers_t headers;
+    const char* error = NULL;
+
+    nr_distributed_trace_parse_w3c_headers(&headers, traceparent, tracestate,
+                                           "190", &error);
+    error = NULL;
+    nr_distributed_trace_accept_inbound_w3c_headers(dt, &headers, "HTTP",
+                                                    &error);
+    nr_distributed_trace_destroy(&dt);
+  }
+  parsed_duration = nr_time_duration(start, nr_get_time());
+
+  printf("w3c accept: %d accepts: %.3fms via object, %.3fms parsed in place\n",
+         NR_BENCH_W3C_ACCEPTS, (double)object_duration / NR_TIME_DIVISOR_MS_D,
+         (double)parsed_duration / NR_TIME_DIVISOR_MS_D);
+}
+
+static void bench_outbound_headers(void) {
+  const char* span_id = "f85f42fd82a4cf1d";
+  const char* txn_id = "164d3b4b0d09cb05";
+  nr_distributed_trace_t* dt = nr_distributed_trace_create();
+  nrtime_t start;
+  nrtime_t uncached_duration;
+  nrtime_t cached_duration;
+  int i;
+
+  nr_distributed_trace_set_account_id(dt, "709288");
+  nr_distributed_trace_set_app_id(dt, "8599547");
+  nr_distributed_trace_set_trusted_key(dt, "190");
+  nr_distributed_trace_set_trace_id(dt, "74be672b84ddc4e4b28be285632bbc0a",
+                                    false);
+  nr_distributed_trace_set_txn_id(dt, txn_id);
+  nr_distributed_trace_set_priority(dt, 0.789);
+  nr_distributed_trace_set_sampled(dt, true);
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_OUTBOUND_CALLS; i++) {
+    nr_distributed_trace_payload_t* payload
+        = nr_distributed_trace_payload_create(dt, span_id);
+    char* text = nr_distributed_trace_payload_as_text(payload);
+    char* traceparent = nr_distributed_trace_create_w3c_traceparent_header(
+        dt->trace_id, span_id, dt->sampled);
+    char* tracestate
+        = nr_distributed_trace_create_w3c_tracestate_header(dt, span_id,
+                                                            txn_id);
+
+    nr_free(text);
+    nr_free(traceparent);
+    nr_free(tracestate);
+    nr_distributed_trace_payload_destroy(&payload);
+  }
+  uncached_duration = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  for (i = 0; i < NR_BENCH_OUTBOUND_CALLS; i++) {
+    nrtime_t now = nr_get_time();
+    char* text = nr_distributed_trace_outbound_payload_text(dt, span_id, now);
+    char* traceparent = nr_distributed_trace_outbound_traceparent(dt, span_id);
+    char* tracestate
+        = nr_distributed_trace_outbound_tracestate(dt, span_id, txn_id, now);
+
+    nr_free(text);
+    nr_free(traceparent);
+    nr_free(tracestate);
+  }
+  cached_duration = nr_time_duration(start, nr_get_time());
+
+  printf("outbound headers: %d calls: %.3fms uncached, %.3fms cached\n",
+         NR_BENCH_OUTBOUND_CALLS,
+         (double)uncached_duration / NR_TIME_DIVISOR_MS_D,
+         (double)cached_duration / NR_TIME_DIVISOR_MS_D);
+
+  nr_distributed_trace_destroy(&dt);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_w3c_accept();
+  bench_outbound_headers();
+}
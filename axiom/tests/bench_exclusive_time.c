@@ -0,0 +1,71 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times calculating exclusive time by sorting the children of a segment and
+ * by sweeping them in order.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_exclusive_time.h"
+#include "nr_exclusive_time_private.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_SWEEP_CHILDREN 100000
+
+static void bench_sweep(void) {
+  nr_exclusive_time_t* et;
+  nr_exclusive_time_sweep_t sweep;
+  nrtime_t et_duration;
+  nrtime_t et_result;
+  nrtime_t start;
+  nrtime_t sweep_duration;
+  nrtime_t sweep_result;
+  size_t i;
+
+  /*
+   * Compare both paths for a segment with many ordered, non-overlapping
+   * children, as produced by a synchronous PHP loop.
+   */
+  start = nr_get_time();
+  et = nr_exclusive_time_create(NR_BENCH_SWEEP_CHILDREN, 0,
+                                NR_BENCH_SWEEP_CHILDREN * 10);
+  for (i = 0; i < NR_BENCH_SWEEP_CHILDREN; i++) {
+    nr_exclusive_time_add_child(et, i * 10 + 1, i * 10 + 9);
+  }
+  et_result = nr_exclusive_time_calculate(et);
+  nr_exclusive_time_destroy(&et);
+  et_duration = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  nr_exclusive_time_sweep_init(&sweep, 0, NR_BENCH_SWEEP_CHILDREN * 10);
+  for (i = 0; i < NR_BENCH_SWEEP_CHILDREN; i++) {
+    nr_exclusive_time_sweep_add_child(&sweep, i * 10 + 1, i * 10 + 9);
+  }
+  sweep_result = nr_exclusive_time_sweep_calculate(&sweep);
+  sweep_duration = nr_time_duration(start, nr_get_time());
+
+  tlib_pass_if_time_equal("benchmark exclusive time",
+                          NR_BENCH_SWEEP_CHILDREN * 2, et_result);
+  tlib_pass_if_time_equal("benchmark sweep exclusive time", et_result,
+                          sweep_result);
+
+  printf("exclusive time: %d children sorted in %.3fms, swept in %.3fms\n",
+         NR_BENCH_SWEEP_CHILDREN, (double)et_duration / NR_TIME_DIVISOR_MS_D,
+         (double)sweep_duration / NR_TIME_DIVISOR_MS_D);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_sweep();
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times the request-scoped maps in the agent: a small map of short string
+ * keys (such as outbound headers) that is created, filled, read and destroyed
+ * many times, and a large map of integer keys (such as parent stacks or curl
+ * handles).
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "util_hashmap.h"
+#include "util_strings.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_SMALL_MAPS 20000
+#define NR_BENCH_SMALL_KEYS 16
+#define NR_BENCH_LARGE_KEYS 20000
+
+static void bench_hashmap(void) {
+  char keys[NR_BENCH_SMALL_KEYS][32];
+  nr_hashmap_t* hashmap;
+  nrtime_t small_duration;
+  nrtime_t large_duration;
+  nrtime_t start;
+  uint64_t found = 0;
+  uint64_t i;
+  int n;
+
+  for (i = 0; i < NR_BENCH_SMALL_KEYS; i++) {
+    snprintf(keys[i], sizeof(keys[i]), "x-benchmark-header-%d", (int)i);
+  }
+
+  start = nr_get_time();
+  for (n = 0; n < NR_BENCH_SMALL_MAPS; n++) {
+    hashmap = nr_hashmap_create(NULL);
+    for (i = 0; i < NR_BENCH_SMALL_KEYS; i++) {
+      nr_hashmap_set(hashmap, keys[i], nr_strlen(keys[i]), keys[i]);
+    }
+    for (i = 0; i < NR_BENCH_SMALL_KEYS * 4; i++) {
+      const char* key = keys[i % NR_BENCH_SMALL_KEYS];
+
+      found += (NULL != nr_hashmap_get(hashmap, key, nr_strlen(key)));
+    }
+    nr_hashmap_destroy(&hashmap);
+  }
+  small_duration = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  hashmap = nr_hashmap_create(NULL);
+  for (i = 0; i < NR_BENCH_LARGE_KEYS; i++) {
+    nr_hashmap_index_set(hashmap, i * 7919, keys[0]);
+  }
+  for (i = 0; i < NR_BENCH_LARGE_KEYS * 4; i++) {
+    uint64_t index = (i % NR_BENCH_LARGE_KEYS) * 7919;
+
+    found += (NULL != nr_hashmap_index_get(hashmap, index));
+  }
+  for (i = 0; i < NR_BENCH_LARGE_KEYS; i += 2) {
+    nr_hashmap_index_delete(hashmap, i * 7919);
+  }
+  nr_hashmap_destroy(&hashmap);
+  large_duration = nr_time_duration(start, nr_get_time());
+
+  tlib_pass_if_uint64_t_equal(
+      "every lookup succeeds",
+      NR_BENCH_SMALL_MAPS * NR_BENCH_SMALL_KEYS * 4 + NR_BENCH_LARGE_KEYS * 4,
+      found);
+
+  printf(
+      "hashmap: %d maps of %d string keys: %.3fms; %d integer keys: %.3fms\n",
+      NR_BENCH_SMALL_MAPS, NR_BENCH_SMALL_KEYS,
+      (double)small_duration / NR_TIME_DIVISOR_MS_D, NR_BENCH_LARGE_KEYS,
+      (double)large_duration / NR_TIME_DIVISOR_MS_D);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_hashmap();
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times finalising the segment tree of large transactions.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_distributed_trace.h"
+#include "nr_segment_traces.h"
+#include "nr_segment_tree.h"
+#include "nr_segment_private.h"
+#include "nr_txn_private.h"
+#include "util_metrics.h"
+#include "util_slab.h"
+#include "util_string_pool.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+/*
+ * Builds a transaction with the given number of segments below the root, in
+ * groups of eight: a parent segment directly below the root, followed by seven
+ * children of varying duration. The transaction is then finalised with the
+ * default trace and span event limits, and the time taken is printed.
+ */
+#define NR_BENCH_SEGMENT_LIMIT 2000
+static void bench_finalise_size(size_t count) {
+  nrtxn_t txn = {0};
+  nr_segment_t* root;
+  nr_segment_t* parent = NULL;
+  nrtxnfinal_t result;
+  nrtime_t start;
+  nrtime_t duration;
+  uint32_t state = 1;
+  size_t expected_spans;
+  size_t i;
+
+  txn.abs_start_time = 1000;
+  txn.distributed_trace = nr_distributed_trace_create();
+  nr_distributed_trace_set_sampled(txn.distributed_trace, true);
+  txn.options.distributed_tracing_enabled = true;
+  txn.options.span_events_enabled = true;
+  txn.app_limits.span_events = NR_BENCH_SEGMENT_LIMIT;
+
+  txn.segment_slab = nr_slab_create(sizeof(nr_segment_t), 0);
+  txn.trace_strings = nr_string_pool_create();
+  txn.scoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+  txn.unscoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+
+  root = nr_slab_next(txn.segment_slab);
+  root->txn = &txn;
+  root->start_time = 0;
+  root->stop_time = (count + 8) * 10;
+  root->name = nr_string_add(txn.trace_strings, "OtherTransaction/php__FILE__");
+  nr_segment_children_init(&root->children);
+  nr_segment_set_priority_flag(root, NR_SEGMENT_PRIORITY_ROOT);
+  txn.segment_root = root;
+
+  for (i = 0; i < count; i++) {
+    nr_segment_t* segment = nr_slab_next(txn.segment_slab);
+
+    segment->txn = &txn;
+    segment->start_time = i * 10 + 1;
+
+    if (0 == i % 8) {
+      segment->stop_time = (i + 8) * 10;
+      segment->name = nr_string_add(txn.trace_strings, "Custom/parent");
+      nr_segment_children_init(&segment->children);
+      nr_segment_add_child(root, segment);
+      parent = segment;
+    } else {
+      state = state * 1103515245 + 12345;
+      segment->stop_time = segment->start_time + 1 + (state >> 16) % 8;
+      segment->name = nr_string_add(txn.trace_strings, "Custom/child");
+      nr_segment_add_child(parent, segment);
+    }
+  }
+
+  txn.segment_count = count + 1;
+
+  start = nr_get_time();
+  result = nr_segment_tree_finalise(&txn, NR_BENCH_SEGMENT_LIMIT,
+                                    NR_BENCH_SEGMENT_LIMIT, NULL, NULL);
+  duration = nr_time_duration(start, nr_get_time());
+
+  expected_spans = count + 1;
+  if (expected_spans > NR_BENCH_SEGMENT_LIMIT) {
+    expected_spans = NR_BENCH_SEGMENT_LIMIT;
+  }
+
+  tlib_pass_if_not_null("benchmark trace", result.trace_json);
+  tlib_pass_if_size_t_equal("benchmark span events", expected_spans,
+                            nr_vector_size(result.span_events));
+  tlib_pass_if_time_equal("benchmark total time", root->stop_time,
+                          result.total_time);
+
+  printf("segment tree finalise: %zu segments in %.3fms\n", count + 1,
+         (double)duration / NR_TIME_DIVISOR_MS_D);
+
+  nr_txn_final_destroy_fields(&result);
+  nr_txn_destroy_fields(&txn);
+}
+
+static void bench_finalise(void) {
+  bench_finalise_size(1000);
+  bench_finalise_size(10000);
+  bench_finalise_size(100000);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_finalise();
+}
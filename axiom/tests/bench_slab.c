@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times the segment slab of consecutive transactions in a worker process,
+ * with and without the page cache: each transaction is created at RINIT,
+ * filled with segments, and destroyed at RSHUTDOWN.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "util_slab.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_TXNS 200
+#define NR_BENCH_SEGMENTS 5000
+#define NR_BENCH_SEGMENT_SIZE 256
+
+static nrtime_t bench_txns(void) {
+  nrtime_t start = nr_get_time();
+  int txn;
+  int i;
+
+  for (txn = 0; txn < NR_BENCH_TXNS; txn++) {
+    nr_slab_t* slab
+        = nr_slab_create(NR_BENCH_SEGMENT_SIZE, NR_BENCH_SEGMENT_SIZE * 100);
+
+    for (i = 0; i < NR_BENCH_SEGMENTS; i++) {
+      char* segment = (char*)nr_slab_next(slab);
+
+      segment[0] = 1;
+      segment[NR_BENCH_SEGMENT_SIZE - 1] = 1;
+    }
+    nr_slab_destroy(&slab);
+  }
+
+  return nr_time_duration(start, nr_get_time());
+}
+
+static void bench_page_cache(void) {
+  nrtime_t cached;
+  nrtime_t uncached;
+
+  nr_slab_page_cache_set_limit(0);
+  uncached = bench_txns();
+
+  nr_slab_page_cache_set_limit(NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT);
+  cached = bench_txns();
+  nr_slab_page_cache_clear();
+
+  printf(
+      "slab: %d transactions of %d segments: %.3fms without the page cache, "
+      "%.3fms with it\n",
+      NR_BENCH_TXNS, NR_BENCH_SEGMENTS, (double)uncached / NR_TIME_DIVISOR_MS_D,
+      (double)cached / NR_TIME_DIVISOR_MS_D);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_page_cache();
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times encoding batches of spans with 20 attributes each, as the span queue
+ * does, comparing a new context for each batch with a reused context.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_span_encoding.h"
+#include "nr_span_event.h"
+#include "nr_span_event_private.h"
+#include "util_memory.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+static nr_span_event_t* bench_span_create(void) {
+  nr_span_event_t* span = nr_span_event_create();
+  char key[32];
+  int i;
+
+  nr_span_event_set_trace_id(span, "0123456789abcdef");
+  for (i = 0; i < 8; i++) {
+    snprintf(key, sizeof(key), "intrinsic.%d", i);
+    nro_set_hash_string(span->intrinsics, key, "value");
+  }
+  for (i = 0; i < 8; i++) {
+    snprintf(key, sizeof(key), "agent.%d", i);
+    nro_set_hash_long(span->agent_attributes, key, i);
+  }
+  for (i = 0; i < 4; i++) {
+    snprintf(key, sizeof(key), "user.%d", i);
+    nro_set_hash_double(span->user_attributes, key, 1.5);
+  }
+
+  return span;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+static void bench_batches(size_t span_count, int batch_count) {
+  nr_span_encoding_context_t* ctx = nr_span_encoding_context_create();
+  nr_span_event_t** spans = nr_calloc(span_count, sizeof(nr_span_event_t*));
+  nrtime_t fresh;
+  nrtime_t reused;
+  nrtime_t start;
+  size_t i;
+  int n;
+
+  for (i = 0; i < span_count; i++) {
+    spans[i] = bench_span_create();
+  }
+
+  start = nr_get_time();
+  for (n = 0; n < batch_count; n++) {
+    nr_span_encoding_result_t result = NR_SPAN_ENCODING_RESULT_INIT;
+
+    nr_span_encoding_batch_v1((const nr_span_event_t**)spans, span_count,
+                              &result);
+    nr_span_encoding_result_deinit(&result);
+  }
+  fresh = nr_time_duration(start, nr_get_time());
+
+  start = nr_get_time();
+  for (n = 0; n < batch_count; n++) {
+    nr_span_encoding_result_t result = NR_SPAN_ENCODING_RESULT_INIT;
+
+    nr_span_encoding_batch_with_context_v1(
+        ctx, (const nr_span_event_t**)spans, span_count, &result);
+    nr_span_encoding_result_deinit(&result);
+  }
+  reused = nr_time_duration(start, nr_get_time());
+
+  printf(
+      "span encoding: %zu spans: %.1fus per batch with a new context, %.1fus "
+      "with a reused context\n",
+      span_count, (double)fresh / batch_count, (double)reused / batch_count);
+
+  for (i = 0; i < span_count; i++) {
+    nr_span_event_destroy(&spans[i]);
+  }
+  nr_free(spans);
+  nr_span_encoding_context_destroy(&ctx);
+}
+#pragma GCC diagnostic pop
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_batches(100, 200);
+  bench_batches(1000, 20);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Times how long a request is held up by finalising a large transaction
+ * inline, and by handing it to the transaction finaliser.
+ */
+#include "nr_axiom.h"
+
+#include <stdio.h>
+
+#include "nr_limits.h"
+#include "nr_segment_private.h"
+#include "nr_segment_traces.h"
+#include "nr_segment_tree.h"
+#include "nr_txn_finaliser.h"
+#include "util_memory.h"
+#include "util_metrics.h"
+#include "util_slab.h"
+#include "util_string_pool.h"
+#include "util_time.h"
+
+#include "tlib_main.h"
+
+#define NR_BENCH_FINALISER_SEGMENTS 20000
+
+static void bench_finalise(nrtxn_t* txn, void* userdata NRUNUSED) {
+  nrtxnfinal_t result = nr_segment_tree_finalise(txn, NR_MAX_SEGMENTS,
+                                                 NR_MAX_SEGMENTS, NULL, NULL);
+
+  nr_txn_final_destroy_fields(&result);
+}
+
+static nrtxn_t* bench_txn_create(void) {
+  nrtxn_t* txn = (nrtxn_t*)nr_zalloc(sizeof(nrtxn_t));
+  nr_segment_t* root;
+  size_t i;
+
+  txn->abs_start_time = 1000;
+  txn->options.tt_enabled = true;
+  txn->segment_slab = nr_slab_create(sizeof(nr_segment_t), 0);
+  txn->trace_strings = nr_string_pool_create();
+  txn->scoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+  txn->unscoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+
+  root = nr_slab_next(txn->segment_slab);
+  root->txn = txn;
+  root->start_time = 0;
+  root->stop_time = NR_BENCH_FINALISER_SEGMENTS * 10;
+  root->name = nr_string_add(txn->trace_strings, "WebTransaction/Uri/bench");
+  nr_segment_children_init(&root->children);
+  txn->segment_root = root;
+
+  for (i = 0; i < NR_BENCH_FINALISER_SEGMENTS; i++) {
+    nr_segment_t* segment = nr_slab_next(txn->segment_slab);
+
+    segment->txn = txn;
+    segment->start_time = i * 10 + 1;
+    segment->stop_time = i * 10 + 9;
+    segment->name = nr_string_add(txn->trace_strings, "Custom/child");
+    nr_segment_add_child(root, segment);
+  }
+  txn->segment_count = NR_BENCH_FINALISER_SEGMENTS + 1;
+
+  return txn;
+}
+
+static void bench_submit(void) {
+  nr_txn_finaliser_t* finaliser;
+  nrtxn_t* txn;
+  nrtime_t deferred;
+  nrtime_t inline_duration;
+  nrtime_t start;
+
+  txn = bench_txn_create();
+  start = nr_get_time();
+  bench_finalise(txn, NULL);
+  nr_txn_destroy(&txn);
+  inline_duration = nr_time_duration(start, nr_get_time());
+
+  finaliser = nr_txn_finaliser_create(4, bench_finalise, NULL);
+  txn = bench_txn_create();
+  start = nr_get_time();
+  tlib_pass_if_bool_equal("benchmark submit", true,
+                          nr_txn_finaliser_submit(finaliser, &txn));
+  deferred = nr_time_duration(start, nr_get_time());
+  nr_txn_finaliser_destroy(&finaliser);
+
+  printf("txn finaliser: request held for %.3fms inline, %.3fms deferred\n",
+         (double)inline_duration / NR_TIME_DIVISOR_MS_D,
+         (double)deferred / NR_TIME_DIVISOR_MS_D);
+}
+
+/*
+ * Benchmarks are timed, so they are run one at a time.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  bench_submit();
+}
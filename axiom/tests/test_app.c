@@ -18,6 +18,8 @@
 #include "util_reply.h"
 #include "util_strings.h"
 #include "util_system.h"
+#include "util_threads.h"
+#include "util_time.h"
 
 #include "tlib_main.h"
 
@@ -819,6 +821,107 @@ static void test_verify_id(void) {
   nr_app_info_destroy_fields(&info);
 }
 
+#define STRESS_THREADS 8
+#define STRESS_APPS 16
+#define STRESS_ITERATIONS 20000
+
+typedef struct _stress_thread_t {
+  nrapplist_t* applist;
+  int thread_id;
+  int lookups;
+  int failures;
+} stress_thread_t;
+
+static void stress_app_info(nr_app_info_t* info,
+                            char* license,
+                            nrobj_t* environment,
+                            int n) {
+  nr_memset(info, 0, sizeof(*info));
+  snprintf(license, NR_LICENSE_SIZE + 1,
+           "12345%05d000000000000000000000000006789", n);
+  info->license = license;
+  info->appname = "stress-app";
+  info->version = "my_version";
+  info->lang = "my_language";
+  info->environment = environment;
+  info->redirect_collector = "collector.newrelic.com";
+}
+
+/*
+ * Simulates the app handling done by a ZTS worker thread at transaction start:
+ * find the app, then verify its agent run ID. Half of the lookups go to a
+ * single hot app shared by all threads.
+ */
+static void* stress_thread(void* arg) {
+  stress_thread_t* st = (stress_thread_t*)arg;
+  nr_app_info_t info;
+  char license[NR_LICENSE_SIZE + 1];
+  nrobj_t* environment = nro_create_from_json("[\"my_environment\"]");
+  int i;
+
+  for (i = 0; i < STRESS_ITERATIONS; i++) {
+    int n = (i & 1) ? 0 : ((st->thread_id + i) % STRESS_APPS);
+    char run_id[32];
+    nrapp_t* app;
+
+    stress_app_info(&info, license, environment, n);
+    app = nr_app_find_or_add_app(st->applist, &info);
+    if (NULL == app) {
+      st->failures++;
+      continue;
+    }
+    if (NR_APP_OK != app->state) {
+      app->agent_run_id = nr_formatf("run%d", n);
+      app->state = NR_APP_OK;
+    }
+    nrt_mutex_unlock(&app->app_lock);
+
+    snprintf(run_id, sizeof(run_id), "run%d", n);
+    app = nr_app_verify_id(st->applist, run_id);
+    if (NULL == app) {
+      st->failures++;
+      continue;
+    }
+    nrt_mutex_unlock(&app->app_lock);
+
+    st->lookups++;
+  }
+
+  nro_delete(environment);
+  return NULL;
+}
+
+static void test_applist_stress(void) {
+  nrapplist_t* applist = nr_applist_create();
+  nrthread_t threads[STRESS_THREADS];
+  stress_thread_t states[STRESS_THREADS];
+  int lookups = 0;
+  int i;
+
+  for (i = 0; i < STRESS_THREADS; i++) {
+    states[i].applist = applist;
+    states[i].thread_id = i;
+    states[i].lookups = 0;
+    states[i].failures = 0;
+    tlib_pass_if_status_success(
+        "stress thread create",
+        nrt_create(&threads[i], NULL, stress_thread, &states[i]));
+  }
+
+  for (i = 0; i < STRESS_THREADS; i++) {
+    nrt_join(threads[i], NULL);
+    tlib_pass_if_int_equal("stress thread failures", 0, states[i].failures);
+    lookups += states[i].lookups;
+  }
+
+  tlib_pass_if_int_equal("stress lookups", STRESS_THREADS * STRESS_ITERATIONS,
+                         lookups);
+  tlib_pass_if_int_equal("stress apps are unique", STRESS_APPS,
+                         applist->num_apps);
+
+  nr_applist_destroy(&applist);
+}
+
 static void test_app_consider_appinfo(void) {
   nrapp_t app;
   time_t now = time(0);
@@ -1032,6 +1135,7 @@ void test_main(void* p NRUNUSED) {
   test_agent_should_do_app_daemon_query();
   test_agent_find_or_add_app();
   test_verify_id();
+  test_applist_stress();
   test_app_consider_appinfo();
   test_app_consider_appinfo_failure();
   test_get_primary_app_name();
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "util_arena.h"
+
+#include "tlib_main.h"
+
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
+
+static bool is_aligned(const void* ptr) {
+  return 0 == ((uintptr_t)ptr & 15);
+}
+
+static void test_bad_parameters(void) {
+  nr_arena_t* arena = NULL;
+
+  nr_arena_destroy(NULL);
+  nr_arena_destroy(&arena);
+  nr_arena_reset(NULL);
+  nr_arena_trim(NULL, 0);
+
+  tlib_pass_if_null("NULL alloc", nr_arena_alloc(NULL, 16));
+  tlib_pass_if_null("NULL alloc array", nr_arena_alloc_array(NULL, 2, 16));
+  tlib_pass_if_size_t_equal("NULL capacity", 0, nr_arena_capacity(NULL));
+
+  arena = nr_arena_create(0);
+  tlib_pass_if_null("alloc overflow", nr_arena_alloc(arena, SIZE_MAX));
+  tlib_pass_if_null("alloc array overflow",
+                    nr_arena_alloc_array(arena, SIZE_MAX / 2, 4));
+  nr_arena_destroy(&arena);
+  tlib_pass_if_null("destroy", arena);
+}
+
+static void test_alloc(void) {
+  nr_arena_t* arena = nr_arena_create(256);
+  char* a;
+  char* b;
+  char* c;
+
+  tlib_pass_if_size_t_equal("initial capacity", 256,
+                            nr_arena_capacity(arena));
+
+  /*
+   * Test : Allocations are aligned, and don't overlap.
+   */
+  a = (char*)nr_arena_alloc(arena, 1);
+  b = (char*)nr_arena_alloc(arena, 17);
+  c = (char*)nr_arena_alloc(arena, 0);
+  tlib_pass_if_not_null("alloc", a);
+  tlib_pass_if_bool_equal("aligned", true, is_aligned(a));
+  tlib_pass_if_bool_equal("aligned", true, is_aligned(b));
+  tlib_pass_if_bool_equal("aligned", true, is_aligned(c));
+  tlib_pass_if_ptr_equal("one byte takes one aligned unit", a + 16, b);
+  tlib_pass_if_ptr_equal("17 bytes take two aligned units", b + 32, c);
+
+  /*
+   * Test : Filling the page adds another.
+   */
+  nr_arena_alloc(arena, 200);
+  tlib_pass_if_size_t_equal("new page", 512, nr_arena_capacity(arena));
+
+  /*
+   * Test : A large allocation gets a page of its own.
+   */
+  a = (char*)nr_arena_alloc(arena, 1000);
+  memset(a, 'x', 1000);
+  tlib_pass_if_size_t_equal("large page", 1520, nr_arena_capacity(arena));
+
+  nr_arena_destroy(&arena);
+}
+
+static void test_alloc_array(void) {
+  nr_arena_t* arena = nr_arena_create(0);
+  uint64_t* values;
+  size_t i;
+
+  values = (uint64_t*)nr_arena_alloc_array(arena, 100, sizeof(uint64_t));
+  tlib_pass_if_not_null("alloc array", values);
+  for (i = 0; i < 100; i++) {
+    values[i] = i;
+  }
+  for (i = 0; i < 100; i++) {
+    tlib_pass_if_uint64_t_equal("array value", i, values[i]);
+  }
+
+  nr_arena_destroy(&arena);
+}
+
+static void test_reset(void) {
+  nr_arena_t* arena = nr_arena_create(256);
+  void* first;
+  size_t capacity;
+  size_t i;
+
+  first = nr_arena_alloc(arena, 16);
+  for (i = 0; i < 100; i++) {
+    nr_arena_alloc(arena, 48);
+  }
+  nr_arena_alloc(arena, 4096);
+  capacity = nr_arena_capacity(arena);
+
+  /*
+   * Test : Resetting the arena reuses its memory, without growing it for the
+   *        same allocations.
+   */
+  nr_arena_reset(arena);
+  tlib_pass_if_ptr_equal("first allocation is reused", first,
+                         nr_arena_alloc(arena, 16));
+  for (i = 0; i < 100; i++) {
+    nr_arena_alloc(arena, 48);
+  }
+  nr_arena_alloc(arena, 4096);
+  tlib_pass_if_size_t_equal("capacity is kept", capacity,
+                            nr_arena_capacity(arena));
+
+  nr_arena_destroy(&arena);
+}
+
+static void test_trim(void) {
+  nr_arena_t* arena = nr_arena_create(256);
+  void* first;
+  size_t i;
+
+  first = nr_arena_alloc(arena, 16);
+  for (i = 0; i < 100; i++) {
+    nr_arena_alloc(arena, 48);
+  }
+  nr_arena_alloc(arena, 4096);
+
+  /*
+   * Test : Trimming the arena frees the pages beyond the limit, keeping the
+   *        pages that fit within it.
+   */
+  nr_arena_trim(arena, 1024);
+  tlib_pass_if_size_t_equal("trimmed capacity", 1024,
+                            nr_arena_capacity(arena));
+  tlib_pass_if_ptr_equal("first page is kept", first,
+                         nr_arena_alloc(arena, 16));
+
+  /*
+   * Test : The trimmed arena grows again as needed.
+   */
+  for (i = 0; i < 100; i++) {
+    tlib_pass_if_not_null("alloc after trim", nr_arena_alloc(arena, 48));
+  }
+  tlib_pass_if_true("capacity grows", nr_arena_capacity(arena) > 1024,
+                    "capacity=%zu", nr_arena_capacity(arena));
+
+  /*
+   * Test : Trimming below the first page keeps the first page.
+   */
+  nr_arena_trim(arena, 0);
+  tlib_pass_if_size_t_equal("first page only", 256, nr_arena_capacity(arena));
+  tlib_pass_if_ptr_equal("first page is reused", first,
+                         nr_arena_alloc(arena, 16));
+
+  nr_arena_destroy(&arena);
+}
+
+void test_main(void* p NRUNUSED) {
+  test_bad_parameters();
+  test_alloc();
+  test_alloc_array();
+  test_reset();
+  test_trim();
+}
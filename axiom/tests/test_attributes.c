@@ -14,6 +14,7 @@
 #include "util_hash.h"
 #include "util_memory.h"
 #include "util_object.h"
+#include "util_random.h"
 #include "util_reply.h"
 #include "util_strings.h"
 #include "util_text.h"
@@ -1192,6 +1193,208 @@ static void test_remove_attribute(void) {
   nr_attributes_destroy(&atts);
 }
 
+/*
+ * The property tests build random configurations and keys from a small
+ * alphabet, so that matches, prefixes and shared trie paths are common.
+ */
+#define TEST_FILTER_CONFIGS 200
+#define TEST_FILTER_KEYS 200
+#define TEST_FILTER_MAX_MODIFIERS 12
+#define TEST_FILTER_MAX_LEN 5
+
+static void random_string(nr_random_t* rnd, char* buf, size_t max_len) {
+  static const char alphabet[] = "ab.";
+  size_t len = nr_random_range(rnd, max_len + 1);
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    buf[i] = alphabet[nr_random_range(rnd, sizeof(alphabet) - 1)];
+  }
+  buf[len] = '\0';
+}
+
+static uint32_t random_destinations(nr_random_t* rnd) {
+  return (uint32_t)nr_random_range(rnd, NR_ATTRIBUTE_DESTINATION_ALL + 1);
+}
+
+static nr_attribute_config_t* random_config(nr_random_t* rnd) {
+  nr_attribute_config_t* config = nr_attribute_config_create();
+  unsigned long num_modifiers
+      = nr_random_range(rnd, TEST_FILTER_MAX_MODIFIERS + 1);
+  unsigned long i;
+
+  nr_attribute_config_disable_destinations(
+      config, random_destinations(rnd) & random_destinations(rnd));
+
+  for (i = 0; i < num_modifiers; i++) {
+    char match[TEST_FILTER_MAX_LEN + 2];
+    uint32_t include = 0;
+    uint32_t exclude = 0;
+
+    random_string(rnd, match, TEST_FILTER_MAX_LEN);
+    if ('\0' == match[0] || nr_random_range(rnd, 2)) {
+      nr_strcat(match, "*");
+    }
+
+    /*
+     * Most modifiers either include or exclude, as configured by users, but
+     * conflicting modifiers must work too.
+     */
+    switch (nr_random_range(rnd, 3)) {
+      case 0:
+        include = random_destinations(rnd);
+        break;
+      case 1:
+        exclude = random_destinations(rnd);
+        break;
+      default:
+        include = random_destinations(rnd);
+        exclude = random_destinations(rnd);
+        break;
+    }
+
+    nr_attribute_config_modify_destinations(config, match, include, exclude);
+  }
+
+  return config;
+}
+
+static void test_filter_equivalence(void) {
+  nr_random_t* rnd = nr_random_create_from_seed(345345);
+  char long_key[NR_ATTRIBUTE_FILTER_MEMO_KEY_SIZE + 8];
+  int mismatches = 0;
+  int i;
+
+  nr_memset(long_key, 'a', sizeof(long_key) - 1);
+  long_key[sizeof(long_key) - 1] = '\0';
+
+  /*
+   * Test : For random configurations and keys, the compiled filter gives the
+   *        same destinations as matching the key against every modifier in
+   *        turn. Each key is tried twice, so that memoised decisions are
+   *        checked too.
+   */
+  for (i = 0; i < TEST_FILTER_CONFIGS; i++) {
+    nr_attribute_config_t* config = random_config(rnd);
+    nr_attribute_config_t* compiled = nr_attribute_config_copy(config);
+    int j;
+
+    tlib_pass_if_not_null("compiled", compiled->filter);
+
+    for (j = 0; j < TEST_FILTER_KEYS * 2; j++) {
+      char key[TEST_FILTER_MAX_LEN * 2 + 1];
+      const char* k = key;
+      uint32_t destinations = random_destinations(rnd);
+      uint32_t expected;
+      uint32_t actual;
+
+      if (j >= TEST_FILTER_KEYS) {
+        k = long_key;
+      }
+      random_string(rnd, key, TEST_FILTER_MAX_LEN * 2);
+
+      expected = nr_attribute_config_apply_list(config, k, nr_mkhash(k, 0),
+                                                destinations);
+      actual = nr_attribute_config_apply(compiled, k, nr_mkhash(k, 0),
+                                         destinations);
+      if (expected != actual) {
+        mismatches += 1;
+        tlib_pass_if_uint32_t_equal(k, expected, actual);
+      }
+
+      actual = nr_attribute_config_apply(compiled, k, nr_mkhash(k, 0),
+                                         destinations);
+      if (expected != actual) {
+        mismatches += 1;
+        tlib_pass_if_uint32_t_equal(k, expected, actual);
+      }
+    }
+
+    nr_attribute_config_destroy(&config);
+    nr_attribute_config_destroy(&compiled);
+  }
+
+  tlib_pass_if_int_equal("compiled filters match the modifier list", 0,
+                         mismatches);
+  nr_random_destroy(&rnd);
+}
+
+static void test_filter_sharing(void) {
+  nr_attribute_config_t* first = nr_attribute_config_create();
+  nr_attribute_config_t* second = nr_attribute_config_create();
+  nr_attribute_config_t* first_copy;
+  nr_attribute_config_t* second_copy;
+  nr_attribute_config_t* copy_of_copy;
+  uint32_t event = NR_ATTRIBUTE_DESTINATION_TXN_EVENT;
+  uint32_t error = NR_ATTRIBUTE_DESTINATION_ERROR;
+  uint32_t slot;
+
+  /*
+   * Test : Copies of identical configurations share a filter, so that the
+   *        configuration built for each request reuses it.
+   */
+  nr_attribute_config_modify_destinations(first, "sharing.*", 0, event);
+  nr_attribute_config_modify_destinations(first, "sharing.kept", event, 0);
+  nr_attribute_config_modify_destinations(second, "sharing.kept", event, 0);
+  nr_attribute_config_modify_destinations(second, "sharing.*", 0, event);
+
+  tlib_pass_if_null("uncompiled", first->filter);
+  first_copy = nr_attribute_config_copy(first);
+  second_copy = nr_attribute_config_copy(second);
+  copy_of_copy = nr_attribute_config_copy(first_copy);
+  tlib_pass_if_ptr_equal("identical configurations", first_copy->filter,
+                         second_copy->filter);
+  tlib_pass_if_ptr_equal("copy of a copy", first_copy->filter,
+                         copy_of_copy->filter);
+
+  /*
+   * Test : Modifying a copy discards its filter, and the copy falls back to
+   *        the modifier list.
+   */
+  nr_attribute_config_modify_destinations(second_copy, "sharing.kept", error,
+                                          0);
+  tlib_pass_if_null("modified", second_copy->filter);
+  tlib_pass_if_uint32_t_equal(
+      "modified copy", event | error,
+      nr_attribute_config_apply(second_copy, "sharing.kept",
+                                nr_mkhash("sharing.kept", 0), 0));
+  tlib_pass_if_uint32_t_equal(
+      "shared filter", event,
+      nr_attribute_config_apply(first_copy, "sharing.kept",
+                                nr_mkhash("sharing.kept", 0), 0));
+
+  /*
+   * Test : The decision is memoised in the filter, and the memo is shared
+   *        with the other copies.
+   */
+  slot = nr_mkhash("sharing.kept", 0) % NR_ATTRIBUTE_FILTER_MEMO_SIZE;
+  tlib_pass_if_not_null("memoised", first_copy->filter->memo[slot]);
+  tlib_pass_if_uint32_t_equal(
+      "memoised decision", event,
+      nr_attribute_config_apply(copy_of_copy, "sharing.kept",
+                                nr_mkhash("sharing.kept", 0), 0));
+
+  /*
+   * Test : A filter outlives the cache while it's in use.
+   */
+  nr_attribute_filter_cache_clear();
+  tlib_pass_if_uint32_t_equal(
+      "after clear", 0,
+      nr_attribute_config_apply(copy_of_copy, "sharing.other",
+                                nr_mkhash("sharing.other", 0), event));
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_attribute_filter_release(NULL);
+
+  nr_attribute_config_destroy(&first);
+  nr_attribute_config_destroy(&second);
+  nr_attribute_config_destroy(&first_copy);
+  nr_attribute_config_destroy(&second_copy);
+  nr_attribute_config_destroy(&copy_of_copy);
+}
+
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
 
 void test_main(void* p NRUNUSED) {
@@ -1220,4 +1423,7 @@ void test_main(void* p NRUNUSED) {
   test_remove_attribute();
 
   test_cross_agent_attribute_configuration();
+
+  test_filter_equivalence();
+  test_filter_sharing();
 }
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include "util_bitset.h"
+
+#include "tlib_main.h"
+
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
+
+static void test_bad_parameters(void) {
+  nr_bitset_t* bitset = NULL;
+
+  nr_bitset_destroy(NULL);
+  nr_bitset_destroy(&bitset);
+
+  tlib_pass_if_bool_equal("NULL contains", false, nr_bitset_contains(NULL, 0));
+  tlib_pass_if_bool_equal("NULL set", false, nr_bitset_set(NULL, 0));
+  tlib_pass_if_size_t_equal("NULL count", 0, nr_bitset_count(NULL));
+
+  nr_bitset_clear(NULL, 0);
+  nr_bitset_reset(NULL);
+}
+
+static void test_create_destroy(void) {
+  nr_bitset_t* bitset;
+
+  /*
+   * Test : Destroying an empty bitset.
+   */
+  bitset = nr_bitset_create(10);
+  tlib_pass_if_not_null("create", bitset);
+  tlib_pass_if_size_t_equal("empty count", 0, nr_bitset_count(bitset));
+  nr_bitset_destroy(&bitset);
+  tlib_pass_if_null("destroy", bitset);
+
+  /*
+   * Test : Destroying a non-empty bitset.
+   */
+  bitset = nr_bitset_create(10);
+  nr_bitset_set(bitset, 1);
+  nr_bitset_destroy(&bitset);
+
+  /*
+   * Test : A bitset with no possible members.
+   */
+  bitset = nr_bitset_create(0);
+  tlib_pass_if_not_null("create", bitset);
+  tlib_pass_if_bool_equal("zero size set", false, nr_bitset_set(bitset, 0));
+  tlib_pass_if_bool_equal("zero size contains", false,
+                          nr_bitset_contains(bitset, 0));
+  nr_bitset_reset(bitset);
+  tlib_pass_if_size_t_equal("zero size count", 0, nr_bitset_count(bitset));
+  nr_bitset_destroy(&bitset);
+}
+
+static void test_set_clear(void) {
+  nr_bitset_t* bitset = nr_bitset_create(130);
+
+  /*
+   * Test : Members on either side of the word boundaries.
+   */
+  tlib_pass_if_bool_equal("set 0", true, nr_bitset_set(bitset, 0));
+  tlib_pass_if_bool_equal("set 63", true, nr_bitset_set(bitset, 63));
+  tlib_pass_if_bool_equal("set 64", true, nr_bitset_set(bitset, 64));
+  tlib_pass_if_bool_equal("set 129", true, nr_bitset_set(bitset, 129));
+  tlib_pass_if_size_t_equal("count", 4, nr_bitset_count(bitset));
+
+  tlib_pass_if_bool_equal("contains 0", true, nr_bitset_contains(bitset, 0));
+  tlib_pass_if_bool_equal("contains 1", false, nr_bitset_contains(bitset, 1));
+  tlib_pass_if_bool_equal("contains 62", false,
+                          nr_bitset_contains(bitset, 62));
+  tlib_pass_if_bool_equal("contains 63", true, nr_bitset_contains(bitset, 63));
+  tlib_pass_if_bool_equal("contains 64", true, nr_bitset_contains(bitset, 64));
+  tlib_pass_if_bool_equal("contains 65", false,
+                          nr_bitset_contains(bitset, 65));
+  tlib_pass_if_bool_equal("contains 129", true,
+                          nr_bitset_contains(bitset, 129));
+
+  /*
+   * Test : Setting a member twice doesn't change the count.
+   */
+  tlib_pass_if_bool_equal("set 63 again", true, nr_bitset_set(bitset, 63));
+  tlib_pass_if_size_t_equal("count", 4, nr_bitset_count(bitset));
+
+  /*
+   * Test : Out of range members are rejected.
+   */
+  tlib_pass_if_bool_equal("set 130", false, nr_bitset_set(bitset, 130));
+  tlib_pass_if_bool_equal("contains 130", false,
+                          nr_bitset_contains(bitset, 130));
+  nr_bitset_clear(bitset, 130);
+  tlib_pass_if_size_t_equal("count", 4, nr_bitset_count(bitset));
+
+  /*
+   * Test : Clearing members.
+   */
+  nr_bitset_clear(bitset, 63);
+  tlib_pass_if_bool_equal("cleared 63", false,
+                          nr_bitset_contains(bitset, 63));
+  tlib_pass_if_bool_equal("kept 64", true, nr_bitset_contains(bitset, 64));
+  tlib_pass_if_size_t_equal("count", 3, nr_bitset_count(bitset));
+
+  nr_bitset_clear(bitset, 63);
+  tlib_pass_if_size_t_equal("clear twice", 3, nr_bitset_count(bitset));
+
+  /*
+   * Test : Resetting the bitset.
+   */
+  nr_bitset_reset(bitset);
+  tlib_pass_if_size_t_equal("reset count", 0, nr_bitset_count(bitset));
+  tlib_pass_if_bool_equal("reset 0", false, nr_bitset_contains(bitset, 0));
+  tlib_pass_if_bool_equal("reset 129", false,
+                          nr_bitset_contains(bitset, 129));
+
+  nr_bitset_destroy(&bitset);
+}
+
+#define BITSET_SIZE 100000
+static void test_bitset(void) {
+  size_t i;
+  nr_bitset_t* bitset = nr_bitset_create(BITSET_SIZE);
+
+  /* Insert every third value. */
+  for (i = 0; i < BITSET_SIZE; i += 3) {
+    nr_bitset_set(bitset, i);
+  }
+
+  /* Insert the same values again. */
+  for (i = 0; i < BITSET_SIZE; i += 3) {
+    nr_bitset_set(bitset, i);
+  }
+
+  /* Verify that the duplicate values weren't counted. */
+  tlib_pass_if_size_t_equal("bitset count", (BITSET_SIZE + 2) / 3,
+                            nr_bitset_count(bitset));
+
+  /* Test that exactly the expected values exist. */
+  for (i = 0; i < BITSET_SIZE; i++) {
+    bool expected = (0 == (i % 3));
+
+    tlib_pass_if_bool_equal("exists", expected, nr_bitset_contains(bitset, i));
+  }
+
+  nr_bitset_destroy(&bitset);
+}
+
+void test_main(void* p NRUNUSED) {
+  test_bad_parameters();
+  test_create_destroy();
+  test_set_clear();
+  test_bitset();
+}
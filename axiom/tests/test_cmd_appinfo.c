@@ -616,6 +616,7 @@ static void test_process_connected_app(void) {
   nr_status_t st;
   nr_flatbuffer_t* reply;
   const char* connect_json;
+  nr_app_connect_state_t* connect_state;
 
   nr_memset(&app, 0, sizeof(app));
   app.state = NR_APP_UNKNOWN;
@@ -681,6 +682,17 @@ static void test_process_connected_app(void) {
                          app.limits.span_events);
   tlib_pass_if_int_equal(__func__, 0, app.limits.log_events);
 
+  /*
+   * The connect state shared with transactions is published.
+   */
+  tlib_pass_if_not_null(__func__, app.connect_state);
+  tlib_pass_if_str_equal(__func__, "346595271037263",
+                         app.connect_state->agent_run_id);
+  tlib_pass_if_not_null(__func__, app.connect_state->connect_reply);
+  tlib_pass_if_int_equal(__func__, 833,
+                         app.connect_state->limits.analytics_events);
+  connect_state = nr_app_connect_state_ref(app.connect_state);
+
   /*
    * Perform same test again to make sure that populated fields are freed
    * before assignment.
@@ -696,12 +708,25 @@ static void test_process_connected_app(void) {
   tlib_pass_if_not_null(__func__, app.txn_rules);
   tlib_pass_if_not_null(__func__, app.segment_terms);
 
+  /*
+   * Connecting again publishes a new connect state, leaving references to the
+   * previous one valid.
+   */
+  tlib_pass_if_not_null(__func__, app.connect_state);
+  tlib_pass_if_true(__func__, connect_state != app.connect_state,
+                    "connect_state=%p", (void*)connect_state);
+  tlib_pass_if_str_equal(__func__, "346595271037263",
+                         connect_state->agent_run_id);
+  nr_app_connect_state_release(&connect_state);
+  tlib_pass_if_null(__func__, connect_state);
+
   nr_free(app.agent_run_id);
   nr_free(app.entity_guid);
   nro_delete(app.connect_reply);
   nr_rules_destroy(&app.url_rules);
   nr_rules_destroy(&app.txn_rules);
   nr_segment_terms_destroy(&app.segment_terms);
+  nr_app_connect_state_release(&app.connect_state);
   nr_flatbuffers_destroy(&reply);
 }
 
@@ -785,6 +810,7 @@ static void test_process_lasp_connected_app(void) {
   nr_rules_destroy(&app.url_rules);
   nr_rules_destroy(&app.txn_rules);
   nr_segment_terms_destroy(&app.segment_terms);
+  nr_app_connect_state_release(&app.connect_state);
   nr_flatbuffers_destroy(&reply);
 }
 
@@ -876,6 +902,7 @@ static void test_process_harvest_timing_connected_app(void) {
   nr_rules_destroy(&app.url_rules);
   nr_rules_destroy(&app.txn_rules);
   nr_segment_terms_destroy(&app.segment_terms);
+  nr_app_connect_state_release(&app.connect_state);
   nr_flatbuffers_destroy(&reply);
 }
 
@@ -1283,8 +1283,8 @@ static void test_encode_php_packages(void) {
       __func__,
       NR_PSTR("["
               "[\"TEST_PACKAGE_3\",\"7.8.9\",{}],"
-              "[\"TEST_PACKAGE_1\",\"1.2.3\",{}],"
-              "[\"TEST_PACKAGE_2\",\"4.5.6\",{}]"
+              "[\"TEST_PACKAGE_2\",\"4.5.6\",{}],"
+              "[\"TEST_PACKAGE_1\",\"1.2.3\",{}]"
               "]"),
       nr_flatbuffers_table_read_bytes(&tbl, EVENT_FIELD_DATA),
       nr_flatbuffers_table_read_vector_len(&tbl, EVENT_FIELD_DATA), __FILE__,
@@ -1390,6 +1390,209 @@ done:
   nr_close(socks[1]);
 }
 
+static void test_trace_sent_externally(void) {
+  nrtxn_t txn;
+  int socks[2];
+  nrbuf_t* buf = NULL;
+  nr_flatbuffers_table_t tbl;
+  nr_status_t st;
+  const char* trace_json = "[[0,{},{},[0,1,\"ROOT\",{},[]]],[]]";
+
+  nbsockpair(socks);
+  nr_memset(&txn, 0, sizeof(txn));
+  txn.name = nr_strdup("WebTransaction/Uri/external");
+  txn.final_data.trace_json = nr_strdup(trace_json);
+  nr_txn_set_guid(&txn, "0123456789abcdef");
+
+  /*
+   * Test : The trace is written from the transaction after the rest of the
+   *        message, and is received intact.
+   */
+  st = nr_cmd_txndata_tx(socks[0], &txn);
+  if (0 != tlib_pass_if_status_success(__func__, st)) {
+    goto done;
+  }
+
+  buf = nr_network_receive(socks[1], 100 /* msecs */);
+  if (0 != tlib_pass_if_true(__func__, NULL != buf, "buf=%p", buf)) {
+    goto done;
+  }
+
+  nr_flatbuffers_table_init_root(&tbl, (const uint8_t*)nr_buffer_cptr(buf),
+                                 nr_buffer_len(buf));
+  if (0
+      != tlib_pass_if_true(
+          __func__,
+          0 != nr_flatbuffers_table_read_union(&tbl, &tbl, MESSAGE_FIELD_DATA),
+          "transaction data missing")) {
+    goto done;
+  }
+  tlib_pass_if_str_equal(
+      __func__, "WebTransaction/Uri/external",
+      nr_flatbuffers_table_read_str(&tbl, TRANSACTION_FIELD_NAME));
+
+  if (0
+      != tlib_pass_if_true(__func__,
+                           0
+                               != nr_flatbuffers_table_read_union(
+                                   &tbl, &tbl, TRANSACTION_FIELD_TRACE),
+                           "trace missing")) {
+    goto done;
+  }
+  tlib_pass_if_str_equal(__func__, "0123456789abcdef",
+                         nr_flatbuffers_table_read_str(&tbl, TRACE_FIELD_GUID));
+  tlib_pass_if_str_equal(__func__, trace_json,
+                         nr_flatbuffers_table_read_str(&tbl, TRACE_FIELD_DATA));
+
+done:
+  nr_buffer_destroy(&buf);
+  nr_close(socks[0]);
+  nr_close(socks[1]);
+  nr_txn_destroy_fields(&txn);
+}
+
+static void test_size_estimates(void) {
+  nr_txndata_size_estimate_t estimate = {.name = NULL};
+  int i;
+
+  /*
+   * Test : Estimates follow increases immediately.
+   */
+  nr_txndata_size_estimate_add(&estimate, 1000);
+  tlib_pass_if_size_t_equal("first size", 1000,
+                            nr_txndata_size_estimate_value(&estimate));
+  nr_txndata_size_estimate_add(&estimate, 2000);
+  tlib_pass_if_size_t_equal("larger size", 2000,
+                            nr_txndata_size_estimate_value(&estimate));
+  nr_txndata_size_estimate_add(&estimate, 0);
+  tlib_pass_if_size_t_equal("smaller size", 2000,
+                            nr_txndata_size_estimate_value(&estimate));
+
+  /*
+   * Test : A large size is forgotten after at most two windows of smaller
+   *        sizes.
+   */
+  for (i = 3; i < NR_TXNDATA_SIZE_WINDOW; i++) {
+    nr_txndata_size_estimate_add(&estimate, 500);
+  }
+  tlib_pass_if_size_t_equal("end of first window", 2000,
+                            nr_txndata_size_estimate_value(&estimate));
+  for (i = 0; i < NR_TXNDATA_SIZE_WINDOW; i++) {
+    nr_txndata_size_estimate_add(&estimate, 500);
+  }
+  tlib_pass_if_size_t_equal("end of second window", 500,
+                            nr_txndata_size_estimate_value(&estimate));
+
+  /*
+   * Test : Sizes are clamped to the largest buffer that is kept.
+   */
+  nr_txndata_size_estimate_add(&estimate, NR_TXNDATA_BUILDER_MAX_RETAINED * 2);
+  tlib_pass_if_size_t_equal("clamped size", NR_TXNDATA_BUILDER_MAX_RETAINED,
+                            nr_txndata_size_estimate_value(&estimate));
+
+  /*
+   * Test : Bad parameters.
+   */
+  tlib_pass_if_size_t_equal("NULL txn", 0, nr_txndata_size_estimate(NULL));
+  nr_txndata_record_size(NULL, 1000);
+}
+
+#define LARGE_TXN_SPAN_EVENTS 5000
+#define LARGE_TXN_TRACE_SIZE (64 * 1024)
+
+static void large_txn_init(nrtxn_t* txn, const char* name) {
+  char* trace_json;
+  size_t i;
+
+  nr_memset(txn, 0, sizeof(*txn));
+  txn->status.recording = 1;
+  txn->name = nr_strdup(name);
+  nr_txn_set_guid(txn, "0123456789abcdef");
+
+  trace_json = (char*)nr_malloc(LARGE_TXN_TRACE_SIZE + 1);
+  nr_memset(trace_json, 'x', LARGE_TXN_TRACE_SIZE);
+  trace_json[LARGE_TXN_TRACE_SIZE] = '\0';
+  txn->final_data.trace_json = trace_json;
+
+  txn->app_limits.span_events = LARGE_TXN_SPAN_EVENTS;
+  txn->final_data.span_events
+      = nr_vector_create(LARGE_TXN_SPAN_EVENTS, destroy_span_event, NULL);
+  for (i = 0; i < LARGE_TXN_SPAN_EVENTS; i++) {
+    nr_span_event_t* span = nr_span_event_create();
+
+    nr_span_event_set_guid(span, "abcdefgh");
+    nr_span_event_set_name(span, "Custom/large_txn_segment");
+    nr_vector_push_back(txn->final_data.span_events, span);
+  }
+}
+
+/*
+ * Returns a transaction name that doesn't share a size estimate entry with
+ * the transactions sent by the other tests, which may be running in parallel.
+ */
+static void large_txn_name(char* name, size_t len) {
+  char others[][16] = {"txnname", "txn_name", "my_txn_name"};
+  int n;
+
+  for (n = 0;; n++) {
+    size_t index;
+    size_t i;
+    bool shared = false;
+
+    snprintf(name, len, "WebTransaction/Uri/large/%d", n);
+    index = nr_txndata_size_estimate_index(name);
+    for (i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+      shared = shared || (index == nr_txndata_size_estimate_index(others[i]));
+    }
+
+    if (!shared) {
+      return;
+    }
+  }
+}
+
+static void test_encode_presized(void) {
+  char name[64];
+  nrtxn_t txn;
+  nr_flatbuffer_t* first;
+  nr_flatbuffer_t* second;
+
+  large_txn_name(name, sizeof(name));
+  large_txn_init(&txn, name);
+
+  /*
+   * Test : A plain encode doesn't record a size estimate.
+   */
+  first = nr_txndata_encode(&txn);
+  tlib_pass_if_size_t_equal("plain encode", 0, nr_txndata_size_estimate(&txn));
+
+  /*
+   * Test : Once a transaction has been sent, the next one with the same name
+   *        is encoded into a buffer that is big enough, and the encoded bytes
+   *        don't depend on the buffer's size.
+   */
+  second = nr_flatbuffers_create(0);
+  nr_txndata_encode_presized(second, &txn, false);
+  tlib_pass_if_true("estimate",
+                    nr_txndata_size_estimate(&txn) >= nr_flatbuffers_len(first),
+                    "estimate=%zu len=%zu", nr_txndata_size_estimate(&txn),
+                    nr_flatbuffers_len(first));
+  nr_flatbuffers_destroy(&second);
+
+  second = nr_flatbuffers_create(0);
+  nr_txndata_encode_presized(second, &txn, false);
+  tlib_pass_if_size_t_equal("presized encode copies nothing", 0,
+                            nr_flatbuffers_bytes_copied(second));
+  tlib_pass_if_bytes_equal_f("presized encode", nr_flatbuffers_data(first),
+                             nr_flatbuffers_len(first),
+                             nr_flatbuffers_data(second),
+                             nr_flatbuffers_len(second), __FILE__, __LINE__);
+
+  nr_flatbuffers_destroy(&first);
+  nr_flatbuffers_destroy(&second);
+  nr_txn_destroy_fields(&txn);
+}
+
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 4, .state_size = 0};
 
 void test_main(void* p NRUNUSED) {
@@ -1405,8 +1608,11 @@ void test_main(void* p NRUNUSED) {
   test_encode_log_forwarding_labels();
   test_encode_log_forwarding_labels_null();
   test_encode_php_packages();
+  test_size_estimates();
+  test_encode_presized();
 
   test_bad_daemon_fd();
   test_null_txn();
   test_empty_txn();
+  test_trace_sent_externally();
 }
@@ -231,6 +231,21 @@ static void test_app_timeout(void) {
   nr_free(argv);
 }
 
+static void test_connect_cache_file(void) {
+  nr_argv_t* argv;
+  nr_daemon_args_t args;
+
+  nr_memset(&args, 0, sizeof(args));
+  args.connect_cache_file = "/var/lib/newrelic/connect.cache";
+  argv = nr_daemon_args_to_argv("newrelic-daemon", &args);
+
+  pass_if_argv_has_flag(argv,
+                        "connect_cache_file=/var/lib/newrelic/connect.cache");
+
+  nr_argv_destroy(argv);
+  nr_free(argv);
+}
+
 static void test_start_timeout(void) {
   nr_argv_t* argv;
   nr_daemon_args_t args;
@@ -400,6 +415,7 @@ void test_main(void* p NRUNUSED) {
   test_integration_mode_enabled();
   test_integration_mode_disabled();
   test_app_timeout();
+  test_connect_cache_file();
   test_start_timeout();
 
   /*
@@ -9,6 +9,8 @@
 #include "nr_txn.h"
 #include "nr_distributed_trace_private.h"
 #include "util_memory.h"
+#include "util_strings.h"
+#include "util_time.h"
 #include <locale.h>
 
 static void test_distributed_trace_create_destroy(void) {
@@ -1613,6 +1615,390 @@ static void test_distributed_trace_accept_inbound_w3c_payload_invalid(void) {
   nr_distributed_trace_destroy(&dt);
 }
 
+static void test_distributed_trace_parse_w3c_headers(void) {
+  const char* traceparent
+      = "00-22222222222222222222222222222222-3333333333333333-01";
+  nr_distributed_trace_w3c_headers_t headers;
+  const char* error = NULL;
+  nrobj_t* res;
+  char* res_str;
+  size_t index;
+  struct testcase_t {
+    const char* traceparent;
+    bool valid;
+    const char* message;
+  } testcases[] = {
+      {"01-22222222222222222222222222222222-3333333333333333-01-future", true,
+       "additional fields for a later version"},
+      {"00-22222222222222222222222222222222-3333333333333333-01\n", true,
+       "trailing newline"},
+      {"01-22222222222222222222222222222222-3333333333333333-01-a\n", true,
+       "additional fields and trailing newline"},
+      {"00-22222222222222222222222222222222-3333333333333333-01-", false,
+       "empty additional fields for version 00"},
+      {"01-22222222222222222222222222222222-3333333333333333-01-a\nb", false,
+       "newline within additional fields"},
+      {"00-22222222222222222222222222222222-3333333333333333-01\n\n", false,
+       "two trailing newlines"},
+      {"00-22222222222222222222222222222222-3333333333333333-01x", false,
+       "trailing characters"},
+      {"00-2222222222222222222222222222222a-333333333333333F-01", false,
+       "uppercase hex"},
+      {"0g-22222222222222222222222222222222-3333333333333333-01", false,
+       "invalid version"},
+  };
+
+  /*
+   * Test : Bad parameters.
+   */
+  tlib_pass_if_false(
+      "NULL headers",
+      nr_distributed_trace_parse_w3c_headers(NULL, traceparent, NULL, NULL,
+                                             &error),
+      "expected false");
+
+  /*
+   * Test : Trace parent edge cases are parsed as the regular expression in
+   *        the specification would.
+   */
+  for (index = 0; index < sizeof(testcases) / sizeof(testcases[0]); index++) {
+    error = NULL;
+    tlib_pass_if_bool_equal(
+        testcases[index].message, testcases[index].valid,
+        nr_distributed_trace_parse_w3c_headers(
+            &headers, testcases[index].traceparent, NULL, NULL, &error));
+  }
+
+  /*
+   * Test : Fields refer into the headers rather than copying them.
+   */
+  error = NULL;
+  tlib_pass_if_true(
+      "valid headers",
+      nr_distributed_trace_parse_w3c_headers(
+          &headers, traceparent,
+          " other=1 , 190@nr=0-1-70-85-4a3f-9eff-0-0.5-1563 ", "190", &error),
+      "expected true");
+  tlib_pass_if_null("valid headers", error);
+  tlib_pass_if_ptr_equal("trace id in place", traceparent + 3,
+                         headers.trace_id.value);
+  tlib_pass_if_size_t_equal("trace id length", 32, headers.trace_id.len);
+  tlib_pass_if_ptr_equal("parent id in place", traceparent + 36,
+                         headers.parent_id.value);
+  tlib_pass_if_int_equal("trace flags", 1, headers.trace_flags);
+  tlib_pass_if_true("NR entry", headers.has_nr_entry, "expected true");
+  tlib_pass_if_int_equal("parent type", 1, headers.parent_type);
+  tlib_pass_if_true("sampled", headers.has_sampled, "expected true");
+  tlib_pass_if_int_equal("sampled", 0, headers.sampled);
+  tlib_pass_if_double_equal("priority", 0.5, headers.priority);
+  tlib_pass_if_long_equal("timestamp", 1563, headers.timestamp);
+  tlib_pass_if_true("other vendors", headers.has_other_vendors,
+                    "expected true");
+
+  /*
+   * Test : The last New Relic entry is used, and entries without a vendor key
+   *        are forwarded but not listed as vendors.
+   */
+  error = NULL;
+  res = nr_distributed_trace_convert_w3c_headers_to_object(
+      traceparent,
+      "190@nr=0-0-70-85-----1,==,190@nr=0-0-71-86-----2,other= 1", "190",
+      &error);
+  res_str = nro_to_json(res);
+  tlib_pass_if_null("multiple NR entries", error);
+  tlib_pass_if_str_equal("multiple NR entries",
+                         "{"
+                         "\"traceparent\":{"
+                         "\"version\":\"00\","
+                         "\"trace_id\":\"22222222222222222222222222222222\","
+                         "\"parent_id\":\"3333333333333333\","
+                         "\"trace_flags\":1"
+                         "},"
+                         "\"tracingVendors\":\"other\","
+                         "\"rawTracingVendors\":\"==,other= 1\","
+                         "\"tracestate\":{"
+                         "\"version\":0,"
+                         "\"parent_type\":0,"
+                         "\"parent_account_id\":\"71\","
+                         "\"parent_application_id\":\"86\","
+                         "\"timestamp\":2"
+                         "}"
+                         "}",
+                         res_str);
+  nro_delete(res);
+  nr_free(res_str);
+
+  error = NULL;
+  res = nr_distributed_trace_convert_w3c_headers_to_object(traceparent, "==",
+                                                           "190", &error);
+  res_str = nro_to_json(res);
+  tlib_pass_if_str_equal("only keyless entries",
+                         "Supportability/TraceContext/TraceState/NoNrEntry",
+                         error);
+  tlib_pass_if_null("only keyless entries",
+                    nro_get_hash_value(res, "rawTracingVendors", NULL));
+  nro_delete(res);
+  nr_free(res_str);
+
+  error = NULL;
+  res = nr_distributed_trace_convert_w3c_headers_to_object(traceparent, "",
+                                                           "190", &error);
+  tlib_pass_if_str_equal("empty trace state", "",
+                         nro_get_hash_string(res, "tracingVendors", NULL));
+  tlib_pass_if_str_equal("empty trace state", "",
+                         nro_get_hash_string(res, "rawTracingVendors", NULL));
+  nro_delete(res);
+
+  error = NULL;
+  res = nr_distributed_trace_convert_w3c_headers_to_object(traceparent, " , ",
+                                                           "190", &error);
+  tlib_pass_if_str_equal("blank trace state",
+                         "Supportability/TraceContext/TraceState/NoNrEntry",
+                         error);
+  tlib_pass_if_null("blank trace state",
+                    nro_get_hash_value(res, "tracingVendors", NULL));
+  nro_delete(res);
+}
+
+#define test_dt_inbound_equal(M, EXPECTED, ACTUAL)                            \
+  do {                                                                        \
+    tlib_pass_if_bool_equal(M, (EXPECTED)->inbound.set,                       \
+                            (ACTUAL)->inbound.set);                           \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.type,                       \
+                           (ACTUAL)->inbound.type);                           \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.app_id,                     \
+                           (ACTUAL)->inbound.app_id);                         \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.account_id,                 \
+                           (ACTUAL)->inbound.account_id);                     \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.transport_type,             \
+                           (ACTUAL)->inbound.transport_type);                 \
+    tlib_pass_if_time_equal(M, (EXPECTED)->inbound.timestamp,                 \
+                            (ACTUAL)->inbound.timestamp);                     \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.guid,                       \
+                           (ACTUAL)->inbound.guid);                           \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.txn_id,                     \
+                           (ACTUAL)->inbound.txn_id);                         \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.tracing_vendors,            \
+                           (ACTUAL)->inbound.tracing_vendors);                \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.raw_tracing_vendors,        \
+                           (ACTUAL)->inbound.raw_tracing_vendors);            \
+    tlib_pass_if_str_equal(M, (EXPECTED)->inbound.trusted_parent_id,          \
+                           (ACTUAL)->inbound.trusted_parent_id);              \
+    tlib_pass_if_str_equal(M, (EXPECTED)->trace_id, (ACTUAL)->trace_id);      \
+    tlib_pass_if_bool_equal(M, (EXPECTED)->sampled, (ACTUAL)->sampled);       \
+    tlib_pass_if_double_equal(M, (EXPECTED)->priority, (ACTUAL)->priority);   \
+  } while (0)
+
+static void test_distributed_trace_accept_inbound_w3c_headers(void) {
+  const char* traceparent
+      = "00-22222222222222222222222222222222-3333333333333333-01";
+  nr_distributed_trace_w3c_headers_t headers;
+  nr_distributed_trace_t* dt = nr_distributed_trace_create();
+  const char* error = NULL;
+  size_t index;
+  const char* tracestates[] = {
+      NULL,
+      "",
+      "other=1",
+      "190@nr=0-0-70-85-----1563",
+      "190@nr=0-1-70-85-4a3f-9eff-1-.342-1563,other=other,other2=other2",
+      "190@nr=0-2-70-85-4a3f-9eff-0-1.2.3-1563",
+      "dd=1, 190@nr=0-0-70-85-4a3f--1-0-1563-new-fields ,==,dt=2",
+      "190@nr=0",
+      "23@nr=0-0-70-85-----1563",
+  };
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_distributed_trace_parse_w3c_headers(&headers, traceparent, NULL, NULL,
+                                         &error);
+  error = NULL;
+  tlib_pass_if_false("NULL dt",
+                     nr_distributed_trace_accept_inbound_w3c_headers(
+                         NULL, &headers, "HTTP", &error),
+                     "expected false");
+  tlib_pass_if_str_equal(
+      "NULL dt", "Supportability/TraceContext/Accept/Exception", error);
+  error = NULL;
+  tlib_pass_if_false("NULL headers",
+                     nr_distributed_trace_accept_inbound_w3c_headers(
+                         dt, NULL, "HTTP", &error),
+                     "expected false");
+  tlib_pass_if_str_equal(
+      "NULL headers",
+      "Supportability/TraceContext/TraceParent/Parse/Exception", error);
+  tlib_pass_if_false("NULL error",
+                     nr_distributed_trace_accept_inbound_w3c_headers(
+                         dt, &headers, "HTTP", NULL),
+                     "expected false");
+  nr_distributed_trace_destroy(&dt);
+
+  /*
+   * Test : Accepting parsed headers has the same result as accepting them
+   *        as an object.
+   */
+  for (index = 0; index < sizeof(tracestates) / sizeof(tracestates[0]);
+       index++) {
+    nr_distributed_trace_t* expected = nr_distributed_trace_create();
+    nr_distributed_trace_t* actual = nr_distributed_trace_create();
+    const char* expected_error = NULL;
+    const char* actual_error = NULL;
+    nrobj_t* obj = nr_distributed_trace_convert_w3c_headers_to_object(
+        traceparent, tracestates[index], "190", &expected_error);
+
+    nr_distributed_trace_parse_w3c_headers(
+        &headers, traceparent, tracestates[index], "190", &actual_error);
+    tlib_pass_if_str_equal(NRSAFESTR(tracestates[index]), expected_error,
+                           actual_error);
+
+    expected_error = NULL;
+    actual_error = NULL;
+    tlib_pass_if_bool_equal(
+        NRSAFESTR(tracestates[index]),
+        nr_distributed_trace_accept_inbound_w3c_payload(expected, obj, "HTTP",
+                                                        &expected_error),
+        nr_distributed_trace_accept_inbound_w3c_headers(actual, &headers,
+                                                        "HTTP", &actual_error));
+    tlib_pass_if_str_equal(NRSAFESTR(tracestates[index]), expected_error,
+                           actual_error);
+    test_dt_inbound_equal(NRSAFESTR(tracestates[index]), expected, actual);
+
+    nro_delete(obj);
+    nr_distributed_trace_destroy(&expected);
+    nr_distributed_trace_destroy(&actual);
+  }
+}
+
+/*
+ * The outbound timestamp used by the tests below, and how it is formatted.
+ */
+#define TEST_OUTBOUND_NOW (1482959525577 * NR_TIME_DIVISOR_MS + 123)
+#define TEST_OUTBOUND_NOW_MS "1482959525577"
+
+static void test_outbound_headers_match(const char* testname,
+                                        nr_distributed_trace_t* dt,
+                                        const char* span_id,
+                                        const char* txn_id) {
+  nr_distributed_trace_payload_t* payload;
+  char* expected;
+  char* actual;
+  char* timestamp;
+
+  payload = nr_distributed_trace_payload_create(dt, span_id);
+  payload->timestamp = TEST_OUTBOUND_NOW;
+  expected = nr_distributed_trace_payload_as_text(payload);
+  actual = nr_distributed_trace_outbound_payload_text(dt, span_id,
+                                                      TEST_OUTBOUND_NOW);
+  tlib_pass_if_str_equal(testname, expected, actual);
+  nr_free(expected);
+  nr_free(actual);
+  nr_distributed_trace_payload_destroy(&payload);
+
+  expected = nr_distributed_trace_create_w3c_traceparent_header(
+      dt->trace_id, span_id, dt->sampled);
+  actual = nr_distributed_trace_outbound_traceparent(dt, span_id);
+  tlib_pass_if_str_equal(testname, expected, actual);
+  nr_free(expected);
+  nr_free(actual);
+
+  /*
+   * The uncached tracestate header always uses the current time, so its
+   * timestamp is replaced before comparing.
+   */
+  expected = nr_distributed_trace_create_w3c_tracestate_header(dt, span_id,
+                                                               txn_id);
+  if (expected) {
+    timestamp = strrchr(expected, '-');
+    timestamp[1] = '\0';
+    expected = nr_str_append(expected, TEST_OUTBOUND_NOW_MS, NULL);
+  }
+  actual = nr_distributed_trace_outbound_tracestate(dt, span_id, txn_id,
+                                                    TEST_OUTBOUND_NOW);
+  tlib_pass_if_str_equal(testname, expected, actual);
+  nr_free(expected);
+  nr_free(actual);
+}
+
+static void test_distributed_trace_outbound_headers(void) {
+  size_t i;
+  size_t j;
+  nr_distributed_trace_t* dt;
+  const struct {
+    const char* account_id;
+    const char* app_id;
+    const char* trusted_key;
+    const char* trace_id;
+    const char* txn_id;
+    nr_sampling_priority_t priority;
+    bool sampled;
+  } metadata[] = {
+      {"12345", "67890", "12345", "3221bf09aa0bcf0d", "3221bf09aa0bcf0d",
+       0.123456, true},
+      {"12345", "67890", "12345", "3221bf09aa0bcf0d", "3221bf09aa0bcf0d",
+       0.123456, false},
+      {"12345", "67890", "12345", "3221bf09aa0bcf0d", "3221bf09aa0bcf0d",
+       1.5, false},
+      {"12345", "67890", "190", "3221bf09aa0bcf0d", "3221bf09aa0bcf0d", 1.5,
+       false},
+      {"12345", "67890", "190", "74BE672b84ddc4e4b28be285632bbc0a",
+       "3221bf09aa0bcf0d", 0.5, true},
+      {"12345", "67890", "190", "111122223333FoUrfIvE6666777788889999",
+       "3221bf09aa0bcf0d", 0.5, true},
+      {"12345", "67890", "190", "3221bf09aa0bcf0d", NULL, 0.5, true},
+      {"12345", NULL, "190", "3221bf09aa0bcf0d", "3221bf09aa0bcf0d", 0.5,
+       true},
+      {NULL, "67890", NULL, "3221bf09aa0bcf0d", "3221bf09aa0bcf0d", 0.5, true},
+      {"12345", "67890", "190", NULL, "3221bf09aa0bcf0d", 0.5, true},
+      {"ac\"count", "app/\\id", "tr\nkey", "3221bf09aa0bcf0d", "tx\"n", 0.0,
+       false},
+  };
+  const char* span_ids[] = {
+      NULL,
+      "f85f42fd82a4cf1d",
+      "sp\"an\\id",
+      "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",
+  };
+  const char* txn_ids[] = {NULL, "164d3b4b0d09cb05"};
+
+  tlib_pass_if_null("NULL dt payload",
+                    nr_distributed_trace_outbound_payload_text(
+                        NULL, "f85f42fd82a4cf1d", TEST_OUTBOUND_NOW));
+  tlib_pass_if_null(
+      "NULL dt traceparent",
+      nr_distributed_trace_outbound_traceparent(NULL, "f85f42fd82a4cf1d"));
+  tlib_pass_if_null("NULL dt tracestate",
+                    nr_distributed_trace_outbound_tracestate(
+                        NULL, "f85f42fd82a4cf1d", NULL, TEST_OUTBOUND_NOW));
+
+  /*
+   * The same distributed trace is used throughout, so that each change of
+   * metadata has to invalidate the cached parts.
+   */
+  dt = nr_distributed_trace_create();
+  test_outbound_headers_match("empty metadata", dt, "f85f42fd82a4cf1d", NULL);
+
+  for (i = 0; i < sizeof(metadata) / sizeof(metadata[0]); i++) {
+    nr_distributed_trace_set_account_id(dt, metadata[i].account_id);
+    nr_distributed_trace_set_app_id(dt, metadata[i].app_id);
+    nr_distributed_trace_set_trusted_key(dt, metadata[i].trusted_key);
+    nr_distributed_trace_set_trace_id(dt, metadata[i].trace_id, false);
+    nr_distributed_trace_set_txn_id(dt, metadata[i].txn_id);
+    nr_distributed_trace_set_priority(dt, metadata[i].priority);
+    nr_distributed_trace_set_sampled(dt, metadata[i].sampled);
+
+    for (j = 0; j < sizeof(span_ids) / sizeof(span_ids[0]); j++) {
+      char* testname = nr_formatf("metadata=%zu span_id=%zu", i, j);
+
+      test_outbound_headers_match(testname, dt, span_ids[j], txn_ids[0]);
+      test_outbound_headers_match(testname, dt, span_ids[j], txn_ids[1]);
+      nr_free(testname);
+    }
+  }
+
+  nr_distributed_trace_destroy(&dt);
+}
+
 static void test_distributed_trace_create_trace_parent_header(void) {
   char* trace_id = "mEaTbAlLS";
   char* trace_id2 = "111122223333FoUrfIvE666677778888";
@@ -1744,9 +2130,12 @@ void test_main(void* p NRUNUSED) {
   test_distributed_trace_convert_w3c_tracestate_invalid();
   test_distributed_trace_convert_w3c_tracestate();
   test_distributed_trace_accept_inbound_w3c_payload_invalid();
+  test_distributed_trace_parse_w3c_headers();
+  test_distributed_trace_accept_inbound_w3c_headers();
 
   test_create_trace_state_header();
   test_distributed_trace_create_trace_parent_header();
+  test_distributed_trace_outbound_headers();
   test_distributed_trace_set_trace_id(false);
   test_distributed_trace_set_trace_id(true);
 }
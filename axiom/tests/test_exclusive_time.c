@@ -8,6 +8,7 @@
 #include "nr_exclusive_time.h"
 #include "nr_exclusive_time_private.h"
 #include "util_memory.h"
+#include "util_random.h"
 #include "util_time.h"
 
 #include "tlib_main.h"
@@ -522,6 +523,170 @@ static void test_compare(void) {
                          nr_exclusive_time_transition_compare(&a, &b, NULL));
 }
 
+static void test_sweep(void) {
+  nr_exclusive_time_sweep_t sweep;
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_exclusive_time_sweep_init(NULL, 10, 50);
+  tlib_pass_if_bool_equal("NULL sweep should fail to add a child", false,
+                          nr_exclusive_time_sweep_add_child(NULL, 20, 30));
+  tlib_pass_if_time_equal("NULL sweep should fail to calculate", 0,
+                          nr_exclusive_time_sweep_calculate(NULL));
+
+  /*
+   * Test : Start time after stop time.
+   */
+  nr_exclusive_time_sweep_init(&sweep, 50, 10);
+  tlib_pass_if_time_equal(
+      "start time after stop time should return an exclusive time of 0", 0,
+      nr_exclusive_time_sweep_calculate(&sweep));
+
+  /*
+   * Test : No children.
+   */
+  nr_exclusive_time_sweep_init(&sweep, 10, 50);
+  tlib_pass_if_time_equal(
+      "a segment with no children should have its entire duration attributed "
+      "as exclusive time",
+      40, nr_exclusive_time_sweep_calculate(&sweep));
+
+  /*
+   * Test : Ordered children, some touching, some zero duration.
+   *
+   * time ->   10        20        30        40        50
+   *           Parent---------------------------------->
+   *                     Child----->
+   *                               Child----->
+   *                                         |
+   */
+  nr_exclusive_time_sweep_init(&sweep, 10, 50);
+  tlib_pass_if_bool_equal("ordered child", true,
+                          nr_exclusive_time_sweep_add_child(&sweep, 20, 30));
+  tlib_pass_if_bool_equal("touching child", true,
+                          nr_exclusive_time_sweep_add_child(&sweep, 30, 40));
+  tlib_pass_if_bool_equal("zero duration child", true,
+                          nr_exclusive_time_sweep_add_child(&sweep, 40, 40));
+  tlib_pass_if_time_equal("ordered children", 20,
+                          nr_exclusive_time_sweep_calculate(&sweep));
+
+  /*
+   * Test : Children outside the parent are clamped.
+   *
+   * time ->   10        20        30        40        50        60
+   *                     Parent----------------------->
+   *           Child----------->
+   *                                         Child------------->
+   */
+  nr_exclusive_time_sweep_init(&sweep, 20, 50);
+  nr_exclusive_time_sweep_add_child(&sweep, 10, 25);
+  nr_exclusive_time_sweep_add_child(&sweep, 40, 60);
+  tlib_pass_if_time_equal("clamped children", 15,
+                          nr_exclusive_time_sweep_calculate(&sweep));
+
+  /*
+   * Test : Invalid children are ignored.
+   */
+  nr_exclusive_time_sweep_init(&sweep, 10, 50);
+  tlib_pass_if_bool_equal("invalid child", true,
+                          nr_exclusive_time_sweep_add_child(&sweep, 30, 20));
+  tlib_pass_if_time_equal("invalid child", 40,
+                          nr_exclusive_time_sweep_calculate(&sweep));
+
+  /*
+   * Test : Overlapping and unordered children are rejected.
+   */
+  nr_exclusive_time_sweep_init(&sweep, 10, 50);
+  nr_exclusive_time_sweep_add_child(&sweep, 20, 30);
+  tlib_pass_if_bool_equal("overlapping child", false,
+                          nr_exclusive_time_sweep_add_child(&sweep, 25, 35));
+  tlib_pass_if_bool_equal("unordered child", false,
+                          nr_exclusive_time_sweep_add_child(&sweep, 10, 15));
+}
+
+/*
+ * Add the given children to both an exclusive time structure and a sweep,
+ * returning whether the sweep accepted all of them.
+ */
+static bool add_children_to_both(nr_exclusive_time_t* et,
+                                 nr_exclusive_time_sweep_t* sweep,
+                                 const nrtime_t* starts,
+                                 const nrtime_t* stops,
+                                 size_t count) {
+  bool swept = true;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    nr_exclusive_time_add_child(et, starts[i], stops[i]);
+    if (swept) {
+      swept = nr_exclusive_time_sweep_add_child(sweep, starts[i], stops[i]);
+    }
+  }
+
+  return swept;
+}
+
+#define NR_SWEEP_RANDOM_ROUNDS 1000
+#define NR_SWEEP_RANDOM_CHILDREN 32
+static void test_sweep_random(void) {
+  nrtime_t starts[NR_SWEEP_RANDOM_CHILDREN];
+  nrtime_t stops[NR_SWEEP_RANDOM_CHILDREN];
+  nr_random_t* rnd = nr_random_create_from_seed(345345);
+  size_t round;
+
+  for (round = 0; round < NR_SWEEP_RANDOM_ROUNDS; round++) {
+    nr_exclusive_time_t* et;
+    nr_exclusive_time_sweep_t sweep;
+    size_t count = nr_random_range(rnd, NR_SWEEP_RANDOM_CHILDREN + 1);
+    nrtime_t parent_start = nr_random_range(rnd, 100);
+    nrtime_t parent_stop = parent_start + nr_random_range(rnd, 1000);
+    nrtime_t time = nr_random_range(rnd, 200);
+    size_t i;
+
+    /*
+     * Test : Ordered, non-overlapping children, possibly touching each other
+     *        or extending beyond the parent, must be accepted by the sweep,
+     *        which must agree with the exclusive time structure.
+     */
+    for (i = 0; i < count; i++) {
+      starts[i] = time + nr_random_range(rnd, 3) * nr_random_range(rnd, 50);
+      stops[i] = starts[i] + nr_random_range(rnd, 60);
+      time = stops[i];
+    }
+
+    et = nr_exclusive_time_create(count, parent_start, parent_stop);
+    nr_exclusive_time_sweep_init(&sweep, parent_start, parent_stop);
+    tlib_pass_if_bool_equal(
+        "ordered children must be accepted", true,
+        add_children_to_both(et, &sweep, starts, stops, count));
+    tlib_pass_if_time_equal("ordered children must agree",
+                            nr_exclusive_time_calculate(et),
+                            nr_exclusive_time_sweep_calculate(&sweep));
+    nr_exclusive_time_destroy(&et);
+
+    /*
+     * Test : For arbitrary children, if the sweep accepts them, it must agree
+     *        with the exclusive time structure.
+     */
+    for (i = 0; i < count; i++) {
+      starts[i] = nr_random_range(rnd, 1200);
+      stops[i] = starts[i] + nr_random_range(rnd, 100);
+    }
+
+    et = nr_exclusive_time_create(count, parent_start, parent_stop);
+    nr_exclusive_time_sweep_init(&sweep, parent_start, parent_stop);
+    if (add_children_to_both(et, &sweep, starts, stops, count)) {
+      tlib_pass_if_time_equal("accepted children must agree",
+                              nr_exclusive_time_calculate(et),
+                              nr_exclusive_time_sweep_calculate(&sweep));
+    }
+    nr_exclusive_time_destroy(&et);
+  }
+
+  nr_random_destroy(&rnd);
+}
+
 tlib_parallel_info_t parallel_info
     = {.suggested_nthreads = -1, .state_size = 0};
 
@@ -531,4 +696,6 @@ void test_main(void* p NRUNUSED) {
   test_add_child();
   test_calculate();
   test_compare();
+  test_sweep();
+  test_sweep_random();
 }
@@ -136,6 +136,51 @@ static void test_export(void) {
   nr_explain_plan_destroy(&plan);
 }
 
+static void test_import(void) {
+  nr_explain_plan_t* plan = NULL;
+  char* json = NULL;
+
+  /*
+   * Bad parameters.
+   */
+  tlib_pass_if_null("NULL json", nr_explain_plan_create_from_json(NULL));
+  tlib_pass_if_null("empty json", nr_explain_plan_create_from_json(""));
+  tlib_pass_if_null("invalid json", nr_explain_plan_create_from_json("[[],"));
+  tlib_pass_if_null("not an array", nr_explain_plan_create_from_json("{}"));
+  tlib_pass_if_null("one element", nr_explain_plan_create_from_json("[[]]"));
+  tlib_pass_if_null("three elements",
+                    nr_explain_plan_create_from_json("[[],[],[]]"));
+  tlib_pass_if_null("non-array columns",
+                    nr_explain_plan_create_from_json("[1,[]]"));
+  tlib_pass_if_null("non-array rows",
+                    nr_explain_plan_create_from_json("[[],\"a\"]"));
+
+  /*
+   * Round trips.
+   */
+  plan = nr_explain_plan_create_from_json("[[],[]]");
+  tlib_pass_if_not_null("empty plan", plan);
+  tlib_pass_if_int_equal("empty plan", 0, nr_explain_plan_column_count(plan));
+  json = nr_explain_plan_to_json(plan);
+  tlib_pass_if_str_equal("empty plan", "[[],[]]", json);
+  nr_free(json);
+  nr_explain_plan_destroy(&plan);
+
+  plan = nr_explain_plan_create_from_json(
+      "[[\"a\",\"b\",\"c\"],[[42,\"foo\",null],[\"bar\",0,1.5]]]");
+  tlib_pass_if_not_null("columns and rows", plan);
+  tlib_pass_if_int_equal("columns and rows", 3,
+                         nr_explain_plan_column_count(plan));
+  tlib_pass_if_int_equal("columns and rows", 2, nro_getsize(plan->rows));
+  json = nr_explain_plan_to_json(plan);
+  tlib_pass_if_str_equal(
+      "columns and rows",
+      "[[\"a\",\"b\",\"c\"],[[42,\"foo\",null],[\"bar\",0,1.50000]]]",
+      json);
+  nr_free(json);
+  nr_explain_plan_destroy(&plan);
+}
+
 static void test_row(void) {
   nr_explain_plan_t* plan = NULL;
   nrobj_t* row = NULL;
@@ -179,5 +224,6 @@ void test_main(void* p NRUNUSED) {
   test_column();
   test_destroy();
   test_export();
+  test_import();
   test_row();
 }
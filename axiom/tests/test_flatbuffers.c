@@ -1334,6 +1334,176 @@ static void test_minimum_flatbuffer_size(void) {
   nr_flatbuffers_destroy(&fb);
 }
 
+static void build_reserve_table(nr_flatbuffer_t* fb) {
+  uint32_t name = nr_flatbuffers_prepend_string(fb, "reserved");
+
+  nr_flatbuffers_object_begin(fb, 2);
+  nr_flatbuffers_object_prepend_i64(fb, 0, 0x0102030405060708, 0);
+  nr_flatbuffers_object_prepend_uoffset(fb, 1, name, 0);
+  nr_flatbuffers_finish(fb, nr_flatbuffers_object_end(fb));
+}
+
+static void test_reserve_and_reset(void) {
+  nr_flatbuffer_t* grown;
+  nr_flatbuffer_t* reserved;
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_flatbuffers_reserve(NULL, 64);
+  nr_flatbuffers_reset(NULL);
+  tlib_pass_if_size_t_equal("NULL capacity", 0, nr_flatbuffers_capacity(NULL));
+  tlib_pass_if_size_t_equal("NULL bytes copied", 0,
+                            nr_flatbuffers_bytes_copied(NULL));
+
+  /*
+   * Test : Reserving rounds the capacity up to a power of 2, and never
+   *        shrinks the buffer.
+   */
+  reserved = nr_flatbuffers_create(0);
+  nr_flatbuffers_reserve(reserved, 100);
+  tlib_pass_if_size_t_equal("reserve", 128, nr_flatbuffers_capacity(reserved));
+  nr_flatbuffers_reserve(reserved, 10);
+  tlib_pass_if_size_t_equal("reserve less", 128,
+                            nr_flatbuffers_capacity(reserved));
+
+  /*
+   * Test : A reserved buffer produces the same bytes as one that grows as
+   *        required, without copying.
+   */
+  grown = nr_flatbuffers_create(0);
+  build_reserve_table(grown);
+  build_reserve_table(reserved);
+  tlib_pass_if_true("growing copies", 0 < nr_flatbuffers_bytes_copied(grown),
+                    "bytes_copied=%zu", nr_flatbuffers_bytes_copied(grown));
+  tlib_pass_if_size_t_equal("reserved copies nothing", 0,
+                            nr_flatbuffers_bytes_copied(reserved));
+  test_bytes_equal_fn("reserved", nr_flatbuffers_data(grown),
+                      nr_flatbuffers_len(grown), reserved, __FILE__, __LINE__);
+
+  /*
+   * Test : A reset buffer keeps its capacity and can be reused.
+   */
+  nr_flatbuffers_reset(grown);
+  tlib_pass_if_size_t_equal("reset len", 0, nr_flatbuffers_len(grown));
+  tlib_pass_if_size_t_equal("reset bytes copied", 0,
+                            nr_flatbuffers_bytes_copied(grown));
+  build_reserve_table(grown);
+  tlib_pass_if_size_t_equal("reused copies nothing", 0,
+                            nr_flatbuffers_bytes_copied(grown));
+  test_bytes_equal_fn("reused", nr_flatbuffers_data(reserved),
+                      nr_flatbuffers_len(reserved), grown, __FILE__, __LINE__);
+
+  nr_flatbuffers_destroy(&grown);
+  nr_flatbuffers_destroy(&reserved);
+}
+
+/*
+ * Returns the complete message for a flatbuffer with an external tail.
+ */
+static uint8_t* external_message(const nr_flatbuffer_t* fb, size_t* len) {
+  uint8_t* msg;
+
+  *len = nr_flatbuffers_len(fb) + nr_flatbuffers_external_len(fb);
+  msg = (uint8_t*)nr_malloc(*len);
+  nr_memcpy(msg, nr_flatbuffers_data(fb), nr_flatbuffers_len(fb));
+  nr_memcpy(msg + nr_flatbuffers_len(fb), nr_flatbuffers_external_data(fb),
+            nr_flatbuffers_external_len(fb));
+
+  return msg;
+}
+
+static void test_prepend_external(void) {
+  nr_flatbuffer_t* fb;
+  nr_flatbuffers_table_t tbl;
+  uint8_t* msg;
+  size_t len;
+  uint32_t data;
+  uint32_t name;
+  const char* trace = "a string that stays where it is";
+  const uint8_t bytes[] = {1, 2, 3, 4, 5, 6, 7};
+
+  /*
+   * Test : A string prepended first becomes the external tail, and the
+   *        complete message reads back correctly.
+   */
+  fb = nr_flatbuffers_create(0);
+  data = nr_flatbuffers_prepend_string_external(fb, trace);
+  name = nr_flatbuffers_prepend_string(fb, "name");
+  nr_flatbuffers_object_begin(fb, 3);
+  nr_flatbuffers_object_prepend_uoffset(fb, 0, data, 0);
+  nr_flatbuffers_object_prepend_uoffset(fb, 1, name, 0);
+  nr_flatbuffers_object_prepend_f64(fb, 2, 1.5, 0);
+  nr_flatbuffers_finish(fb, nr_flatbuffers_object_end(fb));
+
+  tlib_pass_if_ptr_equal("external data", trace,
+                         nr_flatbuffers_external_data(fb));
+  tlib_pass_if_size_t_equal("external len", nr_strlen(trace) + 1,
+                            nr_flatbuffers_external_len(fb));
+
+  msg = external_message(fb, &len);
+  nr_flatbuffers_table_init_root(&tbl, msg, len);
+  tlib_pass_if_str_equal("external string", trace,
+                         nr_flatbuffers_table_read_str(&tbl, 0));
+  tlib_pass_if_str_equal("internal string", "name",
+                         nr_flatbuffers_table_read_str(&tbl, 1));
+  tlib_pass_if_double_equal("aligned field", 1.5,
+                            nr_flatbuffers_table_read_f64(&tbl, 2, 0.0));
+  nr_free(msg);
+
+  /*
+   * Test : Resetting the buffer drops the external tail.
+   */
+  nr_flatbuffers_reset(fb);
+  tlib_pass_if_null("reset external data", nr_flatbuffers_external_data(fb));
+  tlib_pass_if_size_t_equal("reset external len", 0,
+                            nr_flatbuffers_external_len(fb));
+
+  /*
+   * Test : Bytes work the same way.
+   */
+  data = nr_flatbuffers_prepend_bytes_external(fb, bytes, sizeof(bytes));
+  nr_flatbuffers_object_begin(fb, 1);
+  nr_flatbuffers_object_prepend_uoffset(fb, 0, data, 0);
+  nr_flatbuffers_finish(fb, nr_flatbuffers_object_end(fb));
+
+  msg = external_message(fb, &len);
+  nr_flatbuffers_table_init_root(&tbl, msg, len);
+  tlib_pass_if_size_t_equal("external bytes len", sizeof(bytes),
+                            nr_flatbuffers_table_read_vector_len(&tbl, 0));
+  tlib_pass_if_bytes_equal("external bytes", bytes, sizeof(bytes),
+                           nr_flatbuffers_table_read_bytes(&tbl, 0),
+                           sizeof(bytes));
+  nr_free(msg);
+  nr_flatbuffers_destroy(&fb);
+
+  /*
+   * Test : Values that aren't prepended first are copied.
+   */
+  fb = nr_flatbuffers_create(0);
+  nr_flatbuffers_prepend_string(fb, "first");
+  data = nr_flatbuffers_prepend_string_external(fb, trace);
+  nr_flatbuffers_prepend_bytes_external(fb, bytes, sizeof(bytes));
+  tlib_pass_if_null("copied data", nr_flatbuffers_external_data(fb));
+  tlib_pass_if_size_t_equal("copied len", 0, nr_flatbuffers_external_len(fb));
+  tlib_pass_if_str_equal(
+      "copied string", trace,
+      (const char*)nr_flatbuffers_data(fb) + nr_flatbuffers_len(fb) - data
+          + sizeof(uint32_t));
+  nr_flatbuffers_destroy(&fb);
+
+  /*
+   * Test : Bad parameters.
+   */
+  fb = nr_flatbuffers_create(0);
+  tlib_pass_if_uint32_t_equal("NULL string", 0,
+                              nr_flatbuffers_prepend_string_external(fb, NULL));
+  tlib_pass_if_null("NULL fb data", nr_flatbuffers_external_data(NULL));
+  tlib_pass_if_size_t_equal("NULL fb len", 0,
+                            nr_flatbuffers_external_len(NULL));
+  nr_flatbuffers_destroy(&fb);
+}
+
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
 
 void test_main(void* p NRUNUSED) {
@@ -1360,6 +1530,8 @@ void test_main(void* p NRUNUSED) {
   test_read_string();
   test_lookup_unknown_field();
   test_minimum_flatbuffer_size();
+  test_reserve_and_reset();
+  test_prepend_external();
 
   /*
    * These values control the fuzz test and were taken verbatim from
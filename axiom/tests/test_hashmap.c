@@ -30,8 +30,9 @@ static void test_create_destroy(void) {
   hashmap = nr_hashmap_create(NULL);
   tlib_pass_if_not_null("hashmap", hashmap);
   tlib_pass_if_null("hashmap dtor", hashmap->dtor_func);
-  tlib_pass_if_size_t_equal("hashmap buckets", 8, hashmap->log2_num_buckets);
-  tlib_pass_if_not_null("hashmap buckets", hashmap->buckets);
+  tlib_pass_if_size_t_equal("hashmap slots", NR_HASHMAP_DEFAULT_LOG2_SLOTS,
+                            hashmap->log2_num_slots);
+  tlib_pass_if_null("slots are allocated lazily", hashmap->slots);
   nr_hashmap_destroy(&hashmap);
 
   /*
@@ -39,18 +40,19 @@ static void test_create_destroy(void) {
    */
   hashmap = nr_hashmap_create_buckets(16, NULL);
   tlib_pass_if_not_null("hashmap", hashmap);
-  tlib_pass_if_size_t_equal("hashmap buckets", 4, hashmap->log2_num_buckets);
+  tlib_pass_if_size_t_equal("hashmap slots", 4, hashmap->log2_num_slots);
   nr_hashmap_destroy(&hashmap);
 
   hashmap = nr_hashmap_create_buckets(0, NULL);
   tlib_pass_if_not_null("hashmap", hashmap);
-  tlib_pass_if_size_t_equal("hashmap buckets", 8, hashmap->log2_num_buckets);
+  tlib_pass_if_size_t_equal("hashmap slots", NR_HASHMAP_DEFAULT_LOG2_SLOTS,
+                            hashmap->log2_num_slots);
   nr_hashmap_destroy(&hashmap);
 
   hashmap = nr_hashmap_create_buckets(511, destructor);
   tlib_pass_if_not_null("hashmap", hashmap);
   tlib_pass_if_ptr_equal("hashmap dtor", destructor, hashmap->dtor_func);
-  tlib_pass_if_size_t_equal("hashmap buckets", 9, hashmap->log2_num_buckets);
+  tlib_pass_if_size_t_equal("hashmap slots", 9, hashmap->log2_num_slots);
   nr_hashmap_destroy(&hashmap);
 
   /*
@@ -59,8 +61,19 @@ static void test_create_destroy(void) {
   hashmap = nr_hashmap_create_buckets(1 << 29, destructor);
   tlib_pass_if_not_null("hashmap", hashmap);
   tlib_pass_if_ptr_equal("hashmap dtor", destructor, hashmap->dtor_func);
-  tlib_pass_if_size_t_equal("hashmap buckets", 24, hashmap->log2_num_buckets);
+  tlib_pass_if_size_t_equal("hashmap slots", 24, hashmap->log2_num_slots);
   nr_hashmap_destroy(&hashmap);
+
+  /*
+   * Test : Destroying a hashmap with elements.
+   */
+  hashmap = nr_hashmap_create(destructor);
+  nr_hashmap_set(hashmap, NR_PSTR("short"), nr_strdup("value"));
+  nr_hashmap_set(hashmap, NR_PSTR("a key that is too long to be stored inline"),
+                 nr_strdup("value"));
+  tlib_pass_if_not_null("slots are allocated", hashmap->slots);
+  nr_hashmap_destroy(&hashmap);
+  tlib_pass_if_null("destroy", hashmap);
 }
 
 static void apply_func(uint64_t* value,
@@ -312,6 +325,170 @@ static void test_update(void) {
   nr_hashmap_destroy(&hashmap);
 }
 
+/*
+ * Returns whether every element can reach its slot from its ideal slot
+ * without passing an empty slot, which is the invariant that lookups rely on.
+ */
+static bool probe_sequences_are_intact(const nr_hashmap_t* hashmap) {
+  size_t count = ((size_t)1) << hashmap->log2_num_slots;
+  size_t mask = count - 1;
+  size_t elements = 0;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    const nr_hashmap_slot_t* slot = &hashmap->slots[i];
+    size_t d;
+
+    if (0 == slot->distance) {
+      continue;
+    }
+
+    elements += 1;
+    if ((slot->hash & mask) != ((i - (slot->distance - 1)) & mask)) {
+      return false;
+    }
+    for (d = 1; d < slot->distance; d++) {
+      if (0 == hashmap->slots[(i - d) & mask].distance) {
+        return false;
+      }
+    }
+  }
+
+  return elements == hashmap->elements;
+}
+
+static void test_grow(void) {
+  nr_hashmap_t* hashmap = nr_hashmap_create_buckets(2, NULL);
+  uint64_t values[1000];
+  uint64_t i;
+
+  for (i = 0; i < 1000; i++) {
+    values[i] = i;
+    tlib_pass_if_status_success("set", nr_hashmap_index_set(hashmap, i * 31,
+                                                            &values[i]));
+  }
+
+  tlib_pass_if_size_t_equal("count", 1000, nr_hashmap_count(hashmap));
+  tlib_pass_if_true("load factor",
+                    hashmap->elements * 8
+                        <= (((size_t)1) << hashmap->log2_num_slots) * 7,
+                    "log2_num_slots=%zu", hashmap->log2_num_slots);
+  tlib_pass_if_true("probe sequences", probe_sequences_are_intact(hashmap),
+                    "log2_num_slots=%zu", hashmap->log2_num_slots);
+
+  for (i = 0; i < 1000; i++) {
+    tlib_pass_if_ptr_equal("get after growing", &values[i],
+                           nr_hashmap_index_get(hashmap, i * 31));
+  }
+  tlib_pass_if_null("missing", nr_hashmap_index_get(hashmap, 1));
+
+  nr_hashmap_destroy(&hashmap);
+}
+
+static void test_key_storage(void) {
+  nr_hashmap_t* hashmap = nr_hashmap_create(destructor);
+  char inline_key[NR_HASHMAP_INLINE_KEY_SIZE];
+  char heap_key[NR_HASHMAP_INLINE_KEY_SIZE + 1];
+  nr_vector_t* keys;
+
+  nr_memset(inline_key, 'a', sizeof(inline_key));
+  nr_memset(heap_key, 'a', sizeof(heap_key));
+
+  /*
+   * Test : Keys up to the inline size are stored in the slot, and longer keys
+   *        on the heap. Keys that share a prefix are distinct.
+   */
+  nr_hashmap_set(hashmap, inline_key, sizeof(inline_key), nr_strdup("inline"));
+  nr_hashmap_set(hashmap, heap_key, sizeof(heap_key), nr_strdup("heap"));
+  nr_hashmap_set(hashmap, inline_key, 1, nr_strdup("one"));
+  tlib_pass_if_size_t_equal("count", 3, nr_hashmap_count(hashmap));
+
+  tlib_pass_if_str_equal(
+      "inline key", "inline",
+      nr_hashmap_get(hashmap, inline_key, sizeof(inline_key)));
+  tlib_pass_if_str_equal("heap key", "heap",
+                         nr_hashmap_get(hashmap, heap_key, sizeof(heap_key)));
+  tlib_pass_if_str_equal("one byte key", "one",
+                         nr_hashmap_get(hashmap, inline_key, 1));
+  tlib_pass_if_null("prefix of an inline key",
+                    nr_hashmap_get(hashmap, inline_key, 2));
+
+  /*
+   * Test : Binary keys with embedded NUL bytes.
+   */
+  nr_hashmap_set(hashmap, "a\0b", 3, nr_strdup("binary"));
+  tlib_pass_if_str_equal("binary key", "binary",
+                         nr_hashmap_get(hashmap, "a\0b", 3));
+  tlib_pass_if_null("binary key mismatch", nr_hashmap_get(hashmap, "a\0c", 3));
+
+  keys = nr_hashmap_keys(hashmap);
+  tlib_pass_if_size_t_equal("keys", 4, nr_vector_size(keys));
+  nr_vector_destroy(&keys);
+
+  /*
+   * Test : Updating and deleting free the keys and values.
+   */
+  nr_hashmap_update(hashmap, heap_key, sizeof(heap_key), nr_strdup("updated"));
+  tlib_pass_if_str_equal("updated heap key", "updated",
+                         nr_hashmap_get(hashmap, heap_key, sizeof(heap_key)));
+  tlib_pass_if_status_success(
+      "delete heap key",
+      nr_hashmap_delete(hashmap, heap_key, sizeof(heap_key)));
+  tlib_pass_if_status_success(
+      "delete inline key",
+      nr_hashmap_delete(hashmap, inline_key, sizeof(inline_key)));
+  tlib_pass_if_size_t_equal("count", 2, nr_hashmap_count(hashmap));
+
+  nr_hashmap_destroy(&hashmap);
+}
+
+static void test_delete_shifts_back(void) {
+  nr_hashmap_t* hashmap = nr_hashmap_create_buckets(256, NULL);
+  uint64_t i;
+  uint64_t values[200];
+
+  /*
+   * Fill the hashmap close to its load limit, so that there are long runs of
+   * displaced elements, then delete every other element and check that the
+   * remaining elements were shifted towards their ideal slots.
+   */
+  for (i = 0; i < 200; i++) {
+    values[i] = i;
+    nr_hashmap_index_set(hashmap, i, &values[i]);
+  }
+  tlib_pass_if_size_t_equal("no growth", 8, hashmap->log2_num_slots);
+  tlib_pass_if_true("probe sequences", probe_sequences_are_intact(hashmap),
+                    "after insertion");
+
+  for (i = 0; i < 200; i += 2) {
+    tlib_pass_if_status_success("delete", nr_hashmap_index_delete(hashmap, i));
+    tlib_pass_if_status_failure("delete twice",
+                                nr_hashmap_index_delete(hashmap, i));
+  }
+  tlib_pass_if_true("probe sequences", probe_sequences_are_intact(hashmap),
+                    "after deletion");
+
+  for (i = 0; i < 200; i++) {
+    uint64_t* expected = (i & 1) ? &values[i] : NULL;
+
+    tlib_pass_if_ptr_equal("get after delete", expected,
+                           nr_hashmap_index_get(hashmap, i));
+  }
+
+  /*
+   * Test : Deleted elements can be added back.
+   */
+  for (i = 0; i < 200; i += 2) {
+    tlib_pass_if_status_success("set again",
+                                nr_hashmap_index_set(hashmap, i, &values[i]));
+  }
+  tlib_pass_if_size_t_equal("count", 200, nr_hashmap_count(hashmap));
+  tlib_pass_if_true("probe sequences", probe_sequences_are_intact(hashmap),
+                    "after reinsertion");
+
+  nr_hashmap_destroy(&hashmap);
+}
+
 static int vector_string_comparator(const void* a,
                                     const void* b,
                                     void* userdata NRUNUSED) {
@@ -363,6 +540,9 @@ void test_main(void* p NRUNUSED) {
   test_get_into();
   test_has();
   test_keys();
+  test_grow();
+  test_key_storage();
+  test_delete_shifts_back();
   test_stress();
   test_update();
 }
@@ -318,9 +318,71 @@ static void test_events_null(void) {
 
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
 
+static void test_events_admits(void) {
+  nr_log_events_t* events = nr_log_events_create(2);
+  nr_log_events_t* empty = nr_log_events_create(0);
+  nr_log_event_t* e = NULL;
+
+  /*
+   * Test : Bad parameters and empty pools admit nothing.
+   */
+  tlib_pass_if_false("NULL events", nr_log_events_admits(NULL, 0, 0),
+                     "expected false");
+  tlib_pass_if_false("empty pool", nr_log_events_admits(empty, 100, 0),
+                     "expected false");
+  nr_log_events_add_skipped_event(NULL);
+
+  /*
+   * Test : A pool that isn't full admits every event.
+   */
+  tlib_pass_if_true("not full", nr_log_events_admits(events, 0, 0),
+                    "expected true");
+  e = create_sample_event(LOG_MESSAGE_0);
+  nr_log_event_set_priority(e, 10);
+  nr_log_events_add_event(events, e);
+  e = create_sample_event(LOG_MESSAGE_1);
+  nr_log_event_set_priority(e, 20);
+  nr_log_events_add_event(events, e);
+
+  /*
+   * Test : A full pool admits events that would replace its minimum, ordered
+   *        by priority and then by timestamp.
+   */
+  tlib_pass_if_false("lower priority",
+                     nr_log_events_admits(events, 9, LOG_TIMESTAMP * 2),
+                     "expected false");
+  tlib_pass_if_true("higher priority", nr_log_events_admits(events, 11, 0),
+                    "expected true");
+  tlib_pass_if_false(
+      "same priority, older",
+      nr_log_events_admits(events, 10, LOG_TIMESTAMP * NR_TIME_DIVISOR_MS - 1),
+      "expected false");
+  tlib_pass_if_true(
+      "same priority, same age",
+      nr_log_events_admits(events, 10, LOG_TIMESTAMP * NR_TIME_DIVISOR_MS),
+      "expected true");
+  tlib_pass_if_true(
+      "same priority, newer",
+      nr_log_events_admits(events, 10, LOG_TIMESTAMP * NR_TIME_DIVISOR_MS + 1),
+      "expected true");
+
+  /*
+   * Test : Skipped events are seen but not saved.
+   */
+  nr_log_events_add_skipped_event(events);
+  tlib_pass_if_int_equal("skipped event seen", 3,
+                         nr_log_events_number_seen(events));
+  tlib_pass_if_int_equal("skipped event not saved", 2,
+                         nr_log_events_number_saved(events));
+
+  nr_log_events_destroy(&events);
+  nr_log_events_destroy(&empty);
+}
+
 void test_main(void* p NRUNUSED) {
   test_events_success();
   test_events_sample();
   test_events_null();
+  test_events_admits();
   test_log_event_comparator();
 }
\ No newline at end of file
@@ -16,6 +16,7 @@
 #include "util_memory.h"
 #include "util_strings.h"
 #include "util_syscalls.h"
+#include "util_text.h"
 
 #include "tlib_main.h"
 
@@ -771,6 +772,92 @@ static void test_timezones(void) {
   }
 }
 
+static char* read_log_buffer_file(void) {
+  char* contents = nr_read_file_contents("logbuffer.tmp", 1024 * 1024);
+
+  return contents ? contents : nr_strdup("");
+}
+
+static void test_log_buffer(void) {
+  char* contents;
+  char long_message[8192];
+  int i;
+
+  nr_unlink("logbuffer.tmp");
+  nrl_set_log_level("info");
+  nrl_set_log_file("./logbuffer.tmp");
+  nrl_set_log_buffer_size(512);
+
+  /*
+   * Warnings and errors are written immediately.
+   */
+  nrl_warning(NRL_TEST, "buffered warning");
+  contents = read_log_buffer_file();
+  tlib_pass_if_not_null("warning written immediately",
+                        nr_strstr(contents, "warning: buffered warning\n"));
+  nr_free(contents);
+
+  /*
+   * Everything is written on flush, in order.
+   */
+  nrl_info(NRL_TEST, "buffered info 1");
+  nrl_info(NRL_TEST, "buffered info 2");
+  nrl_flush_log();
+  contents = read_log_buffer_file();
+  tlib_pass_if_not_null("info written on flush",
+                        nr_strstr(contents, "info: buffered info 1\n"));
+  tlib_pass_if_true("info written in order",
+                    nr_strstr(contents, "buffered info 1")
+                        < nr_strstr(contents, "buffered info 2"),
+                    "contents=%s", contents);
+  nr_free(contents);
+
+  /*
+   * Messages too long for the buffer are written directly, after the messages
+   * that were buffered before them.
+   */
+  nr_memset(long_message, 'x', sizeof(long_message) - 1);
+  long_message[sizeof(long_message) - 1] = '\0';
+  nrl_info(NRL_TEST, "buffered info 3");
+  nrl_info(NRL_TEST, "%s", long_message);
+  contents = read_log_buffer_file();
+  tlib_pass_if_not_null("long message written",
+                        nr_strstr(contents, long_message));
+  tlib_pass_if_true("long message written in order",
+                    nr_strstr(contents, "buffered info 3")
+                        < nr_strstr(contents, long_message),
+                    "contents=%s", "...");
+  nr_free(contents);
+
+  /*
+   * If the log file doesn't accept writes, the oldest messages are dropped
+   * and a count of the dropped messages is written later.
+   */
+  if (0 == nr_access("/dev/full", W_OK)) {
+    nrl_set_log_file("/dev/full");
+    for (i = 0; i < 20; i++) {
+      nrl_info(NRL_TEST, "overflowing message %02d", i);
+    }
+    nrl_set_log_file("./logbuffer.tmp");
+    nrl_flush_log();
+
+    contents = read_log_buffer_file();
+    tlib_pass_if_null("oldest message dropped",
+                      nr_strstr(contents, "overflowing message 00"));
+    tlib_pass_if_not_null("newest message kept",
+                          nr_strstr(contents, "overflowing message 19\n"));
+    tlib_pass_if_not_null(
+        "dropped count written",
+        nr_strstr(contents,
+                  "log messages were dropped because the log buffer was full"));
+    nr_free(contents);
+  }
+
+  nrl_set_log_buffer_size(0);
+  nrl_close_log_file();
+  nr_unlink("logbuffer.tmp");
+}
+
 tlib_parallel_info_t parallel_info
     = {.suggested_nthreads = -1, .state_size = 0};
 
@@ -798,5 +885,6 @@ void test_main(void* p NRUNUSED) {
                         cleanup_string, 0, 0);
 
   test_vlog();
+  test_log_buffer();
   test_timezones();
 }
@@ -11,6 +11,7 @@
 #include "util_network.h"
 #include "util_strings.h"
 #include "util_syscalls.h"
+#include "util_threads.h"
 
 #include "tlib_main.h"
 
@@ -409,6 +410,139 @@ static void test_read_times_out(void) {
   nr_buffer_destroy(&reply);
 }
 
+/*
+ * Socket buffers small enough that writing a large message always results
+ * in partial writes.
+ */
+#define TEST_SMALL_SOCKET_BUFFER 4096
+#define TEST_VECTORED_MESSAGE_LEN (1024 * 1024)
+
+static void setup_small_pair(int socks[2]) {
+  int size = TEST_SMALL_SOCKET_BUFFER;
+
+  setup_pair(socks);
+  setsockopt(socks[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  setsockopt(socks[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+static void* test_vectored_reader(void* arg) {
+  int fd = *(int*)arg;
+
+  return nr_network_receive(fd, nr_get_time() + 5 * NR_TIME_DIVISOR);
+}
+
+/*
+ * Fills an iovec with part of a message, so that every byte of the message
+ * depends on its position.
+ */
+static void fill_iov(struct iovec* iov,
+                     char* message,
+                     size_t start,
+                     size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    message[start + i] = (char)((start + i) % 251);
+  }
+  iov->iov_base = message + start;
+  iov->iov_len = len;
+}
+
+static void test_write_message_vectored(void) {
+  int socks[2];
+  char* message = (char*)nr_malloc(TEST_VECTORED_MESSAGE_LEN);
+  struct iovec iov[4];
+  nrthread_t reader;
+  void* result = NULL;
+  nrbuf_t* buf;
+  nr_status_t st;
+
+  /*
+   * Test : A large message split across several buffers, including an empty
+   *        one, is received intact through socket buffers much smaller than
+   *        the message, with a deadline.
+   */
+  fill_iov(&iov[0], message, 0, 3);
+  fill_iov(&iov[1], message, 3, 0);
+  fill_iov(&iov[2], message, 3, TEST_VECTORED_MESSAGE_LEN / 2);
+  fill_iov(&iov[3], message, 3 + TEST_VECTORED_MESSAGE_LEN / 2,
+           TEST_VECTORED_MESSAGE_LEN / 2 - 3);
+
+  setup_small_pair(socks);
+  nrt_create(&reader, NULL, test_vectored_reader, &socks[1]);
+  st = nr_write_message_vectored(socks[0], iov, 4,
+                                 nr_get_time() + 5 * NR_TIME_DIVISOR);
+  tlib_pass_if_status_success("vectored write", st);
+  nrt_join(reader, &result);
+
+  buf = (nrbuf_t*)result;
+  tlib_pass_if_bytes_equal("vectored message", message,
+                           TEST_VECTORED_MESSAGE_LEN, nr_buffer_cptr(buf),
+                           nr_buffer_len(buf));
+  nr_buffer_destroy(&buf);
+
+  /*
+   * Test : The iovecs passed in are not modified.
+   */
+  tlib_pass_if_ptr_equal("iov base", message + 3, iov[2].iov_base);
+  tlib_pass_if_size_t_equal("iov len", TEST_VECTORED_MESSAGE_LEN / 2,
+                            iov[2].iov_len);
+
+  /*
+   * Test : The deadline is observed when nothing reads the message.
+   */
+  errno = 0;
+  st = nr_write_message_vectored(
+      socks[0], iov, 4,
+      nr_get_time() + (TEST_NETWORK_TIMEOUT_MS * NR_TIME_DIVISOR_MS));
+  tlib_pass_if_status_failure("vectored write times out", st);
+  tlib_pass_if_int_equal("vectored write errno", ETIMEDOUT, errno);
+
+  nr_close(socks[0]);
+  nr_close(socks[1]);
+  nr_free(message);
+}
+
+static void test_write_message_vectored_bad_params(void) {
+  int socks[2];
+  struct iovec iov[NR_WRITE_MESSAGE_MAX_IOV + 1];
+  int i;
+
+  for (i = 0; i < NR_WRITE_MESSAGE_MAX_IOV + 1; i++) {
+    iov[i].iov_base = (void*)((uintptr_t) "x");
+    iov[i].iov_len = 1;
+  }
+
+  setup_pair(socks);
+
+  tlib_pass_if_status_failure("negative fd",
+                              nr_write_message_vectored(-1, iov, 1, 0));
+  tlib_pass_if_status_failure("NULL iov",
+                              nr_write_message_vectored(socks[0], NULL, 1, 0));
+  tlib_pass_if_status_failure("no iovs",
+                              nr_write_message_vectored(socks[0], iov, 0, 0));
+  tlib_pass_if_status_failure(
+      "too many iovs", nr_write_message_vectored(
+                           socks[0], iov, NR_WRITE_MESSAGE_MAX_IOV + 1, 0));
+
+  iov[1].iov_base = NULL;
+  tlib_pass_if_status_failure("NULL buffer",
+                              nr_write_message_vectored(socks[0], iov, 2, 0));
+
+  iov[1].iov_base = (void*)((uintptr_t) "x");
+  iov[1].iov_len = NR_PROTOCOL_CMDLEN_MAX_BYTES;
+  tlib_pass_if_status_failure("excessive len",
+                              nr_write_message_vectored(socks[0], iov, 2, 0));
+
+  tlib_pass_if_status_failure("writev bad fd",
+                              nr_writev_full(-1, iov, 1, 0));
+  tlib_pass_if_status_success("writev nothing",
+                              nr_writev_full(socks[0], NULL, 0, 0));
+
+  nr_close(socks[0]);
+  nr_close(socks[1]);
+}
+
 static void test_set_nonblocking_bad_param(void) {
   nr_status_t st = nr_network_set_non_blocking(-1);
 
@@ -447,5 +581,8 @@ void test_main(void* p NRUNUSED) {
   test_read_bad_params();
   test_read_times_out();
 
+  test_write_message_vectored();
+  test_write_message_vectored_bad_params();
+
   test_set_nonblocking_bad_param();
 }
@@ -110,7 +110,7 @@ static void test_php_packages_to_json_buffer(void) {
   nr_buffer_add(buf, NR_PSTR("\0"));
   tlib_pass_if_str_equal("filled collection",
                          "[[\"Package One\",\"11.0\",{}],[\"Package "
-                         "Three\",\" \",{}],[\"Package Two\",\"2.0.0\",{}]]",
+                         "Two\",\"2.0.0\",{}],[\"Package Three\",\" \",{}]]",
                          nr_buffer_cptr(buf));
   nr_php_packages_destroy(&collection);
   nr_buffer_destroy(&buf);
@@ -141,7 +141,7 @@ static void test_php_packages_to_json(void) {
 
   tlib_pass_if_str_equal("full hashmap",
                          "[[\"Package One\",\"10.1.0\",{}],[\"Package "
-                         "Three\",\" \",{}],[\"Package Two\",\"11.2.0\",{}]]",
+                         "Two\",\"11.2.0\",{}],[\"Package Three\",\" \",{}]]",
                          json);
 
   nr_free(json);
@@ -361,7 +361,7 @@ static void test_php_package_iterate(void) {
   nr_php_packages_iterate(hm, nr_php_packages_itereate_callback, (void*)buf);
   nr_buffer_add(buf, NR_PSTR("\0"));
   tlib_pass_if_str_equal("iterate created proper string",
-                         "name1,name1_version\nname2,name2_version\nname3,name3_version\n", nr_buffer_cptr(buf));
+                         "name2,name2_version\nname3,name3_version\nname1,name1_version\n", nr_buffer_cptr(buf));
   nr_buffer_destroy(&buf);
 
   nr_php_packages_destroy(&hm);
@@ -1848,9 +1848,8 @@ static void test_segment_discard_keep_metrics_no_exclusive(void) {
 }
 
 static void test_segment_tree_to_heap(void) {
-  nr_minmax_heap_t* heap;
-  nr_segment_tree_to_heap_metadata_t heaps
-      = {.trace_heap = NULL, .span_heap = NULL};
+  nr_segment_tree_to_heap_metadata_t metadata
+      = {.segments = NULL, .total_time = 0, .main_context = NULL};
 
   nr_segment_t* root = nr_zalloc(sizeof(nr_segment_t));
   nr_segment_t* mini = nr_zalloc(sizeof(nr_segment_t));
@@ -1875,74 +1874,42 @@ static void test_segment_tree_to_heap(void) {
   nr_segment_add_child(root, midi);
   nr_segment_add_child(root, maxi);
 
-  /*
-   * Test : Normal operation.  Insert multiple segments directly into a
-   * two-slot heap and affirm that the expected pair are the min and
-   * max members of the heap.  It's an indirect way of testing that
-   * the supplied comparator is working, but I want to affirm all the
-   * right pieces are in place for a heap of segments.
-   */
-  heap = nr_segment_heap_create(2, nr_segment_wrapped_duration_comparator);
-
-  nr_minmax_heap_insert(heap, (void*)mini);
-  nr_minmax_heap_insert(heap, (void*)midi);
-  nr_minmax_heap_insert(heap, (void*)maxi);
-  nr_minmax_heap_insert(heap, (void*)root);
-
-  tlib_pass_if_ptr_equal(
-      "After inserting the maxi segment, it must be the min value in the "
-      "heap",
-      nr_minmax_heap_peek_min(heap), maxi);
-
-  tlib_pass_if_ptr_equal(
-      "After inserting the root segment, it must be the max value in the "
-      "heap",
-      nr_minmax_heap_peek_max(heap), root);
-  nr_minmax_heap_destroy(&heap);
-
   /*
    * Bad input
    */
 
-  // Test : No heaps should not blow up
+  // Test : No metadata should not blow up
   nr_segment_tree_to_heap(root, NULL);
 
   // Test : No root should not blow up
-  nr_segment_tree_to_heap(NULL, &heaps);
-
-  /*
-   * Test : Normal operation.  Iterate over a tree and make a heap.
-   */
-  heaps.trace_heap
-      = nr_segment_heap_create(2, nr_segment_wrapped_duration_comparator);
-  heaps.span_heap
-      = nr_segment_heap_create(2, nr_segment_wrapped_duration_comparator);
-  nr_segment_tree_to_heap(root, &heaps);
-
-  tlib_pass_if_ptr_equal(
-      "After inserting the maxi segment, it must be the min value in the "
-      "trace heap",
-      nr_minmax_heap_peek_min(heaps.trace_heap), maxi);
-  tlib_pass_if_ptr_equal(
-      "After inserting the maxi segment, it must be the min value in the "
-      "span heap",
-      nr_minmax_heap_peek_min(heaps.span_heap), maxi);
-
-  tlib_pass_if_ptr_equal(
-      "After inserting the root segment, it must be the max value in the "
-      "trace heap",
-      nr_minmax_heap_peek_max(heaps.trace_heap), root);
-  tlib_pass_if_ptr_equal(
-      "After inserting the root segment, it must be the max value in the "
-      "span heap",
-      nr_minmax_heap_peek_max(heaps.span_heap), root);
+  nr_segment_tree_to_heap(NULL, &metadata);
+
+  /*
+   * Test : Normal operation.  Iterate over a tree and collect the segments
+   * into a vector, giving each segment its index within the vector.
+   */
+  metadata.segments = nr_vector_create(4, NULL, NULL);
+  nr_segment_tree_to_heap(root, &metadata);
+
+  tlib_pass_if_size_t_equal("Every segment must be collected", 4,
+                            nr_vector_size(metadata.segments));
+  tlib_pass_if_ptr_equal("The root segment must be collected first", root,
+                         nr_vector_get(metadata.segments, root->index));
+  tlib_pass_if_size_t_equal("The root segment must have index 0", 0,
+                            root->index);
+  tlib_pass_if_ptr_equal("The mini segment must be at its index", mini,
+                         nr_vector_get(metadata.segments, mini->index));
+  tlib_pass_if_ptr_equal("The midi segment must be at its index", midi,
+                         nr_vector_get(metadata.segments, midi->index));
+  tlib_pass_if_ptr_equal("The maxi segment must be at its index", maxi,
+                         nr_vector_get(metadata.segments, maxi->index));
+  tlib_pass_if_time_equal("The total time must be the sum of exclusive time",
+                          10200, metadata.total_time);
   tlib_pass_if_not_null("The exclusive time on the root segment must be kept",
                         root->exclusive_time);
 
   /* Clean up */
-  nr_minmax_heap_destroy(&heap);
-  nr_minmax_heap_destroy(&heaps.trace_heap);
-  nr_minmax_heap_destroy(&heaps.span_heap);
+  nr_vector_destroy(&metadata.segments);
   nr_segment_destroy_tree(root);
   nr_free(root);
   nr_free(mini);
@@ -1977,10 +1944,11 @@ static void test_segment_set(void) {
   nr_free(mini);
 }
 
-static void test_segment_heap_to_set(void) {
-  nr_set_t* set;
-  nr_segment_tree_to_heap_metadata_t heaps
-      = {.trace_heap = NULL, .span_heap = NULL};
+static void test_segment_select_to_bitset(void) {
+  nr_bitset_t* bitset;
+  nr_vector_t* vector;
+  nr_segment_tree_to_heap_metadata_t metadata
+      = {.segments = NULL, .total_time = 0, .main_context = NULL};
 
   nr_segment_t* root = nr_zalloc(sizeof(nr_segment_t));
   nr_segment_t* mini = nr_zalloc(sizeof(nr_segment_t));
@@ -2005,41 +1973,54 @@ static void test_segment_heap_to_set(void) {
   nr_segment_add_child(root, midi);
   nr_segment_add_child(root, maxi);
 
-  /* Build a heap */
-  heaps.trace_heap
-      = nr_segment_heap_create(4, nr_segment_wrapped_duration_comparator);
-  nr_segment_tree_to_heap(root, &heaps);
-
-  /* Prepare a set for population */
-  set = nr_set_create();
+  /* Collect the segments */
+  metadata.segments = nr_vector_create(4, NULL, NULL);
+  nr_segment_tree_to_heap(root, &metadata);
 
   /* Test : Bad parameters */
-  nr_segment_heap_to_set(heaps.trace_heap, NULL);
-  nr_segment_heap_to_set(NULL, set);
-  tlib_pass_if_true("Converting a NULL heap to a set must yield an empty set",
-                    nr_set_size(set) == 0, "Expected true");
-  nr_set_destroy(&set);
+  bitset = nr_bitset_create(4);
+  vector = nr_vector_create(4, NULL, NULL);
+  nr_segment_select_to_bitset(NULL, 4, nr_segment_wrapped_duration_comparator,
+                              bitset);
+  nr_segment_select_to_bitset(metadata.segments, 4, NULL, bitset);
+  nr_segment_select_to_bitset(metadata.segments, 4,
+                              nr_segment_wrapped_duration_comparator, NULL);
+  nr_segment_select_to_bitset(metadata.segments, 0,
+                              nr_segment_wrapped_duration_comparator, bitset);
+  nr_segment_select_to_bitset(vector, 4, nr_segment_wrapped_duration_comparator,
+                              bitset);
+  tlib_pass_if_size_t_equal(
+      "Bad parameters or no segments must yield an empty bitset", 0,
+      nr_bitset_count(bitset));
+  nr_vector_destroy(&vector);
 
-  /* Test : Normal operation. */
-  set = nr_set_create();
-  nr_segment_heap_to_set(heaps.trace_heap, set);
+  /* Test : A bound larger than the number of segments selects them all. */
+  nr_segment_select_to_bitset(metadata.segments, 10,
+                              nr_segment_wrapped_duration_comparator, bitset);
+  tlib_pass_if_size_t_equal("Every segment must be selected", 4,
+                            nr_bitset_count(bitset));
+  nr_bitset_reset(bitset);
 
-  tlib_pass_if_not_null(
-      "Converting a well-formed heap to a set must yield a non-empty set", set);
+  /* Test : Normal operation. */
+  nr_segment_select_to_bitset(metadata.segments, 2,
+                              nr_segment_wrapped_duration_comparator, bitset);
+  tlib_pass_if_size_t_equal("The bound must be respected", 2,
+                            nr_bitset_count(bitset));
 
   /* Affirm membership */
-  tlib_pass_if_true("The longest segment is a member of the set",
-                    nr_set_contains(set, root), "Expected true");
-  tlib_pass_if_true("The second-longest segment is a member of the set",
-                    nr_set_contains(set, maxi), "Expected true");
-  tlib_pass_if_true("The third-longest segment is a member of the set",
-                    nr_set_contains(set, midi), "Expected true");
-  tlib_pass_if_true("The shortest segment is a member of the set",
-                    nr_set_contains(set, mini), "Expected true");
-  nr_set_destroy(&set);
+  tlib_pass_if_true("The longest segment is selected",
+                    nr_bitset_contains(bitset, root->index), "Expected true");
+  tlib_pass_if_true("The second-longest segment is selected",
+                    nr_bitset_contains(bitset, maxi->index), "Expected true");
+  tlib_pass_if_false("The third-longest segment is not selected",
+                     nr_bitset_contains(bitset, midi->index),
+                     "Expected false");
+  tlib_pass_if_false("The shortest segment is not selected",
+                     nr_bitset_contains(bitset, mini->index), "Expected false");
 
   /* Clean up */
-  nr_minmax_heap_destroy(&heaps.trace_heap);
+  nr_bitset_destroy(&bitset);
+  nr_vector_destroy(&metadata.segments);
   nr_segment_destroy_tree(root);
   nr_free(root);
   nr_free(mini);
@@ -3174,6 +3155,159 @@ static void test_segment_attributes_user_txn_event_add(void) {
 
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
 
+typedef struct _test_deferred_attributes_t {
+  int added;
+  int released;
+  int detached;
+  struct _test_deferred_attributes_t* copy; /* Returned when detached */
+} test_deferred_attributes_t;
+
+static void test_deferred_attributes_add(nr_segment_t* segment, void* data) {
+  test_deferred_attributes_t* counts = (test_deferred_attributes_t*)data;
+
+  counts->added++;
+
+  if (NULL == segment->attributes) {
+    segment->attributes = nr_attributes_create(segment->txn->attribute_config);
+  }
+  nr_attributes_agent_add_string(segment->attributes,
+                                 NR_ATTRIBUTE_DESTINATION_SPAN, "deferred",
+                                 "value");
+}
+
+static void test_deferred_attributes_dtor(void* data) {
+  test_deferred_attributes_t* counts = (test_deferred_attributes_t*)data;
+
+  counts->released++;
+}
+
+static const nr_segment_deferred_attributes_t test_deferred_attributes = {
+    .add = test_deferred_attributes_add,
+    .dtor = test_deferred_attributes_dtor,
+};
+
+static void* test_deferred_attributes_detach(nr_segment_t* segment NRUNUSED,
+                                             void* data) {
+  test_deferred_attributes_t* counts = (test_deferred_attributes_t*)data;
+
+  counts->detached++;
+
+  return counts->copy;
+}
+
+static const nr_segment_deferred_attributes_t test_detachable_attributes = {
+    .add = test_deferred_attributes_add,
+    .dtor = test_deferred_attributes_dtor,
+    .detach = test_deferred_attributes_detach,
+    .detached = &test_deferred_attributes,
+};
+
+static void test_segment_deferred_attributes(void) {
+  nrapp_t app = {
+      .state = NR_APP_OK,
+      .limits = {
+          .span_events = NR_DEFAULT_SPAN_EVENTS_MAX_SAMPLES_STORED,
+      },
+  };
+  nrtxnopt_t opts;
+  nrtxn_t* txn;
+  nr_segment_t* segment;
+  nr_segment_t* ended;
+  nr_span_event_t* span;
+  test_deferred_attributes_t first = {0};
+  test_deferred_attributes_t second = {0};
+
+  nr_memset(&opts, 0, sizeof(opts));
+  opts.distributed_tracing_enabled = 1;
+  opts.span_events_enabled = 1;
+  txn = nr_txn_begin(&app, &opts, NULL, NULL);
+  segment = nr_segment_start(txn, txn->segment_root, NULL);
+  nr_distributed_trace_set_sampled(txn->distributed_trace, true);
+
+  /*
+   * Test : Bad parameters. The data is released if the segment can't take it.
+   */
+  nr_segment_set_deferred_attributes(segment, NULL, &first);
+  nr_segment_add_deferred_attributes(NULL);
+  nr_segment_set_deferred_attributes(NULL, &test_deferred_attributes, &first);
+  tlib_pass_if_int_equal("NULL segment added", 0, first.added);
+  tlib_pass_if_int_equal("NULL segment released", 1, first.released);
+
+  /*
+   * Test : Setting the deferred attributes again releases the previous data
+   *        without adding it.
+   */
+  first.released = 0;
+  nr_segment_set_deferred_attributes(segment, &test_deferred_attributes,
+                                     &first);
+  nr_segment_set_deferred_attributes(segment, &test_deferred_attributes,
+                                     &second);
+  tlib_pass_if_int_equal("replaced added", 0, first.added);
+  tlib_pass_if_int_equal("replaced released", 1, first.released);
+  tlib_pass_if_null("not added yet", segment->attributes);
+
+  /*
+   * Test : Creating a span event adds the deferred attributes exactly once.
+   */
+  ended = segment;
+  nr_segment_end(&ended);
+  span = nr_segment_to_span_event(segment);
+  tlib_pass_if_int_equal("span added", 1, second.added);
+  tlib_pass_if_int_equal("span released", 1, second.released);
+  tlib_pass_if_null("span callbacks cleared", segment->deferred_attributes);
+  tlib_pass_if_str_equal(
+      "span attribute", "value",
+      nro_get_hash_string(span->agent_attributes, "deferred", NULL));
+  nr_span_event_destroy(&span);
+
+  nr_segment_add_deferred_attributes(segment);
+  tlib_pass_if_int_equal("added once", 1, second.added);
+  tlib_pass_if_int_equal("released once", 1, second.released);
+
+  /*
+   * Test : Destroying a segment releases the data without adding it.
+   */
+  first.added = 0;
+  first.released = 0;
+  nr_segment_set_deferred_attributes(segment, &test_deferred_attributes,
+                                     &first);
+  nr_segment_destroy_fields(segment);
+  tlib_pass_if_int_equal("destroyed added", 0, first.added);
+  tlib_pass_if_int_equal("destroyed released", 1, first.released);
+
+  /*
+   * Test : Detaching replaces the data with the copy from the detach callback
+   *        without adding it, and is a no-op without a detach callback.
+   */
+  nr_segment_detach_deferred_attributes(NULL);
+
+  first.released = 0;
+  second.added = 0;
+  second.released = 0;
+  first.copy = &second;
+  segment = nr_segment_start(txn, txn->segment_root, NULL);
+  nr_segment_set_deferred_attributes(segment, &test_detachable_attributes,
+                                     &first);
+  nr_segment_detach_deferred_attributes(segment);
+  tlib_pass_if_int_equal("detached", 1, first.detached);
+  tlib_pass_if_int_equal("detached added", 0, first.added);
+  tlib_pass_if_int_equal("detached released", 1, first.released);
+  tlib_pass_if_ptr_equal("detached callbacks", &test_deferred_attributes,
+                         segment->deferred_attributes);
+  tlib_pass_if_ptr_equal("detached data", &second,
+                         segment->deferred_attributes_data);
+
+  nr_segment_detach_deferred_attributes(segment);
+  tlib_pass_if_ptr_equal("detached again", &second,
+                         segment->deferred_attributes_data);
+
+  nr_segment_add_deferred_attributes(segment);
+  tlib_pass_if_int_equal("copy added", 1, second.added);
+  tlib_pass_if_int_equal("copy released", 1, second.released);
+
+  nr_txn_destroy(&txn);
+}
+
 void test_main(void* p NRUNUSED) {
   test_segment_new_txn_with_segment_root();
   test_segment_start();
@@ -3204,7 +3338,7 @@ void test_main(void* p NRUNUSED) {
   test_segment_discard_keep_metrics_no_exclusive();
   test_segment_tree_to_heap();
   test_segment_set();
-  test_segment_heap_to_set();
+  test_segment_select_to_bitset();
   test_segment_set_parent_cycle();
   test_segment_no_recording();
   test_segment_span_comparator();
@@ -3216,4 +3350,5 @@ void test_main(void* p NRUNUSED) {
   test_segment_record_exception();
   test_segment_attributes_user_add();
   test_segment_attributes_user_txn_event_add();
+  test_segment_deferred_attributes();
 }
@@ -1862,21 +1862,21 @@ static void test_json_print_segments_with_sampling(void) {
   nrpool_t* segment_names;
 
   nrtxn_t txn = {.abs_start_time = 1000};
-  nr_set_t* set;
+  nr_bitset_t* set;
 
   nr_span_event_t* evt_root;
   nr_span_event_t* evt_b;
 
   // clang-format off
-  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000};
-  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000};
-  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000};
+  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000, .index = 0};
+  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 1};
+  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000, .index = 2};
+  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000, .index = 3};
   // clang-format on
 
-  set = nr_set_create();
-  nr_set_insert(set, (void*)&root);
-  nr_set_insert(set, (void*)&B);
+  set = nr_bitset_create(4);
+  nr_bitset_set(set, root.index);
+  nr_bitset_set(set, B.index);
   buf = nr_buffer_create(4096, 4096);
   span_events = nr_vector_create(8, nr_vector_span_event_dtor, NULL);
   segment_names = nr_string_pool_create();
@@ -1926,7 +1926,7 @@ static void test_json_print_segments_with_sampling(void) {
   SPAN_EVENT_COMPARE(evt_b, "B", NR_SPAN_GENERIC, evt_root, 3000, 3000);
 
   /* Clean up */
-  nr_set_destroy(&set);
+  nr_bitset_destroy(&set);
   nr_segment_children_deinit(&root.children);
   nr_segment_destroy_fields(&root);
 
@@ -1951,7 +1951,7 @@ static void test_json_print_segments_with_sampling_cousin_parent(void) {
   nrpool_t* segment_names;
 
   nrtxn_t txn = {.abs_start_time = 1000};
-  nr_set_t* set;
+  nr_bitset_t* set;
 
   nr_span_event_t* evt_root;
   nr_span_event_t* evt_c;
@@ -1961,27 +1961,27 @@ static void test_json_print_segments_with_sampling_cousin_parent(void) {
   nr_span_event_t* evt_i;
 
   // clang-format off
-  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 14000};
-  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000};
-  nr_segment_t C = {.txn = &txn, .start_time = 1000, .stop_time = 5000};
-  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000};
-  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000};
-  nr_segment_t G = {.txn = &txn, .start_time = 5000, .stop_time = 5500};
-  nr_segment_t H = {.txn = &txn, .start_time = 1000, .stop_time = 13000};
-  nr_segment_t I = {.txn = &txn, .start_time = 1000, .stop_time = 3000};
-  nr_segment_t J = {.txn = &txn, .start_time = 3000, .stop_time = 13000};
-  nr_segment_t K = {.txn = &txn, .start_time = 2000, .stop_time = 11000};
+  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 14000, .index = 0};
+  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 1};
+  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000, .index = 2};
+  nr_segment_t C = {.txn = &txn, .start_time = 1000, .stop_time = 5000, .index = 3};
+  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 4};
+  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000, .index = 5};
+  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000, .index = 6};
+  nr_segment_t G = {.txn = &txn, .start_time = 5000, .stop_time = 5500, .index = 7};
+  nr_segment_t H = {.txn = &txn, .start_time = 1000, .stop_time = 13000, .index = 8};
+  nr_segment_t I = {.txn = &txn, .start_time = 1000, .stop_time = 3000, .index = 9};
+  nr_segment_t J = {.txn = &txn, .start_time = 3000, .stop_time = 13000, .index = 10};
+  nr_segment_t K = {.txn = &txn, .start_time = 2000, .stop_time = 11000, .index = 11};
   // clang-format on
 
-  set = nr_set_create();
-  nr_set_insert(set, (void*)&root);
-  nr_set_insert(set, (void*)&C);
-  nr_set_insert(set, (void*)&D);
-  nr_set_insert(set, (void*)&F);
-  nr_set_insert(set, (void*)&G);
-  nr_set_insert(set, (void*)&I);
+  set = nr_bitset_create(12);
+  nr_bitset_set(set, root.index);
+  nr_bitset_set(set, C.index);
+  nr_bitset_set(set, D.index);
+  nr_bitset_set(set, F.index);
+  nr_bitset_set(set, G.index);
+  nr_bitset_set(set, I.index);
 
   buf = nr_buffer_create(4096, 4096);
   span_events = nr_vector_create(8, nr_vector_span_event_dtor, NULL);
@@ -2087,7 +2087,7 @@ static void test_json_print_segments_with_sampling_cousin_parent(void) {
   SPAN_EVENT_COMPARE(evt_g, "G", NR_SPAN_GENERIC, evt_f, 6000, 500);
 
   /* Clean up */
-  nr_set_destroy(&set);
+  nr_bitset_destroy(&set);
   nr_segment_children_deinit(&root.children);
   nr_segment_destroy_fields(&root);
 
@@ -2129,8 +2129,8 @@ static void test_json_print_segments_with_sampling_inner_loop(void) {
   nrpool_t* segment_names;
 
   nrtxn_t txn = {.abs_start_time = 1000};
-  nr_set_t* trace_set;
-  nr_set_t* span_set;
+  nr_bitset_t* trace_set;
+  nr_bitset_t* span_set;
 
   nr_span_event_t* evt_root;
   nr_span_event_t* evt_a;
@@ -2139,28 +2139,28 @@ static void test_json_print_segments_with_sampling_inner_loop(void) {
   nr_span_event_t* evt_g;
 
   // clang-format off
-  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000};
-  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000};
-  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000};
-  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000};
-  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000};
-  nr_segment_t G = {.txn = &txn, .start_time = 5000, .stop_time = 5500};
+  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000, .index = 0};
+  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 1};
+  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000, .index = 2};
+  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000, .index = 3};
+  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 4};
+  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000, .index = 5};
+  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000, .index = 6};
+  nr_segment_t G = {.txn = &txn, .start_time = 5000, .stop_time = 5500, .index = 7};
   // clang-format on
 
-  trace_set = nr_set_create();
-  nr_set_insert(trace_set, (void*)&root);
-  nr_set_insert(trace_set, (void*)&C);
-  nr_set_insert(trace_set, (void*)&E);
-  nr_set_insert(trace_set, (void*)&G);
+  trace_set = nr_bitset_create(8);
+  nr_bitset_set(trace_set, root.index);
+  nr_bitset_set(trace_set, C.index);
+  nr_bitset_set(trace_set, E.index);
+  nr_bitset_set(trace_set, G.index);
 
-  span_set = nr_set_create();
-  nr_set_insert(span_set, (void*)&root);
-  nr_set_insert(span_set, (void*)&A);
-  nr_set_insert(span_set, (void*)&D);
-  nr_set_insert(span_set, (void*)&F);
-  nr_set_insert(span_set, (void*)&G);
+  span_set = nr_bitset_create(8);
+  nr_bitset_set(span_set, root.index);
+  nr_bitset_set(span_set, A.index);
+  nr_bitset_set(span_set, D.index);
+  nr_bitset_set(span_set, F.index);
+  nr_bitset_set(span_set, G.index);
 
   buf = nr_buffer_create(4096, 4096);
   span_events = nr_vector_create(8, nr_vector_span_event_dtor, NULL);
@@ -2248,8 +2248,8 @@ static void test_json_print_segments_with_sampling_inner_loop(void) {
   SPAN_EVENT_COMPARE(evt_g, "G", NR_SPAN_GENERIC, evt_f, 6000, 500);
 
   /* Clean up */
-  nr_set_destroy(&trace_set);
-  nr_set_destroy(&span_set);
+  nr_bitset_destroy(&trace_set);
+  nr_bitset_destroy(&span_set);
   nr_segment_children_deinit(&root.children);
   nr_segment_destroy_fields(&root);
 
@@ -2283,7 +2283,7 @@ static void test_json_print_segments_with_sampling_genghis_khan(void) {
   nrpool_t* segment_names;
 
   nrtxn_t txn = {.abs_start_time = 1000};
-  nr_set_t* set;
+  nr_bitset_t* set;
 
   nr_span_event_t* evt_root;
   nr_span_event_t* evt_a;
@@ -2295,27 +2295,27 @@ static void test_json_print_segments_with_sampling_genghis_khan(void) {
   nr_span_event_t* evt_i;
 
   // clang-format off
-  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000};
-  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000};
-  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000};
-  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000};
-  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 7000};
-  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000};
-  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000};
-  nr_segment_t G = {.txn = &txn, .start_time = 0,    .stop_time = 8000};
-  nr_segment_t H = {.txn = &txn, .start_time = 2000, .stop_time = 3000};
-  nr_segment_t I = {.txn = &txn, .start_time = 0,    .stop_time = 6000};
+  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000, .index = 0};
+  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 6000, .index = 1};
+  nr_segment_t B = {.txn = &txn, .start_time = 2000, .stop_time = 5000, .index = 2};
+  nr_segment_t C = {.txn = &txn, .start_time = 3000, .stop_time = 4000, .index = 3};
+  nr_segment_t D = {.txn = &txn, .start_time = 1000, .stop_time = 7000, .index = 4};
+  nr_segment_t E = {.txn = &txn, .start_time = 1000, .stop_time = 4000, .index = 5};
+  nr_segment_t F = {.txn = &txn, .start_time = 4000, .stop_time = 6000, .index = 6};
+  nr_segment_t G = {.txn = &txn, .start_time = 0,    .stop_time = 8000, .index = 7};
+  nr_segment_t H = {.txn = &txn, .start_time = 2000, .stop_time = 3000, .index = 8};
+  nr_segment_t I = {.txn = &txn, .start_time = 0,    .stop_time = 6000, .index = 9};
   // clang-format on
 
-  set = nr_set_create();
-  nr_set_insert(set, (void*)&root);
-  nr_set_insert(set, (void*)&A);
-  nr_set_insert(set, (void*)&C);
-  nr_set_insert(set, (void*)&E);
-  nr_set_insert(set, (void*)&F);
-  nr_set_insert(set, (void*)&G);
-  nr_set_insert(set, (void*)&H);
-  nr_set_insert(set, (void*)&I);
+  set = nr_bitset_create(10);
+  nr_bitset_set(set, root.index);
+  nr_bitset_set(set, A.index);
+  nr_bitset_set(set, C.index);
+  nr_bitset_set(set, E.index);
+  nr_bitset_set(set, F.index);
+  nr_bitset_set(set, G.index);
+  nr_bitset_set(set, H.index);
+  nr_bitset_set(set, I.index);
 
   buf = nr_buffer_create(4096, 4096);
   span_events = nr_vector_create(8, nr_vector_span_event_dtor, NULL);
@@ -2406,7 +2406,7 @@ static void test_json_print_segments_with_sampling_genghis_khan(void) {
   SPAN_EVENT_COMPARE(evt_i, "I", NR_SPAN_GENERIC, evt_root, 1000, 6000);
 
   /* Clean up */
-  nr_set_destroy(&set);
+  nr_bitset_destroy(&set);
   nr_segment_children_deinit(&root.children);
   nr_segment_destroy_fields(&root);
 
@@ -2528,7 +2528,7 @@ static void test_json_print_segments_extremely_short(void) {
 
 static void test_trace_create_data_bad_parameters(void) {
   nrtxn_t txn = {.abs_start_time = 1000};
-  uintptr_t i;
+  size_t i;
   nr_segment_tree_sampling_metadata_t metadata = {.trace_set = NULL};
   nrtxnfinal_t result = {.trace_json = NULL};
 
@@ -2541,7 +2541,7 @@ static void test_trace_create_data_bad_parameters(void) {
   nrobj_t* intrinsics = nro_create_from_json("[\"intrinsics\"]");
 
   metadata.out = &result;
-  metadata.trace_set = nr_set_create();
+  metadata.trace_set = nr_bitset_create(NR_MAX_SEGMENTS + 1);
 
   /*
    * Test : Bad parameters
@@ -2571,7 +2571,7 @@ static void test_trace_create_data_bad_parameters(void) {
 
   /* Insert initial values. */
   for (i = 0; i < NR_MAX_SEGMENTS + 1; i++) {
-    nr_set_insert(metadata.trace_set, (const void*)i);
+    nr_bitset_set(metadata.trace_set, i);
   }
 
   nr_segment_traces_create_data(&txn, 2 * NR_TIME_DIVISOR, &metadata,
@@ -2588,7 +2588,7 @@ static void test_trace_create_data_bad_parameters(void) {
                                 agent_attributes, user_attributes, intrinsics,
                                 true, false);
 
-  nr_set_destroy(&metadata.trace_set);
+  nr_bitset_destroy(&metadata.trace_set);
   nro_delete(agent_attributes);
   nro_delete(user_attributes);
   nro_delete(intrinsics);
@@ -2796,18 +2796,18 @@ static void test_trace_create_data_with_sampling(void) {
   nr_span_event_t* evt_b;
 
   // clang-format off
-  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000};
-  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 2000};
-  nr_segment_t B = {.txn = &txn, .start_time = 3000, .stop_time = 4000};
+  nr_segment_t root = {.txn = &txn, .start_time = 0, .stop_time = 9000, .index = 0};
+  nr_segment_t A = {.txn = &txn, .start_time = 1000, .stop_time = 2000, .index = 1};
+  nr_segment_t B = {.txn = &txn, .start_time = 3000, .stop_time = 4000, .index = 2};
   // clang-format on
 
   metadata.out = &result;
-  metadata.trace_set = nr_set_create();
-  nr_set_insert(metadata.trace_set, (void*)&root);
-  nr_set_insert(metadata.trace_set, (void*)&A);
-  metadata.span_set = nr_set_create();
-  nr_set_insert(metadata.span_set, (void*)&root);
-  nr_set_insert(metadata.span_set, (void*)&B);
+  metadata.trace_set = nr_bitset_create(3);
+  nr_bitset_set(metadata.trace_set, root.index);
+  nr_bitset_set(metadata.trace_set, A.index);
+  metadata.span_set = nr_bitset_create(3);
+  nr_bitset_set(metadata.span_set, root.index);
+  nr_bitset_set(metadata.span_set, B.index);
 
   /* Mock up a transaction */
   mock_txn(&txn, &root);
@@ -2879,8 +2879,8 @@ static void test_trace_create_data_with_sampling(void) {
   nro_delete(agent_attributes);
   nro_delete(user_attributes);
   nro_delete(intrinsics);
-  nr_set_destroy(&metadata.span_set);
-  nr_set_destroy(&metadata.trace_set);
+  nr_bitset_destroy(&metadata.span_set);
+  nr_bitset_destroy(&metadata.trace_set);
 }
 
 tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
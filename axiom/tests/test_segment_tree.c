@@ -12,8 +12,11 @@
 #include "nr_txn_private.h"
 #include "test_segment_helpers.h"
 #include "util_number_converter.h"
+#include "util_random.h"
 #include "util_set.h"
 
+#include <stdio.h>
+
 #include "tlib_main.h"
 
 #define assert_null_result(M, RESULT)                \
@@ -966,6 +969,201 @@ static void test_finalise_with_extended_sampling(void) {
   nr_slab_destroy(&txn.segment_slab);
 }
 
+/*
+ * Builds a transaction with the given number of segments below the root, in
+ * groups of eight: a parent segment directly below the root, followed by seven
+ * children of varying duration. The transaction is then finalised with the
+ * given trace and span event limits.
+ */
+#define NR_TEST_SEGMENT_LARGE_TREE_LIMIT 2000
+static void test_finalise_large_tree_size(size_t count) {
+  nrtxn_t txn = {0};
+  nr_segment_t* root;
+  nr_segment_t* parent = NULL;
+  nrtxnfinal_t result;
+  uint32_t state = 1;
+  size_t expected_spans;
+  size_t i;
+
+  txn.abs_start_time = 1000;
+  txn.distributed_trace = nr_distributed_trace_create();
+  nr_distributed_trace_set_sampled(txn.distributed_trace, true);
+  txn.options.distributed_tracing_enabled = true;
+  txn.options.span_events_enabled = true;
+  txn.app_limits.span_events = NR_TEST_SEGMENT_LARGE_TREE_LIMIT;
+
+  txn.segment_slab = nr_slab_create(sizeof(nr_segment_t), 0);
+  txn.trace_strings = nr_string_pool_create();
+  txn.scoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+  txn.unscoped_metrics = nrm_table_create(NR_METRIC_DEFAULT_LIMIT);
+
+  root = nr_slab_next(txn.segment_slab);
+  root->txn = &txn;
+  root->start_time = 0;
+  root->stop_time = (count + 8) * 10;
+  root->name = nr_string_add(txn.trace_strings, "OtherTransaction/php__FILE__");
+  nr_segment_children_init(&root->children);
+  nr_segment_set_priority_flag(root, NR_SEGMENT_PRIORITY_ROOT);
+  txn.segment_root = root;
+
+  for (i = 0; i < count; i++) {
+    nr_segment_t* segment = nr_slab_next(txn.segment_slab);
+
+    segment->txn = &txn;
+    segment->start_time = i * 10 + 1;
+
+    if (0 == i % 8) {
+      segment->stop_time = (i + 8) * 10;
+      segment->name = nr_string_add(txn.trace_strings, "Custom/parent");
+      nr_segment_children_init(&segment->children);
+      nr_segment_add_child(root, segment);
+      parent = segment;
+    } else {
+      state = state * 1103515245 + 12345;
+      segment->stop_time = segment->start_time + 1 + (state >> 16) % 8;
+      segment->name = nr_string_add(txn.trace_strings, "Custom/child");
+      nr_segment_add_child(parent, segment);
+    }
+  }
+
+  txn.segment_count = count + 1;
+
+  result = nr_segment_tree_finalise(&txn, NR_TEST_SEGMENT_LARGE_TREE_LIMIT,
+                                    NR_TEST_SEGMENT_LARGE_TREE_LIMIT, NULL,
+                                    NULL);
+
+  expected_spans = count + 1;
+  if (expected_spans > NR_TEST_SEGMENT_LARGE_TREE_LIMIT) {
+    expected_spans = NR_TEST_SEGMENT_LARGE_TREE_LIMIT;
+  }
+
+  tlib_pass_if_not_null("large tree trace", result.trace_json);
+  tlib_pass_if_size_t_equal("large tree span events", expected_spans,
+                            nr_vector_size(result.span_events));
+  tlib_pass_if_time_equal("large tree total time", root->stop_time,
+                          result.total_time);
+
+  nr_txn_final_destroy_fields(&result);
+  nr_txn_destroy_fields(&txn);
+}
+
+static void test_finalise_large_tree(void) {
+  test_finalise_large_tree_size(1000);
+  test_finalise_large_tree_size(10000);
+}
+
+/*
+ * Add a random subtree of children to the given parent. The children of each
+ * parent are randomly either ordered and non-overlapping, as in synchronous
+ * code, or arbitrarily overlapping, and some of them are asynchronous.
+ */
+static void add_random_children(nrtxn_t* txn,
+                                nr_random_t* rnd,
+                                nr_segment_t* parent,
+                                int depth) {
+  size_t count = nr_random_range(rnd, 6);
+  bool ordered = (0 != nr_random_range(rnd, 3));
+  nrtime_t time = parent->start_time;
+  nrtime_t duration = nr_time_duration(parent->start_time, parent->stop_time);
+  size_t i;
+
+  if (depth <= 0 || 0 == duration) {
+    return;
+  }
+
+  nr_segment_children_init(&parent->children);
+
+  for (i = 0; i < count; i++) {
+    nr_segment_t* segment = nr_slab_next(txn->segment_slab);
+
+    segment->txn = txn;
+    if (ordered) {
+      segment->start_time = time + nr_random_range(rnd, duration / 8 + 1);
+      segment->stop_time
+          = segment->start_time + nr_random_range(rnd, duration / 4 + 1);
+      time = segment->stop_time;
+    } else {
+      segment->start_time = parent->start_time + nr_random_range(rnd, duration);
+      segment->stop_time
+          = segment->start_time + nr_random_range(rnd, duration / 2 + 1);
+    }
+    if (0 == nr_random_range(rnd, 8)) {
+      segment->async_context = 1 + (int)nr_random_range(rnd, 2);
+    } else {
+      segment->async_context = parent->async_context;
+    }
+
+    nr_segment_add_child(parent, segment);
+    txn->segment_count += 1;
+    add_random_children(txn, rnd, segment, depth - 1);
+  }
+}
+
+/*
+ * Calculate the total time of a tree using only the exclusive time structure.
+ */
+static nrtime_t reference_total_time(nr_segment_t* segment) {
+  size_t count = nr_segment_children_size(&segment->children);
+  nr_exclusive_time_t* et = nr_exclusive_time_create(
+      count, segment->start_time, segment->stop_time);
+  nrtime_t total_time = 0;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    nr_segment_t* child = nr_segment_children_get(&segment->children, i);
+
+    if (child->async_context == segment->async_context) {
+      nr_exclusive_time_add_child(et, child->start_time, child->stop_time);
+    }
+    total_time += reference_total_time(child);
+  }
+
+  total_time += nr_exclusive_time_calculate(et);
+  nr_exclusive_time_destroy(&et);
+
+  return total_time;
+}
+
+#define NR_TEST_RANDOM_TREES 200
+static void test_total_time_random_trees(void) {
+  nr_random_t* rnd = nr_random_create_from_seed(345345);
+  int round;
+
+  for (round = 0; round < NR_TEST_RANDOM_TREES; round++) {
+    nrtxn_t txn = {0};
+    nr_segment_t* root;
+    nrtime_t expected;
+    nr_segment_tree_to_heap_metadata_t metadata = {
+        .segments = NULL,
+        .total_time = 0,
+        .main_context = NULL,
+    };
+
+    txn.segment_slab = nr_slab_create(sizeof(nr_segment_t), 0);
+
+    root = nr_slab_next(txn.segment_slab);
+    root->txn = &txn;
+    root->start_time = 0;
+    root->stop_time = 100000;
+    txn.segment_root = root;
+    txn.segment_count = 1;
+    add_random_children(&txn, rnd, root, 5);
+
+    /*
+     * Test : Whichever way the exclusive time of each segment is calculated,
+     *        the total time must match the sort based calculation.
+     */
+    expected = reference_total_time(root);
+    nr_segment_tree_to_heap(root, &metadata);
+    tlib_pass_if_time_equal("random tree total time", expected,
+                            metadata.total_time);
+
+    nr_txn_destroy_fields(&txn);
+  }
+
+  nr_random_destroy(&rnd);
+}
+
 static void test_nearest_sampled_ancestor(void) {
   nr_set_t* set;
   nr_segment_t* ancestor = NULL;
@@ -1107,6 +1305,8 @@ void test_main(void* p NRUNUSED) {
   test_finalise_with_sampling();
   test_finalise_with_extended_sampling();
   test_finalise_span_priority();
+  test_finalise_large_tree();
+  test_total_time_random_trees();
   test_nearest_sampled_ancestor();
   test_nearest_sampled_ancestor_cycle();
 }
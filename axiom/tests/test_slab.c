@@ -230,11 +230,161 @@ static void test_count(void) {
   nr_slab_destroy(&slab);
 }
 
-tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
+static bool is_zeroed(const char* ptr, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; i++) {
+    if (ptr[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void test_page_cache(void) {
+  nr_slab_t* slab;
+  nr_slab_t* slabs[4];
+  size_t page_size;
+  char* chunk;
+  size_t i;
+
+  nr_slab_page_cache_clear();
+  tlib_pass_if_size_t_equal("an empty cache", 0, nr_slab_page_cache_size());
+
+  tlib_pass_if_size_t_equal("NULL slab hits", 0, nr_slab_page_cache_hits(NULL));
+  tlib_pass_if_size_t_equal("NULL slab misses", 0,
+                            nr_slab_page_cache_misses(NULL));
+
+  /*
+   * Test : A destroyed slab's pages are cached, and handed to the next slab
+   *        zeroed.
+   */
+  slab = nr_slab_create(64, 4096);
+  page_size = slab->page_size;
+  tlib_pass_if_size_t_equal("first slab hits", 0,
+                            nr_slab_page_cache_hits(slab));
+  tlib_pass_if_size_t_equal("first slab misses", 1,
+                            nr_slab_page_cache_misses(slab));
+  for (i = 0; i < 16; i++) {
+    chunk = (char*)nr_slab_next(slab);
+    nr_memset(chunk, 42, slab->object_size);
+  }
+  nr_slab_destroy(&slab);
+  tlib_pass_if_size_t_equal("the page is cached", page_size,
+                            nr_slab_page_cache_size());
+
+  slab = nr_slab_create(64, 4096);
+  tlib_pass_if_size_t_equal("second slab hits", 1,
+                            nr_slab_page_cache_hits(slab));
+  tlib_pass_if_size_t_equal("second slab misses", 0,
+                            nr_slab_page_cache_misses(slab));
+  tlib_pass_if_size_t_equal("the page is taken", 0, nr_slab_page_cache_size());
+  for (i = 0; i < 16; i++) {
+    chunk = (char*)nr_slab_next(slab);
+    tlib_pass_if_true("a reused page is zeroed",
+                      is_zeroed(chunk, slab->object_size), "i=%zu", i);
+  }
+  nr_slab_destroy(&slab);
+
+  /*
+   * Test : The largest cached page that is big enough is used, and the slab
+   *        carries on growing from its size.
+   */
+  nr_slab_page_cache_clear();
+  slab = nr_slab_create(64, 4 * page_size);
+  nr_slab_destroy(&slab);
+  slab = nr_slab_create(64, page_size);
+  tlib_pass_if_size_t_equal("a larger page is used", 1,
+                            nr_slab_page_cache_hits(slab));
+  tlib_pass_if_size_t_equal("the page size follows the page", 4 * page_size,
+                            slab->page_size);
+  tlib_pass_if_size_t_equal("the page capacity follows the page",
+                            4 * page_size - sizeof(nr_slab_page_t),
+                            slab->head->capacity);
+  nr_slab_destroy(&slab);
+
+  /*
+   * Test : Pages that are too small aren't used.
+   */
+  nr_slab_page_cache_clear();
+  slab = nr_slab_create(64, page_size);
+  nr_slab_destroy(&slab);
+  slab = nr_slab_create(64, 2 * page_size);
+  tlib_pass_if_size_t_equal("a smaller page is not used", 0,
+                            nr_slab_page_cache_hits(slab));
+  tlib_pass_if_size_t_equal("the smaller page stays cached", page_size,
+                            nr_slab_page_cache_size());
+  nr_slab_destroy(&slab);
+  tlib_pass_if_size_t_equal("both pages are cached", 3 * page_size,
+                            nr_slab_page_cache_size());
+
+  /*
+   * Test : The limit is enforced when pages are cached, and when it is
+   *        lowered.
+   */
+  nr_slab_page_cache_set_limit(2 * page_size);
+  tlib_pass_if_size_t_equal("lowering the limit trims the cache", 2 * page_size,
+                            nr_slab_page_cache_size());
+
+  nr_slab_page_cache_clear();
+  slab = nr_slab_create(64, 4 * page_size);
+  nr_slab_destroy(&slab);
+  tlib_pass_if_size_t_equal("pages over the limit are freed", 0,
+                            nr_slab_page_cache_size());
+
+  nr_slab_page_cache_set_limit(0);
+  slab = nr_slab_create(64, page_size);
+  nr_slab_destroy(&slab);
+  tlib_pass_if_size_t_equal("a zero limit disables the cache", 0,
+                            nr_slab_page_cache_size());
+
+  nr_slab_page_cache_set_limit(NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT);
+  nr_slab_page_cache_clear();
+
+  /*
+   * Test : Idle pages are trimmed back to the high-water mark at the end of
+   *        each interval.
+   */
+  for (i = 0; i < 4; i++) {
+    slab = nr_slab_create(64, page_size);
+    slabs[i] = slab;
+  }
+  for (i = 0; i < 4; i++) {
+    nr_slab_destroy(&slabs[i]);
+  }
+  tlib_pass_if_size_t_equal("a spike is cached", 4 * page_size,
+                            nr_slab_page_cache_size());
+
+  for (i = 4; i < NR_SLAB_PAGE_CACHE_TRIM_INTERVAL - 1; i++) {
+    slab = nr_slab_create(64, page_size);
+    nr_slab_destroy(&slab);
+  }
+  tlib_pass_if_size_t_equal("idle pages stay cached within the interval",
+                            4 * page_size, nr_slab_page_cache_size());
+
+  slab = nr_slab_create(64, page_size);
+  nr_slab_destroy(&slab);
+  tlib_pass_if_size_t_equal("idle pages are trimmed", page_size,
+                            nr_slab_page_cache_size());
+
+  slab = nr_slab_create(64, page_size);
+  tlib_pass_if_size_t_equal("the kept page is reused", 1,
+                            nr_slab_page_cache_hits(slab));
+  nr_slab_destroy(&slab);
+
+  nr_slab_page_cache_clear();
+}
+
+/*
+ * The page cache is process-wide, so the tests can't run in parallel.
+ */
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 1, .state_size = 0};
 
 void test_main(void* p NRUNUSED) {
   test_create_destroy();
   test_next();
   test_release();
   test_count();
+  test_page_cache();
 }
@@ -9,6 +9,7 @@
 #include "nr_span_encoding_private.h"
 #include "nr_span_event.h"
 #include "nr_span_event_private.h"
+#include "util_memory.h"
 #include "v1.pb-c.h"
 
 #include "tlib_main.h"
@@ -207,6 +208,74 @@ static void test_batch(void) {
 }
 #pragma GCC diagnostic pop
 
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+static void test_batch_with_context(void) {
+  Com__Newrelic__Trace__V1__SpanBatch* encoded;
+  nr_span_encoding_context_t* ctx = NULL;
+  nr_span_encoding_result_t result = NR_SPAN_ENCODING_RESULT_INIT;
+  nr_span_event_t* spans[2] = {nr_span_event_create(), nr_span_event_create()};
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_span_encoding_context_destroy(NULL);
+  nr_span_encoding_context_destroy(&ctx);
+  tlib_pass_if_bool_equal("NULL context", false,
+                          nr_span_encoding_batch_with_context_v1(
+                              NULL, (const nr_span_event_t**)spans, 2,
+                              &result));
+
+  /*
+   * Test : A context reused for successive batches encodes each of them.
+   */
+  ctx = nr_span_encoding_context_create();
+  tlib_pass_if_not_null("context", ctx);
+
+  nr_span_event_set_trace_id(spans[0], "abcdefgh");
+  nr_span_event_set_trace_id(spans[1], "01234567");
+  add_values(spans[0]->agent_attributes);
+  add_values(spans[1]->intrinsics);
+  add_values(spans[1]->user_attributes);
+
+  tlib_pass_if_bool_equal("first batch", true,
+                          nr_span_encoding_batch_with_context_v1(
+                              ctx, (const nr_span_event_t**)spans, 2,
+                              &result));
+  encoded = com__newrelic__trace__v1__span_batch__unpack(NULL, result.len,
+                                                         result.data);
+  tlib_pass_if_not_null("first batch can be unpacked", encoded);
+  tlib_pass_if_size_t_equal("first batch spans", 2, encoded->n_spans);
+  check_values(encoded->spans[0]->agent_attributes,
+               encoded->spans[0]->n_agent_attributes);
+  check_values(encoded->spans[1]->user_attributes,
+               encoded->spans[1]->n_user_attributes);
+  com__newrelic__trace__v1__span_batch__free_unpacked(encoded, NULL);
+  nr_span_encoding_result_deinit(&result);
+
+  tlib_pass_if_bool_equal("second batch", true,
+                          nr_span_encoding_batch_with_context_v1(
+                              ctx, (const nr_span_event_t**)&spans[1], 1,
+                              &result));
+  encoded = com__newrelic__trace__v1__span_batch__unpack(NULL, result.len,
+                                                         result.data);
+  tlib_pass_if_not_null("second batch can be unpacked", encoded);
+  tlib_pass_if_size_t_equal("second batch spans", 1, encoded->n_spans);
+  tlib_pass_if_str_equal("second batch trace ID", "01234567",
+                         encoded->spans[0]->trace_id);
+  check_values(encoded->spans[0]->intrinsics, encoded->spans[0]->n_intrinsics);
+  com__newrelic__trace__v1__span_batch__free_unpacked(encoded, NULL);
+  nr_span_encoding_result_deinit(&result);
+
+  nr_span_encoding_context_destroy(&ctx);
+  tlib_pass_if_null("destroy", ctx);
+
+  nr_span_event_destroy(&spans[0]);
+  nr_span_event_destroy(&spans[1]);
+}
+
+#pragma GCC diagnostic pop
+
 static void test_result_deinit(void) {
   nr_span_encoding_result_t result = NR_SPAN_ENCODING_RESULT_INIT;
 
@@ -310,6 +379,7 @@ tlib_parallel_info_t parallel_info = {.suggested_nthreads = 8, .state_size = 0};
 void test_main(void* p NRUNUSED) {
   test_single();
   test_batch();
+  test_batch_with_context();
   test_result_deinit();
   test_encode_attribute_value();
 }
\ No newline at end of file
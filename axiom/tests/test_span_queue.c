@@ -10,6 +10,7 @@
 #include "nr_span_queue.h"
 #include "nr_span_queue_private.h"
 #include "util_sleep.h"
+#include "util_threads.h"
 
 #include "tlib_main.h"
 
@@ -32,6 +33,34 @@ static bool success_handler(nr_span_encoding_result_t* result, void* count) {
   return true;
 }
 
+typedef struct _test_gate_t {
+  nrthread_mutex_t mutex;
+  nrthread_cond_t cond;
+  bool open;
+  uint64_t count;
+} test_gate_t;
+
+/*
+ * A handler that holds the encoder thread until the gate is opened.
+ */
+static bool gated_handler(nr_span_encoding_result_t* result, void* gate_ptr) {
+  test_gate_t* gate = (test_gate_t*)gate_ptr;
+
+  nrt_mutex_lock(&gate->mutex);
+  while (!gate->open) {
+    nrt_cond_wait(&gate->cond, &gate->mutex);
+  }
+  gate->count += 1;
+  nrt_mutex_unlock(&gate->mutex);
+
+  nr_span_encoding_result_deinit(result);
+  return true;
+}
+
+static void count_dtor(void* count) {
+  *(uint64_t*)count += 1;
+}
+
 static void test_create_destroy(void) {
   uint64_t flush_count = 0;
   nr_span_queue_t* queue = NULL;
@@ -41,14 +70,15 @@ static void test_create_destroy(void) {
    */
   tlib_pass_if_null(
       "0 batch size",
-      nr_span_queue_create(0, 1 * NR_TIME_DIVISOR_MS, success_handler, NULL));
+      nr_span_queue_create(0, 1 * NR_TIME_DIVISOR_MS, success_handler, NULL,
+                           NULL));
 
   tlib_pass_if_null("0 batch timeout",
-                    nr_span_queue_create(100, 0, success_handler, NULL));
+                    nr_span_queue_create(100, 0, success_handler, NULL, NULL));
 
   tlib_pass_if_null(
       "NULL batch handler",
-      nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, NULL, NULL));
+      nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, NULL, NULL, NULL));
 
   nr_span_queue_destroy(NULL);
   nr_span_queue_destroy(&queue);
@@ -57,11 +87,20 @@ static void test_create_destroy(void) {
    * Test : Normal operation.
    */
   queue = nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, success_handler,
-                               &flush_count);
+                               &flush_count, NULL);
   tlib_pass_if_not_null("valid queue", queue);
   nr_span_queue_destroy(&queue);
   tlib_pass_if_uint64_t_equal("destroying a queue does not automatically flush",
                               0, flush_count);
+
+  /*
+   * Test : The userdata destructor is called when the queue is freed.
+   */
+  queue = nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, success_handler,
+                               &flush_count, count_dtor);
+  nr_span_queue_destroy(&queue);
+  tlib_pass_if_null("destroyed queue", queue);
+  tlib_pass_if_uint64_t_equal("userdata destructor", 1, flush_count);
 }
 
 static void test_flush(void) {
@@ -78,7 +117,7 @@ static void test_flush(void) {
    */
   flush_count = 0;
   queue = nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, success_handler,
-                               &flush_count);
+                               &flush_count, NULL);
   tlib_pass_if_bool_equal("empty flush", true, nr_span_queue_flush(queue));
   tlib_pass_if_uint64_t_equal("empty flushes should not call the handler", 0,
                               flush_count);
@@ -89,21 +128,24 @@ static void test_flush(void) {
    */
   flush_count = 0;
   queue = nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, success_handler,
-                               &flush_count);
+                               &flush_count, NULL);
   nr_span_queue_push(queue, nr_span_event_create());
   tlib_pass_if_bool_equal("successful flush", true, nr_span_queue_flush(queue));
+  nr_span_queue_wait(queue);
   tlib_pass_if_uint64_t_equal(
       "successful flushes should invoke the handler once", 1, flush_count);
   nr_span_queue_destroy(&queue);
 
   /*
-   * Test : Failed flush.
+   * Test : Failed flush. The batch is handed off successfully; the failure is
+   *        only seen by the encoder thread.
    */
   flush_count = 0;
   queue = nr_span_queue_create(100, 1 * NR_TIME_DIVISOR_MS, failure_handler,
-                               &flush_count);
+                               &flush_count, NULL);
   nr_span_queue_push(queue, nr_span_event_create());
-  tlib_pass_if_bool_equal("failed flush", false, nr_span_queue_flush(queue));
+  tlib_pass_if_bool_equal("failed flush", true, nr_span_queue_flush(queue));
+  nr_span_queue_wait(queue);
   tlib_pass_if_uint64_t_equal("failed flushes should invoke the handler once",
                               1, flush_count);
   nr_span_queue_destroy(&queue);
@@ -113,7 +155,8 @@ static void test_push(void) {
   uint64_t flush_count = 0;
   size_t i;
   nr_span_queue_t* queue = nr_span_queue_create(10, 3 * NR_TIME_DIVISOR_MS,
-                                                failure_handler, &flush_count);
+                                                failure_handler, &flush_count,
+                                                NULL);
 
   /*
    * Test : Bad parameters.
@@ -124,29 +167,93 @@ static void test_push(void) {
 
   /*
    * Test : Batch capacity hit.
+   *
+   * The full batch and the eleventh span are both sent by the encoder thread.
    */
   for (i = 0; i < 11; i++) {
     tlib_pass_if_bool_equal(
         "successful push returns true, even if the handler doesn't", true,
         nr_span_queue_push(queue, nr_span_event_create()));
   }
-  tlib_pass_if_uint64_t_equal("queue should have been flushed once", 1,
-                              flush_count);
+  nr_span_queue_flush(queue);
+  nr_span_queue_wait(queue);
+  tlib_pass_if_uint64_t_equal(
+      "queue should have been flushed by the push and the flush", 2,
+      flush_count);
 
   /*
    * Test : Timeout hit.
    */
   flush_count = 0;
+  nr_span_queue_push(queue, nr_span_event_create());
   nr_msleep(3);
   tlib_pass_if_bool_equal("another push after the timeout should return true",
                           true,
                           nr_span_queue_push(queue, nr_span_event_create()));
+  nr_span_queue_flush(queue);
+  nr_span_queue_wait(queue);
   tlib_pass_if_uint64_t_equal(
-      "queue should have been flushed again by the timeout", 1, flush_count);
+      "queue should have been flushed again by the timeout", 2, flush_count);
+  tlib_pass_if_uint64_t_equal("no spans are dropped", 0,
+                              nr_span_queue_dropped_spans(queue));
 
   nr_span_queue_destroy(&queue);
 }
 
+static void test_encoder_behind(void) {
+  test_gate_t gate = {.open = false, .count = 0};
+  nr_span_queue_t* queue;
+  size_t i;
+
+  tlib_pass_if_uint64_t_equal("NULL queue", 0,
+                              nr_span_queue_dropped_spans(NULL));
+
+  nrt_mutex_init(&gate.mutex, NULL);
+  nrt_cond_init(&gate.cond);
+
+  /*
+   * Test : With one span per batch and the encoder held on the first batch,
+   *        pushes beyond the pending limit drop their batches rather than
+   *        blocking.
+   */
+  queue = nr_span_queue_create(1, 1 * NR_TIME_DIVISOR, gated_handler, &gate,
+                               NULL);
+  for (i = 0; i < NR_SPAN_QUEUE_MAX_PENDING_BATCHES + 6; i++) {
+    tlib_pass_if_bool_equal("push does not block", true,
+                            nr_span_queue_push(queue, nr_span_event_create()));
+  }
+  tlib_pass_if_uint64_t_equal("excess spans are dropped", 5,
+                              nr_span_queue_dropped_spans(queue));
+
+  nrt_mutex_lock(&gate.mutex);
+  gate.open = true;
+  nrt_cond_broadcast(&gate.cond);
+  nrt_mutex_unlock(&gate.mutex);
+
+  nr_span_queue_wait(queue);
+  nr_span_queue_flush(queue);
+  nr_span_queue_wait(queue);
+  tlib_pass_if_uint64_t_equal("pending batches and the current batch are sent",
+                              NR_SPAN_QUEUE_MAX_PENDING_BATCHES + 1,
+                              gate.count);
+
+  /*
+   * Test : Batches that were handed off are still sent after the queue is
+   *        destroyed, but the current batch isn't. Shutting the encoder down
+   *        waits for them.
+   */
+  gate.count = 0;
+  nr_span_queue_push(queue, nr_span_event_create());
+  nr_span_queue_push(queue, nr_span_event_create());
+  nr_span_queue_destroy(&queue);
+  nr_span_queue_encoder_shutdown();
+  tlib_pass_if_uint64_t_equal("destroy sends handed off batches", 1,
+                              gate.count);
+
+  nrt_cond_destroy(&gate.cond);
+  nrt_mutex_destroy(&gate.mutex);
+}
+
 tlib_parallel_info_t parallel_info
     = {.suggested_nthreads = -1, .state_size = 0};
 
@@ -154,4 +261,5 @@ void test_main(void* p NRUNUSED) {
   test_create_destroy();
   test_flush();
   test_push();
+  test_encoder_behind();
 }
@@ -341,6 +341,7 @@ static void test_synthetics_cross_agent_tests(void) {
       nr_free(outbound);
     }
 
+    nro_delete(txn->app_connect_reply);
     nr_txn_destroy(&txn);
   }
 
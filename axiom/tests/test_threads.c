@@ -20,6 +20,8 @@ typedef struct _test_threads_state_t {
   nrthread_mutex_t static_mutex;
   nrthread_mutex_t mutex;
   nrthread_mutex_t mutex1;
+  nrthread_cond_t cond;
+  int cond_flag;
 } test_threads_state_t;
 
 #define SLEEP_SCALE 4
@@ -80,6 +82,62 @@ static void test_static_mutex(test_threads_state_t* p) {
                     (int)rv);
 }
 
+static void* test_threads_cond_waiter(void* vp) {
+  test_threads_state_t* p = (test_threads_state_t*)vp;
+
+  nrt_mutex_lock(&p->mutex1);
+  while (1 != p->cond_flag) {
+    nrt_cond_wait(&p->cond, &p->mutex1);
+  }
+  p->cond_flag = 2;
+  nrt_cond_signal(&p->cond);
+  nrt_mutex_unlock(&p->mutex1);
+
+  return 0;
+}
+
+static void test_cond(test_threads_state_t* p) {
+  nr_status_t rv;
+  nrthread_t t;
+
+  rv = nrt_cond_init(&p->cond);
+  tlib_pass_if_true("cond init", NR_SUCCESS == rv, "rv=%d", (int)rv);
+  rv = nrt_mutex_init(&p->mutex1, 0);
+  tlib_pass_if_true("cond mutex init", NR_SUCCESS == rv, "rv=%d", (int)rv);
+
+  rv = nrt_cond_wait(NULL, &p->mutex1);
+  tlib_pass_if_true("NULL cond wait fails", NR_FAILURE == rv, "rv=%d", (int)rv);
+  rv = nrt_cond_signal(NULL);
+  tlib_pass_if_true("NULL cond signal fails", NR_FAILURE == rv, "rv=%d",
+                    (int)rv);
+  rv = nrt_cond_broadcast(NULL);
+  tlib_pass_if_true("NULL cond broadcast fails", NR_FAILURE == rv, "rv=%d",
+                    (int)rv);
+
+  /*
+   * Hand a flag to a waiting thread and wait for it to hand it back.
+   */
+  p->cond_flag = 0;
+  rv = nrt_create(&t, 0, test_threads_cond_waiter, p);
+  tlib_pass_if_true("cond thread create OK", NR_SUCCESS == rv, "rv=%d",
+                    (int)rv);
+
+  nrt_mutex_lock(&p->mutex1);
+  p->cond_flag = 1;
+  rv = nrt_cond_broadcast(&p->cond);
+  tlib_pass_if_true("cond broadcast", NR_SUCCESS == rv, "rv=%d", (int)rv);
+  while (2 != p->cond_flag) {
+    nrt_cond_wait(&p->cond, &p->mutex1);
+  }
+  nrt_mutex_unlock(&p->mutex1);
+  tlib_pass_if_int_equal("cond flag handed back", 2, p->cond_flag);
+
+  nrt_join(t, 0);
+  rv = nrt_cond_destroy(&p->cond);
+  tlib_pass_if_true("cond destroy", NR_SUCCESS == rv, "rv=%d", (int)rv);
+  nrt_mutex_destroy(&p->mutex1);
+}
+
 /*
  * The test itself is crafted to test parallelism.
  *
@@ -125,4 +183,9 @@ void test_main(void* vp) {
   tlib_pass_if_true("simple thread create OK", NR_SUCCESS == rv, "rv=%d",
                     (int)rv);
   nrt_join(t1, 0);
+
+  /*
+   * Test 6: signal a waiting thread through a condition variable.
+   */
+  test_cond(p);
 }
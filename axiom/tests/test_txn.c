@@ -34,6 +34,7 @@
 #include "util_random.h"
 #include "util_strings.h"
 #include "util_text.h"
+#include "util_threads.h"
 #include "util_url.h"
 #include "util_vector.h"
 
@@ -1672,6 +1673,220 @@ static void test_begin_bad_params(void) {
   nr_attribute_config_destroy(&config);
 }
 
+static void test_begin_snapshot(void) {
+  nrapp_t app;
+  nrtxnopt_t opts;
+  nr_txn_app_snapshot_t snapshot;
+  nr_app_connect_state_t* connect_state;
+  nrtxn_t* txn;
+
+  nr_memset(&app, 0, sizeof(app));
+  nr_memset(&opts, 0, sizeof(opts));
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_txn_snapshot_app(NULL, &app);
+  nr_txn_app_snapshot_destroy_fields(NULL);
+  tlib_pass_if_null("NULL snapshot",
+                    nr_txn_begin_snapshot(NULL, &opts, NULL, NULL));
+
+  nr_txn_snapshot_app(&snapshot, NULL);
+  tlib_pass_if_null("NULL app",
+                    nr_txn_begin_snapshot(&snapshot, &opts, NULL, NULL));
+  nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+  app.state = NR_APP_INVALID;
+  nr_txn_snapshot_app(&snapshot, &app);
+  tlib_pass_if_null("invalid app",
+                    nr_txn_begin_snapshot(&snapshot, &opts, NULL, NULL));
+  tlib_pass_if_null("invalid app guid", snapshot.guid);
+  nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+  /*
+   * Test : The transaction only depends on the snapshot, so the app can
+   *        change once the snapshot has been taken.
+   */
+  app.state = NR_APP_OK;
+  app.rnd = nr_random_create();
+  nr_random_seed(app.rnd, 345345);
+  app.agent_run_id = nr_strdup("12345678");
+  app.entity_name = nr_strdup("App Name");
+  app.info.license = nr_strdup("1234567890123456789012345678901234567890");
+  app.info.security_policies_token = nr_strdup("token");
+  app.connect_reply = nro_create_from_json("{\"apdex_t\":0.6}");
+  nr_app_harvest_init(&app.harvest, nr_get_time(), 3600 * NR_TIME_DIVISOR,
+                      10);
+
+  nr_txn_snapshot_app(&snapshot, &app);
+  tlib_pass_if_uint64_t_equal("snapshot counts a transaction", 1,
+                              app.harvest.transactions_seen);
+  tlib_pass_if_bool_equal("first transaction is sampled", true,
+                          snapshot.sampled);
+
+  nr_free(app.agent_run_id);
+  nro_delete(app.connect_reply);
+  app.state = NR_APP_INVALID;
+
+  nr_memset(&opts, 0, sizeof(opts));
+  txn = nr_txn_begin_snapshot(&snapshot, &opts, NULL, NULL);
+  tlib_pass_if_not_null("txn", txn);
+  tlib_pass_if_null("connect state moved", snapshot.connect_state);
+  tlib_pass_if_str_equal("agent run id", "12345678", txn->agent_run_id);
+  tlib_pass_if_str_equal("guid", snapshot.guid, nr_txn_get_guid(txn));
+  tlib_pass_if_time_equal("apdex", 600 * NR_TIME_DIVISOR_MS,
+                          txn->options.apdex_t);
+  tlib_pass_if_int_equal("lasp", 1, txn->lasp);
+  tlib_pass_if_bool_equal(
+      "sampled", true, nr_distributed_trace_is_sampled(txn->distributed_trace));
+  tlib_pass_if_ptr_equal("rnd", app.rnd, txn->rnd);
+
+  nr_txn_destroy(&txn);
+  nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+  /*
+   * Test : A published connect state is shared by reference with the
+   *        transaction, which keeps it when the app publishes a new one.
+   */
+  app.state = NR_APP_OK;
+  app.agent_run_id = nr_strdup("12345678");
+  app.connect_reply = nro_create_from_json("{\"apdex_t\":0.6}");
+  nr_app_publish_connect_state(&app);
+  connect_state = app.connect_state;
+
+  nr_txn_snapshot_app(&snapshot, &app);
+  tlib_pass_if_ptr_equal("shared connect state", connect_state,
+                         snapshot.connect_state);
+  tlib_pass_if_int_equal("connect state refcount", 2,
+                         connect_state->refcount);
+
+  txn = nr_txn_begin_snapshot(&snapshot, &opts, NULL, NULL);
+  tlib_pass_if_not_null("txn", txn);
+  tlib_pass_if_ptr_equal("txn connect state", connect_state,
+                         txn->app_connect_state);
+  tlib_pass_if_ptr_equal("txn connect reply", connect_state->connect_reply,
+                         txn->app_connect_reply);
+
+  nr_free(app.agent_run_id);
+  app.agent_run_id = nr_strdup("87654321");
+  nr_app_publish_connect_state(&app);
+  tlib_pass_if_true("new connect state", connect_state != app.connect_state,
+                    "connect_state=%p", (void*)connect_state);
+  tlib_pass_if_str_equal("txn connect state kept", "12345678",
+                         txn->app_connect_state->agent_run_id);
+  tlib_pass_if_time_equal("apdex", 600 * NR_TIME_DIVISOR_MS,
+                          txn->options.apdex_t);
+
+  nr_txn_destroy(&txn);
+  nr_txn_app_snapshot_destroy_fields(&snapshot);
+  nr_app_connect_state_release(&app.connect_state);
+  nr_free(app.agent_run_id);
+  nro_delete(app.connect_reply);
+  nr_free(app.entity_name);
+  nr_free(app.info.license);
+  nr_free(app.info.security_policies_token);
+  nr_random_destroy(&app.rnd);
+}
+
+#define BEGIN_STRESS_THREADS 8
+#define BEGIN_STRESS_TXNS 500
+
+typedef struct _begin_stress_state_t {
+  nrapp_t* app;
+  int txns;
+  int sampled;
+} begin_stress_state_t;
+
+/*
+ * Begins transactions the way nr_php_txn_begin() does: the app is only locked
+ * while the snapshot is taken.
+ */
+static void* begin_stress_thread(void* arg) {
+  begin_stress_state_t* state = (begin_stress_state_t*)arg;
+  nrtxnopt_t opts;
+  int i;
+
+  nr_memset(&opts, 0, sizeof(opts));
+
+  for (i = 0; i < BEGIN_STRESS_TXNS; i++) {
+    nr_txn_app_snapshot_t snapshot;
+    nrtxn_t* txn;
+
+    nrt_mutex_lock(&state->app->app_lock);
+    nr_txn_snapshot_app(&snapshot, state->app);
+    nrt_mutex_unlock(&state->app->app_lock);
+
+    txn = nr_txn_begin_snapshot(&snapshot, &opts, NULL, NULL);
+    nr_txn_app_snapshot_destroy_fields(&snapshot);
+
+    if (txn && 0 == nr_strcmp("12345678", txn->agent_run_id)) {
+      state->txns += 1;
+      if (nr_distributed_trace_is_sampled(txn->distributed_trace)) {
+        state->sampled += 1;
+      }
+    }
+    nr_txn_destroy(&txn);
+  }
+
+  return NULL;
+}
+
+static void test_begin_snapshot_threads(void) {
+  nrapp_t app;
+  nrthread_t threads[BEGIN_STRESS_THREADS];
+  begin_stress_state_t states[BEGIN_STRESS_THREADS];
+  int txns = 0;
+  int sampled = 0;
+  int i;
+
+  nr_memset(&app, 0, sizeof(app));
+  app.state = NR_APP_OK;
+  app.rnd = nr_random_create();
+  nr_random_seed(app.rnd, 345345);
+  app.agent_run_id = nr_strdup("12345678");
+  app.connect_reply = nro_new_hash();
+  nr_app_harvest_init(&app.harvest, nr_get_time(), 3600 * NR_TIME_DIVISOR,
+                      10);
+  nr_app_publish_connect_state(&app);
+  nrt_mutex_init(&app.app_lock, NULL);
+
+  /*
+   * Test : Transactions begun concurrently from snapshots see a consistent
+   *        app: every transaction is counted for harvest sampling, exactly
+   *        the sampling target is sampled in the first harvest, and every
+   *        reference to the shared connect state is released.
+   */
+  for (i = 0; i < BEGIN_STRESS_THREADS; i++) {
+    states[i].app = &app;
+    states[i].txns = 0;
+    states[i].sampled = 0;
+    tlib_pass_if_status_success(
+        "begin thread create",
+        nrt_create(&threads[i], NULL, begin_stress_thread, &states[i]));
+  }
+
+  for (i = 0; i < BEGIN_STRESS_THREADS; i++) {
+    nrt_join(threads[i], NULL);
+    txns += states[i].txns;
+    sampled += states[i].sampled;
+  }
+
+  tlib_pass_if_int_equal("begun txns", BEGIN_STRESS_THREADS * BEGIN_STRESS_TXNS,
+                         txns);
+  tlib_pass_if_uint64_t_equal("txns seen",
+                              BEGIN_STRESS_THREADS * BEGIN_STRESS_TXNS,
+                              app.harvest.transactions_seen);
+  tlib_pass_if_int_equal("sampled txns", 10, sampled);
+  tlib_pass_if_int_equal("connect state refcount", 1,
+                         app.connect_state->refcount);
+
+  nrt_mutex_destroy(&app.app_lock);
+  nr_app_connect_state_release(&app.connect_state);
+  nr_free(app.agent_run_id);
+  nro_delete(app.connect_reply);
+  nr_random_destroy(&app.rnd);
+}
+
 static void test_begin(void) {
   nrtxn_t* rv;
   nrtxnopt_t optsv;
@@ -6099,6 +6314,7 @@ static void test_accept_before_create_distributed_tracing(void) {
                     nr_strstr(text, "\"tr\":\"3221bf09aa0bcf0d\""));
   nr_free(text);
   nr_hashmap_destroy(&header_map);
+  nro_delete(txn.app_connect_reply);
   nr_txn_destroy_fields(&txn);
 }
 
@@ -6778,6 +6994,7 @@ static void test_txn_accept_distributed_trace_payload_w3c(void) {
                      "CreateBeforeAccept",
                      1, 0, 0, 0, 0, 0);
 
+  nro_delete(txn.app_connect_reply);
   nr_txn_destroy_fields(&txn);
   nr_hashmap_destroy(&headers);
 }
@@ -6862,6 +7079,7 @@ static void test_txn_accept_distributed_trace_payload_w3c_and_nr(void) {
                      "Supportability/TraceContext/Accept/Success", 1, 0, 0, 0,
                      0, 0);
 
+  nro_delete(txn.app_connect_reply);
   nr_txn_destroy_fields(&txn);
   nr_hashmap_destroy(&headers);
 }
@@ -7182,6 +7400,7 @@ static void test_txn_accept_distributed_trace_payload(void) {
   nr_hashmap_destroy(&map_empty);
   nr_hashmap_destroy(&map_no_nr_headers);
   nr_hashmap_destroy(&map_mixed_headers);
+  nro_delete(txn.app_connect_reply);
   nr_txn_destroy_fields(&txn);
 }
 
@@ -7299,7 +7518,8 @@ static bool null_batch_handler(nr_span_encoding_result_t* result, void* count) {
 static void test_should_create_span_events(void) {
   nrtxn_t txn;
   nr_span_queue_t* queue = nr_span_queue_create(1000, 1 * NR_TIME_DIVISOR,
-                                                null_batch_handler, NULL);
+                                                null_batch_handler, NULL,
+                                                NULL);
 
   const struct {
     bool distributed_tracing_enabled;
@@ -8038,9 +8258,11 @@ static void test_span_queue(void) {
   nr_span_queue_destroy(&txn->span_queue);
   txn->span_queue = nr_span_queue_create(opts.span_queue_batch_size,
                                          opts.span_queue_batch_timeout,
-                                         null_batch_handler, &batch_count);
+                                         null_batch_handler, &batch_count,
+                                         NULL);
 
   nr_txn_end(txn);
+  nr_span_queue_wait(txn->span_queue);
   tlib_pass_if_uint64_t_equal(
       "a batch must be sent at the end of a transaction", 1, batch_count);
 
@@ -8392,6 +8614,45 @@ static void test_record_log_event(void) {
                      "Logging/Forwarding/Dropped", 2, 0, 0, 0, 0, 0);
   nr_txn_destroy(&txn);
 
+  /* Sampling skips building events that would be discarded */
+  txn = new_txn_for_record_log_event_test(APP_ENTITY_NAME);
+  for (int i = 0, max_events = nr_log_events_max_events(txn->log_events);
+       i < max_events; i++) {
+    nr_txn_record_log_event(txn, LOG_EVENT_PARAMS, NULL, &appv);
+  }
+  tlib_pass_if_false(
+      "older event not admitted",
+      nr_txn_log_event_is_admitted(txn, LOG_LEVEL,
+                                   LOG_TIMESTAMP * NR_TIME_DIVISOR_MS - 1),
+      "expected false");
+  tlib_pass_if_true(
+      "newer event admitted",
+      nr_txn_log_event_is_admitted(txn, LOG_LEVEL,
+                                   LOG_TIMESTAMP * NR_TIME_DIVISOR_MS + 1),
+      "expected true");
+  tlib_pass_if_false(
+      "filtered level not admitted",
+      nr_txn_log_event_is_admitted(txn, LL_DEBU_STR,
+                                   LOG_TIMESTAMP * NR_TIME_DIVISOR_MS + 1),
+      "expected false");
+  tlib_pass_if_false("NULL txn not admitted",
+                     nr_txn_log_event_is_admitted(NULL, LOG_LEVEL, 0),
+                     "expected false");
+
+  nr_txn_record_log_event(txn, LOG_LEVEL, LOG_MESSAGE,
+                          LOG_TIMESTAMP * NR_TIME_DIVISOR_MS - 1,
+                          nr_attributes_create(NULL), &appv);
+  tlib_pass_if_size_t_equal("skipped event seen",
+                            nr_log_events_max_events(txn->log_events) + 1,
+                            nr_log_events_number_seen(txn->log_events));
+  tlib_pass_if_size_t_equal("skipped event not saved",
+                            nr_log_events_max_events(txn->log_events),
+                            nr_log_events_number_saved(txn->log_events));
+  test_txn_metric_is("skipped event dropped", txn->unscoped_metrics,
+                     MET_FORCED, "Logging/Forwarding/Dropped", 1, 0, 0, 0, 0,
+                     0);
+  nr_txn_destroy(&txn);
+
   /* Happy path with log events pool size of 0 */
   txn = new_txn_for_record_log_event_test(APP_ENTITY_NAME);
   /* Force pool size of 0 */
@@ -8651,9 +8912,9 @@ static void test_nr_txn_add_php_package(void) {
   json = nr_php_packages_to_json(txn->php_packages);
 
   tlib_pass_if_str_equal("correct json",
-                         "[[\"Laravel\",\"8.83.27\",{}],"
-                         "[\"Drupal\",\" \",{}],[\"Wordpress\",\" \",{}],"
-                         "[\"Slim\",\"4.12.0\",{}]]",
+                         "[[\"Wordpress\",\" \",{}],[\"Drupal\",\" \",{}],"
+                         "[\"Slim\",\"4.12.0\",{}],"
+                         "[\"Laravel\",\"8.83.27\",{}]]",
                          json);
 
   nr_free(json);
@@ -8701,9 +8962,9 @@ static void test_nr_txn_add_php_package_from_source(void) {
   json = nr_php_packages_to_json(txn->php_packages);
 
   tlib_pass_if_str_equal("correct json",
-                         "[[\"Laravel\",\"8.83.27\",{}],"
-                         "[\"Drupal\",\" \",{}],[\"Wordpress\",\" \",{}],"
-                         "[\"Slim\",\"4.12.0\",{}]]",
+                         "[[\"Wordpress\",\" \",{}],[\"Drupal\",\" \",{}],"
+                         "[\"Slim\",\"4.12.0\",{}],"
+                         "[\"Laravel\",\"8.83.27\",{}]]",
                          json);
 
   nr_free(json);
@@ -8768,9 +9029,9 @@ static void test_nr_txn_suggest_package_supportability_metric(void) {
       txn->php_package_major_version_metrics_suggestions);
 
   tlib_pass_if_str_equal("correct json",
-                         "[[\"Laravel\",\"8.83.27\",{}],"
-                         "[\"Drupal\",\" \",{}],[\"Wordpress\",\" \",{}],"
-                         "[\"Slim\",\"4.12.0\",{}]]",
+                         "[[\"Wordpress\",\" \",{}],[\"Drupal\",\" \",{}],"
+                         "[\"Slim\",\"4.12.0\",{}],"
+                         "[\"Laravel\",\"8.83.27\",{}]]",
                          json);
 
   nr_free(json);
@@ -8799,6 +9060,8 @@ void test_main(void* p NRUNUSED) {
   test_record_error_worthy();
   test_record_error();
   test_begin_bad_params();
+  test_begin_snapshot();
+  test_begin_snapshot_threads();
   test_begin();
   test_end();
   test_should_force_persist();
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include "nr_txn_finaliser.h"
+#include "util_memory.h"
+#include "util_threads.h"
+
+#include "tlib_main.h"
+
+typedef struct _test_finaliser_state_t {
+  nrthread_mutex_t mutex;
+  nrthread_cond_t cond;
+  bool gate_open;  /* Whether finalisation may proceed */
+  int started;     /* The number of transactions the worker has started */
+  int finalised;   /* The number of transactions the worker has finalised */
+  bool rnd_is_set; /* Whether every transaction had a random generator */
+} test_finaliser_state_t;
+
+static void test_finaliser_func(nrtxn_t* txn, void* userdata) {
+  test_finaliser_state_t* state = (test_finaliser_state_t*)userdata;
+
+  nrt_mutex_lock(&state->mutex);
+  state->started += 1;
+  nrt_cond_broadcast(&state->cond);
+  while (!state->gate_open) {
+    nrt_cond_wait(&state->cond, &state->mutex);
+  }
+  state->finalised += 1;
+  state->rnd_is_set = state->rnd_is_set && (NULL != txn->rnd);
+  nrt_mutex_unlock(&state->mutex);
+}
+
+static void test_finaliser_state_init(test_finaliser_state_t* state,
+                                      bool gate_open) {
+  nrt_mutex_init(&state->mutex, NULL);
+  nrt_cond_init(&state->cond);
+  state->gate_open = gate_open;
+  state->started = 0;
+  state->finalised = 0;
+  state->rnd_is_set = true;
+}
+
+static void test_finaliser_state_destroy(test_finaliser_state_t* state) {
+  nrt_cond_destroy(&state->cond);
+  nrt_mutex_destroy(&state->mutex);
+}
+
+static nrtxn_t* test_txn_create(void) {
+  return (nrtxn_t*)nr_zalloc(sizeof(nrtxn_t));
+}
+
+static void test_bad_parameters(void) {
+  test_finaliser_state_t state;
+  nr_txn_finaliser_t* finaliser = NULL;
+  nrtxn_t* txn = NULL;
+
+  test_finaliser_state_init(&state, true);
+
+  tlib_pass_if_null("NULL func",
+                    nr_txn_finaliser_create(1, NULL, (void*)&state));
+  tlib_pass_if_null("zero max pending",
+                    nr_txn_finaliser_create(0, test_finaliser_func, &state));
+
+  tlib_pass_if_bool_equal("NULL finaliser", false,
+                          nr_txn_finaliser_submit(NULL, &txn));
+  tlib_pass_if_bool_equal("NULL finaliser is not owned", false,
+                          nr_txn_finaliser_is_owned(NULL));
+  nr_txn_finaliser_drain(NULL);
+  nr_txn_finaliser_destroy(NULL);
+  nr_txn_finaliser_destroy(&finaliser);
+
+  finaliser = nr_txn_finaliser_create(1, test_finaliser_func, &state);
+  tlib_pass_if_not_null("create", finaliser);
+  tlib_pass_if_bool_equal("owned", true, nr_txn_finaliser_is_owned(finaliser));
+  tlib_pass_if_bool_equal("NULL txn pointer", false,
+                          nr_txn_finaliser_submit(finaliser, NULL));
+  tlib_pass_if_bool_equal("NULL txn", false,
+                          nr_txn_finaliser_submit(finaliser, &txn));
+  nr_txn_finaliser_destroy(&finaliser);
+  tlib_pass_if_null("destroy", finaliser);
+
+  test_finaliser_state_destroy(&state);
+}
+
+static void test_submit(void) {
+  test_finaliser_state_t state;
+  nr_txn_finaliser_t* finaliser;
+  int i;
+
+  test_finaliser_state_init(&state, true);
+  finaliser = nr_txn_finaliser_create(16, test_finaliser_func, &state);
+
+  for (i = 0; i < 10; i++) {
+    nrtxn_t* txn = test_txn_create();
+
+    tlib_pass_if_bool_equal("submit", true,
+                            nr_txn_finaliser_submit(finaliser, &txn));
+    tlib_pass_if_null("ownership is taken", txn);
+  }
+
+  nr_txn_finaliser_drain(finaliser);
+  tlib_pass_if_int_equal("every txn is finalised", 10, state.finalised);
+  tlib_pass_if_bool_equal("every txn has a random generator", true,
+                          state.rnd_is_set);
+
+  nr_txn_finaliser_destroy(&finaliser);
+  test_finaliser_state_destroy(&state);
+}
+
+static void test_full(void) {
+  test_finaliser_state_t state;
+  nr_txn_finaliser_t* finaliser;
+  nrtxn_t* first = test_txn_create();
+  nrtxn_t* second = test_txn_create();
+  nrtxn_t* third = test_txn_create();
+
+  test_finaliser_state_init(&state, false);
+  finaliser = nr_txn_finaliser_create(1, test_finaliser_func, &state);
+
+  /*
+   * Wait until the worker is busy with the first transaction, so that the
+   * second one fills the queue.
+   */
+  tlib_pass_if_bool_equal("submit first", true,
+                          nr_txn_finaliser_submit(finaliser, &first));
+  nrt_mutex_lock(&state.mutex);
+  while (0 == state.started) {
+    nrt_cond_wait(&state.cond, &state.mutex);
+  }
+  nrt_mutex_unlock(&state.mutex);
+
+  tlib_pass_if_bool_equal("submit second", true,
+                          nr_txn_finaliser_submit(finaliser, &second));
+  tlib_pass_if_bool_equal("submit to a full finaliser", false,
+                          nr_txn_finaliser_submit(finaliser, &third));
+  tlib_pass_if_not_null("ownership is kept when refused", third);
+
+  nrt_mutex_lock(&state.mutex);
+  state.gate_open = true;
+  nrt_cond_broadcast(&state.cond);
+  nrt_mutex_unlock(&state.mutex);
+
+  nr_txn_finaliser_drain(finaliser);
+  tlib_pass_if_int_equal("accepted txns are finalised", 2, state.finalised);
+
+  tlib_pass_if_bool_equal("submit after draining", true,
+                          nr_txn_finaliser_submit(finaliser, &third));
+
+  /*
+   * Destroying the finaliser finalises any transactions still waiting.
+   */
+  nr_txn_finaliser_destroy(&finaliser);
+  tlib_pass_if_int_equal("destroy finalises waiting txns", 3,
+                         state.finalised);
+
+  test_finaliser_state_destroy(&state);
+}
+
+tlib_parallel_info_t parallel_info = {.suggested_nthreads = 2, .state_size = 0};
+
+void test_main(void* p NRUNUSED) {
+  test_bad_parameters();
+  test_submit();
+  test_full();
+}
@@ -629,6 +629,139 @@ static void test_sort(void) {
   nr_vector_deinit(&v);
 }
 
+static int uintptr_cmp_plain(const void* a,
+                             const void* b,
+                             void* userdata NRUNUSED) {
+  if ((uintptr_t)a < (uintptr_t)b) {
+    return -1;
+  } else if ((uintptr_t)a > (uintptr_t)b) {
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Checks every possible selection position of a vector built from the given
+ * values, against the fully sorted values.
+ */
+static void test_select_values(const char* testname,
+                               const uintptr_t* values,
+                               size_t count) {
+  nr_vector_t sorted;
+  nr_vector_t v;
+  size_t i;
+  size_t pos;
+
+  nr_vector_init(&sorted, count, NULL, NULL);
+  for (i = 0; i < count; i++) {
+    nr_vector_push_back(&sorted, (void*)values[i]);
+  }
+  nr_vector_sort(&sorted, uintptr_cmp_plain, NULL);
+
+  for (pos = 0; pos < count; pos++) {
+    void* element;
+    uintptr_t selected;
+    bool partitioned = true;
+
+    nr_vector_init(&v, count, NULL, NULL);
+    for (i = 0; i < count; i++) {
+      nr_vector_push_back(&v, (void*)values[i]);
+    }
+
+    tlib_pass_if_bool_equal(testname, true,
+                            nr_vector_select(&v, pos, uintptr_cmp_plain, NULL));
+
+    element = nr_vector_get(&v, pos);
+    selected = (uintptr_t)element;
+    element = nr_vector_get(&sorted, pos);
+    tlib_pass_if_uintptr_t_equal(testname, (uintptr_t)element, selected);
+
+    for (i = 0; i < count; i++) {
+      uintptr_t value;
+
+      element = nr_vector_get(&v, i);
+      value = (uintptr_t)element;
+
+      if ((i < pos && value > selected) || (i > pos && value < selected)) {
+        partitioned = false;
+      }
+    }
+    tlib_pass_if_true(testname, partitioned, "pos=%zu", pos);
+
+    nr_vector_deinit(&v);
+  }
+
+  nr_vector_deinit(&sorted);
+}
+
+static void test_select(void) {
+  uintptr_t values[64];
+  uint32_t state = 1;
+  size_t i;
+  void* element;
+  nr_vector_t v;
+
+  /*
+   * Test : Bad parameters.
+   */
+  nr_vector_init(&v, 8, NULL, NULL);
+  tlib_pass_if_bool_equal("selecting in a NULL vector should fail", false,
+                          nr_vector_select(NULL, 0, uintptr_cmp_plain, NULL));
+  tlib_pass_if_bool_equal("selecting with a NULL comparator should fail",
+                          false, nr_vector_select(&v, 0, NULL, NULL));
+  tlib_pass_if_bool_equal("selecting in an empty vector should fail", false,
+                          nr_vector_select(&v, 0, uintptr_cmp_plain, NULL));
+  nr_vector_push_back(&v, (void*)1);
+  tlib_pass_if_bool_equal(
+      "selecting beyond the end of a vector should fail", false,
+      nr_vector_select(&v, 1, uintptr_cmp_plain, NULL));
+
+  /*
+   * Test : Userdata is passed to the comparator.
+   */
+  nr_vector_push_back(&v, (void*)0);
+  expected_sort_userdata = 42;
+  tlib_pass_if_bool_equal("selecting in a vector should succeed", true,
+                          nr_vector_select(&v, 0, uintptr_cmp, (void*)42));
+  element = nr_vector_get(&v, 0);
+  tlib_pass_if_uintptr_t_equal("selected value should match", 0,
+                               (uintptr_t)element);
+  nr_vector_deinit(&v);
+
+  /*
+   * Test : Normal operation.
+   */
+  values[0] = 7;
+  test_select_values("single element", values, 1);
+
+  for (i = 0; i < 64; i++) {
+    values[i] = i;
+  }
+  test_select_values("ascending", values, 64);
+
+  for (i = 0; i < 64; i++) {
+    values[i] = 64 - i;
+  }
+  test_select_values("descending", values, 64);
+
+  for (i = 0; i < 64; i++) {
+    values[i] = 5;
+  }
+  test_select_values("all equal", values, 64);
+
+  for (i = 0; i < 64; i++) {
+    state = state * 1103515245 + 12345;
+    values[i] = (state >> 16) % 8;
+  }
+  test_select_values("many duplicates", values, 64);
+
+  for (i = 0; i < 64; i++) {
+    state = state * 1103515245 + 12345;
+    values[i] = state >> 8;
+  }
+  test_select_values("random", values, 63);
+}
+
 typedef struct {
   uintptr_t calls;
   uintptr_t limit;
@@ -840,6 +973,7 @@ void test_main(void* p NRUNUSED) {
   test_get_element();
   test_replace();
   test_sort();
+  test_select();
   test_iterate();
   test_find();
 }
@@ -0,0 +1,205 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include "util_arena.h"
+#include "util_memory.h"
+
+/*
+ * As with the slab allocator, all architectures we support align on 16 byte
+ * boundaries.
+ */
+#define NR_ARENA_ALIGNMENT 16
+#define NR_ARENA_ALIGN(S) \
+  (((S) + (NR_ARENA_ALIGNMENT - 1)) & ~((size_t)NR_ARENA_ALIGNMENT - 1))
+
+/*
+ * A page within the arena. The usable memory follows the header, which is
+ * padded to keep it aligned.
+ */
+typedef struct _nr_arena_page_t {
+  struct _nr_arena_page_t* next;
+  size_t capacity;
+  size_t used;
+} nr_arena_page_t;
+
+#define NR_ARENA_PAGE_HEADER_SIZE NR_ARENA_ALIGN(sizeof(nr_arena_page_t))
+
+/*
+ * Pages are kept in allocation order. Allocations are made from the current
+ * page; pages after it are either empty or were skipped because an allocation
+ * didn't fit, and will be used again after a reset.
+ */
+struct _nr_arena_t {
+  nr_arena_page_t* first;
+  nr_arena_page_t* current;
+  nr_arena_page_t* last;
+  size_t page_size;
+};
+
+static nr_arena_page_t* nr_arena_page_create(size_t capacity) {
+  nr_arena_page_t* page
+      = (nr_arena_page_t*)nr_malloc(NR_ARENA_PAGE_HEADER_SIZE + capacity);
+
+  page->next = NULL;
+  page->capacity = capacity;
+  page->used = 0;
+
+  return page;
+}
+
+static char* nr_arena_page_data(nr_arena_page_t* page) {
+  return ((char*)page) + NR_ARENA_PAGE_HEADER_SIZE;
+}
+
+nr_arena_t* nr_arena_create(size_t page_size) {
+  nr_arena_t* arena;
+
+  if (0 == page_size) {
+    long sys_page_size = sysconf(_SC_PAGESIZE);
+
+    /*
+     * Four system pages, less the page header, so that the allocation itself
+     * is a multiple of the system page size.
+     */
+    page_size = 4 * (size_t)((sys_page_size > 0) ? sys_page_size : 4096)
+                - NR_ARENA_PAGE_HEADER_SIZE;
+  }
+
+  arena = (nr_arena_t*)nr_malloc(sizeof(nr_arena_t));
+  arena->page_size = NR_ARENA_ALIGN(page_size);
+  arena->first = nr_arena_page_create(arena->page_size);
+  arena->current = arena->first;
+  arena->last = arena->first;
+
+  return arena;
+}
+
+void nr_arena_destroy(nr_arena_t** arena_ptr) {
+  nr_arena_page_t* page;
+
+  if (NULL == arena_ptr || NULL == *arena_ptr) {
+    return;
+  }
+
+  page = (*arena_ptr)->first;
+  while (page) {
+    nr_arena_page_t* next = page->next;
+
+    nr_free(page);
+    page = next;
+  }
+
+  nr_realfree((void**)arena_ptr);
+}
+
+void* nr_arena_alloc(nr_arena_t* arena, size_t size) {
+  nr_arena_page_t* page;
+  void* ptr;
+
+  if (nrunlikely(NULL == arena)) {
+    return NULL;
+  }
+
+  if (nrunlikely(size > SIZE_MAX - NR_ARENA_ALIGNMENT)) {
+    return NULL;
+  }
+  size = NR_ARENA_ALIGN(size ? size : 1);
+
+  /*
+   * Find the first page from the current one that has room, reusing pages
+   * kept from before the last reset where possible.
+   */
+  page = arena->current;
+  while (page && (page->capacity - page->used) < size) {
+    page = page->next;
+  }
+
+  if (NULL == page) {
+    /*
+     * Allocations larger than the page size get a page of their own, which
+     * will be reused for other allocations after a reset.
+     */
+    page = nr_arena_page_create((size > arena->page_size) ? size
+                                                          : arena->page_size);
+    arena->last->next = page;
+    arena->last = page;
+  }
+
+  arena->current = page;
+  ptr = nr_arena_page_data(page) + page->used;
+  page->used += size;
+
+  return ptr;
+}
+
+void* nr_arena_alloc_array(nr_arena_t* arena, size_t nmemb, size_t size) {
+  if (0 != size && nmemb > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  return nr_arena_alloc(arena, nmemb * size);
+}
+
+void nr_arena_reset(nr_arena_t* arena) {
+  nr_arena_page_t* page;
+
+  if (NULL == arena) {
+    return;
+  }
+
+  for (page = arena->first; page; page = page->next) {
+    page->used = 0;
+  }
+  arena->current = arena->first;
+}
+
+void nr_arena_trim(nr_arena_t* arena, size_t max_capacity) {
+  nr_arena_page_t* page;
+  size_t capacity;
+
+  if (NULL == arena) {
+    return;
+  }
+
+  nr_arena_reset(arena);
+
+  page = arena->first;
+  capacity = page->capacity;
+  while (page->next && capacity <= max_capacity
+         && page->next->capacity <= max_capacity - capacity) {
+    page = page->next;
+    capacity += page->capacity;
+  }
+  arena->last = page;
+
+  page = page->next;
+  arena->last->next = NULL;
+  while (page) {
+    nr_arena_page_t* next = page->next;
+
+    nr_free(page);
+    page = next;
+  }
+}
+
+size_t nr_arena_capacity(const nr_arena_t* arena) {
+  const nr_arena_page_t* page;
+  size_t capacity = 0;
+
+  if (NULL == arena) {
+    return 0;
+  }
+
+  for (page = arena->first; page; page = page->next) {
+    capacity += page->capacity;
+  }
+
+  return capacity;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Functions related to bump allocation of short lived, heterogeneous objects.
+ *
+ * An arena hands out memory from large pages by advancing a cursor. Individual
+ * allocations can't be freed: instead, the whole arena is reset once all of its
+ * objects are finished with, and its pages are reused by later allocations.
+ */
+#ifndef UTIL_ARENA_HDR
+#define UTIL_ARENA_HDR
+
+#include <stddef.h>
+
+typedef struct _nr_arena_t nr_arena_t;
+
+/*
+ * Purpose : Create an arena.
+ *
+ * Params  : 1. The default page size, or 0 to use a default based on the
+ *              system page size.
+ *
+ * Returns : A new arena, which must be destroyed with nr_arena_destroy().
+ */
+extern nr_arena_t* nr_arena_create(size_t page_size);
+
+/*
+ * Purpose : Destroy an arena, freeing every allocation made from it.
+ *
+ * Params  : 1. A pointer to the arena to destroy.
+ */
+extern void nr_arena_destroy(nr_arena_t** arena_ptr);
+
+/*
+ * Purpose : Allocate memory from an arena.
+ *
+ * Params  : 1. The arena.
+ *           2. The number of bytes to allocate.
+ *
+ * Returns : A pointer to the memory, aligned on a 16 byte boundary, or NULL
+ *           on error. The memory is not zeroed, and remains valid until the
+ *           arena is reset or destroyed.
+ */
+extern void* nr_arena_alloc(nr_arena_t* arena, size_t size);
+
+/*
+ * Purpose : Allocate memory for an array from an arena.
+ *
+ * Params  : 1. The arena.
+ *           2. The number of elements.
+ *           3. The size of each element.
+ *
+ * Returns : A pointer to the memory, as for nr_arena_alloc(), or NULL on error
+ *           or overflow.
+ */
+extern void* nr_arena_alloc_array(nr_arena_t* arena,
+                                  size_t nmemb,
+                                  size_t size);
+
+/*
+ * Purpose : Reset an arena, invalidating every allocation made from it.
+ *
+ *           The arena keeps its pages, so that allocations made after the
+ *           reset don't need to allocate memory until they exceed the total
+ *           allocated before it.
+ *
+ * Params  : 1. The arena.
+ */
+extern void nr_arena_reset(nr_arena_t* arena);
+
+/*
+ * Purpose : Reset an arena, and free the pages that take its capacity beyond
+ *           a limit.
+ *
+ *           Pages are kept in allocation order, so the arena keeps the pages
+ *           that fit within the limit and frees the rest. The first page is
+ *           always kept.
+ *
+ * Params  : 1. The arena.
+ *           2. The maximum capacity to keep, in bytes.
+ */
+extern void nr_arena_trim(nr_arena_t* arena, size_t max_capacity);
+
+/*
+ * Purpose : Return the total size of the pages owned by an arena.
+ *
+ * Params  : 1. The arena.
+ *
+ * Returns : The capacity of the arena's pages, in bytes.
+ */
+extern size_t nr_arena_capacity(const nr_arena_t* arena);
+
+#endif /* UTIL_ARENA_HDR */
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "nr_axiom.h"
+
+#include "util_bitset.h"
+#include "util_memory.h"
+
+static size_t nr_bitset_words(size_t nbits) {
+  return (nbits + NR_BITSET_WORD_BITS - 1) / NR_BITSET_WORD_BITS;
+}
+
+nr_bitset_t* nr_bitset_create(size_t nbits) {
+  nr_bitset_t* bitset = (nr_bitset_t*)nr_malloc(sizeof(nr_bitset_t));
+
+  bitset->nbits = nbits;
+  bitset->count = 0;
+  bitset->words = NULL;
+
+  if (nbits > 0) {
+    bitset->words
+        = (uint64_t*)nr_calloc(nr_bitset_words(nbits), sizeof(uint64_t));
+  }
+
+  return bitset;
+}
+
+void nr_bitset_destroy(nr_bitset_t** bitset_ptr) {
+  if (NULL == bitset_ptr || NULL == *bitset_ptr) {
+    return;
+  }
+
+  nr_free((*bitset_ptr)->words);
+  nr_realfree((void**)bitset_ptr);
+}
+
+bool nr_bitset_set(nr_bitset_t* bitset, size_t bit) {
+  uint64_t mask;
+  uint64_t* word;
+
+  if (NULL == bitset || bit >= bitset->nbits) {
+    return false;
+  }
+
+  mask = (uint64_t)1 << (bit % NR_BITSET_WORD_BITS);
+  word = &bitset->words[bit / NR_BITSET_WORD_BITS];
+
+  if (0 == (*word & mask)) {
+    *word |= mask;
+    bitset->count += 1;
+  }
+
+  return true;
+}
+
+void nr_bitset_clear(nr_bitset_t* bitset, size_t bit) {
+  uint64_t mask;
+  uint64_t* word;
+
+  if (NULL == bitset || bit >= bitset->nbits) {
+    return;
+  }
+
+  mask = (uint64_t)1 << (bit % NR_BITSET_WORD_BITS);
+  word = &bitset->words[bit / NR_BITSET_WORD_BITS];
+
+  if (0 != (*word & mask)) {
+    *word &= ~mask;
+    bitset->count -= 1;
+  }
+}
+
+void nr_bitset_reset(nr_bitset_t* bitset) {
+  if (NULL == bitset || NULL == bitset->words) {
+    return;
+  }
+
+  nr_memset(bitset->words, 0,
+            nr_bitset_words(bitset->nbits) * sizeof(uint64_t));
+  bitset->count = 0;
+}
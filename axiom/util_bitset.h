@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 New Relic Corporation. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * A fixed size set of small, dense integers, stored one bit per possible
+ * member.
+ */
+#ifndef UTIL_BITSET_HDR
+#define UTIL_BITSET_HDR
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NR_BITSET_WORD_BITS (sizeof(uint64_t) * 8)
+
+/* The bitset data type. */
+typedef struct _nr_bitset_t {
+  size_t nbits;    /* The number of possible members */
+  size_t count;    /* The number of members */
+  uint64_t* words; /* The bits, least significant bit first */
+} nr_bitset_t;
+
+/*
+ * Purpose : Create a bitset.
+ *
+ * Params  : 1. The number of possible members. Valid members are 0 up to, but
+ *              not including, this value.
+ *
+ * Returns : An empty bitset, which must be destroyed with nr_bitset_destroy().
+ */
+extern nr_bitset_t* nr_bitset_create(size_t nbits);
+
+/*
+ * Purpose : Destroy a bitset.
+ *
+ * Params  : 1. A pointer to the bitset to be destroyed.
+ */
+extern void nr_bitset_destroy(nr_bitset_t** bitset_ptr);
+
+/*
+ * Purpose : Add a member to a bitset.
+ *
+ * Params  : 1. The bitset.
+ *           2. The member to add.
+ *
+ * Returns : True if the member is now in the bitset; false if the member is
+ *           out of range or on error.
+ */
+extern bool nr_bitset_set(nr_bitset_t* bitset, size_t bit);
+
+/*
+ * Purpose : Remove a member from a bitset.
+ *
+ * Params  : 1. The bitset.
+ *           2. The member to remove.
+ */
+extern void nr_bitset_clear(nr_bitset_t* bitset, size_t bit);
+
+/*
+ * Purpose : Remove all members from a bitset.
+ *
+ * Params  : 1. The bitset.
+ */
+extern void nr_bitset_reset(nr_bitset_t* bitset);
+
+/*
+ * Purpose : Test if a bitset contains the given member.
+ *
+ * Params  : 1. The bitset.
+ *           2. The member to check.
+ *
+ * Returns : True if the member is in the bitset; false otherwise.
+ */
+static inline bool nr_bitset_contains(const nr_bitset_t* bitset, size_t bit) {
+  if (NULL == bitset || bit >= bitset->nbits) {
+    return false;
+  }
+
+  return 0
+         != (bitset->words[bit / NR_BITSET_WORD_BITS]
+             & ((uint64_t)1 << (bit % NR_BITSET_WORD_BITS)));
+}
+
+/*
+ * Purpose : Return the number of members in a bitset.
+ *
+ * Params  : 1. The bitset.
+ *
+ * Returns : The number of members.
+ */
+static inline size_t nr_bitset_count(const nr_bitset_t* bitset) {
+  if (NULL == bitset) {
+    return 0;
+  }
+
+  return bitset->count;
+}
+
+#endif /* UTIL_BITSET_HDR */
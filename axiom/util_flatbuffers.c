@@ -57,6 +57,20 @@ struct _nr_flatbuffer_t {
   uint32_t* vtables;
   int vtables_len;
   int vtables_cap;
+
+  /*
+   * The number of bytes moved by growing the buffer since it was created or
+   * last reset.
+   */
+  size_t bytes_copied;
+
+  /*
+   * Contents that belong at the end of the message but are written from
+   * where the caller keeps them, rather than being copied into the buffer.
+   * Offsets are relative, so the message doesn't depend on where it ends.
+   */
+  const uint8_t* external;
+  size_t external_len;
 };
 
 /* Number of metadata fields in each vtable. */
@@ -267,22 +281,11 @@ void nr_flatbuffers_pad(nr_flatbuffer_t* fb, size_t n) {
   nr_memset(fb->pos, 0, n);
 }
 
-static void nr_flatbuffers_grow(nr_flatbuffer_t* fb) {
+static void nr_flatbuffers_resize(nr_flatbuffer_t* fb, size_t new_size) {
   size_t used;
-  size_t old_size;
-  size_t new_size;
   uint8_t* new_front;
   uint8_t* new_pos;
 
-  old_size = (size_t)(fb->back - fb->front);
-  /* Cannot grow buffer beyond 2 gigabytes. */
-  nr_flatbuffers_assert(0 == (old_size & (size_t)0xC0000000));
-
-  new_size = old_size * 2;
-  if (0 == new_size) {
-    new_size = 1;
-  }
-
   /*
    * Note: flatbuffers are built back-to-front; i.e. additional space is
    * prepended to the buffer rather than appended.
@@ -292,6 +295,7 @@ static void nr_flatbuffers_grow(nr_flatbuffer_t* fb) {
   new_pos = new_front + (new_size - used);
   nr_memset(new_front, 0, new_size - used);
   nr_memcpy(new_pos, fb->pos, used);
+  fb->bytes_copied += used;
 
   nr_free(fb->front);
   fb->front = new_front;
@@ -299,6 +303,79 @@ static void nr_flatbuffers_grow(nr_flatbuffer_t* fb) {
   fb->pos = fb->back - used;
 }
 
+static void nr_flatbuffers_grow(nr_flatbuffer_t* fb) {
+  size_t old_size;
+  size_t new_size;
+
+  old_size = (size_t)(fb->back - fb->front);
+  /* Cannot grow buffer beyond 2 gigabytes. */
+  nr_flatbuffers_assert(0 == (old_size & (size_t)0xC0000000));
+
+  new_size = old_size * 2;
+  if (0 == new_size) {
+    new_size = 1;
+  }
+
+  nr_flatbuffers_resize(fb, new_size);
+}
+
+void nr_flatbuffers_reserve(nr_flatbuffer_t* fb, size_t size) {
+  size_t new_size;
+
+  if ((NULL == fb) || (size <= nr_flatbuffers_capacity(fb))) {
+    return;
+  }
+
+  /*
+   * Keep the capacity a power of 2, as growing would. Alignment is
+   * calculated from the address of each write, so the back of the buffer
+   * must stay aligned for the output not to depend on the capacity.
+   */
+  new_size = 1;
+  while (new_size < size) {
+    new_size *= 2;
+  }
+
+  nr_flatbuffers_resize(fb, new_size);
+}
+
+void nr_flatbuffers_reset(nr_flatbuffer_t* fb) {
+  if (NULL == fb) {
+    return;
+  }
+
+  /*
+   * Zero the used part of the buffer, so that it's in the same state as a
+   * newly allocated one.
+   */
+  if (fb->pos) {
+    nr_memset(fb->pos, 0, nr_flatbuffers_len(fb));
+  }
+  fb->pos = fb->back;
+  fb->min_align = 1;
+  fb->inside_object = 0;
+  fb->object_end = 0;
+  fb->vtable_len = 0;
+  fb->vtables_len = 0;
+  fb->bytes_copied = 0;
+  fb->external = NULL;
+  fb->external_len = 0;
+}
+
+size_t nr_flatbuffers_capacity(const nr_flatbuffer_t* fb) {
+  if (fb) {
+    return (size_t)(fb->back - fb->front);
+  }
+  return 0;
+}
+
+size_t nr_flatbuffers_bytes_copied(const nr_flatbuffer_t* fb) {
+  if (fb) {
+    return fb->bytes_copied;
+  }
+  return 0;
+}
+
 void nr_flatbuffers_prep(nr_flatbuffer_t* fb,
                          size_t size,
                          size_t additional_bytes) {
@@ -504,6 +581,61 @@ uint32_t nr_flatbuffers_prepend_bytes(nr_flatbuffer_t* fb,
   return nr_flatbuffers_vector_end(fb, len);
 }
 
+static bool nr_flatbuffers_can_prepend_external(const nr_flatbuffer_t* fb) {
+  return (0 == nr_flatbuffers_len(fb)) && (NULL == fb->external)
+         && !fb->inside_object;
+}
+
+uint32_t nr_flatbuffers_prepend_string_external(nr_flatbuffer_t* fb,
+                                                const char* s) {
+  size_t len;
+
+  if (NULL == s) {
+    return 0;
+  }
+
+  if (!nr_flatbuffers_can_prepend_external(fb)) {
+    return nr_flatbuffers_prepend_string(fb, s);
+  }
+
+  /*
+   * Only the length precedes the string in the buffer. The string's own
+   * terminator is part of the tail.
+   */
+  len = (size_t)nr_strlen(s);
+  nr_flatbuffers_prep(fb, sizeof(uint32_t), 0);
+  fb->external = (const uint8_t*)s;
+  fb->external_len = len + 1;
+  return nr_flatbuffers_vector_end(fb, len);
+}
+
+uint32_t nr_flatbuffers_prepend_bytes_external(nr_flatbuffer_t* fb,
+                                               const void* src,
+                                               uint32_t len) {
+  if (!nr_flatbuffers_can_prepend_external(fb) || (0 == len)) {
+    return nr_flatbuffers_prepend_bytes(fb, src, len);
+  }
+
+  nr_flatbuffers_prep(fb, sizeof(uint32_t), 0);
+  fb->external = (const uint8_t*)src;
+  fb->external_len = len;
+  return nr_flatbuffers_vector_end(fb, len);
+}
+
+const uint8_t* nr_flatbuffers_external_data(const nr_flatbuffer_t* fb) {
+  if (fb) {
+    return fb->external;
+  }
+  return NULL;
+}
+
+size_t nr_flatbuffers_external_len(const nr_flatbuffer_t* fb) {
+  if (fb) {
+    return fb->external_len;
+  }
+  return 0;
+}
+
 nr_status_t nr_flatbuffers_object_begin(nr_flatbuffer_t* fb, int num_fields) {
   if (NULL == fb) {
     return NR_FAILURE;
@@ -44,6 +44,44 @@ typedef struct {
  */
 extern nr_flatbuffer_t* nr_flatbuffers_create(size_t initial_size);
 
+/*
+ * Purpose : Ensure the buffer can hold at least the given number of bytes
+ *           without growing.
+ *
+ * Params  : 1. The flatbuffer.
+ *           2. The capacity in bytes. This is rounded up to the next power of
+ *              2.
+ */
+extern void nr_flatbuffers_reserve(nr_flatbuffer_t* fb, size_t size);
+
+/*
+ * Purpose : Empty the buffer so that it can be used to build another
+ *           flatbuffer, keeping the memory that has been allocated.
+ *
+ * Params  : 1. The flatbuffer.
+ */
+extern void nr_flatbuffers_reset(nr_flatbuffer_t* fb);
+
+/*
+ * Purpose : Returns the number of bytes the buffer can hold before it next
+ *           needs to grow.
+ *
+ * Params  : 1. The flatbuffer.
+ *
+ * Returns : The capacity in bytes.
+ */
+extern size_t nr_flatbuffers_capacity(const nr_flatbuffer_t* fb);
+
+/*
+ * Purpose : Returns the number of bytes copied by growing the buffer since it
+ *           was created or last reset.
+ *
+ * Params  : 1. The flatbuffer.
+ *
+ * Returns : The number of bytes.
+ */
+extern size_t nr_flatbuffers_bytes_copied(const nr_flatbuffer_t* fb);
+
 /*
  * Purpose : Returns a pointer to the first byte in the buffer.
  *
@@ -58,7 +96,8 @@ extern const uint8_t* nr_flatbuffers_data(const nr_flatbuffer_t* fb);
  *
  * Params  : 1. The flatbuffer.
  *
- * Returns : The size of the buffer in bytes.
+ * Returns : The size of the buffer in bytes. This doesn't include the
+ *           external tail, if any.
  */
 extern size_t nr_flatbuffers_len(const nr_flatbuffer_t* fb);
 
@@ -135,6 +174,46 @@ extern uint32_t nr_flatbuffers_prepend_bytes(nr_flatbuffer_t* fb,
                                              const void* src,
                                              uint32_t len);
 
+/*
+ * Purpose : Prepends a NUL-terminated string or an array of bytes to the
+ *           buffer without copying it.
+ *
+ *           The contents are left where they are, and become the external
+ *           tail of the buffer: the final message is the bytes returned by
+ *           nr_flatbuffers_data() followed by the bytes returned by
+ *           nr_flatbuffers_external_data(). The contents must therefore
+ *           remain valid until the message has been written.
+ *
+ *           This is only possible for the first value prepended to the
+ *           buffer, since that value ends up at the very end of the message.
+ *           Otherwise, the contents are copied as by
+ *           nr_flatbuffers_prepend_string() or nr_flatbuffers_prepend_bytes().
+ *
+ * Params  : 1. The flatbuffer.
+ *           2. The string or byte array to prepend.
+ *           3. For bytes, the length of the array.
+ *
+ * Returns : A reference to the value, as for nr_flatbuffers_prepend_string()
+ *           and nr_flatbuffers_prepend_bytes().
+ */
+extern uint32_t nr_flatbuffers_prepend_string_external(nr_flatbuffer_t* fb,
+                                                       const char* s);
+extern uint32_t nr_flatbuffers_prepend_bytes_external(nr_flatbuffer_t* fb,
+                                                      const void* src,
+                                                      uint32_t len);
+
+/*
+ * Purpose : Returns the external tail of the buffer, which follows the bytes
+ *           returned by nr_flatbuffers_data() in the final message.
+ *
+ * Params  : 1. The flatbuffer.
+ *
+ * Returns : A pointer to the tail, and its length in bytes, which are NULL
+ *           and 0 if the buffer has no external tail.
+ */
+extern const uint8_t* nr_flatbuffers_external_data(const nr_flatbuffer_t* fb);
+extern size_t nr_flatbuffers_external_len(const nr_flatbuffer_t* fb);
+
 /*
  * Purpose : Begins a new vector whose contents will be prepended to the buffer.
  *
@@ -12,8 +12,183 @@
 #include "util_hashmap_private.h"
 #include "util_memory.h"
 
-static inline size_t nr_hashmap_count_buckets(const nr_hashmap_t* hashmap) {
-  return (size_t)(1 << hashmap->log2_num_buckets);
+static inline size_t nr_hashmap_count_slots(const nr_hashmap_t* hashmap) {
+  return ((size_t)1) << hashmap->log2_num_slots;
+}
+
+static inline uint32_t nr_hashmap_hash_key(const char* key, size_t key_len) {
+  int len = (int)key_len;
+
+  /*
+   * There's an implicit assumption here that nr_mkhash will return a
+   * reasonably well distributed hash value, and therefore that using the low
+   * bits to pick the ideal slot is OK. If MurmurHash3 (the hash function we're
+   * using at the time of writing this) turns out to be less well distributed
+   * than we may hope, then we should evaluate whether another function can be
+   * used, and whether we should implement and use a function just for the
+   * hashmap structure with the qualities we want.
+   */
+  return nr_mkhash(key, &len);
+}
+
+static nr_hashmap_t* nr_hashmap_create_internal(
+    size_t log2_num_slots,
+    nr_hashmap_dtor_func_t dtor_func) {
+  nr_hashmap_t* hashmap;
+
+  if (0 == log2_num_slots) {
+    /*
+     * Encode the default value in one place: namely, here.
+     */
+    log2_num_slots = NR_HASHMAP_DEFAULT_LOG2_SLOTS;
+  } else if (log2_num_slots > NR_HASHMAP_MAX_INITIAL_LOG2_SLOTS) {
+    /*
+     * Basic sanity check: it's extremely unlikely that we'll ever need a
+     * hashmap for the agent that starts with more than 2^24 slots.
+     */
+    log2_num_slots = NR_HASHMAP_MAX_INITIAL_LOG2_SLOTS;
+  }
+
+  hashmap = (nr_hashmap_t*)nr_malloc(sizeof(nr_hashmap_t));
+  hashmap->dtor_func = dtor_func;
+  hashmap->log2_num_slots = log2_num_slots;
+  hashmap->slots = NULL;
+  hashmap->elements = 0;
+
+  return hashmap;
+}
+
+/*
+ * Purpose : Find the slot holding the given key.
+ *
+ * Returns : The slot, or NULL if the key isn't in the hashmap.
+ */
+static nr_hashmap_slot_t* nr_hashmap_find(const nr_hashmap_t* hashmap,
+                                          uint32_t hash,
+                                          const char* key,
+                                          size_t key_len) {
+  size_t mask;
+  size_t i;
+  uint32_t distance;
+
+  if (NULL == hashmap->slots) {
+    return NULL;
+  }
+
+  mask = nr_hashmap_count_slots(hashmap) - 1;
+  for (i = hash & mask, distance = 1;; i = (i + 1) & mask, distance++) {
+    nr_hashmap_slot_t* slot = &hashmap->slots[i];
+
+    /*
+     * An empty slot, or an element that is closer to its ideal slot than the
+     * key would be here, means the key would have been placed before this
+     * point had it been inserted. As the table is never full, every probe
+     * sequence ends this way.
+     */
+    if (slot->distance < distance) {
+      return NULL;
+    }
+
+    if (hash == slot->hash && key_len == slot->key_len
+        && 0 == nr_memcmp(key, nr_hashmap_slot_key(slot), key_len)) {
+      return slot;
+    }
+  }
+}
+
+/*
+ * Purpose : Place an element into the slot array, moving other elements as
+ *           required.
+ *
+ * Params  : 1. The hashmap, which must have at least one empty slot.
+ *           2. The element, which must not already be in the hashmap. Its
+ *              distance is overwritten.
+ */
+static void nr_hashmap_place(nr_hashmap_t* hashmap, nr_hashmap_slot_t entry) {
+  size_t mask = nr_hashmap_count_slots(hashmap) - 1;
+  size_t i;
+
+  entry.distance = 1;
+  for (i = entry.hash & mask;; i = (i + 1) & mask, entry.distance++) {
+    nr_hashmap_slot_t* slot = &hashmap->slots[i];
+
+    if (0 == slot->distance) {
+      *slot = entry;
+      return;
+    }
+
+    /*
+     * Take the slot of an element that is closer to its ideal slot, and carry
+     * on looking for a slot for that element instead.
+     */
+    if (slot->distance < entry.distance) {
+      nr_hashmap_slot_t displaced = *slot;
+
+      *slot = entry;
+      entry = displaced;
+    }
+  }
+}
+
+static void nr_hashmap_resize(nr_hashmap_t* hashmap, size_t log2_num_slots) {
+  nr_hashmap_slot_t* old_slots = hashmap->slots;
+  size_t old_count = old_slots ? nr_hashmap_count_slots(hashmap) : 0;
+  size_t i;
+
+  hashmap->log2_num_slots = log2_num_slots;
+  hashmap->slots = (nr_hashmap_slot_t*)nr_calloc(
+      nr_hashmap_count_slots(hashmap), sizeof(nr_hashmap_slot_t));
+
+  /*
+   * The cached hash means keys don't need to be rehashed, and heap keys move
+   * with their slot.
+   */
+  for (i = 0; i < old_count; i++) {
+    if (old_slots[i].distance) {
+      nr_hashmap_place(hashmap, old_slots[i]);
+    }
+  }
+
+  nr_free(old_slots);
+}
+
+static void nr_hashmap_add(nr_hashmap_t* hashmap,
+                           uint32_t hash,
+                           const char* key,
+                           size_t key_len,
+                           void* value) {
+  nr_hashmap_slot_t entry;
+
+  /*
+   * Grow once the hashmap would be more than 7/8 full: beyond that, probe
+   * sequences get long quickly.
+   */
+  if (NULL == hashmap->slots) {
+    nr_hashmap_resize(hashmap, hashmap->log2_num_slots);
+  } else if ((hashmap->elements + 1) * 8
+             > nr_hashmap_count_slots(hashmap) * 7) {
+    nr_hashmap_resize(hashmap, hashmap->log2_num_slots + 1);
+  }
+
+  entry.hash = hash;
+  entry.distance = 1;
+  entry.key_len = key_len;
+  if (key_len <= NR_HASHMAP_INLINE_KEY_SIZE) {
+    nr_memcpy(entry.key.inline_key, key, key_len);
+  } else {
+    entry.key.heap_key = (char*)nr_malloc(key_len);
+    nr_memcpy(entry.key.heap_key, key, key_len);
+  }
+  entry.value = value;
+
+  nr_hashmap_place(hashmap, entry);
+  hashmap->elements += 1;
+}
+
+static void nr_hashmap_slot_destroy_key(nr_hashmap_slot_t* slot) {
+  if (slot->key_len > NR_HASHMAP_INLINE_KEY_SIZE) {
+    nr_free(slot->key.heap_key);
+  }
 }
 
 nr_hashmap_t* nr_hashmap_create(nr_hashmap_dtor_func_t dtor_func) {
@@ -33,7 +208,7 @@ nr_hashmap_t* nr_hashmap_create_buckets(size_t buckets,
      */
 
     actual_buckets = 1;
-    while (((size_t)(1 << actual_buckets)) < buckets) {
+    while (((size_t)1 << actual_buckets) < buckets) {
       actual_buckets += 1;
     }
   }
@@ -42,8 +217,8 @@ nr_hashmap_t* nr_hashmap_create_buckets(size_t buckets,
 }
 
 void nr_hashmap_destroy(nr_hashmap_t** hashmap_ptr) {
-  size_t count;
   nr_hashmap_t* hashmap;
+  size_t count;
   size_t i;
 
   if ((NULL == hashmap_ptr) || (NULL == *hashmap_ptr)) {
@@ -51,19 +226,19 @@ void nr_hashmap_destroy(nr_hashmap_t** hashmap_ptr) {
   }
   hashmap = *hashmap_ptr;
 
-  count = nr_hashmap_count_buckets(hashmap);
+  count = hashmap->slots ? nr_hashmap_count_slots(hashmap) : 0;
   for (i = 0; i < count; i++) {
-    nr_hashmap_bucket_t* bucket = hashmap->buckets[i];
+    nr_hashmap_slot_t* slot = &hashmap->slots[i];
 
-    while (bucket) {
-      nr_hashmap_bucket_t* next = bucket->next;
-
-      nr_hashmap_destroy_bucket(&bucket, hashmap->dtor_func);
-      bucket = next;
+    if (slot->distance) {
+      nr_hashmap_slot_destroy_key(slot);
+      if (hashmap->dtor_func) {
+        (hashmap->dtor_func)(slot->value);
+      }
     }
   }
 
-  nr_free(hashmap->buckets);
+  nr_free(hashmap->slots);
   nr_realfree((void**)hashmap_ptr);
 }
 
@@ -73,16 +248,16 @@ void nr_hashmap_apply(nr_hashmap_t* hashmap,
   size_t count;
   size_t i;
 
-  if ((NULL == hashmap) || (NULL == apply_func)) {
+  if ((NULL == hashmap) || (NULL == apply_func) || (NULL == hashmap->slots)) {
     return;
   }
 
-  count = nr_hashmap_count_buckets(hashmap);
+  count = nr_hashmap_count_slots(hashmap);
   for (i = 0; i < count; i++) {
-    nr_hashmap_bucket_t* bucket;
+    nr_hashmap_slot_t* slot = &hashmap->slots[i];
 
-    for (bucket = hashmap->buckets[i]; bucket; bucket = bucket->next) {
-      (apply_func)(bucket->value, bucket->key.value, bucket->key.length,
+    if (slot->distance) {
+      (apply_func)(slot->value, nr_hashmap_slot_key(slot), slot->key_len,
                    user_data);
     }
   }
@@ -99,42 +274,50 @@ size_t nr_hashmap_count(const nr_hashmap_t* hashmap) {
 nr_status_t nr_hashmap_delete(nr_hashmap_t* hashmap,
                               const char* key,
                               size_t key_len) {
-  nr_hashmap_bucket_t* bucket = NULL;
-  size_t hash;
+  nr_hashmap_slot_t* slot;
+  size_t mask;
+  size_t i;
+  void* value;
 
   if ((NULL == hashmap) || (NULL == key) || (0 == key_len)) {
     return NR_FAILURE;
   }
 
-  hash = nr_hashmap_hash_key(hashmap->log2_num_buckets, key, key_len);
-  if (nr_hashmap_fetch(hashmap, hash, key, key_len, &bucket)) {
-    /*
-     * Patch up the doubly linked list so that we don't point at something
-     * we're about to free.
-     */
-    if (bucket->next) {
-      bucket->next->prev = bucket->prev;
-    }
+  slot = nr_hashmap_find(hashmap, nr_hashmap_hash_key(key, key_len), key,
+                         key_len);
+  if (NULL == slot) {
+    return NR_FAILURE;
+  }
 
-    if (bucket->prev) {
-      bucket->prev->next = bucket->next;
-    }
+  value = slot->value;
+  nr_hashmap_slot_destroy_key(slot);
 
-    /*
-     * If this is the first bucket in the list for this hash key, we need to
-     * point the head of the list at the next bucket.
-     */
-    if (hashmap->buckets[hash] == bucket) {
-      hashmap->buckets[hash] = bucket->next;
+  /*
+   * Shift the following elements back by one slot until reaching an empty
+   * slot or an element that is already in its ideal slot. This keeps every
+   * probe sequence contiguous without needing tombstones.
+   */
+  mask = nr_hashmap_count_slots(hashmap) - 1;
+  i = (size_t)(slot - hashmap->slots);
+  for (;;) {
+    size_t next = (i + 1) & mask;
+
+    if (hashmap->slots[next].distance <= 1) {
+      break;
     }
 
-    nr_hashmap_destroy_bucket(&bucket, hashmap->dtor_func);
-    hashmap->elements -= 1;
+    hashmap->slots[i] = hashmap->slots[next];
+    hashmap->slots[i].distance -= 1;
+    i = next;
+  }
+  hashmap->slots[i].distance = 0;
+  hashmap->elements -= 1;
 
-    return NR_SUCCESS;
+  if (hashmap->dtor_func) {
+    (hashmap->dtor_func)(value);
   }
 
-  return NR_FAILURE;
+  return NR_SUCCESS;
 }
 
 void* nr_hashmap_get(nr_hashmap_t* hashmap, const char* key, size_t key_len) {
@@ -151,17 +334,17 @@ int nr_hashmap_get_into(nr_hashmap_t* hashmap,
                         const char* key,
                         size_t key_len,
                         void** value_ptr) {
-  nr_hashmap_bucket_t* bucket = NULL;
-  size_t hash;
+  nr_hashmap_slot_t* slot;
 
   if ((NULL == hashmap) || (NULL == key) || (0 == key_len)
       || (NULL == value_ptr)) {
     return 0;
   }
 
-  hash = nr_hashmap_hash_key(hashmap->log2_num_buckets, key, key_len);
-  if (nr_hashmap_fetch(hashmap, hash, key, key_len, &bucket)) {
-    *value_ptr = bucket->value;
+  slot = nr_hashmap_find(hashmap, nr_hashmap_hash_key(key, key_len), key,
+                         key_len);
+  if (slot) {
+    *value_ptr = slot->value;
     return 1;
   }
 
@@ -169,32 +352,31 @@ int nr_hashmap_get_into(nr_hashmap_t* hashmap,
 }
 
 int nr_hashmap_has(nr_hashmap_t* hashmap, const char* key, size_t key_len) {
-  size_t hash;
-
   if ((NULL == hashmap) || (NULL == key) || (0 == key_len)) {
     return 0;
   }
 
-  hash = nr_hashmap_hash_key(hashmap->log2_num_buckets, key, key_len);
-  return nr_hashmap_fetch(hashmap, hash, key, key_len, NULL);
+  return NULL
+         != nr_hashmap_find(hashmap, nr_hashmap_hash_key(key, key_len), key,
+                            key_len);
 }
 
 nr_status_t nr_hashmap_set(nr_hashmap_t* hashmap,
                            const char* key,
                            size_t key_len,
                            void* value) {
-  size_t hash;
+  uint32_t hash;
 
   if ((NULL == hashmap) || (NULL == key) || (0 == key_len)) {
     return NR_FAILURE;
   }
 
-  hash = nr_hashmap_hash_key(hashmap->log2_num_buckets, key, key_len);
-  if (nr_hashmap_fetch(hashmap, hash, key, key_len, NULL)) {
+  hash = nr_hashmap_hash_key(key, key_len);
+  if (nr_hashmap_find(hashmap, hash, key, key_len)) {
     return NR_FAILURE;
   }
 
-  nr_hashmap_add_internal(hashmap, hash, key, key_len, value);
+  nr_hashmap_add(hashmap, hash, key, key_len, value);
   return NR_SUCCESS;
 }
 
@@ -202,125 +384,25 @@ void nr_hashmap_update(nr_hashmap_t* hashmap,
                        const char* key,
                        size_t key_len,
                        void* value) {
-  nr_hashmap_bucket_t* bucket = NULL;
-  size_t hash;
+  nr_hashmap_slot_t* slot;
+  uint32_t hash;
 
   if ((NULL == hashmap) || (NULL == key) || (0 == key_len)) {
     return;
   }
 
-  hash = nr_hashmap_hash_key(hashmap->log2_num_buckets, key, key_len);
-  if (nr_hashmap_fetch(hashmap, hash, key, key_len, &bucket)) {
+  hash = nr_hashmap_hash_key(key, key_len);
+  slot = nr_hashmap_find(hashmap, hash, key, key_len);
+  if (slot) {
     if (hashmap->dtor_func) {
-      (hashmap->dtor_func)(bucket->value);
+      (hashmap->dtor_func)(slot->value);
     }
 
-    bucket->value = value;
+    slot->value = value;
     return;
   }
 
-  nr_hashmap_add_internal(hashmap, hash, key, key_len, value);
-}
-
-void nr_hashmap_add_internal(nr_hashmap_t* hashmap,
-                             size_t hash_key,
-                             const char* key,
-                             size_t key_len,
-                             void* value) {
-  nr_hashmap_bucket_t* bucket;
-
-  bucket = (nr_hashmap_bucket_t*)nr_malloc(sizeof(nr_hashmap_bucket_t));
-  bucket->prev = NULL;
-  bucket->next = hashmap->buckets[hash_key];
-  bucket->key.length = key_len;
-  bucket->key.value = (char*)nr_malloc(key_len);
-  nr_memcpy(bucket->key.value, key, key_len);
-  bucket->value = value;
-
-  if (hashmap->buckets[hash_key]) {
-    hashmap->buckets[hash_key]->prev = bucket;
-  }
-
-  hashmap->buckets[hash_key] = bucket;
-  ++hashmap->elements;
-}
-
-nr_hashmap_t* nr_hashmap_create_internal(size_t log2_num_buckets,
-                                         nr_hashmap_dtor_func_t dtor_func) {
-  nr_hashmap_t* hashmap;
-
-  if (0 == log2_num_buckets) {
-    /*
-     * Encode the default value in one place: namely, here.
-     */
-    log2_num_buckets = 8;
-  } else if (log2_num_buckets > 24) {
-    /*
-     * Basic sanity check: it's extremely unlikely that we'll ever need a
-     * hashmap for the agent that has more than 2^24 buckets.
-     */
-    log2_num_buckets = 24;
-  }
-
-  hashmap = (nr_hashmap_t*)nr_malloc(sizeof(nr_hashmap_t));
-  hashmap->dtor_func = dtor_func;
-  hashmap->log2_num_buckets = log2_num_buckets;
-  hashmap->buckets = (nr_hashmap_bucket_t**)nr_calloc(
-      (1 << log2_num_buckets), sizeof(nr_hashmap_bucket_t*));
-  hashmap->elements = 0;
-
-  return hashmap;
-}
-
-void nr_hashmap_destroy_bucket(nr_hashmap_bucket_t** bucket_ptr,
-                               nr_hashmap_dtor_func_t dtor_func) {
-  nr_hashmap_bucket_t* bucket = *bucket_ptr;
-
-  nr_free(bucket->key.value);
-  if (dtor_func) {
-    (dtor_func)(bucket->value);
-  }
-  nr_realfree((void**)bucket_ptr);
-}
-
-int nr_hashmap_fetch(nr_hashmap_t* hashmap,
-                     size_t hash_key,
-                     const char* key,
-                     size_t key_len,
-                     nr_hashmap_bucket_t** bucket_ptr) {
-  nr_hashmap_bucket_t* bucket;
-
-  for (bucket = hashmap->buckets[hash_key]; bucket; bucket = bucket->next) {
-    if (key_len == bucket->key.length) {
-      if (0 == nr_memcmp(key, bucket->key.value, key_len)) {
-        if (bucket_ptr) {
-          *bucket_ptr = bucket;
-        }
-        return 1;
-      }
-    }
-  }
-
-  return 0;
-}
-
-size_t nr_hashmap_hash_key(size_t log2_num_buckets,
-                           const char* key,
-                           size_t key_len) {
-  int len = (int)key_len;
-  uint32_t hash = nr_mkhash(key, &len);
-
-  /*
-   * There's an implicit assumption here that nr_mkhash will return a
-   * reasonably well distributed hash value, and therefore that using the low
-   * bits for truncation is OK. If MurmurHash3 (the hash function we're using
-   * at the time of writing this) turns out to be less well distributed than we
-   * may hope, then we should evaluate whether another function can be used,
-   * and whether we should implement and use a function just for the hashmap
-   * structure with the qualities we want.
-   */
-
-  return (hash & ((1 << log2_num_buckets) - 1));
+  nr_hashmap_add(hashmap, hash, key, key_len, value);
 }
 
 static void nr_hashmap_keys_destroy_key(void* key, void* userdata NRUNUSED) {
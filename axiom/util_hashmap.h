@@ -4,8 +4,8 @@
  */
 
 /*
- * A basic unordered hash map, implemented using a simple hash table with
- * doubly linked lists to handle hash collisions.
+ * A basic unordered hash map, implemented using an open addressing hash table
+ * with Robin Hood probing. The table grows as elements are added.
  */
 #ifndef UTIL_HASHMAP_HDR
 #define UTIL_HASHMAP_HDR
@@ -46,11 +46,12 @@ typedef void (*nr_hashmap_dtor_func_t)(void* value);
 extern nr_hashmap_t* nr_hashmap_create(nr_hashmap_dtor_func_t dtor_func);
 
 /*
- * Purpose : Create a hashmap with a set number of buckets.
+ * Purpose : Create a hashmap with a set initial number of buckets.
  *
- * Params  : 1. The number of buckets. If this is not a power of 2, this will
- *              be rounded up to the next power of 2. The maximum value is
- *              2^24; values above this will be capped to 2^24.
+ * Params  : 1. The initial number of buckets. If this is not a power of 2,
+ *              this will be rounded up to the next power of 2. The maximum
+ *              value is 2^24; values above this will be capped to 2^24. The
+ *              hashmap grows beyond this as required.
  *           2. The destructor function, or NULL if not required.
  *
  * Returns : A newly allocated hashmap.
@@ -73,6 +74,9 @@ extern void nr_hashmap_destroy(nr_hashmap_t** hashmap_ptr);
  *           2. The function to call for each key-value pair.
  *           3. A pointer that will be passed unchanged into the apply
  *              function.
+ *
+ * Warning : The apply function must not add or delete elements, since that
+ *           may move elements within the hashmap.
  */
 extern void nr_hashmap_apply(nr_hashmap_t* hashmap,
                              nr_hashmap_apply_func_t apply_func,
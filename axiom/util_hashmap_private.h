@@ -9,73 +9,60 @@
 #include "util_hashmap.h"
 
 /*
- * A structure representing keys. Note that key values are binary safe.
+ * Keys up to this length are stored inside the slot itself, so that the
+ * common case of short string and integer keys needs no allocation and
+ * comparing a key touches no memory outside the slot array.
  */
-struct _nr_hashmap_key_t {
-  size_t length;
-  char* value;
-};
-typedef struct _nr_hashmap_key_t nr_hashmap_key_t;
+#define NR_HASHMAP_INLINE_KEY_SIZE 24
 
 /*
- * A single bucket within a hashmap. As these are implemented as a doubly
- * linked list, note that there are both prev and next pointers.
+ * The number of slots allocated by default, as a power of 2.
  */
-struct _nr_hashmap_bucket_t {
-  struct _nr_hashmap_bucket_t* prev;
-  struct _nr_hashmap_bucket_t* next;
-  nr_hashmap_key_t key;
+#define NR_HASHMAP_DEFAULT_LOG2_SLOTS 4
+
+/*
+ * The maximum initial number of slots that may be requested, as a power of 2.
+ * The hashmap may grow beyond this as elements are added.
+ */
+#define NR_HASHMAP_MAX_INITIAL_LOG2_SLOTS 24
+
+/*
+ * A single slot within a hashmap. Note that key values are binary safe.
+ */
+typedef struct _nr_hashmap_slot_t {
+  uint32_t hash;     /* The full hash of the key */
+  uint32_t distance; /* 0 if the slot is empty, otherwise the distance of the
+                        slot from the key's ideal slot plus 1 */
+  size_t key_len;
+  union {
+    char inline_key[NR_HASHMAP_INLINE_KEY_SIZE];
+    char* heap_key;
+  } key;
   void* value;
-};
-typedef struct _nr_hashmap_bucket_t nr_hashmap_bucket_t;
+} nr_hashmap_slot_t;
 
+/*
+ * The hashmap is an open addressing hash table using linear probing with
+ * Robin Hood insertion: an element being inserted takes the slot of any
+ * element that is closer to its own ideal slot, which keeps probe sequences
+ * short, and allows lookups to stop as soon as they reach such an element.
+ * Deletion shifts the following elements back rather than leaving
+ * tombstones.
+ */
 struct _nr_hashmap_t {
   nr_hashmap_dtor_func_t dtor_func;
-  size_t log2_num_buckets; /* this is the log2() of the true number of
-                              buckets */
-  nr_hashmap_bucket_t** buckets;
+  size_t log2_num_slots;    /* this is the log2() of the true number of
+                               slots */
+  nr_hashmap_slot_t* slots; /* allocated on the first insertion */
   size_t elements;
 };
 
-/*
- * Purpose : Unconditionally add a value to a hashmap.
- *
- * Notes   : 1. This function does not check parameters for validity.
- *           2. This function does not check if the key already exists; if it
- *              does a duplicate value will be added. (This will work as
- *              expected in terms of retrieval, but may cause unexpected
- *              behaviour if the element is deleted, and wastes memory.)
- */
-extern void nr_hashmap_add_internal(nr_hashmap_t* hashmap,
-                                    size_t hash_key,
-                                    const char* key,
-                                    size_t key_len,
-                                    void* value);
-
-extern nr_hashmap_t* nr_hashmap_create_internal(
-    size_t log2_num_buckets,
-    nr_hashmap_dtor_func_t dtor_func);
+static inline const char* nr_hashmap_slot_key(const nr_hashmap_slot_t* slot) {
+  if (slot->key_len <= NR_HASHMAP_INLINE_KEY_SIZE) {
+    return slot->key.inline_key;
+  }
 
-extern void nr_hashmap_destroy_bucket(nr_hashmap_bucket_t** bucket_ptr,
-                                      nr_hashmap_dtor_func_t dtor_func);
-
-extern int nr_hashmap_fetch(nr_hashmap_t* hashmap,
-                            size_t hash_key,
-                            const char* key,
-                            size_t key_len,
-                            nr_hashmap_bucket_t** bucket_ptr);
-
-/*
- * Purpose : Calculate the hash key for the given key.
- *
- * Params  : 1. The log2_num_buckets value in the hashmap.
- *           2. The key.
- *           3. The size of the key.
- *
- * Returns : The hash key.
- */
-extern size_t nr_hashmap_hash_key(size_t log2_num_buckets,
-                                  const char* key,
-                                  size_t key_len);
+  return slot->key.heap_key;
+}
 
 #endif /* UTIL_HASHMAP_PRIVATE_HDR */
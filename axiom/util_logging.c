@@ -17,6 +17,7 @@
 #include "util_memory.h"
 #include "util_strings.h"
 #include "util_syscalls.h"
+#include "util_threads.h"
 
 typedef struct _nrl_subsys_names_t {
   const char* name;
@@ -79,6 +80,52 @@ static int logfile_fd = -1;
 
 const uint32_t* const nrl_level_mask_ptr = nrl_level_mask;
 
+/*
+ * Buffered logging.
+ *
+ * When a buffer size has been set, formatted log lines are appended to a
+ * process-wide ring buffer instead of being written one at a time. The buffer
+ * is written to the log file when a line doesn't fit, when a second has passed
+ * since the last write, when a warning or error is logged, and whenever
+ * nrl_flush_log() is called. If the buffer can't be written, the oldest lines
+ * are dropped to make room and a count of the dropped lines is written once
+ * the log file accepts data again.
+ *
+ * The buffer records the pid of the process that filled it. Lines buffered by
+ * a parent process before a fork are discarded by the child, as the parent
+ * still owns and will write them.
+ *
+ * The buffer mutex is locked with pthread_mutex_lock() directly, since the
+ * nrt_mutex_* wrappers log on failure and would recurse.
+ */
+#define NRL_BUFFER_FLUSH_INTERVAL_SECONDS 1
+#define NRL_BUFFER_LINE_MAX 4096
+
+typedef struct _nrl_buffer_t {
+  char* data;        /* Ring storage */
+  size_t size;       /* Capacity of data; 0 when buffering is disabled */
+  size_t start;      /* Offset of the oldest buffered byte */
+  size_t used;       /* Number of buffered bytes */
+  uint64_t dropped;  /* Lines dropped since the last successful write */
+  time_t last_flush; /* Time of the last write */
+  pid_t pid;         /* Process that buffered the lines */
+} nrl_buffer_t;
+
+static nrl_buffer_t nrl_buffer = {NULL, 0, 0, 0, 0, 0, 0};
+static nrthread_mutex_t nrl_buffer_mutex = NRTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * The date, time and UTC offset parts of the log line timestamp only change
+ * once a second, so they are cached per thread.
+ */
+typedef struct _nrl_timestamp_cache_t {
+  time_t sec;
+  char datetime[64]; /* "YYYY-MM-DD HH:MM:SS" */
+  int offset_24h;    /* difference from GMT in 24h format e.g. -0700 */
+} nrl_timestamp_cache_t;
+
+static nrt_thread_local nrl_timestamp_cache_t nrl_timestamp_cache = {-1, "", 0};
+
 nr_status_t nrl_set_log_file(const char* filename) {
   if ((0 == filename) || (0 == filename[0])) {
     return NR_FAILURE;
@@ -88,6 +135,7 @@ nr_status_t nrl_set_log_file(const char* filename) {
    * Close an existing log file, if one is open.
    */
   if (-1 != logfile_fd) {
+    nrl_flush_log();
     nr_close(logfile_fd);
   }
 
@@ -110,6 +158,7 @@ void nrl_close_log_file(void) {
   if (-1 == logfile_fd) {
     return;
   }
+  nrl_flush_log();
   nr_close(logfile_fd);
   logfile_fd = -1;
 }
@@ -118,12 +167,14 @@ int nrl_get_log_fd(void) {
   return logfile_fd;
 }
 
-void nrl_format_timestamp(char* buf, size_t buflen, const struct timeval* tv) {
-  struct tm tm;
+/*
+ * Purpose : Convert a time to local time, and compute the difference from GMT
+ *           in 24h format e.g. -0700.
+ */
+static void nrl_localtime(const time_t* sec, struct tm* tm, int* offset_24h) {
   int offset_secs; /* difference from GMT in seconds */
-  int offset_24h;  /* difference in 24h format e.g. -0700 */
 
-  localtime_r(&tv->tv_sec, &tm);
+  localtime_r(sec, tm);
 
 #ifdef NR_SYSTEM_SOLARIS
   /*
@@ -132,15 +183,15 @@ void nrl_format_timestamp(char* buf, size_t buflen, const struct timeval* tv) {
    * sign is also reversed compared to POSIX. i.e. a negative offset
    * indicates a timezone that is east of Greenwich rather than west.
    */
-  offset_secs = -(int)(tm.tm_isdst && daylight ? altzone : timezone);
+  offset_secs = -(int)(tm->tm_isdst && daylight ? altzone : timezone);
 #else
-  offset_secs = (int)tm.tm_gmtoff;
+  offset_secs = (int)tm->tm_gmtoff;
 #endif
 
   if (offset_secs >= 0) {
     const int hours = (offset_secs / 60) / 60;
     const int minutes = (offset_secs / 60) % 60;
-    offset_24h = hours * 100 + minutes;
+    *offset_24h = hours * 100 + minutes;
   } else {
     /*
      * Note: the modulus operator rounds towards zero, therefore
@@ -149,8 +200,15 @@ void nrl_format_timestamp(char* buf, size_t buflen, const struct timeval* tv) {
      */
     const int hours = (-offset_secs / 60) / 60;
     const int minutes = (-offset_secs / 60) % 60;
-    offset_24h = -(hours * 100 + minutes);
+    *offset_24h = -(hours * 100 + minutes);
   }
+}
+
+void nrl_format_timestamp(char* buf, size_t buflen, const struct timeval* tv) {
+  struct tm tm;
+  int offset_24h;
+
+  nrl_localtime(&tv->tv_sec, &tm, &offset_24h);
 
   buf[0] = '\0';
   snprintf(buf, buflen, "%04d-%02d-%02d %02d:%02d:%02d.%03d %+05d",
@@ -162,6 +220,274 @@ void nrl_format_timestamp(char* buf, size_t buflen, const struct timeval* tv) {
 static char logger_newline[]
     = "\n"; /* must be static char to be used in iovec */
 
+/*
+ * Purpose : Format the preamble of a log line, using the calling thread's
+ *           cached date and time where possible.
+ *
+ * Returns : The length of the preamble, or -1 on error.
+ */
+static int nrl_format_preamble(char* buf,
+                               size_t buflen,
+                               nrloglev_t level,
+                               const struct timeval* tv) {
+  nrl_timestamp_cache_t* cache = &nrl_timestamp_cache;
+  int len;
+
+  if (cache->sec != tv->tv_sec) {
+    struct tm tm;
+
+    nrl_localtime(&tv->tv_sec, &tm, &cache->offset_24h);
+    snprintf(cache->datetime, sizeof(cache->datetime),
+             "%04d-%02d-%02d %02d:%02d:%02d", (int)tm.tm_year + 1900,
+             (int)tm.tm_mon + 1, (int)tm.tm_mday, (int)tm.tm_hour,
+             (int)tm.tm_min, (int)tm.tm_sec);
+    cache->sec = tv->tv_sec;
+  }
+
+  len = snprintf(buf, buflen, "%s.%03d %+05d (%d %d) %s: ", cache->datetime,
+                 (int)(tv->tv_usec / 1000), cache->offset_24h, nr_getpid(),
+                 nr_gettid(), level_names[level]);
+  if ((len < 0) || ((size_t)len >= buflen)) {
+    return -1;
+  }
+  return len;
+}
+
+static void nrl_buffer_reset_locked(void) {
+  nrl_buffer.start = 0;
+  nrl_buffer.used = 0;
+  nrl_buffer.dropped = 0;
+  nrl_buffer.pid = nr_getpid();
+}
+
+/*
+ * Purpose : Drop the oldest line from the log buffer.
+ */
+static void nrl_buffer_drop_oldest_locked(void) {
+  size_t i;
+
+  for (i = 0; i < nrl_buffer.used; i++) {
+    if ('\n' == nrl_buffer.data[(nrl_buffer.start + i) % nrl_buffer.size]) {
+      i++;
+      break;
+    }
+  }
+
+  nrl_buffer.start = (nrl_buffer.start + i) % nrl_buffer.size;
+  nrl_buffer.used -= i;
+  nrl_buffer.dropped += 1;
+  if (0 == nrl_buffer.used) {
+    nrl_buffer.start = 0;
+  }
+}
+
+static void nrl_flush_log_locked(int fd) {
+  struct iovec iov[2];
+  int iovcnt = 1;
+  size_t first;
+  ssize_t written;
+
+  if ((-1 == fd) || (0 == nrl_buffer.size)) {
+    return;
+  }
+
+  if (nrl_buffer.pid != nr_getpid()) {
+    nrl_buffer_reset_locked();
+    return;
+  }
+
+  nrl_buffer.last_flush = time(0);
+
+  if (nrl_buffer.dropped) {
+    char notice[256];
+    struct timeval tv;
+    int len;
+
+    tv.tv_sec = 0;
+    tv.tv_usec = 0;
+    gettimeofday(&tv, 0);
+    len = nrl_format_preamble(notice, sizeof(notice), NRL_WARNING, &tv);
+    if (len < 0) {
+      return;
+    }
+    len += snprintf(notice + len, sizeof(notice) - (size_t)len,
+                    "%llu log messages were dropped because the log buffer "
+                    "was full\n",
+                    (unsigned long long)nrl_buffer.dropped);
+    if ((size_t)len >= sizeof(notice)) {
+      len = (int)sizeof(notice) - 1;
+    }
+    if (-1 == nr_write(fd, notice, (size_t)len)) {
+      return;
+    }
+    nrl_buffer.dropped = 0;
+  }
+
+  if (0 == nrl_buffer.used) {
+    return;
+  }
+
+  first = nrl_buffer.size - nrl_buffer.start;
+  if (first > nrl_buffer.used) {
+    first = nrl_buffer.used;
+  }
+  iov[0].iov_base = nrl_buffer.data + nrl_buffer.start;
+  iov[0].iov_len = first;
+  if (first < nrl_buffer.used) {
+    iov[1].iov_base = nrl_buffer.data;
+    iov[1].iov_len = nrl_buffer.used - first;
+    iovcnt = 2;
+  }
+
+  written = nr_writev(fd, iov, iovcnt);
+  if (written <= 0) {
+    return;
+  }
+
+  nrl_buffer.start = (nrl_buffer.start + (size_t)written) % nrl_buffer.size;
+  nrl_buffer.used -= (size_t)written;
+  if (0 == nrl_buffer.used) {
+    nrl_buffer.start = 0;
+  }
+}
+
+/*
+ * Purpose : Format a log line into the log buffer.
+ *
+ * Returns : true if the line was buffered, or false if buffering is disabled
+ *           or the line is too long to buffer, in which case it must be
+ *           written directly.
+ */
+static bool nrl_buffer_log_message(int fd,
+                                   nrloglev_t level,
+                                   const char* fmt,
+                                   va_list ap) {
+  char line[NRL_BUFFER_LINE_MAX];
+  struct timeval tv;
+  va_list ap_copy;
+  int preamble_len;
+  int msg_len;
+  size_t len;
+  size_t tail;
+  size_t first;
+
+  tv.tv_sec = 0;
+  tv.tv_usec = 0;
+  gettimeofday(&tv, 0);
+  preamble_len = nrl_format_preamble(line, sizeof(line), level, &tv);
+  if (preamble_len < 0) {
+    return false;
+  }
+
+  va_copy(ap_copy, ap);
+  msg_len = vsnprintf(line + preamble_len, sizeof(line) - (size_t)preamble_len,
+                      fmt, ap_copy);
+  va_end(ap_copy);
+
+  /*
+   * One byte must remain for the newline.
+   */
+  if ((msg_len < 0)
+      || ((size_t)msg_len >= sizeof(line) - (size_t)preamble_len - 1)) {
+    return false;
+  }
+  len = (size_t)preamble_len + (size_t)msg_len;
+  line[len] = '\n';
+  len += 1;
+
+  pthread_mutex_lock(&nrl_buffer_mutex);
+
+  if (len > nrl_buffer.size) {
+    pthread_mutex_unlock(&nrl_buffer_mutex);
+    return false;
+  }
+
+  if (nrl_buffer.pid != nr_getpid()) {
+    nrl_buffer_reset_locked();
+  }
+
+  if (nrl_buffer.size - nrl_buffer.used < len) {
+    nrl_flush_log_locked(fd);
+  }
+  while (nrl_buffer.size - nrl_buffer.used < len) {
+    nrl_buffer_drop_oldest_locked();
+  }
+
+  tail = (nrl_buffer.start + nrl_buffer.used) % nrl_buffer.size;
+  first = nrl_buffer.size - tail;
+  if (first > len) {
+    first = len;
+  }
+  nr_memcpy(nrl_buffer.data + tail, line, first);
+  nr_memcpy(nrl_buffer.data, line + first, len - first);
+  nrl_buffer.used += len;
+
+  if (((int)level <= (int)NRL_WARNING)
+      || ((tv.tv_sec - nrl_buffer.last_flush)
+          >= NRL_BUFFER_FLUSH_INTERVAL_SECONDS)) {
+    nrl_flush_log_locked(fd);
+  }
+
+  pthread_mutex_unlock(&nrl_buffer_mutex);
+
+  return true;
+}
+
+void nrl_set_log_buffer_size(size_t size) {
+  pthread_mutex_lock(&nrl_buffer_mutex);
+
+  nrl_flush_log_locked(logfile_fd);
+  nr_free(nrl_buffer.data);
+  nrl_buffer.size = 0;
+  nrl_buffer_reset_locked();
+
+  if (size > 0) {
+    nrl_buffer.data = (char*)nr_malloc(size);
+    nrl_buffer.size = size;
+    nrl_buffer.last_flush = time(0);
+  }
+
+  pthread_mutex_unlock(&nrl_buffer_mutex);
+}
+
+void nrl_flush_log(void) {
+  if (0 == nrl_buffer.size) {
+    return;
+  }
+
+  pthread_mutex_lock(&nrl_buffer_mutex);
+  nrl_flush_log_locked(logfile_fd);
+  pthread_mutex_unlock(&nrl_buffer_mutex);
+}
+
+void nrl_flush_log_signal_safe(void) {
+  struct iovec iov[2];
+  int iovcnt = 1;
+  size_t start = nrl_buffer.start;
+  size_t used = nrl_buffer.used;
+  size_t first;
+
+  if ((-1 == logfile_fd) || (0 == nrl_buffer.size) || (0 == used)
+      || (start >= nrl_buffer.size) || (used > nrl_buffer.size)
+      || (nrl_buffer.pid != nr_getpid())) {
+    return;
+  }
+
+  first = nrl_buffer.size - start;
+  if (first > used) {
+    first = used;
+  }
+  iov[0].iov_base = nrl_buffer.data + start;
+  iov[0].iov_len = first;
+  if (first < used) {
+    iov[1].iov_base = nrl_buffer.data;
+    iov[1].iov_len = used - first;
+    iovcnt = 2;
+  }
+
+  nr_writev(logfile_fd, iov, iovcnt);
+}
+
 static nr_status_t nrl_send_log_message_internal(int fd,
                                                  nrloglev_t level,
                                                  const char* fmt,
@@ -169,7 +495,6 @@ static nr_status_t nrl_send_log_message_internal(int fd,
   char preamble[128];
   struct iovec miov[3];
   struct timeval tv;
-  char log_timestamp[128];
   char* msg;
   int preamble_len;
   int msg_len;
@@ -186,14 +511,22 @@ static nr_status_t nrl_send_log_message_internal(int fd,
     return NR_FAILURE;
   }
 
+  if (nrl_buffer.size) {
+    if (nrl_buffer_log_message(fd, level, fmt, ap)) {
+      return NR_SUCCESS;
+    }
+
+    /*
+     * The line couldn't be buffered. Write out what has been buffered so far
+     * so that the line is written in order.
+     */
+    nrl_flush_log();
+  }
+
   tv.tv_sec = 0;
   gettimeofday(&tv, 0);
-  log_timestamp[0] = '\0';
-  nrl_format_timestamp(log_timestamp, sizeof(log_timestamp), &tv);
 
-  preamble_len
-      = snprintf(preamble, sizeof(preamble), "%s (%d %d) %s: ", log_timestamp,
-                 nr_getpid(), nr_gettid(), level_names[level]);
+  preamble_len = nrl_format_preamble(preamble, sizeof(preamble), level, &tv);
 
   if (-1 == preamble_len) {
     return NR_FAILURE;
@@ -10,6 +10,7 @@
 #define UTIL_LOGGING_HDR
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "nr_axiom.h"
@@ -163,6 +164,38 @@ static inline int nrl_should_print(nrloglev_t level, uint32_t subsystem) {
 extern nr_status_t nrl_set_log_file(const char* filename);
 extern void nrl_close_log_file(void);
 
+/*
+ * Purpose : Enable or disable buffering of log messages.
+ *
+ * Params  : 1. The size of the log buffer in bytes, or 0 to write each log
+ *              message to the log file as it is logged.
+ *
+ * Notes   : Buffered log messages are formatted into a process-wide ring
+ *           buffer without allocating memory, and written to the log file
+ *           when the buffer is full, at least once a second while messages
+ *           are being logged, whenever a warning or error is logged, and by
+ *           nrl_flush_log(). If the log file doesn't accept the data, the
+ *           oldest messages are dropped and a count of them is logged later.
+ *           Messages longer than 4KB are written directly.
+ *
+ *           Like nrl_set_log_file(), this should be called by a single thread
+ *           before logging occurs.
+ */
+extern void nrl_set_log_buffer_size(size_t size);
+
+/*
+ * Purpose : Write any buffered log messages to the log file.
+ */
+extern void nrl_flush_log(void);
+
+/*
+ * Purpose : Write any buffered log messages to the log file from within a
+ *           fatal signal handler. This takes no locks and allocates no
+ *           memory, so the output may be incomplete if another thread was
+ *           logging at the time.
+ */
+extern void nrl_flush_log_signal_safe(void);
+
 /*
  * Purpose : Return the fd of the log file for direct writing / dumping.
  *
@@ -111,34 +111,120 @@ nr_status_t nr_write_full(int fd,
   return NR_SUCCESS;
 }
 
+nr_status_t nr_writev_full(int fd,
+                           struct iovec* iov,
+                           int iovcnt,
+                           nrtime_t deadline) {
+  int err;
+
+  if ((fd < 0) || ((NULL == iov) && (iovcnt > 0)) || (iovcnt < 0)) {
+    errno = EINVAL;
+    return NR_FAILURE;
+  }
+
+  for (;;) {
+    ssize_t rv;
+
+    /*
+     * Skip the buffers that have been written completely, so that a partial
+     * write resumes from the first byte that wasn't written.
+     */
+    while ((iovcnt > 0) && (0 == iov->iov_len)) {
+      iov++;
+      iovcnt--;
+    }
+    if (0 == iovcnt) {
+      return NR_SUCCESS;
+    }
+
+    rv = nr_writev(fd, iov, iovcnt);
+    if (rv >= 0) {
+      size_t written = (size_t)rv;
+
+      while (written > 0) {
+        size_t n = (written < iov->iov_len) ? written : iov->iov_len;
+
+        iov->iov_base = (char*)iov->iov_base + n;
+        iov->iov_len -= n;
+        written -= n;
+        if (0 == iov->iov_len) {
+          iov++;
+          iovcnt--;
+        }
+      }
+      continue;
+    }
+
+    err = errno;
+    if (EINTR == err) {
+      continue;
+    }
+
+    if ((EAGAIN != err) && (EWOULDBLOCK != err)) {
+      return NR_FAILURE;
+    }
+
+    if (NR_FAILURE == nr_wait_fd(fd, POLLOUT, deadline)) {
+      return NR_FAILURE;
+    }
+  }
+}
+
 nr_status_t nr_write_message(int fd,
                              const void* buf,
                              size_t len,
                              nrtime_t deadline) {
-  nrbuf_t* header;
-  nr_status_t st;
+  struct iovec iov;
 
-  if ((fd < 0) || (NULL == buf)) {
+  if (NULL == buf) {
     errno = EINVAL;
     return NR_FAILURE;
   }
-  if (len > NR_PROTOCOL_CMDLEN_MAX_BYTES) {
+
+  iov.iov_base = (void*)((uintptr_t)buf);
+  iov.iov_len = len;
+
+  return nr_write_message_vectored(fd, &iov, 1, deadline);
+}
+
+nr_status_t nr_write_message_vectored(int fd,
+                                      const struct iovec* iov,
+                                      int iovcnt,
+                                      nrtime_t deadline) {
+  struct iovec frames[NR_WRITE_MESSAGE_MAX_IOV + 1];
+  uint8_t preamble[NR_PROCOTOL_PREAMBLE_LENGTH];
+  size_t len = 0;
+  int i;
+
+  if ((fd < 0) || (NULL == iov) || (iovcnt < 1)
+      || (iovcnt > NR_WRITE_MESSAGE_MAX_IOV)) {
     errno = EINVAL;
     return NR_FAILURE;
   }
 
-  header = nr_buffer_create(NR_PROCOTOL_PREAMBLE_LENGTH, 0);
-  nr_protocol_write_preamble(header, len);
-
-  st = nr_write_full(fd, nr_buffer_cptr(header), nr_buffer_len(header),
-                     deadline);
-  nr_buffer_destroy(&header);
-
-  if (NR_FAILURE == st) {
+  for (i = 0; i < iovcnt; i++) {
+    if ((NULL == iov[i].iov_base) && (iov[i].iov_len > 0)) {
+      errno = EINVAL;
+      return NR_FAILURE;
+    }
+    len += iov[i].iov_len;
+  }
+  if (len > NR_PROTOCOL_CMDLEN_MAX_BYTES) {
+    errno = EINVAL;
     return NR_FAILURE;
   }
 
-  return nr_write_full(fd, buf, len, deadline);
+  /*
+   * The preamble and the message body are written with a single call, so
+   * that the body doesn't need to be copied after the preamble, and a small
+   * message doesn't need two system calls.
+   */
+  nr_protocol_preamble_encode(preamble, (uint32_t)len);
+  frames[0].iov_base = preamble;
+  frames[0].iov_len = sizeof(preamble);
+  nr_memcpy(&frames[1], iov, iovcnt * sizeof(struct iovec));
+
+  return nr_writev_full(fd, frames, iovcnt + 1, deadline);
 }
 
 static nrbuf_t* nrn_read_internal(int fd,
@@ -205,6 +291,16 @@ nrbuf_t* nrn_read(int fd, int nbytes, nrtime_t deadline) {
   return reply;
 }
 
+void nr_protocol_preamble_encode(uint8_t* preamble, uint32_t datalen) {
+  uint32_t format = NR_PREAMBLE_FORMAT;
+  int i;
+
+  for (i = 0; i < 4; i++) {
+    preamble[i] = (uint8_t)(datalen >> (8 * i));
+    preamble[4 + i] = (uint8_t)(format >> (8 * i));
+  }
+}
+
 void nr_protocol_write_preamble(nrbuf_t* buf, uint32_t datalen) {
   nr_buffer_write_uint32_t_le(buf, datalen);
   nr_buffer_write_uint32_t_le(buf, NR_PREAMBLE_FORMAT);
@@ -21,6 +21,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
 
 #include "nr_axiom.h"
 #include "util_buffer.h"
@@ -67,6 +68,35 @@ extern nr_status_t nr_write_message(int fd,
                                     size_t len,
                                     nrtime_t deadline);
 
+/*
+ * The maximum number of buffers that may make up a message written with
+ * nr_write_message_vectored().
+ */
+#define NR_WRITE_MESSAGE_MAX_IOV 8
+
+/*
+ * Purpose : Write a message whose body is split across several buffers to a
+ *           file descriptor. The preamble and the buffers are written with
+ *           writev(), so the body is never copied into contiguous memory.
+ *
+ * Params  : 1. The destination.
+ *           2. The buffers that make up the message body, in order.
+ *           3. The number of buffers, at most NR_WRITE_MESSAGE_MAX_IOV.
+ *           4. The write deadline or zero for none. The deadline should
+ *              be expressed as a point in time (i.e. absolute) rather than
+ *              a timeout.
+ *
+ * Returns : NR_SUCCESS if the complete message was sent; otherwise,
+ *           NR_FAILURE.
+ *
+ * Notes   : As with nr_write_message(), errno is set to ETIMEDOUT if the
+ *           complete message could not be written prior to the deadline.
+ */
+extern nr_status_t nr_write_message_vectored(int fd,
+                                             const struct iovec* iov,
+                                             int iovcnt,
+                                             nrtime_t deadline);
+
 /*
  * Purpose : Write to a file descriptor with an optional deadline.
  *
@@ -87,6 +117,26 @@ extern nr_status_t nr_write_full(int fd,
                                  size_t len,
                                  nrtime_t deadline);
 
+/*
+ * Purpose : Write several buffers to a file descriptor with an optional
+ *           deadline, resuming after partial writes.
+ *
+ * Params  : 1. The destination.
+ *           2. The buffers to write. The array is updated as data is
+ *              written, and its contents are unspecified on return.
+ *           3. The number of buffers.
+ *           4. The deadline for the write or zero for none.
+ *
+ * Returns : NR_SUCCESS if all of the data was written; otherwise, NR_FAILURE.
+ *
+ * Notes   : This function shall set errno to ETIMEDOUT and return NR_FAILURE
+ *           if the data could not be written prior to the deadline.
+ */
+extern nr_status_t nr_writev_full(int fd,
+                                  struct iovec* iov,
+                                  int iovcnt,
+                                  nrtime_t deadline);
+
 typedef enum _nr_network_status_t {
   /*
    * The call resulted in an error other than EAGAIN/EWOULDBLOCK/EINTR.
@@ -162,4 +212,10 @@ extern nr_status_t nr_network_set_non_blocking(int fd);
  */
 extern void nr_protocol_write_preamble(nrbuf_t* buf, uint32_t datalen);
 
+/*
+ * Purpose : Encode the protocol preamble into NR_PROCOTOL_PREAMBLE_LENGTH
+ *           bytes of memory.
+ */
+extern void nr_protocol_preamble_encode(uint8_t* preamble, uint32_t datalen);
+
 #endif /* UTIL_NETWORK_HDR */
@@ -83,6 +83,11 @@ void nr_signal_tracer_common(int sig) {
     return;
   }
 
+  /*
+   * Write out any buffered log messages first, as they may explain the crash.
+   */
+  nrl_flush_log_signal_safe();
+
   if (SIGSEGV == sig) {
     signal_name = "segmentation violation";
   } else if (SIGFPE == sig) {
@@ -10,11 +10,210 @@
 #include "util_logging.h"
 #include "util_memory.h"
 #include "util_slab_private.h"
+#include "util_threads.h"
 
-static nr_slab_page_t* nr_slab_page_create(size_t page_size,
+/*
+ * Pages belonging to destroyed slab allocators are kept in a process-wide
+ * cache, up to a limit, so that the next slab allocator (typically the
+ * segment slab of the next transaction) can reuse them instead of going back
+ * to malloc() and having the kernel fault in and zero fresh pages.
+ *
+ * The cached pages are kept as a singly linked list through their prev
+ * pointers, most recently cached first. The used field of a cached page
+ * records how much of it was handed out, since only that part needs to be
+ * zeroed again before it is reused.
+ *
+ * The limit only bounds the cache: after a spike (one very large transaction,
+ * say) it would otherwise stay full of pages that later slab allocators never
+ * need. So the cache also tracks its high-water mark, the most bytes of pages
+ * handed back by a single slab allocator, and every
+ * NR_SLAB_PAGE_CACHE_TRIM_INTERVAL slab allocators it frees the idle pages
+ * that keep it above the mark and starts a new interval.
+ */
+static struct {
+  nrthread_mutex_t mutex;
+  nr_slab_page_t* pages;
+  size_t bytes;
+  size_t limit;
+  size_t high_water; /* The high-water mark for the current interval */
+  size_t puts;       /* Slab allocators destroyed in the current interval */
+} nr_slab_page_cache = {
+    .mutex = NRTHREAD_MUTEX_INITIALIZER,
+    .pages = NULL,
+    .bytes = 0,
+    .limit = NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT,
+    .high_water = 0,
+    .puts = 0,
+};
+
+static void nr_slab_page_list_free(nr_slab_page_t* pages) {
+  while (pages) {
+    nr_slab_page_t* prev = pages->prev;
+
+    nr_free(pages);
+    pages = prev;
+  }
+}
+
+/*
+ * Purpose : Take a page of at least the given size from the page cache.
+ *
+ * Returns : The largest cached page that is big enough, or NULL if there is
+ *           none. Preferring the largest page means that a transaction that
+ *           follows a large one needs fewer, bigger pages.
+ */
+static nr_slab_page_t* nr_slab_page_cache_take(size_t page_size) {
+  nr_slab_page_t** best = NULL;
+  nr_slab_page_t** iter;
+  nr_slab_page_t* page = NULL;
+
+  nrt_mutex_lock(&nr_slab_page_cache.mutex);
+  for (iter = &nr_slab_page_cache.pages; *iter; iter = &(*iter)->prev) {
+    if ((*iter)->size >= page_size
+        && (NULL == best || (*iter)->size > (*best)->size)) {
+      best = iter;
+    }
+  }
+  if (best) {
+    page = *best;
+    *best = page->prev;
+    nr_slab_page_cache.bytes -= page->size;
+  }
+  nrt_mutex_unlock(&nr_slab_page_cache.mutex);
+
+  return page;
+}
+
+/*
+ * Purpose : Put a list of pages into the page cache.
+ *
+ * Params  : 1. The list of pages.
+ *           2. A list of pages to be freed.
+ *
+ * Returns : The list of pages to be freed, with the pages that would have
+ *           taken the cache over its limit added. The caller must free them
+ *           once the mutex has been released.
+ *
+ * Warning : The page cache's mutex must be held.
+ */
+static nr_slab_page_t* nr_slab_page_cache_add_locked(nr_slab_page_t* pages,
+                                                     nr_slab_page_t* excess) {
+  while (pages) {
+    nr_slab_page_t* prev = pages->prev;
+
+    if (nr_slab_page_cache.bytes + pages->size <= nr_slab_page_cache.limit) {
+      pages->prev = nr_slab_page_cache.pages;
+      nr_slab_page_cache.pages = pages;
+      nr_slab_page_cache.bytes += pages->size;
+    } else {
+      pages->prev = excess;
+      excess = pages;
+    }
+    pages = prev;
+  }
+
+  return excess;
+}
+
+/*
+ * Purpose : Trim the page cache to a number of bytes, keeping the most
+ *           recently cached pages.
+ *
+ * Params  : 1. The number of bytes to keep.
+ *           2. A list of pages to be freed.
+ *
+ * Returns : The list of pages to be freed, with the trimmed pages added. The
+ *           caller must free them once the mutex has been released.
+ *
+ * Warning : The page cache's mutex must be held.
+ */
+static nr_slab_page_t* nr_slab_page_cache_trim_locked(size_t max_bytes,
+                                                      nr_slab_page_t* excess) {
+  nr_slab_page_t** iter = &nr_slab_page_cache.pages;
+  size_t kept = 0;
+
+  while (*iter) {
+    nr_slab_page_t* page = *iter;
+
+    if (kept + page->size <= max_bytes) {
+      kept += page->size;
+      iter = &page->prev;
+    } else {
+      *iter = page->prev;
+      page->prev = excess;
+      excess = page;
+    }
+  }
+  nr_slab_page_cache.bytes = kept;
+
+  return excess;
+}
+
+/*
+ * Purpose : Put the pages of a destroyed slab allocator into the page cache,
+ *           freeing any that would take the cache over its limit, and trim
+ *           idle pages at the end of each interval.
+ */
+static void nr_slab_page_cache_put(nr_slab_page_t* pages) {
+  nr_slab_page_t* excess = NULL;
+  nr_slab_page_t* iter;
+  size_t returned = 0;
+
+  for (iter = pages; iter; iter = iter->prev) {
+    returned += iter->size;
+  }
+
+  nrt_mutex_lock(&nr_slab_page_cache.mutex);
+  excess = nr_slab_page_cache_add_locked(pages, excess);
+
+  if (returned > nr_slab_page_cache.high_water) {
+    nr_slab_page_cache.high_water = returned;
+  }
+  nr_slab_page_cache.puts += 1;
+
+  if (nr_slab_page_cache.puts >= NR_SLAB_PAGE_CACHE_TRIM_INTERVAL) {
+    excess = nr_slab_page_cache_trim_locked(nr_slab_page_cache.high_water,
+                                            excess);
+    nr_slab_page_cache.high_water = 0;
+    nr_slab_page_cache.puts = 0;
+  }
+  nrt_mutex_unlock(&nr_slab_page_cache.mutex);
+
+  nr_slab_page_list_free(excess);
+}
+
+static nr_slab_page_t* nr_slab_page_create(nr_slab_t* slab,
                                            nr_slab_page_t* prev) {
+  size_t page_size = slab->page_size;
   nr_slab_page_t* page;
 
+  page = nr_slab_page_cache_take(page_size);
+  if (page) {
+    /*
+     * Only the part of the page that was handed out last time can be dirty:
+     * the rest is still zeroed from when the page was allocated.
+     */
+    memset(page->data, 0, page->used);
+    slab->page_cache_hits += 1;
+
+    /*
+     * Carry on growing from the size of the page actually used.
+     */
+    page_size = page->size;
+    slab->page_size = page_size;
+
+    *page = (nr_slab_page_t){
+        .size = page_size,
+        .capacity = page_size - sizeof(nr_slab_page_t),
+        .used = 0,
+        .prev = prev,
+    };
+
+    return page;
+  }
+
+  slab->page_cache_misses += 1;
+
   /*
    * Traditionally, one would implement this kind of allocator on top of
    * mmap(). In practice, though, the libc on our supported operating systems
@@ -37,6 +236,7 @@ static nr_slab_page_t* nr_slab_page_create(size_t page_size,
   }
 
   *page = (nr_slab_page_t){
+      .size = page_size,
       .capacity = page_size - sizeof(nr_slab_page_t),
       .used = 0,
       .prev = prev,
@@ -45,6 +245,41 @@ static nr_slab_page_t* nr_slab_page_create(size_t page_size,
   return page;
 }
 
+void nr_slab_page_cache_set_limit(size_t limit) {
+  nr_slab_page_t* excess;
+
+  nrt_mutex_lock(&nr_slab_page_cache.mutex);
+  nr_slab_page_cache.limit = limit;
+  excess = nr_slab_page_cache_trim_locked(limit, NULL);
+  nrt_mutex_unlock(&nr_slab_page_cache.mutex);
+
+  nr_slab_page_list_free(excess);
+}
+
+void nr_slab_page_cache_clear(void) {
+  nr_slab_page_t* pages;
+
+  nrt_mutex_lock(&nr_slab_page_cache.mutex);
+  pages = nr_slab_page_cache.pages;
+  nr_slab_page_cache.pages = NULL;
+  nr_slab_page_cache.bytes = 0;
+  nr_slab_page_cache.high_water = 0;
+  nr_slab_page_cache.puts = 0;
+  nrt_mutex_unlock(&nr_slab_page_cache.mutex);
+
+  nr_slab_page_list_free(pages);
+}
+
+size_t nr_slab_page_cache_size(void) {
+  size_t bytes;
+
+  nrt_mutex_lock(&nr_slab_page_cache.mutex);
+  bytes = nr_slab_page_cache.bytes;
+  nrt_mutex_unlock(&nr_slab_page_cache.mutex);
+
+  return bytes;
+}
+
 nr_slab_t* nr_slab_create(size_t object_size, size_t page_size) {
   nr_slab_t* slab;
   long sys_page_size;
@@ -109,10 +344,13 @@ nr_slab_t* nr_slab_create(size_t object_size, size_t page_size) {
     return NULL;
   }
 
+  slab->page_cache_hits = 0;
+  slab->page_cache_misses = 0;
+
   /*
    * Create the first page.
    */
-  slab->head = nr_slab_page_create(slab->page_size, NULL);
+  slab->head = nr_slab_page_create(slab, NULL);
 
   /*
    * Set up the free list. The default 128 capacity was cargo culted from the
@@ -127,7 +365,6 @@ nr_slab_t* nr_slab_create(size_t object_size, size_t page_size) {
 
 void nr_slab_destroy(nr_slab_t** slab_ptr) {
   nr_slab_t* slab;
-  nr_slab_page_t* head;
 
   if (nrunlikely(NULL == slab_ptr || NULL == *slab_ptr)) {
     return;
@@ -137,16 +374,10 @@ void nr_slab_destroy(nr_slab_t** slab_ptr) {
   nr_vector_deinit(&slab->free_list);
 
   /*
-   * Actually destroying the slab allocator is easy: we just free each page
-   * until we have no more pages.
+   * Actually destroying the slab allocator is easy: we just hand each page
+   * to the page cache, which frees any it has no room for.
    */
-  head = slab->head;
-  while (head) {
-    nr_slab_page_t* prev = head->prev;
-
-    nr_free(head);
-    head = prev;
-  }
+  nr_slab_page_cache_put(slab->head);
 
   nr_realfree((void**)slab_ptr);
 }
@@ -190,7 +421,7 @@ void* nr_slab_next(nr_slab_t* slab) {
       slab->page_size *= 2;
     }
 
-    new_page = nr_slab_page_create(slab->page_size, slab->head);
+    new_page = nr_slab_page_create(slab, slab->head);
     if (nrunlikely(NULL == new_page)) {
       return NULL;
     }
@@ -224,6 +455,22 @@ bool nr_slab_release(nr_slab_t* slab, void* obj) {
   return nr_vector_push_back(&slab->free_list, obj);
 }
 
+size_t nr_slab_page_cache_hits(const nr_slab_t* slab) {
+  if (slab) {
+    return slab->page_cache_hits;
+  } else {
+    return 0;
+  }
+}
+
+size_t nr_slab_page_cache_misses(const nr_slab_t* slab) {
+  if (slab) {
+    return slab->page_cache_misses;
+  } else {
+    return 0;
+  }
+}
+
 size_t nr_slab_count(const nr_slab_t* slab) {
   if (slab) {
     return slab->count;
@@ -14,6 +14,12 @@
 
 typedef struct _nr_slab_t nr_slab_t;
 
+/*
+ * The default maximum number of bytes of pages kept in the process-wide page
+ * cache once their slab allocators have been destroyed.
+ */
+#define NR_SLAB_PAGE_CACHE_DEFAULT_LIMIT (4 * 1024 * 1024)
+
 /*
  * Purpose : Create a slab allocator for homogeneous objects.
  *
@@ -40,6 +46,12 @@ extern nr_slab_t* nr_slab_create(size_t object_size, size_t page_size);
  * Purpose : Destroy a slab allocator.
  *
  * Params  : 1. A pointer to the slab allocator to destroy.
+ *
+ * Notes   : The slab allocator's pages are kept in a process-wide page cache
+ *           for reuse by later slab allocators, as long as the cache stays
+ *           within its limit. Pages beyond the limit are freed, as are cached
+ *           pages that stay idle while the cache is larger than recent slab
+ *           allocators have needed.
  */
 extern void nr_slab_destroy(nr_slab_t** slab_ptr);
 
@@ -77,4 +89,35 @@ extern bool nr_slab_release(nr_slab_t* slab, void* obj);
  */
 extern size_t nr_slab_count(const nr_slab_t* slab);
 
+/*
+ * Purpose : Return the number of pages a slab allocator took from the
+ *           process-wide page cache, and the number it had to allocate.
+ *
+ * Params  : 1. The slab allocator.
+ *
+ * Returns : The number of pages.
+ */
+extern size_t nr_slab_page_cache_hits(const nr_slab_t* slab);
+extern size_t nr_slab_page_cache_misses(const nr_slab_t* slab);
+
+/*
+ * Purpose : Set the maximum number of bytes of pages kept in the process-wide
+ *           page cache. Cached pages beyond the new limit are freed.
+ *
+ * Params  : 1. The limit in bytes. 0 disables the cache and frees every cached
+ *              page.
+ */
+extern void nr_slab_page_cache_set_limit(size_t limit);
+
+/*
+ * Purpose : Free every page in the process-wide page cache.
+ */
+extern void nr_slab_page_cache_clear(void);
+
+/*
+ * Purpose : Return the number of bytes of pages currently in the process-wide
+ *           page cache.
+ */
+extern size_t nr_slab_page_cache_size(void);
+
 #endif /* UTIL_SLAB_HDR */
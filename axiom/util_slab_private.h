@@ -8,6 +8,12 @@
 
 #include "util_vector.h"
 
+/*
+ * The number of slab allocators destroyed between each trim of the idle pages
+ * in the process-wide page cache.
+ */
+#define NR_SLAB_PAGE_CACHE_TRIM_INTERVAL 64
+
 /*
  * A page within the slab allocator.
  *
@@ -20,6 +26,7 @@ typedef struct _nr_slab_page_t {
   // The capacity and amount used are stored in bytes, not objects. (If we ever
   // decide to extend this to support heterogeneous object allocation, that'll
   // be handy.)
+  size_t size; /* The size of the allocation, including this header. */
   size_t capacity;
   size_t used;
 
@@ -40,6 +47,8 @@ struct _nr_slab_t {
   size_t object_size;
   size_t page_size;
   size_t count; /* The total number of objects returned from the slab. */
+  size_t page_cache_hits;   /* Pages taken from the process page cache. */
+  size_t page_cache_misses; /* Pages that had to be allocated. */
 };
 
 #endif /* UTIL_SLAB_PRIVATE_HDR */
@@ -133,6 +133,102 @@ nr_status_t nrt_mutex_destroy_f(nrthread_mutex_t* mutex,
   return NR_SUCCESS;
 }
 
+nr_status_t nrt_cond_init_f(nrthread_cond_t* cond,
+                            const char* file,
+                            int line) {
+  int ret;
+
+  if (0 == cond) {
+    return NR_FAILURE;
+  }
+
+  ret = pthread_cond_init((pthread_cond_t*)cond, NULL);
+  if (0 != ret) {
+    nrl_error(NRL_THREADS, "nrt_cond_init failed: %.16s [%.150s:%d]",
+              nr_errno(ret), file, line);
+    return NR_FAILURE;
+  }
+
+  return NR_SUCCESS;
+}
+
+nr_status_t nrt_cond_destroy_f(nrthread_cond_t* cond,
+                               const char* file,
+                               int line) {
+  int ret;
+
+  if (0 == cond) {
+    return NR_FAILURE;
+  }
+
+  ret = pthread_cond_destroy((pthread_cond_t*)cond);
+  if (0 != ret) {
+    nrl_error(NRL_THREADS, "nrt_cond_destroy failed: %.16s [%.150s:%d]",
+              nr_errno(ret), file, line);
+    return NR_FAILURE;
+  }
+
+  return NR_SUCCESS;
+}
+
+nr_status_t nrt_cond_wait_f(nrthread_cond_t* cond,
+                            nrthread_mutex_t* mutex,
+                            const char* file,
+                            int line) {
+  int ret;
+
+  if ((0 == cond) || (0 == mutex)) {
+    return NR_FAILURE;
+  }
+
+  ret = pthread_cond_wait((pthread_cond_t*)cond, (pthread_mutex_t*)mutex);
+  if (0 != ret) {
+    nrl_error(NRL_THREADS, "nrt_cond_wait failed: %.16s [%.150s:%d]",
+              nr_errno(ret), file, line);
+    return NR_FAILURE;
+  }
+
+  return NR_SUCCESS;
+}
+
+nr_status_t nrt_cond_signal_f(nrthread_cond_t* cond,
+                              const char* file,
+                              int line) {
+  int ret;
+
+  if (0 == cond) {
+    return NR_FAILURE;
+  }
+
+  ret = pthread_cond_signal((pthread_cond_t*)cond);
+  if (0 != ret) {
+    nrl_error(NRL_THREADS, "nrt_cond_signal failed: %.16s [%.150s:%d]",
+              nr_errno(ret), file, line);
+    return NR_FAILURE;
+  }
+
+  return NR_SUCCESS;
+}
+
+nr_status_t nrt_cond_broadcast_f(nrthread_cond_t* cond,
+                                 const char* file,
+                                 int line) {
+  int ret;
+
+  if (0 == cond) {
+    return NR_FAILURE;
+  }
+
+  ret = pthread_cond_broadcast((pthread_cond_t*)cond);
+  if (0 != ret) {
+    nrl_error(NRL_THREADS, "nrt_cond_broadcast failed: %.16s [%.150s:%d]",
+              nr_errno(ret), file, line);
+    return NR_FAILURE;
+  }
+
+  return NR_SUCCESS;
+}
+
 nr_status_t nrt_join_f(nrthread_t thread,
                        void** valptr,
                        const char* file,
@@ -20,8 +20,10 @@ typedef pthread_mutex_t nrthread_mutex_t;
 typedef pthread_t nrthread_t;
 typedef pthread_attr_t nrthread_attr_t;
 typedef pthread_mutexattr_t nrthread_mutexattr_t;
+typedef pthread_cond_t nrthread_cond_t;
 
 #define NRTHREAD_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#define NRTHREAD_COND_INITIALIZER PTHREAD_COND_INITIALIZER
 
 typedef void*(nrt_start_routine_t)(void*);
 
@@ -66,6 +68,44 @@ extern nr_status_t nrt_mutex_unlock_f(nrthread_mutex_t* mutex,
                                       const char* file,
                                       int line);
 
+/*
+ * Purpose : Initializes or destroys a condition variable.
+ * Returns : NR_SUCCESS or NR_FAILURE.
+ * See     :
+ * http://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_cond_init.html
+ */
+extern nr_status_t nrt_cond_init_f(nrthread_cond_t* cond,
+                                   const char* file,
+                                   int line);
+extern nr_status_t nrt_cond_destroy_f(nrthread_cond_t* cond,
+                                      const char* file,
+                                      int line);
+
+/*
+ * Purpose : Wait on a condition variable. The mutex must be locked by the
+ *           caller, and is locked again when this function returns.
+ * Returns : NR_SUCCESS or NR_FAILURE.
+ * See     :
+ * http://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_cond_wait.html
+ */
+extern nr_status_t nrt_cond_wait_f(nrthread_cond_t* cond,
+                                   nrthread_mutex_t* mutex,
+                                   const char* file,
+                                   int line);
+
+/*
+ * Purpose : Wake one or all of the threads waiting on a condition variable.
+ * Returns : NR_SUCCESS or NR_FAILURE.
+ * See     :
+ * http://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_cond_signal.html
+ */
+extern nr_status_t nrt_cond_signal_f(nrthread_cond_t* cond,
+                                     const char* file,
+                                     int line);
+extern nr_status_t nrt_cond_broadcast_f(nrthread_cond_t* cond,
+                                        const char* file,
+                                        int line);
+
 /*
  * Purpose : Wait for thread termination.
  * Returns : NR_SUCCESS or NR_FAILURE.
@@ -85,6 +125,11 @@ extern nr_status_t nrt_join_f(nrthread_t thread,
 #define nrt_mutex_unlock(T) nrt_mutex_unlock_f((T), __FILE__, __LINE__)
 #define nrt_mutex_destroy(T) nrt_mutex_destroy_f((T), __FILE__, __LINE__)
 #define nrt_join(T, V) nrt_join_f((T), (V), __FILE__, __LINE__)
+#define nrt_cond_init(C) nrt_cond_init_f((C), __FILE__, __LINE__)
+#define nrt_cond_destroy(C) nrt_cond_destroy_f((C), __FILE__, __LINE__)
+#define nrt_cond_wait(C, M) nrt_cond_wait_f((C), (M), __FILE__, __LINE__)
+#define nrt_cond_signal(C) nrt_cond_signal_f((C), __FILE__, __LINE__)
+#define nrt_cond_broadcast(C) nrt_cond_broadcast_f((C), __FILE__, __LINE__)
 
 /*
  * Set up a nrt_thread_local storage class for thread local variables.
@@ -104,4 +149,30 @@ extern nr_status_t nrt_join_f(nrthread_t thread,
 #error "Unsupported compiler: don't know how to define thread local variables."
 #endif
 
+/*
+ * Atomic loads and stores for values that are published by one thread and
+ * read by others without holding a lock. A store with release semantics makes
+ * every write that preceded it visible to a thread that observes the stored
+ * value through a load with acquire semantics.
+ *
+ * nrt_atomic_add_fetch and nrt_atomic_sub_fetch return the new value, and
+ * suit reference counts. nrt_atomic_compare_exchange stores V in *P only if
+ * *P equals *E, returning true if it did; otherwise the current value of *P
+ * is written to *E.
+ */
+#if defined(__GNUC__)
+#define nrt_atomic_load_acquire(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#define nrt_atomic_store_release(P, V) \
+  __atomic_store_n((P), (V), __ATOMIC_RELEASE)
+#define nrt_atomic_add_fetch(P, V) \
+  __atomic_add_fetch((P), (V), __ATOMIC_ACQ_REL)
+#define nrt_atomic_sub_fetch(P, V) \
+  __atomic_sub_fetch((P), (V), __ATOMIC_ACQ_REL)
+#define nrt_atomic_compare_exchange(P, E, V)                      \
+  __atomic_compare_exchange_n((P), (E), (V), 0, __ATOMIC_ACQ_REL, \
+                              __ATOMIC_ACQUIRE)
+#else
+#error "Unsupported compiler: don't know how to define atomic operations."
+#endif
+
 #endif /* UTIL_THREADS_HDR */
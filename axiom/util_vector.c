@@ -285,6 +285,62 @@ bool nr_vector_sort(nr_vector_t* v,
   return true;
 }
 
+bool nr_vector_select(nr_vector_t* v,
+                      size_t pos,
+                      nr_vector_cmp_t comparator,
+                      void* userdata) {
+  void** elements;
+  ssize_t left;
+  ssize_t right;
+  ssize_t k;
+
+  if (NULL == v || NULL == comparator || pos >= v->used) {
+    return false;
+  }
+
+  /*
+   * Hoare's FIND, as refined by Wirth: partition around the element currently
+   * at the selected position, then continue within whichever side still
+   * contains that position.
+   */
+  elements = v->elements;
+  left = 0;
+  right = (ssize_t)v->used - 1;
+  k = (ssize_t)pos;
+
+  while (left < right) {
+    void* pivot = elements[k];
+    ssize_t i = left;
+    ssize_t j = right;
+
+    do {
+      while ((comparator)(elements[i], pivot, userdata) < 0) {
+        i++;
+      }
+      while ((comparator)(pivot, elements[j], userdata) < 0) {
+        j--;
+      }
+      if (i <= j) {
+        void* tmp = elements[i];
+
+        elements[i] = elements[j];
+        elements[j] = tmp;
+        i++;
+        j--;
+      }
+    } while (i <= j);
+
+    if (j < k) {
+      left = i;
+    }
+    if (k < i) {
+      right = j;
+    }
+  }
+
+  return true;
+}
+
 bool nr_vector_iterate(nr_vector_t* v,
                        nr_vector_iter_t callback,
                        void* userdata) {
@@ -257,6 +257,30 @@ extern bool nr_vector_sort(nr_vector_t* v,
                            nr_vector_cmp_t comparator,
                            void* userdata);
 
+/*
+ * Purpose : Partially sort a vector in place, so that the element at the given
+ *           position is the one that would be there if the vector were fully
+ *           sorted, no element before it compares greater than it, and no
+ *           element after it compares less than it.
+ *
+ *           This runs in linear time on average, and is useful for finding the
+ *           n greatest or least elements in a vector without sorting it.
+ *
+ * Params  : 1. The vector.
+ *           2. The position to select.
+ *           3. The comparison function to use when comparing elements within
+ *              the vector. See nr_sort()'s compar documentation for more
+ *              detail.
+ *           4. The userdata to pass to the comparison function.
+ *
+ * Returns : True if the vector was successfully partially sorted; false
+ *           otherwise.
+ */
+extern bool nr_vector_select(nr_vector_t* v,
+                             size_t pos,
+                             nr_vector_cmp_t comparator,
+                             void* userdata);
+
 typedef bool (*nr_vector_iter_t)(void* element, void* userdata);
 
 /*
@@ -251,6 +251,7 @@ type Config struct {
 	IntegrationMode    bool           `config:"-"`                              // Whether to log integration test output
 	AppTimeout         config.Timeout `config:"app_timeout"`                    // Inactivity timeout for applications.
 	WaitForPort        time.Duration  `config:"wait_for_port"`                  // How long to wait for the worker process to open a port.
+	ConnectCacheFile   string         `config:"connect_cache_file"`             // Path to the file used to persist connect replies across restarts.
 }
 
 func (cfg *Config) MakeUtilConfig() utilization.Config {
@@ -112,10 +112,11 @@ func runWorker(cfg *Config) {
 	}
 
 	p := newrelic.NewProcessor(newrelic.ProcessorConfig{
-		Client:          client,
-		IntegrationMode: cfg.IntegrationMode,
-		UtilConfig:      cfg.MakeUtilConfig(),
-		AppTimeout:      time.Duration(cfg.AppTimeout),
+		Client:           client,
+		IntegrationMode:  cfg.IntegrationMode,
+		UtilConfig:       cfg.MakeUtilConfig(),
+		AppTimeout:       time.Duration(cfg.AppTimeout),
+		ConnectCacheFile: cfg.ConnectCacheFile,
 	})
 	go processTxnData(errorChan, p)
 
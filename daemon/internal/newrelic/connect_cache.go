@@ -0,0 +1,219 @@
+//
+// Copyright 2020 New Relic Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+package newrelic
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"encoding/json"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/newrelic/newrelic-php-agent/daemon/internal/newrelic/limits"
+	"github.com/newrelic/newrelic-php-agent/daemon/internal/newrelic/log"
+)
+
+// ConnectCache persists the most recent successful connect reply for each
+// application to a local file. A daemon that is restarted can then answer
+// the first AppInfo request for a known application immediately, rather than
+// making every agent process wait for a new preconnect and connect round
+// trip to the collector.
+//
+// Entries are keyed by a hash of the complete AppInfo sent by the agent, so
+// that any change to the agent's configuration or version results in a fresh
+// connect, and so that license keys are never written to the file. Should the
+// collector reject a restored agent run ID, the usual restart exception
+// handling reconnects the application and the stale entry is removed.
+//
+// A nil *ConnectCache is valid and caches nothing.
+type ConnectCache struct {
+	path    string
+	maxAge  time.Duration
+	entries map[string]*ConnectCacheEntry
+}
+
+// ConnectCacheEntry is the persisted state of a single connected application.
+type ConnectCacheEntry struct {
+	Collector        string `json:"collector"`
+	ConnectReply     string `json:"connect_reply"`
+	SecurityPolicies string `json:"security_policies"`
+	ConnectTime      int64  `json:"connect_time"`
+}
+
+type connectCacheFile struct {
+	Version int                           `json:"version"`
+	Entries map[string]*ConnectCacheEntry `json:"entries"`
+}
+
+const connectCacheVersion = 1
+
+// connectCacheKey returns the key under which the connect state of the
+// application described by info is stored.
+func connectCacheKey(info *AppInfo) (string, error) {
+	js, err := json.Marshal(info)
+	if nil != err {
+		return "", err
+	}
+	sum := sha256.Sum256(js)
+	return hex.EncodeToString(sum[:]), nil
+}
+
+// NewConnectCache creates a connect cache backed by the file at path and
+// loads any entries that are younger than maxAge. If path is empty, nil is
+// returned. A missing or unreadable file results in an empty cache.
+func NewConnectCache(path string, maxAge time.Duration) *ConnectCache {
+	if "" == path {
+		return nil
+	}
+
+	c := &ConnectCache{
+		path:    path,
+		maxAge:  maxAge,
+		entries: make(map[string]*ConnectCacheEntry),
+	}
+
+	data, err := os.ReadFile(path)
+	if nil != err {
+		if !os.IsNotExist(err) {
+			log.Warnf("unable to read connect cache file %q: %v", path, err)
+		}
+		return c
+	}
+
+	var file connectCacheFile
+	if err := json.Unmarshal(data, &file); nil != err {
+		log.Warnf("unable to parse connect cache file %q: %v", path, err)
+		return c
+	}
+	if connectCacheVersion != file.Version {
+		log.Debugf("ignoring connect cache file %q with version %d",
+			path, file.Version)
+		return c
+	}
+
+	now := time.Now()
+	for key, entry := range file.Entries {
+		if nil != entry && !c.expired(entry, now) {
+			c.entries[key] = entry
+		}
+	}
+
+	log.Debugf("loaded %d entries from connect cache file %q",
+		len(c.entries), path)
+
+	return c
+}
+
+func (c *ConnectCache) expired(entry *ConnectCacheEntry, now time.Time) bool {
+	if c.maxAge <= 0 {
+		return false
+	}
+	return now.Sub(time.Unix(entry.ConnectTime, 0)) >= c.maxAge
+}
+
+// Lookup returns the cached connect state for the application, or nil if
+// there is none or it has expired.
+func (c *ConnectCache) Lookup(info *AppInfo, now time.Time) *ConnectCacheEntry {
+	if nil == c {
+		return nil
+	}
+
+	key, err := connectCacheKey(info)
+	if nil != err {
+		return nil
+	}
+
+	entry := c.entries[key]
+	if nil == entry {
+		return nil
+	}
+	if c.expired(entry, now) {
+		delete(c.entries, key)
+		return nil
+	}
+	return entry
+}
+
+// Store records the connect state of an application and writes the cache
+// file.
+func (c *ConnectCache) Store(info *AppInfo, entry *ConnectCacheEntry) {
+	if nil == c || nil == entry {
+		return
+	}
+
+	key, err := connectCacheKey(info)
+	if nil != err {
+		log.Debugf("unable to compute connect cache key for app '%s': %v",
+			info, err)
+		return
+	}
+
+	now := time.Now()
+	for k, e := range c.entries {
+		if c.expired(e, now) {
+			delete(c.entries, k)
+		}
+	}
+
+	if _, ok := c.entries[key]; !ok && len(c.entries) >= limits.AppLimit {
+		log.Debugf("connect cache is full, not storing app '%s'", info)
+		return
+	}
+
+	c.entries[key] = entry
+	c.save()
+}
+
+// Remove discards the connect state of an application and writes the cache
+// file if an entry was present.
+func (c *ConnectCache) Remove(info *AppInfo) {
+	if nil == c {
+		return
+	}
+
+	key, err := connectCacheKey(info)
+	if nil != err {
+		return
+	}
+
+	if _, ok := c.entries[key]; ok {
+		delete(c.entries, key)
+		c.save()
+	}
+}
+
+// save writes the cache to a temporary file which is then renamed over the
+// cache file, so that a daemon that crashes mid-write never leaves a
+// truncated cache behind.
+func (c *ConnectCache) save() {
+	data, err := json.Marshal(&connectCacheFile{
+		Version: connectCacheVersion,
+		Entries: c.entries,
+	})
+	if nil != err {
+		log.Warnf("unable to encode connect cache: %v", err)
+		return
+	}
+
+	tmp, err := os.CreateTemp(filepath.Dir(c.path), filepath.Base(c.path)+".tmp")
+	if nil != err {
+		log.Warnf("unable to write connect cache file %q: %v", c.path, err)
+		return
+	}
+
+	_, err = tmp.Write(data)
+	if closeErr := tmp.Close(); nil == err {
+		err = closeErr
+	}
+	if nil == err {
+		err = os.Rename(tmp.Name(), c.path)
+	}
+	if nil != err {
+		log.Warnf("unable to write connect cache file %q: %v", c.path, err)
+		os.Remove(tmp.Name())
+	}
+}
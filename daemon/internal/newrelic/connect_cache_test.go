@@ -0,0 +1,192 @@
+//
+// Copyright 2020 New Relic Corporation. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+package newrelic
+
+import (
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/newrelic/newrelic-php-agent/daemon/internal/newrelic/limits"
+)
+
+var sampleConnectCacheEntry = ConnectCacheEntry{
+	Collector:        "specific_collector.com",
+	ConnectReply:     `{"agent_run_id":"one"}`,
+	SecurityPolicies: `{}`,
+}
+
+func TestConnectCacheDisabled(t *testing.T) {
+	c := NewConnectCache("", time.Hour)
+	if nil != c {
+		t.Fatal(c)
+	}
+
+	// A nil cache must be safe to use.
+	c.Store(&sampleAppInfo, &sampleConnectCacheEntry)
+	c.Remove(&sampleAppInfo)
+	if entry := c.Lookup(&sampleAppInfo, time.Now()); nil != entry {
+		t.Fatal(entry)
+	}
+}
+
+func TestConnectCacheRoundTrip(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+
+	entry := sampleConnectCacheEntry
+	entry.ConnectTime = time.Now().Unix()
+
+	c := NewConnectCache(path, time.Hour)
+	c.Store(&sampleAppInfo, &entry)
+
+	c = NewConnectCache(path, time.Hour)
+	got := c.Lookup(&sampleAppInfo, time.Now())
+	if nil == got {
+		t.Fatal("expected cached entry")
+	}
+	if *got != entry {
+		t.Fatal(got, entry)
+	}
+
+	data, err := os.ReadFile(path)
+	if nil != err {
+		t.Fatal(err)
+	}
+	if strings.Contains(string(data), string(sampleAppInfo.License)) {
+		t.Fatal("license key written to connect cache file")
+	}
+
+	c.Remove(&sampleAppInfo)
+	c = NewConnectCache(path, time.Hour)
+	if got := c.Lookup(&sampleAppInfo, time.Now()); nil != got {
+		t.Fatal(got)
+	}
+}
+
+func TestConnectCacheKeyIncludesSettings(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+
+	entry := sampleConnectCacheEntry
+	entry.ConnectTime = time.Now().Unix()
+
+	c := NewConnectCache(path, time.Hour)
+	c.Store(&sampleAppInfo, &entry)
+
+	info := sampleAppInfo
+	info.Settings = map[string]interface{}{"newrelic.enabled": true}
+	if got := c.Lookup(&info, time.Now()); nil != got {
+		t.Fatal(got)
+	}
+
+	info = sampleAppInfo
+	info.AgentVersion = "0.0.2"
+	if got := c.Lookup(&info, time.Now()); nil != got {
+		t.Fatal(got)
+	}
+}
+
+func TestConnectCacheExpiry(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+	now := time.Now()
+
+	entry := sampleConnectCacheEntry
+	entry.ConnectTime = now.Add(-2 * time.Hour).Unix()
+
+	c := NewConnectCache(path, time.Hour)
+	c.entries["stale"] = &entry
+	if got := c.Lookup(&sampleAppInfo, now); nil != got {
+		t.Fatal(got)
+	}
+
+	// Expired entries are pruned when the file is written and when it is
+	// loaded.
+	fresh := sampleConnectCacheEntry
+	fresh.ConnectTime = now.Unix()
+	c.Store(&sampleAppInfo, &fresh)
+	if _, ok := c.entries["stale"]; ok {
+		t.Fatal("stale entry not pruned")
+	}
+
+	c = NewConnectCache(path, time.Hour)
+	if 1 != len(c.entries) {
+		t.Fatal(c.entries)
+	}
+	if got := c.Lookup(&sampleAppInfo, now.Add(2*time.Hour)); nil != got {
+		t.Fatal(got)
+	}
+}
+
+func TestConnectCacheCorruptFile(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+	if err := os.WriteFile(path, []byte("not json"), 0600); nil != err {
+		t.Fatal(err)
+	}
+
+	c := NewConnectCache(path, time.Hour)
+	if nil == c || 0 != len(c.entries) {
+		t.Fatal(c)
+	}
+}
+
+func TestConnectCacheRestoresApp(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+
+	m := NewMockedProcessor(1)
+	m.p.connectCache = NewConnectCache(path, limits.ConnectCacheMaxAge)
+	m.DoAppInfo(t, nil, AppStateUnknown)
+	m.DoConnect(t, &idOne)
+	m.DoAppInfo(t, nil, AppStateConnected)
+	m.QuitTestProcessor()
+
+	// A new processor answers the first AppInfo request from the cache,
+	// without contacting the collector.
+	m = NewMockedProcessor(1)
+	m.p.connectCache = NewConnectCache(path, limits.ConnectCacheMaxAge)
+	reply := m.p.IncomingAppInfo(nil, &sampleAppInfo)
+	<-m.p.trackProgress // receive app info
+
+	if AppStateConnected != reply.State {
+		t.Fatal(reply.State)
+	}
+	if !strings.Contains(string(reply.ConnectReply), `"agent_run_id":"one"`) {
+		t.Fatal(string(reply.ConnectReply))
+	}
+	if _, ok := m.p.harvests[idOne]; !ok {
+		t.Fatal("restored app has no harvest")
+	}
+	m.QuitTestProcessor()
+}
+
+func TestConnectCacheRemovedOnRestart(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "connect.cache")
+
+	m := NewMockedProcessor(1)
+	m.p.connectCache = NewConnectCache(path, limits.ConnectCacheMaxAge)
+	m.DoAppInfo(t, nil, AppStateUnknown)
+	m.DoConnect(t, &idOne)
+
+	m.TxnData(t, idOne, txnEventSample1)
+	m.processorHarvestChan <- ProcessorHarvest{
+		AppHarvest: m.p.harvests[idOne],
+		ID:         idOne,
+		Type:       HarvestTxnEvents,
+	}
+	<-m.p.trackProgress // unblock processor
+
+	<-m.clientParams
+	m.clientReturn <- ClientReturn{nil, SampleRestartException, 401}
+	<-m.p.trackProgress // unblock processor after handling harvest restart error
+
+	c := NewConnectCache(path, limits.ConnectCacheMaxAge)
+	if got := c.Lookup(&sampleAppInfo, time.Now()); nil != got {
+		t.Fatal(got)
+	}
+
+	m.DoConnect(t, &idTwo)
+	m.QuitTestProcessor()
+}
@@ -811,6 +811,7 @@ var (
 		regexp.MustCompile(`Memory/Physical`),
 		regexp.MustCompile(`Supportability/execute/user/call_count`),
 		regexp.MustCompile(`Supportability/execute/allocated_segment_count`),
+		regexp.MustCompile(`^Supportability/Segment/PageCache/`),
 		regexp.MustCompile(`Memory/RSS`),
 		regexp.MustCompile(`^Supportability\/Locale`),
 		regexp.MustCompile(`^Supportability\/InstrumentedFunction`),
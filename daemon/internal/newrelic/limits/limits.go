@@ -30,6 +30,11 @@ const (
 	// dropped and require a reconnect to being collecting data again.
 	DefaultAppTimeout = 10 * time.Minute
 
+	// ConnectCacheMaxAge specifies the age after which a connect reply
+	// persisted in the connect cache file is no longer used to restore an
+	// application after a daemon restart.
+	ConnectCacheMaxAge = 1 * time.Hour
+
 	// Harvest Data Limits
 	DefaultReportPeriod          = 60 * time.Second
 	MaxMetrics                   = 2 * 1000
@@ -93,6 +93,9 @@ type ProcessorConfig struct {
 	IntegrationMode bool
 	UtilConfig      utilization.Config
 	AppTimeout      time.Duration
+	// ConnectCacheFile is the path of the file used to persist connect
+	// replies across daemon restarts. Empty disables the cache.
+	ConnectCacheFile string
 }
 
 type Processor struct {
@@ -114,6 +117,7 @@ type Processor struct {
 	appConnectBackoff     time.Duration
 	cfg                   ProcessorConfig
 	util                  *utilization.Data
+	connectCache          *ConnectCache
 }
 
 func (p *Processor) processTxnData(d TxnData) {
@@ -377,6 +381,7 @@ func (p *Processor) processAppInfo(m AppInfoMessage) {
 
 	app = NewApp(m.Info)
 	p.apps[key] = app
+	p.restoreConnectedApp(app)
 	numapps = len(p.apps)
 	log.Healthf("current number of apps is %d of a max of %d",
 		numapps, limits.AppLimit)
@@ -422,12 +427,14 @@ func (p *Processor) processConnectAttempt(rep ConnectAttempt) {
 
 	app.RawConnectReply = rep.RawReply.Body
 	if rep.RawReply.IsDisconnect() {
+		p.connectCache.Remove(app.info)
 		app.state = AppStateDisconnected
 		log.Warnf("app '%s' connect attempt returned %s; disconnecting", app, collector.NewRPMResponseError(rep.RawReply.Err).Err)
 		return
 	} else if rep.RawReply.IsRestartException() {
 		// in accord with the spec, invalid license is a restart exception. Except we want
 		//    to shutdown instead of restart.
+		p.connectCache.Remove(app.info)
 		if rep.RawReply.IsInvalidLicense() {
 			app.state = AppStateInvalidLicense
 			log.Warnf("app '%s' connect attempt returned %s; shutting down", app, collector.NewRPMResponseError(rep.RawReply.Err).Err)
@@ -442,13 +449,57 @@ func (p *Processor) processConnectAttempt(rep ConnectAttempt) {
 		return
 	}
 
-	app.connectReply = rep.Reply
+	p.connectApp(app, rep.Reply, rep.Collector, rep.RawSecurityPolicies, time.Now())
+
+	log.Infof("app '%s' connected with run id '%s'", app, app.connectReply.ID)
+
+	p.connectCache.Store(app.info, &ConnectCacheEntry{
+		Collector:        app.collector,
+		ConnectReply:     string(app.RawConnectReply),
+		SecurityPolicies: string(app.RawSecurityPolicies),
+		ConnectTime:      app.connectTime.Unix(),
+	})
+}
+
+// restoreConnectedApp marks a newly added application as connected using
+// the connect reply persisted by a previous daemon, if there is one. This
+// allows the first AppInfo request after a daemon restart to be answered
+// without waiting for the collector.
+func (p *Processor) restoreConnectedApp(app *App) {
+	entry := p.connectCache.Lookup(app.info, time.Now())
+	if nil == entry {
+		return
+	}
+
+	reply, err := parseConnectReply([]byte(entry.ConnectReply))
+	if nil != err {
+		log.Debugf("ignoring cached connect reply for app '%s': %v", app, err)
+		p.connectCache.Remove(app.info)
+		return
+	}
+	if _, ok := p.harvests[*reply.ID]; ok {
+		// Another application already owns this run ID.
+		return
+	}
+
+	app.RawConnectReply = []byte(entry.ConnectReply)
+	p.connectApp(app, reply, entry.Collector, []byte(entry.SecurityPolicies),
+		time.Unix(entry.ConnectTime, 0))
+
+	log.Infof("app '%s' restored run id '%s' from connect cache", app,
+		app.connectReply.ID)
+}
+
+// connectApp transitions an application to the connected state and starts
+// its harvest.
+func (p *Processor) connectApp(app *App, reply *ConnectReply, collectorHost string, rawSecurityPolicies []byte, connectTime time.Time) {
+	app.connectReply = reply
 	app.state = AppStateConnected
-	app.collector = rep.Collector
-	app.RawSecurityPolicies = rep.RawSecurityPolicies
+	app.collector = collectorHost
+	app.RawSecurityPolicies = rawSecurityPolicies
 
 	// Set up the timing data to send to the agent for harvest estimation during event sampling.
-	app.connectTime = time.Now()
+	app.connectTime = connectTime
 
 	// The sampling_target and sampling_target_period have default values of 10 samples per 60 seconds.
 	app.harvestFrequency = time.Duration(app.connectReply.SamplingFrequency) * time.Second
@@ -468,8 +519,6 @@ func (p *Processor) processConnectAttempt(rep ConnectAttempt) {
 	// Set up the trigger that controls how often the daemon harvests all data.
 	app.HarvestTrigger = getHarvestTrigger(app.info.License, app.connectReply)
 
-	log.Infof("app '%s' connected with run id '%s'", app, app.connectReply.ID)
-
 	p.harvests[*app.connectReply.ID] = NewAppHarvest(*app.connectReply.ID, app,
 		NewHarvest(time.Now(), app.connectReply.EventHarvestConfig.EventConfigs), p.processorHarvestChan)
 }
@@ -884,9 +933,11 @@ func (p *Processor) processHarvestError(d HarvestError) {
 	switch {
 	case d.Reply.IsDisconnect() || app.state == AppStateDisconnected:
 		app.state = AppStateDisconnected
+		p.connectCache.Remove(app.info)
 		p.shutdownAppHarvest(d.id)
 	case d.Reply.IsRestartException() || app.state == AppStateRestart:
 		app.state = AppStateUnknown
+		p.connectCache.Remove(app.info)
 		p.shutdownAppHarvest(d.id)
 		p.considerConnect(app)
 	}
@@ -908,6 +959,7 @@ func NewProcessor(cfg ProcessorConfig) *Processor {
 		dataUsageChannel:  make(chan dataUsageInfo, 25),
 		appConnectBackoff: limits.AppConnectAttemptBackoff,
 		cfg:               cfg,
+		connectCache:      NewConnectCache(cfg.ConnectCacheFile, limits.ConnectCacheMaxAge),
 	}
 }
 